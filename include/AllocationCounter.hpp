@@ -0,0 +1,12 @@
+#pragma once
+
+/**
+ * Number of heap allocations made so far by the calling thread
+ *
+ * Every global operator new is replaced (see AllocationCounter.cpp) to bump a
+ * thread-local counter, so the difference between two calls on one thread counts
+ * exactly the allocations made in between, whatever other threads are doing.
+ *
+ * @return Allocation count of the calling thread
+ */
+long long threadAllocationCount();
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Image.hpp"
+#include "Rasterizer.hpp"
+#include <cstdint>
+#include <string>
+
+/**
+ * Edge antialiasing of rendered frames
+ *
+ * Supersampling rasterizes and shades every sample of a finer grid and
+ * box-filters them down; its names give that grid's samples per axis.
+ * Multisampling rasterizes the pixel grid with a coverage mask of four samples
+ * per pixel and depth-tests once per pixel, at the pixel center. Each face is
+ * shaded once per pixel and weighted by the samples it covers, so only edge
+ * pixels cost more than one shade.
+ */
+enum class Antialiasing {
+    None,     // One sample per pixel
+    SSAA2x2,  // 2x2 shaded samples per pixel (4 samples)
+    SSAA4x4,  // 4x4 shaded samples per pixel (16 samples)
+    MSAA4x    // 4 coverage samples per pixel, shaded once per face
+};
+
+/**
+ * Coverage samples of a multisampled pixel showing more than one visibility entry
+ *
+ * Every face covering a sample is depth-tested at the pixel center, so a face
+ * keeps one depth across its samples; only edge pixels carry one of these.
+ */
+struct CoverageSamples {
+    uint32_t ids[Rasterizer::COVERAGE_SAMPLES];     // Visibility entry of each sample
+    uint32_t depths[Rasterizer::COVERAGE_SAMPLES];  // Depth value of each sample's entry
+};
+
+/**
+ * Samples per pixel along each axis of the grid a mode rasterizes on
+ *
+ * @param mode Antialiasing mode
+ * @return 1 (also for MSAA, which rasterizes pixels), 2 or 4
+ */
+int antialiasingSampleScale(Antialiasing mode);
+
+/**
+ * Parse an antialiasing mode name ("none", "ssaa2x2", "ssaa4x4" or "msaa4x")
+ *
+ * The earlier names "ssaa2x" and "ssaa4x" are still read as "ssaa2x2" and "ssaa4x4".
+ *
+ * @param name Mode name
+ * @param mode Receives the mode if the name is valid
+ * @return True if the name was recognized
+ */
+bool parseAntialiasing(const std::string& name, Antialiasing& mode);
+
+/**
+ * Name of an antialiasing mode as used in the configuration
+ *
+ * @param mode Antialiasing mode
+ * @return Name such as "msaa4x"
+ */
+const char* antialiasingName(Antialiasing mode);
+
+/**
+ * Box-filter a rectangle of samples down into the target
+ *
+ * Runs the SSE4.1 kernel when the CPU has it; every kernel rounds the same way,
+ * so the result does not depend on the instruction set.
+ *
+ * @param samples Image of factor x factor samples per target pixel
+ * @param target Image receiving the filtered pixels
+ * @param factor Samples per pixel along each axis (2 or 4)
+ * @param pixels Target pixels to write (must lie inside the target)
+ */
+void downsampleBox(const Image& samples, Image& target, int factor, const RasterRect& pixels);
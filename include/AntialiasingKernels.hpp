@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+
+// Plain data interface to the ISA-specific downsampling kernels. The kernel sources
+// are compiled with per-file instruction set flags, so this header must stay free
+// of inline functions and standard library templates.
+
+/**
+ * A rectangle of RGB24 pixels and the factor x factor block of samples behind each
+ */
+struct DownsampleRect {
+    const unsigned char* samples;  // First sample of the rectangle
+    size_t sampleStride;           // Bytes between sample rows
+    unsigned char* pixels;         // First output pixel
+    size_t pixelStride;            // Bytes between output rows
+    int width;                     // Output pixels per row
+    int height;                    // Output rows
+    int factor;                    // Samples per pixel along each axis (2 or 4)
+};
+
+/**
+ * Portable box filter, also used for the columns the vector kernel leaves over
+ *
+ * Each channel becomes the rounded mean of its factor x factor samples:
+ * (sum + n / 2) / n with n = factor * factor. Every kernel computes exactly this.
+ *
+ * @param rect Samples and output pixels
+ * @param firstColumn First output column to filter
+ */
+void downsampleBoxScalar(const DownsampleRect& rect, int firstColumn);
+
+/**
+ * SSE4.1 box filter, 16 samples of each row per iteration
+ *
+ * @param rect Samples and output pixels
+ */
+void downsampleBoxSSE41(const DownsampleRect& rect);
+
+/**
+ * AVX2 box filter, the SSE4.1 kernel on two groups of samples at once
+ *
+ * @param rect Samples and output pixels
+ */
+void downsampleBoxAVX2(const DownsampleRect& rect);
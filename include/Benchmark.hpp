@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "ConfigManager.hpp"
+#include "Image.hpp"
+#include "Texture.hpp"
+
+// Forward declaration
+class Renderer;
+
+/**
+ * Benchmark harness that times rendering paths on the configured scene
+ */
+class Benchmark {
+public:
+    /**
+     * Constructor
+     *
+     * @param config Configuration describing the scene to benchmark
+     * @param decalTexture Texture applied to the decal face
+     */
+    Benchmark(const ConfigManager& config, const Texture& decalTexture);
+
+    /**
+     * Run a named benchmark scenario
+     *
+     * @param name Scenario name (see scenarioNames())
+     * @return true if the scenario exists and ran
+     */
+    bool run(const std::string& name);
+
+    /**
+     * Names of the available benchmark scenarios
+     *
+     * @return List of scenario names
+     */
+    static std::vector<std::string> scenarioNames();
+
+private:
+    /**
+     * Callback receiving each rendered frame (sample index, image)
+     */
+    typedef std::function<void(size_t, const Image&)> FrameVisitor;
+
+    const ConfigManager& config;
+    const Texture& decalTexture;
+
+    /**
+     * Frame numbers sampled evenly across the configured animation
+     *
+     * @param maxFrames Upper bound on the number of frames
+     * @return Frame numbers to render
+     */
+    std::vector<int> sampleFrames(int maxFrames) const;
+
+    /**
+     * Render sampled frames of a scene and return the average render time
+     * Only renderFrame is timed; the visitor runs outside the measurement
+     *
+     * @param scene Scene settings (cube size, animation)
+     * @param renderer The renderer to time
+     * @param maxFrames Upper bound on the number of frames
+     * @param visit Optional callback for each rendered frame
+     * @param steadyAllocations Optional; receives the heap allocations renderFrame made
+     *        on this thread after the first frame
+     * @return Milliseconds per frame
+     */
+    double timeFrames(const ConfigManager& scene, Renderer& renderer, int maxFrames, const FrameVisitor& visit,
+        long long* steadyAllocations = nullptr) const;
+
+    /**
+     * Compare two sets of frames pixel by pixel
+     *
+     * @param a First set of frames
+     * @param b Second set of frames
+     * @param differingPixels Output for the number of pixels that differ
+     * @return Largest per-channel difference
+     */
+    static int compareFrames(const std::vector<Image>& a, const std::vector<Image>& b, long long& differingPixels);
+
+    /**
+     * FNV-1a hash of an image's pixels, for cheap identity checks on large frames
+     *
+     * @param image Image to hash
+     * @return 64-bit hash
+     */
+    static uint64_t checksum(const Image& image);
+
+    /**
+     * Reference vs scanline texture walk on the decal face
+     *
+     * Coverage is compared on its own, with a texture of one marker color; colors
+     * are compared where both walks covered the pixel.
+     *
+     * @return False if the walks cover different pixels away from the quad edges,
+     *         or differ by more than one per channel
+     */
+    bool runTextureWalk();
+
+    /**
+     * Tiled rendering at 1080p, 4K and 8K across 1-64 tile threads
+     *
+     * @return False if a tiled run differs from the untiled one or allocates after its first frame
+     */
+    bool runTileScaling();
+
+    /**
+     * Bilinear sampler kernels against the double-precision reference loop, the
+     * cost of each filter on a minified quad, the trilinear and area kernels per
+     * instruction set on a large minified texture, and each filter's error on an
+     * oblique strip against a supersampled reference
+     *
+     * @return False if a vector trilinear or area kernel differs from the portable one
+     */
+    bool runSamplerKernels();
+
+    /**
+     * Cost of texturing a minified quad as it spins in the image plane, for
+     * linear and tiled texel layouts
+     */
+    void runRotationSweep();
+
+    /**
+     * Per-face texture mapping setup: general 8x8 solve plus inverse against the
+     * closed-form quad-to-square mapping
+     */
+    void runHomographySetup();
+
+    /**
+     * Frame cost of scenes that cross the near plane or reach far off screen,
+     * against the configured scene, with tiled output checked against untiled
+     */
+    void runClipping();
+
+    /**
+     * Vertices per second of the per-vertex transform and projection against the
+     * batched structure-of-arrays kernels
+     */
+    void runVertexTransform();
+
+    /**
+     * Instanced cube fields: frame time against visible and total instance counts,
+     * and the face radix sort against a comparison sort
+     */
+    void runSceneScaling();
+
+    /**
+     * OBJ loading throughput and triangle path frame time on the configured mesh
+     * (or a generated 500k-triangle sphere), and the cube drawn as textured
+     * triangles checked against the quad path
+     */
+    void runMeshPath();
+
+    /**
+     * Hundreds of interpenetrating cubes drawn sorted, with 16- and 32-bit depth
+     * buffers and through the visibility buffer: frame time, overdraw, depth
+     * complexity and how many pixels the block ranges reject before any
+     * per-pixel compare
+     */
+    void runDepthTest();
+
+    /**
+     * Box filter kernels against the portable loop, and frame time of each
+     * antialiasing mode against none
+     */
+    void runAntialiasing();
+
+    /**
+     * Texture ingest of a decoded 8K image through an Image against straight
+     * into the padded texel rows, and the whole load of the configured decal,
+     * decoded and mapped from the texture cache
+     */
+    void runTextureLoad();
+
+    /**
+     * Paged against resident sampling of an 8K texture over a series of rotated
+     * views, for every filter: time per view, pages read and peak page memory
+     * under a small budget, and a pixel comparison of the two
+     */
+    void runPaging();
+
+    /**
+     * Fixed-point against double-precision bilinear sampling: throughput of each
+     * on a perspective quad and their error against the double reference, output
+     * independent of span splits and texel layout, and whole frames of the
+     * configured scene rendered both ways
+     *
+     * @return False if the fixed-point kernel exceeds its documented error bounds
+     *         or depends on span splits
+     */
+    bool runFixedPoint();
+
+    /**
+     * Every supported kernel level forced in turn: 4K frame clears, fills of short
+     * runs and frames of the configured scene, checked to be identical across levels
+     */
+    void runKernelIsa();
+};
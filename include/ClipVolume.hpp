@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Math.hpp"
+
+/**
+ * Camera-space clip volume: the near plane plus a guard band around the viewport
+ *
+ * Every plane is a half-space n . p + d >= 0 in camera space. The guard-band planes
+ * pass through the eye: screen x >= -margin is scale * x + (centerX + margin) * z >= 0,
+ * the homogeneous clip-space test without a divide. Polygons are clipped only
+ * against planes they actually cross, and the margin keeps faces that merely
+ * overlap the screen edge out of the clipper entirely; the rasterizer's clip
+ * rectangle trims those for free. What the clipper guarantees is that projected
+ * vertices are finite and bounded, whatever the camera or the geometry.
+ * With a zero margin the volume is the view frustum, used to cull whole objects.
+ */
+class ClipVolume {
+public:
+    static const int PLANE_COUNT = 5;
+
+    /**
+     * Outcode bits, one per plane
+     */
+    enum Plane {
+        NEAR_PLANE = 1 << 0,
+        LEFT_PLANE = 1 << 1,
+        RIGHT_PLANE = 1 << 2,
+        TOP_PLANE = 1 << 3,
+        BOTTOM_PLANE = 1 << 4
+    };
+
+    /**
+     * Constructor
+     *
+     * @param scale Projection scale of the camera
+     * @param centerX Screen X of the optical axis
+     * @param centerY Screen Y of the optical axis
+     * @param width Viewport width in pixels
+     * @param height Viewport height in pixels
+     * @param nearZ Distance of the near plane
+     * @param margin Guard band around the viewport in pixels
+     */
+    ClipVolume(double scale, double centerX, double centerY, int width, int height, double nearZ, double margin);
+
+    /**
+     * Classify a camera-space point against every plane
+     *
+     * @param p Point in camera space
+     * @return Bit set for each plane the point is outside of (0 = inside the volume)
+     */
+    int outcode(const Vec3& p) const;
+
+    /**
+     * Classify a point from its screen position and depth, as produced by transformAndProject
+     *
+     * Matches outcode() up to rounding for points in front of the eye. A point
+     * at depth 0 has no meaningful screen position and only gets the near bit.
+     *
+     * @param x Screen X after the perspective divide
+     * @param y Screen Y after the perspective divide
+     * @param depth Camera-space depth
+     * @return Bit set for each plane the point is outside of (0 = inside the volume)
+     */
+    int outcodeProjected(float x, float y, float depth) const;
+
+    /**
+     * Check if a sphere lies entirely outside one of the planes
+     *
+     * @param center Sphere center in camera space
+     * @param radius Sphere radius
+     * @return True if nothing inside the sphere can be inside the volume
+     */
+    bool excludesSphere(const Vec3& center, double radius) const;
+
+    /**
+     * Clip a convex polygon against a set of planes (Sutherland-Hodgman)
+     *
+     * Edges are tracked through the clip: an output edge lying on one of the
+     * polygon's own edges gets its bit set in outlineMask, while edges running
+     * along a clip plane do not, so outlines are never drawn where the near plane
+     * or the guard band cut the polygon.
+     *
+     * @param input Polygon vertices in camera space
+     * @param count Number of vertices
+     * @param planes Outcode bits of the planes to clip against
+     * @param output Receives up to count + PLANE_COUNT vertices
+     * @param outlineMask Receives bit i set when edge i -> i+1 of the output is a polygon edge
+     * @return Number of output vertices (0 if nothing is left)
+     */
+    int clipPolygon(const Vec3* input, int count, int planes, Vec3* output, unsigned& outlineMask) const;
+
+private:
+    Vec3 normals[PLANE_COUNT];
+    double offsets[PLANE_COUNT];
+    float nearDepth;
+    float left, right, top, bottom;  // Guard band rectangle in screen space
+};
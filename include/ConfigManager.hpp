@@ -5,6 +5,8 @@
 #include "Image.hpp"
 #include "Math.hpp"
 #include "Cube.hpp"
+#include "Mesh.hpp"
+#include "Texture.hpp"
 
 // Forward declaration
 class Renderer;
@@ -20,11 +22,20 @@ public:
     int frameRate;
     std::string outputDirectory;
     std::string outputFilename;
+    std::string outputMode;      // "frames" (PPM files, then ffmpeg) or "pipe" (raw frames streamed to the encoder)
+    std::string encoderCommand;  // Encoder executable for pipe mode (ffmpeg, or a stand-in reading rgb24 on stdin)
+    int writerQueueDepth;        // Rendered frames that may wait for the background frame writer
 
     // Rendering settings
     int width;
     int height;
     Color backgroundColor;
+    int threads;         // Frames rendered concurrently (0 = all hardware threads)
+    int tileSize;        // Screen tile size for tiled rendering (0 = untiled)
+    int tileThreads;     // Threads rasterizing the tiles of one frame (0 = all hardware threads)
+    int depthBits;       // Depth buffer precision: 0 (faces sorted back to front), 16 or 32
+    bool visibilityBuffer;  // Shade each pixel once from a buffer of face ids (depth tested, 32 bits if depthBits is 0)
+    std::string antialiasing;  // "none", "ssaa2x2", "ssaa4x4" (sample grids) or "msaa4x" (samples per pixel)
 
     // Camera settings
     double cameraScale;
@@ -33,6 +44,17 @@ public:
     double cubeSize;
     int decalFaceIndex;  // Which face gets the texture (0-5)
     std::string decalImagePath;
+    std::string decalSampler;  // Decal texture filter: "nearest", "bilinear", "trilinear" or "area"
+    std::string decalLayout;   // Decal texel order: "linear" or "tiled"
+    int decalPageBudgetMB;     // Page the decal from the texture cache with this much memory (0 = load it whole)
+
+    // Texture cache settings
+    std::string textureCacheDirectory;  // Decoded textures kept here for the next run (empty = no cache, the default)
+    int textureCacheLimitMB;            // Least recently used entries are deleted beyond this size
+
+    // Mesh settings
+    std::string meshPath;           // OBJ file rendered instead of the cube (empty = the cube)
+    std::string meshDecalMaterial;  // Material of the mesh triangles that get the decal (empty = material decalFaceIndex)
 
     // Rotation settings
     double rotationSpeedX;     // Rotation speed multiplier for X axis
@@ -90,12 +112,28 @@ public:
 
     /**
      * Render an animation of a rotating cube
+     * Frames are rendered concurrently on `threads` workers, each with its own copy
+     * of the renderer, into recycled buffers that a background FrameWriter writes
+     * out strictly in frame order. Heap allocations made while rendering after each
+     * worker's first frame are counted and reported, along with the time the writer
+     * and the renderers spent waiting on each other.
+     * In "pipe" output mode frames are streamed to the encoder instead of saved.
      *
-     * @param renderer The renderer to use
+     * @param renderer The renderer to use (copied per worker)
      * @param cube The cube to animate
-     * @param decalImage Optional texture to apply to front face
+     * @param decalTexture Optional texture to apply to the decal face
+     * @param mesh Optional mesh animated instead of the cube
+     * @param decalMaterial Material id of the mesh triangles that get the decal, or -1
+     */
+    void renderAnimation(Renderer& renderer, Cube& cube, const Texture* decalTexture = nullptr,
+        const Mesh* mesh = nullptr, int decalMaterial = -1);
+
+    /**
+     * Build the shell command that encodes raw rgb24 frames from stdin
+     *
+     * @return Command line for the encoder in pipe mode
      */
-    void renderAnimation(Renderer& renderer, Cube& cube, const Image* decalImage = nullptr);
+    std::string buildEncoderCommand() const;
 
     /**
      * Create output directory and clean any existing files
@@ -107,8 +145,9 @@ public:
      *
      * @param frame The image to save
      * @param frameNumber The frame number (used in filename)
+     * @return true if the frame was written
      */
-    void saveFrame(const Image& frame, int frameNumber) const;
+    bool saveFrame(const Image& frame, int frameNumber) const;
 
     /**
      * Create a video from the rendered frames
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <string>
+
+/**
+ * Check if the CPU supports SSE4.1
+ * Always false when the build has no x86 kernels
+ *
+ * @return True if SSE4.1 instructions can run
+ */
+bool cpuHasSSE41();
+
+/**
+ * Check if the CPU and operating system support AVX2
+ * Always false when the build has no x86 kernels
+ *
+ * @return True if AVX2 instructions can run
+ */
+bool cpuHasAVX2();
+
+/**
+ * Check if the CPU and operating system support AVX-512 (foundation and
+ * byte/word instructions)
+ * Always false when the build has no x86 kernels
+ *
+ * @return True if AVX-512F and AVX-512BW instructions can run
+ */
+bool cpuHasAVX512();
+
+/**
+ * Instruction set level of the hot kernels
+ *
+ * Every kernel is built in a portable version and for some of the levels above
+ * it, each in its own source file compiled with that level's flags. Calls run
+ * the best version at or below the active level:
+ * - Frame clear and span fill: portable, AVX2, AVX-512
+ * - Bilinear texture sampling: portable, SSE4.1, AVX2, AVX-512
+ * - Supersampling box filter: portable, SSE4.1, AVX2
+ * - Vertex transform and projection: portable, AVX2
+ */
+enum class KernelIsa {
+    SSE2,    // Portable C++ only, compiled for the x86-64 baseline
+    SSE41,
+    AVX2,
+    AVX512
+};
+
+/**
+ * Best kernel level supported by this CPU and build
+ *
+ * @return Detected level (SSE2 when the build has no x86 kernels)
+ */
+KernelIsa detectKernelIsa();
+
+/**
+ * Check if a kernel level can run on this CPU and build
+ *
+ * @param isa Level to check
+ * @return True if supported
+ */
+bool isKernelIsaSupported(KernelIsa isa);
+
+/**
+ * Get the active kernel level, detected with cpuid on first use
+ *
+ * @return Active level
+ */
+KernelIsa getKernelIsa();
+
+/**
+ * Force the kernel level, for testing the lower ones on a newer CPU
+ * Set it at startup, before any kernel runs.
+ *
+ * @param isa Level (ignored with a warning if unsupported)
+ * @return True if the level was set
+ */
+bool setKernelIsa(KernelIsa isa);
+
+/**
+ * Parse a kernel level name ("sse2", "sse4.1", "avx2" or "avx512")
+ *
+ * @param name Level name
+ * @param isa Receives the level if the name is valid
+ * @return True if the name was recognized
+ */
+bool parseKernelIsa(const std::string& name, KernelIsa& isa);
+
+/**
+ * Human-readable name of a kernel level
+ *
+ * @param isa Kernel level
+ * @return Name such as "AVX2"
+ */
+const char* kernelIsaName(KernelIsa isa);
@@ -1,15 +1,24 @@
 #pragma once
 
+#include <array>
 #include <vector>
 #include "Math.hpp"
+#include "Mesh.hpp"
 
 /**
  * 3D Cube representation with vertices and faces
+ *
+ * Per-face geometry (outward normals and centroids) is computed once when the
+ * cube is built or transformed, so renderers only need to dot a face normal with
+ * the camera position in object space to decide whether the face is visible.
  */
 class Cube {
 public:
     std::vector<Vec3> vertices;
-    std::vector<std::vector<int>> faces;
+    std::array<std::array<int, 4>, 6> faces;  // Vertex indices of each face
+    std::array<Vec3, 6> normals;              // Unit outward normal of each face
+    std::array<Vec3, 6> centroids;            // Center of each face
+    double boundingRadius;                    // Radius of the sphere around the origin holding every vertex
 
     /**
      * Constructor for creating a cube
@@ -20,8 +29,26 @@ public:
 
     /**
      * Apply a 4x4 transformation matrix to all vertices
+     * Normals, centroids and the bounding radius are updated to match.
      *
      * @param matrix The transformation matrix to apply
      */
     void transform(const Mat4x4& matrix);
-};
\ No newline at end of file
+
+    /**
+     * Build a triangle mesh of the cube
+     *
+     * Each face becomes two triangles over four vertices of its own, with material
+     * id equal to the face index and texture coordinates running from (0,0) at the
+     * face's first corner to (1,1) at its third, as the decal is mapped on the cube.
+     *
+     * @return The cube as a mesh
+     */
+    Mesh toMesh() const;
+
+private:
+    /**
+     * Recompute normals, centroids and the bounding radius from the vertices
+     */
+    void computeFaceGeometry();
+};
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * Depth of a planar face over the screen
+ *
+ * For a planar face near / z is an affine function of the pixel position, so
+ * the face's closeness to the eye is exactly a * x + b * y + c: 1 on the near
+ * plane, falling towards 0 with distance.
+ */
+struct DepthPlane {
+    double a = 0.0;
+    double b = 0.0;
+    double c = 0.0;
+
+    /**
+     * Closeness at a pixel
+     *
+     * @param x Pixel X
+     * @param y Pixel Y
+     * @return near / z of the face at the pixel
+     */
+    double at(double x, double y) const {
+        return a * x + b * y + c;
+    }
+};
+
+/**
+ * Depth target with a hierarchical min/max per block
+ *
+ * Stores the closeness of the nearest surface drawn at each pixel, quantized to
+ * the full range of T (uint16_t or uint32_t); a cleared buffer holds 0, infinitely
+ * far away. Each BLOCK_SIZE x BLOCK_SIZE block tracks the smallest and largest
+ * value it holds, so a face or span lying entirely behind a block is rejected without
+ * reading its pixels, and a span entirely in front of it passes without per-pixel
+ * compares. The block minimum stays exact: the pixels holding it are counted, and
+ * the block is rescanned only once every one of them has been overwritten.
+ *
+ * Clearing only marks the blocks stale; a block's pixels are cleared the first
+ * time anything is stored in it, so frames that leave most of the screen empty
+ * never touch most of the buffer.
+ *
+ * Blocks are aligned to the pixel grid, so callers that split the screen into
+ * clip rectangles that are multiples of BLOCK_SIZE can test them concurrently.
+ */
+template<typename T>
+class DepthBuffer {
+public:
+    static const int BLOCK_SIZE = 8;
+
+    DepthBuffer() : width(0), height(0), blocksX(0), companion(nullptr) {
+    }
+
+    /**
+     * Resize and clear to infinitely far, reusing the storage when large enough
+     *
+     * @param width Width in pixels
+     * @param height Height in pixels
+     * @param companion Optional per-pixel buffer of width * height entries that is
+     *        cleared to 0 along with each stale block (may be null)
+     */
+    void reset(int width, int height, uint32_t* companion = nullptr) {
+        this->width = width;
+        this->height = height;
+        this->companion = companion;
+        blocksX = (width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        const int blocksY = (height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        values.resize(static_cast<size_t>(width) * height);
+        blocks.resize(static_cast<size_t>(blocksX) * blocksY);
+        for (Block& block : blocks) {
+            block.minValue = 0;
+            block.maxValue = 0;
+            block.minCount = 0;
+            block.stale = true;
+        }
+    }
+
+    /**
+     * Quantize a closeness value
+     *
+     * @param closeness near / z, clamped to [0, 1]
+     * @return Stored depth value (larger is nearer)
+     */
+    static T quantize(double closeness) {
+        const double maxValue = static_cast<double>(std::numeric_limits<T>::max());
+        return static_cast<T>(std::max(0.0, std::min(1.0, closeness)) * maxValue);
+    }
+
+    /**
+     * Depth-test a span, storing the values that pass
+     *
+     * Pixels pass when the plane is strictly nearer than the stored value. Runs of
+     * passing pixels are handed to emit(x0, x1) after their depth is written.
+     *
+     * @param y Row
+     * @param x0 First pixel
+     * @param x1 Last pixel
+     * @param plane Depth of the surface being drawn
+     * @param blockRejected Incremented for every pixel rejected by a block's range
+     * @param pixelRejected Incremented for every pixel failing its own compare
+     * @param emit Called with each run of passing pixels
+     */
+    template<typename Emit>
+    void testSpan(int y, int x0, int x1, const DepthPlane& plane, long long& blockRejected,
+        long long& pixelRejected, Emit& emit) {
+        const double rowBase = plane.b * y + plane.c;
+        T* row = &values[static_cast<size_t>(y) * width];
+        Block* blockRow = &blocks[(y / BLOCK_SIZE) * blocksX];
+
+        int runStart = -1;
+        for (int bx0 = x0; bx0 <= x1; ) {
+            const int bx1 = std::min(x1, bx0 | (BLOCK_SIZE - 1));
+            Block& block = blockRow[bx0 / BLOCK_SIZE];
+            if (block.stale) {
+                clearBlock(bx0 / BLOCK_SIZE, y / BLOCK_SIZE);
+            }
+            else if (block.minCount == 0) {
+                rescan(bx0 / BLOCK_SIZE, y / BLOCK_SIZE);
+            }
+
+            // Closeness is linear along the row, so the ends bound the segment
+            const T first = quantize(plane.a * bx0 + rowBase);
+            const T last = quantize(plane.a * bx1 + rowBase);
+            if (std::max(first, last) <= block.minValue) {
+                // Behind everything in the block
+                blockRejected += bx1 - bx0 + 1;
+                if (runStart >= 0) {
+                    emit(runStart, bx0 - 1);
+                    runStart = -1;
+                }
+            }
+            else if (std::min(first, last) > block.maxValue) {
+                // In front of everything in the block
+                for (int x = bx0; x <= bx1; x++) {
+                    store(block, row, x, quantize(plane.a * x + rowBase));
+                }
+                if (runStart < 0) {
+                    runStart = bx0;
+                }
+            }
+            else {
+                for (int x = bx0; x <= bx1; x++) {
+                    const T value = quantize(plane.a * x + rowBase);
+                    if (value > row[x]) {
+                        store(block, row, x, value);
+                        if (runStart < 0) {
+                            runStart = x;
+                        }
+                    }
+                    else {
+                        pixelRejected++;
+                        if (runStart >= 0) {
+                            emit(runStart, x - 1);
+                            runStart = -1;
+                        }
+                    }
+                }
+            }
+            bx0 = bx1 + 1;
+        }
+        if (runStart >= 0) {
+            emit(runStart, x1);
+        }
+    }
+
+    /**
+     * Whether a plane lies behind everything drawn in a rectangle of one block
+     *
+     * @param x0 Left pixel
+     * @param y0 Top pixel
+     * @param x1 Right pixel, in the same block as x0
+     * @param y1 Bottom pixel, in the same block as y0
+     * @param plane Depth of the surface being drawn
+     * @return true if no pixel of the plane in the rectangle can pass testSpan
+     */
+    bool occludes(int x0, int y0, int x1, int y1, const DepthPlane& plane) {
+        Block& block = blocks[(y0 / BLOCK_SIZE) * blocksX + x0 / BLOCK_SIZE];
+        if (!block.stale && block.minCount == 0) {
+            rescan(x0 / BLOCK_SIZE, y0 / BLOCK_SIZE);
+        }
+        // Closeness is linear, so it peaks at one corner of the rectangle
+        const double nearest = plane.at(plane.a > 0.0 ? x1 : x0, plane.b > 0.0 ? y1 : y0);
+        return quantize(nearest) <= block.minValue;
+    }
+
+    /**
+     * Depth-test a single pixel, storing the value if it passes
+     *
+     * @param x Pixel X
+     * @param y Pixel Y
+     * @param value Depth value; passes when at least as near as the stored one
+     * @return true if the pixel passed
+     */
+    bool testPixel(int x, int y, T value) {
+        Block& block = blocks[(y / BLOCK_SIZE) * blocksX + x / BLOCK_SIZE];
+        if (block.stale) {
+            clearBlock(x / BLOCK_SIZE, y / BLOCK_SIZE);
+        }
+        T* row = &values[static_cast<size_t>(y) * width];
+        if (value < row[x]) {
+            return false;
+        }
+        store(block, row, x, value);
+        return true;
+    }
+
+    /**
+     * Whether anything was stored in a pixel's block since the last reset
+     *
+     * Untouched blocks hold stale pixels, and their companion entries are stale too.
+     *
+     * @param x Pixel X
+     * @param y Pixel Y
+     * @return true if the block's pixels (and companion entries) are valid
+     */
+    bool touched(int x, int y) const {
+        return !blocks[(y / BLOCK_SIZE) * blocksX + x / BLOCK_SIZE].stale;
+    }
+
+    /**
+     * Clear a pixel's block if it is stale, so its value and companion entry
+     * can be read and written directly
+     *
+     * @param x Pixel X
+     * @param y Pixel Y
+     */
+    void touch(int x, int y) {
+        if (blocks[(y / BLOCK_SIZE) * blocksX + x / BLOCK_SIZE].stale) {
+            clearBlock(x / BLOCK_SIZE, y / BLOCK_SIZE);
+        }
+    }
+
+    /**
+     * Stored value of a pixel
+     *
+     * @param x Pixel X
+     * @param y Pixel Y
+     * @return Depth value (0 where nothing was drawn)
+     */
+    T at(int x, int y) const {
+        return touched(x, y) ? values[static_cast<size_t>(y) * width + x] : 0;
+    }
+
+private:
+    struct Block {
+        T minValue;         // Smallest value in the block (a lower bound while minCount is 0)
+        T maxValue;         // Largest value in the block
+        uint16_t minCount;  // Pixels holding minValue; 0 once all of them were overwritten
+        bool stale;         // Pixels not cleared since the last reset (all of them count as 0)
+    };
+
+    int width;
+    int height;
+    int blocksX;
+    std::vector<T> values;
+    std::vector<Block> blocks;
+    uint32_t* companion;
+
+    void clearBlock(int bx, int by) {
+        Block& block = blocks[by * blocksX + bx];
+        const int x0 = bx * BLOCK_SIZE;
+        const int xEnd = std::min(width, x0 + BLOCK_SIZE);
+        const int yEnd = std::min(height, (by + 1) * BLOCK_SIZE);
+        for (int y = by * BLOCK_SIZE; y < yEnd; y++) {
+            const size_t row = static_cast<size_t>(y) * width;
+            std::fill(values.data() + row + x0, values.data() + row + xEnd, T(0));
+            if (companion) {
+                std::fill(companion + row + x0, companion + row + xEnd, 0u);
+            }
+        }
+        block.minCount = static_cast<uint16_t>((xEnd - x0) * (yEnd - by * BLOCK_SIZE));
+        block.stale = false;
+    }
+
+    // Values only ever grow, so the minimum only changes when its last holder is overwritten
+    void store(Block& block, T* row, int x, T value) {
+        if (row[x] == block.minValue && block.minCount > 0) {
+            block.minCount--;
+        }
+        row[x] = value;
+        block.maxValue = std::max(block.maxValue, value);
+    }
+
+    void rescan(int bx, int by) {
+        Block& block = blocks[by * blocksX + bx];
+        const int xEnd = std::min(width, (bx + 1) * BLOCK_SIZE);
+        const int yEnd = std::min(height, (by + 1) * BLOCK_SIZE);
+        T minValue = std::numeric_limits<T>::max();
+        uint16_t count = 0;
+        for (int y = by * BLOCK_SIZE; y < yEnd; y++) {
+            const T* row = &values[static_cast<size_t>(y) * width];
+            for (int x = bx * BLOCK_SIZE; x < xEnd; x++) {
+                if (row[x] < minValue) {
+                    minValue = row[x];
+                    count = 1;
+                }
+                else if (row[x] == minValue) {
+                    count++;
+                }
+            }
+        }
+        block.minValue = minValue;
+        block.minCount = count;
+    }
+};
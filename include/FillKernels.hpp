@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+
+// Plain data interface to the ISA-specific fill kernels. The kernel sources are
+// compiled with per-file instruction set flags, so this header must stay free of
+// inline functions and standard library templates.
+
+/**
+ * Channel index (0, 1 or 2) of each byte of 64 packed RGB pixels, so the vector
+ * kernels can build their pattern registers with one byte shuffle each
+ */
+extern const unsigned char FILL_PHASE[192];
+
+/**
+ * Runs of at least this many pixels (12 MB) are written by the vector kernels
+ * with non-temporal stores, which skip reading every line in before overwriting
+ * it. Smaller frames are cleared through the cache, where the faces drawn next
+ * still find them.
+ */
+const size_t FILL_STREAM_PIXELS = 1 << 22;
+
+/**
+ * Portable fill, also used for runs too short to be worth a vector kernel
+ *
+ * @param out First RGB byte of the run
+ * @param count Number of pixels
+ * @param rgb The fill color's red, green and blue bytes
+ */
+void fillPixelsPortable(unsigned char* out, size_t count, const unsigned char* rgb);
+
+/**
+ * AVX2 fill, 32 pixels (three 32-byte stores) per iteration and a copy of
+ * the pattern registers for the rest; long runs stream from a 32-byte boundary
+ *
+ * @param out First RGB byte of the run
+ * @param count Number of pixels
+ * @param rgb The fill color's red, green and blue bytes
+ */
+void fillPixelsAVX2(unsigned char* out, size_t count, const unsigned char* rgb);
+
+/**
+ * AVX-512 fill, 64 pixels (three 64-byte stores) per iteration and masked
+ * stores for the rest; long runs stream from a 64-byte boundary
+ *
+ * @param out First RGB byte of the run
+ * @param count Number of pixels
+ * @param rgb The fill color's red, green and blue bytes
+ */
+void fillPixelsAVX512(unsigned char* out, size_t count, const unsigned char* rgb);
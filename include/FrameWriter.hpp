@@ -0,0 +1,94 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Image.hpp"
+
+/**
+ * Time accounting of a frame writer run
+ */
+struct FrameWriterStats {
+    int framesWritten = 0;         // Frames handed to the sink
+    double writeMs = 0.0;          // Time the writer spent in the sink (I/O)
+    double writerIdleMs = 0.0;     // Time the writer waited for the next frame to be rendered
+    double rendererBlockedMs = 0.0; // Time renderers waited for a free buffer (summed over threads)
+};
+
+/**
+ * Background thread writing rendered frames in order
+ *
+ * Frames are rendered into a ring of recycled buffers: frame n uses buffer
+ * n % bufferCount, and may start only once frame n - bufferCount has been
+ * written. Renderers fill buffers concurrently while the writer thread passes
+ * finished frames to the sink strictly in frame order, so rendering and I/O
+ * overlap and memory stays bounded.
+ */
+class FrameWriter {
+public:
+    /**
+     * Sink receiving each frame in order; returns false on failure
+     */
+    typedef std::function<bool(const Image& frame, int frameNumber)> Sink;
+
+    /**
+     * Constructor - allocates the buffers and starts the writer thread
+     *
+     * @param width Frame width (buffers are preallocated at this size)
+     * @param height Frame height
+     * @param bufferCount Number of recycled frame buffers (at least 1)
+     * @param sink Called on the writer thread for every frame in order
+     */
+    FrameWriter(int width, int height, int bufferCount, Sink sink);
+
+    /**
+     * Destructor - calls finish()
+     */
+    ~FrameWriter();
+
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    /**
+     * Get the buffer to render a frame into, waiting until it has been written out
+     *
+     * @param frameNumber Frame about to be rendered
+     * @return Buffer owned by this frame until submit()
+     */
+    Image& acquire(int frameNumber);
+
+    /**
+     * Hand a rendered frame to the writer
+     *
+     * @param frameNumber Frame previously acquired and now fully rendered
+     */
+    void submit(int frameNumber);
+
+    /**
+     * Write every submitted frame that is next in order, then stop the writer thread
+     *
+     * @return Time accounting of the run
+     */
+    FrameWriterStats finish();
+
+private:
+    /**
+     * Writer thread: passes frames to the sink in order
+     */
+    void writerLoop();
+
+    std::vector<Image> buffers;
+    std::vector<char> ready;     // Buffer holds a rendered frame waiting to be written
+    Sink sink;
+    int nextFrame;               // Next frame to be written
+    bool stopping;
+    bool sinkFailed;
+    FrameWriterStats stats;
+
+    std::mutex mutex;
+    std::condition_variable frameReady;
+    std::condition_variable bufferFree;
+    std::thread writer;
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <vector>
 #include <string>
 
@@ -53,6 +54,15 @@ public:
      */
     Image(unsigned char* data, int width, int height, int channels);
 
+    /**
+     * Resize and clear the image, reusing its pixel storage when large enough
+     *
+     * @param width New width in pixels
+     * @param height New height in pixels
+     * @param background Color every pixel is set to
+     */
+    void reset(int width, int height, const Color& background);
+
     /**
      * Set color of a specific pixel
      *
@@ -71,6 +81,22 @@ public:
      */
     Color getPixel(int x, int y) const;
 
+    /**
+     * Direct access to a row of pixels (no bounds checking)
+     *
+     * @param y Row index, must be inside the image
+     * @return Pointer to the first pixel of the row
+     */
+    Color* rowData(int y);
+
+    /**
+     * Direct read-only access to a row of pixels (no bounds checking)
+     *
+     * @param y Row index, must be inside the image
+     * @return Pointer to the first pixel of the row
+     */
+    const Color* rowData(int y) const;
+
     /**
      * Draw a line between two points
      *
@@ -95,38 +121,14 @@ public:
      */
     void fillTriangle(int x1, int y1, int x2, int y2, int x3, int y3, const Color& color);
 
-    /**
-     * Helper method for triangle filling (flat bottom case)
-     *
-     * @param x1 First point X coordinate
-     * @param y1 First point Y coordinate
-     * @param x2 Second point X coordinate
-     * @param y2 Second point Y coordinate
-     * @param x3 Third point X coordinate
-     * @param y3 Third point Y coordinate
-     * @param color Fill color
-     */
-    void fillFlatBottomTriangle(int x1, int y1, int x2, int y2, int x3, int y3, const Color& color);
-
-    /**
-     * Helper method for triangle filling (flat top case)
-     *
-     * @param x1 First point X coordinate
-     * @param y1 First point Y coordinate
-     * @param x2 Second point X coordinate
-     * @param y2 Second point Y coordinate
-     * @param x3 Third point X coordinate
-     * @param y3 Third point Y coordinate
-     * @param color Fill color
-     */
-    void fillFlatTopTriangle(int x1, int y1, int x2, int y2, int x3, int y3, const Color& color);
-
     /**
      * Save image as PPM (P6 format)
+     * The header and the whole pixel buffer are each written in one call
      *
      * @param filename Output filename
+     * @return true if the file was written completely
      */
-    void saveAsPPM(const std::string& filename) const;
+    bool saveAsPPM(const std::string& filename) const;
 
     /**
      * Get image width
@@ -143,6 +145,16 @@ public:
     int getHeight() const;
 };
 
+/**
+ * Fill a run of pixels with one color, with the kernel for the active kernel
+ * level (see KernelIsa)
+ *
+ * @param out First pixel of the run
+ * @param count Number of pixels
+ * @param color Fill color
+ */
+void fillPixels(Color* out, size_t count, const Color& color);
+
 /**
  * Load image using stb_image (PNG, JPG, etc.)
  *
@@ -4,9 +4,12 @@
 #include <iostream>
 #include <sstream>
 #include <memory>
+#include <mutex>
+#include <atomic>
 
 /**
  * Logger class to handle all logging operations using a singleton pattern
+ * Safe to use from several threads; each message is written as one line
  */
 class Logger {
 public:
@@ -160,7 +163,8 @@ private:
      */
     std::string levelToString(LogLevel level);
 
-    LogLevel currentLevel;
+    std::atomic<LogLevel> currentLevel;
+    std::mutex outputMutex;  // Keeps lines from concurrent threads from interleaving
 };
 
 // Macro for easy logging using temporary objects
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Memory mapping of a whole file
+ *
+ * Pages are faulted in on first touch, so parsers can stream through files of
+ * any size and binary formats can be used in place without copying them into a
+ * buffer first. Files are mapped read-only, or created at a fixed size and
+ * mapped for writing.
+ */
+class MappedFile {
+public:
+    /**
+     * How a read-only mapping will be used, passed on to the kernel
+     */
+    enum class Access {
+        Sequential,  // Read front to back once, as parsers do
+        Resident     // Used in place for the life of the mapping; paged in ahead of use
+    };
+
+    /**
+     * Default constructor - nothing mapped
+     */
+    MappedFile();
+
+    /**
+     * Destructor - unmaps the file if still open
+     */
+    ~MappedFile();
+
+    // The mapping owns operating system handles
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * Map a file read-only
+     *
+     * @param filename File to map
+     * @param access How the contents will be read
+     * @return true if the file was opened (an empty file maps to zero bytes)
+     */
+    bool open(const std::string& filename, Access access = Access::Sequential);
+
+    /**
+     * Create (or truncate) a file of the given size and map it for writing
+     *
+     * Writes reach the file through the page cache; they are complete once the
+     * mapping is closed.
+     *
+     * @param filename File to create
+     * @param size Size in bytes (greater than zero)
+     * @return true if the file was created and mapped
+     */
+    bool create(const std::string& filename, size_t size);
+
+    /**
+     * Unmap the file
+     */
+    void close();
+
+    /**
+     * Check if a file is mapped
+     *
+     * @return true between a successful open() and close()
+     */
+    bool isOpen() const;
+
+    /**
+     * Get the file contents
+     *
+     * @return Pointer to the first byte (null for an empty file)
+     */
+    const char* data() const;
+
+    /**
+     * Get the contents of a mapping made by create()
+     *
+     * @return Pointer to the first byte, or null for a read-only mapping
+     */
+    char* writableData();
+
+    /**
+     * Get the file size
+     *
+     * @return Size in bytes
+     */
+    size_t size() const;
+
+private:
+    const char* mapping;
+    size_t length;
+    bool opened;
+    bool writable;
+#if defined(_WIN32)
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
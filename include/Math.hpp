@@ -2,6 +2,7 @@
 
 #include <cmath>
 #include <vector>
+#include "VertexKernels.hpp"
 
 /**
  * 2D Point/Vector representation
@@ -145,6 +146,13 @@ public:
      * @return Transformed vector
      */
     Vec3 transform(const Vec3& v) const;
+
+    /**
+     * Inverse of an affine matrix (bottom row 0, 0, 0, 1)
+     *
+     * @return Inverse matrix (identity if the linear part is singular)
+     */
+    Mat4x4 inverseAffine() const;
 };
 
 /**
@@ -182,6 +190,47 @@ Mat4x4 rotateZ(double angle);
  */
 Vec2 projectPoint(const Vec3& p, double d, double cx, double cy);
 
+/**
+ * Perspective projection as a 4x4 matrix, for use with transformAndProject
+ *
+ * Maps a camera-space point to (d x + cx z, d y + cy z, z, z), so after the divide
+ * by w = z it lands where projectPoint puts it.
+ *
+ * @param d Distance to projection plane
+ * @param cx X coordinate of center point
+ * @param cy Y coordinate of center point
+ * @return Projection matrix
+ */
+Mat4x4 perspectiveProjection(double d, double cx, double cy);
+
+/**
+ * Transform and project a batch of points in one pass
+ *
+ * Fuses the model transform, translation and perspective divide: pass
+ * perspectiveProjection(...) * model as the transform. Point i becomes
+ * (X / W, Y / W) with depth W, where (X, Y, Z, W) = transform * (x, y, z, 1).
+ * Nothing is checked per point; points with W <= 0 are behind the eye and their
+ * screen position is meaningless, which the caller can tell from the depth.
+ * Runs the AVX2 kernel when the CPU has it (4 points per iteration); results
+ * are identical on every path.
+ *
+ * @param transform Combined model-view-projection matrix
+ * @param in Input points
+ * @param out Output arrays, each with room for count values
+ * @param count Number of points
+ */
+void transformAndProject(const Mat4x4& transform, const PointsSoA& in, const ScreenPointsSoA& out, size_t count);
+
+/**
+ * Single-precision transformAndProject (8 points per iteration with AVX2)
+ *
+ * @param transform Combined model-view-projection matrix (rounded to float)
+ * @param in Input points
+ * @param out Output arrays, each with room for count values
+ * @param count Number of points
+ */
+void transformAndProject(const Mat4x4& transform, const PointsSoAf& in, const ScreenPointsSoAf& out, size_t count);
+
 /**
  * Compute homography matrix from four point correspondences
  *
@@ -191,6 +240,49 @@ Vec2 projectPoint(const Vec3& p, double d, double cx, double cy);
  */
 Mat3x3 computeHomography(const std::vector<Vec2>& src, const std::vector<Vec2>& dst);
 
+/**
+ * Compute homography matrix from four point correspondences without allocating
+ *
+ * @param src Four source points in 2D
+ * @param dst Four destination points in 2D
+ * @return Homography matrix (3x3)
+ */
+Mat3x3 computeHomography(const Vec2* src, const Vec2* dst);
+
+/**
+ * Closed-form projective mapping from a quadrilateral onto the unit square
+ *
+ * quad[0..3] map to (0,0), (1,0), (1,1), (0,1). The square-to-quad mapping is
+ * written down directly (Heckbert's construction, normalized so m[2][2] = 1) and
+ * inverted through its adjugate, so no linear solver is involved and nothing is
+ * logged. Quads that are degenerate, self-intersecting or not convex, where the
+ * mapping would flip sign inside the quad, are rejected.
+ *
+ * @param quad Four corners of the quadrilateral
+ * @param mapping Receives the mapping from quad to unit square coordinates
+ * @return true if the quad has a valid mapping
+ */
+bool quadToSquare(const Vec2* quad, Mat3x3& mapping);
+
+/**
+ * Projective mapping from the screen onto the unit square for a camera-space parallelogram
+ *
+ * Built from the face itself rather than its projected corners, so it stays valid
+ * when corners lie behind the camera and the face has been clipped. The third
+ * coordinate of the mapped point is 1/z, positive in front of the camera.
+ *
+ * @param origin Corner that maps to (0,0)
+ * @param edgeU Edge from origin to the corner that maps to (1,0)
+ * @param edgeV Edge from origin to the corner that maps to (0,1)
+ * @param d Distance to projection plane
+ * @param cx X coordinate of center point
+ * @param cy Y coordinate of center point
+ * @param mapping Receives the mapping from screen to unit square coordinates
+ * @return true if the plane of the face does not pass through the eye
+ */
+bool parallelogramToSquare(const Vec3& origin, const Vec3& edgeU, const Vec3& edgeV,
+    double d, double cx, double cy, Mat3x3& mapping);
+
 /**
  * Check if a point is inside a convex quadrilateral
  *
@@ -198,4 +290,14 @@ Mat3x3 computeHomography(const std::vector<Vec2>& src, const std::vector<Vec2>&
  * @param quad Vector of four points defining the quadrilateral
  * @return True if the point is inside the quadrilateral
  */
-bool isInsideQuad(const Vec2& p, const std::vector<Vec2>& quad);
\ No newline at end of file
+bool isInsideQuad(const Vec2& p, const std::vector<Vec2>& quad);
+
+/**
+ * Check if a point is inside a convex polygon of either winding
+ *
+ * @param p Point to check
+ * @param polygon Polygon vertices
+ * @param count Number of vertices
+ * @return True if the point is inside the polygon
+ */
+bool isInsideConvexPolygon(const Vec2& p, const Vec2* polygon, int count);
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Math.hpp"
+
+/**
+ * Indexed triangle mesh with flat vertex and index buffers
+ *
+ * Vertex attributes are stored one array per component, so the whole position
+ * buffer goes through transformAndProject in one batch. Triangles are wound so
+ * that (b - a) x (c - a) points out of the surface, like the faces of Cube.
+ * Every triangle carries a material id; the renderer colors triangles by
+ * material and maps the decal texture onto the triangles of one material.
+ */
+class Mesh {
+public:
+    std::vector<float> x, y, z;                // Vertex positions
+    std::vector<float> u, v;                   // Texture coordinates, (0,0) top-left to (1,1) bottom-right; empty if the mesh has none
+    std::vector<uint32_t> indices;             // Three vertex indices per triangle
+    std::vector<uint16_t> materials;           // Material id of each triangle
+    std::vector<std::string> materialNames;    // Name of each material id
+    std::vector<Vec3> normals;                 // Unit outward normal of each triangle (zero if degenerate)
+    double boundingRadius;                     // Radius of the sphere around the origin holding every vertex
+
+    /**
+     * Default constructor creates an empty mesh
+     */
+    Mesh();
+
+    /**
+     * Number of vertices
+     *
+     * @return Vertex count
+     */
+    size_t vertexCount() const;
+
+    /**
+     * Number of triangles
+     *
+     * @return Triangle count
+     */
+    size_t triangleCount() const;
+
+    /**
+     * Check if the vertices carry texture coordinates
+     *
+     * @return true if u and v hold one value per vertex
+     */
+    bool hasTexCoords() const;
+
+    /**
+     * View of the position buffers for the batch vertex kernels
+     *
+     * @return Position arrays
+     */
+    PointsSoAf positions() const;
+
+    /**
+     * Get the position of a vertex
+     *
+     * @param index Vertex index
+     * @return Position in object space
+     */
+    Vec3 position(uint32_t index) const;
+
+    /**
+     * Look up a material by name
+     *
+     * @param name Material name
+     * @return Material id, or -1 if the mesh has no such material
+     */
+    int findMaterial(const std::string& name) const;
+
+    /**
+     * Recompute triangle normals and the bounding radius from the vertices
+     * Call after changing positions or indices.
+     */
+    void computeGeometry();
+
+    /**
+     * Center the mesh on its bounding box and scale it to a bounding radius
+     *
+     * @param radius Bounding sphere radius around the origin after fitting
+     */
+    void fitToRadius(double radius);
+};
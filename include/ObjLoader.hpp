@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include "Mesh.hpp"
+
+/**
+ * Load a Wavefront OBJ file into a mesh
+ *
+ * The file is memory-mapped and parsed in a single streaming pass: v, vt, f and
+ * usemtl lines are read, everything else (normals, groups, smoothing, material
+ * libraries) is skipped. Polygons are split into triangle fans, and every distinct
+ * position/texture-coordinate pair becomes one mesh vertex. OBJ's y-up axes, with
+ * +z towards the viewer, are turned half a turn around x into the renderer's
+ * y-down, z-forward camera axes, which keeps counter-clockwise faces outward
+ * facing; texture v is flipped to run top to bottom.
+ *
+ * @param filename OBJ file to load
+ * @param mesh Receives the mesh (normals and bounding radius computed)
+ * @return true if the file was parsed; on failure the error is logged
+ */
+bool loadObjMesh(const std::string& filename, Mesh& mesh);
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Mip-mapped texture kept on disk in fixed-size pages and read into memory on demand
+ *
+ * Every level is cut into PAGE_SIZE x PAGE_SIZE texel pages. Each page also holds
+ * the first column and row of its right and bottom neighbours (the edge texels
+ * repeated past the last page), so every bilinear footprint lies inside one page.
+ * Samplers pin the pages a run of pixels reads, fetch from them and unpin them;
+ * unpinned pages stay resident in least recently used order until the memory
+ * budget is needed for others. Memory use is therefore the budget plus the
+ * pages pinned at any one moment, whatever the size of the texture.
+ *
+ * Page files are written once by convert(). Levels and texels are bit-identical
+ * to the mip chain Texture builds, so paged and resident sampling give the same
+ * pixels. All methods may be called from any thread.
+ */
+class PagedTexture {
+public:
+    static const int PAGE_SHIFT = 7;
+    static const int PAGE_SIZE = 1 << PAGE_SHIFT;
+    static const int PAGE_ROWS = PAGE_SIZE + 1;      // Texel rows per page, the bottom neighbour's included
+    static const int PAGE_STRIDE = PAGE_SIZE + 4;    // Texels per page row, rounded up to 16 bytes
+    static const size_t PAGE_BYTES = static_cast<size_t>(PAGE_STRIDE) * PAGE_ROWS * sizeof(uint32_t);
+
+    /**
+     * Size of one mip level and where its pages are
+     */
+    struct Level {
+        int width, height;    // Level size in texels
+        int pagesX, pagesY;   // Pages per row and per column
+        uint32_t firstPage;   // Id of page (0, 0); pages follow row by row
+    };
+
+    /**
+     * Page cache counters
+     */
+    struct Stats {
+        long long faults = 0;           // Pages read from the page file
+        long long evictions = 0;        // Resident pages dropped to make room
+        size_t residentBytes = 0;       // Page memory currently allocated
+        size_t peakResidentBytes = 0;   // Largest residentBytes so far
+    };
+
+    /**
+     * Default constructor - nothing open
+     */
+    PagedTexture();
+
+    /**
+     * Destructor - closes the page file and frees the resident pages
+     */
+    ~PagedTexture();
+
+    // Owns the page file and the resident pages
+    PagedTexture(const PagedTexture&) = delete;
+    PagedTexture& operator=(const PagedTexture&) = delete;
+
+    /**
+     * Write the page file of an image file
+     *
+     * Binary PPM (P6) sources are streamed a row at a time, so converting them
+     * needs memory for a band of PAGE_ROWS rows per level whatever their size.
+     * Other formats are decoded whole by stb_image first.
+     *
+     * @param source Image file (PPM, PNG, JPG, etc.)
+     * @param pageFile Page file to write
+     * @return true if the page file was written
+     */
+    static bool convert(const std::string& source, const std::string& pageFile);
+
+    /**
+     * Write the page file of packed RGBA32 rows
+     *
+     * @param rgba Row-major 0xAABBGGRR texels, width per row
+     * @param width Width in texels
+     * @param height Height in texels
+     * @param pageFile Page file to write
+     * @return true if the page file was written
+     */
+    static bool convert(const uint32_t* rgba, int width, int height, const std::string& pageFile);
+
+    /**
+     * Open a page file; no pages are read until they are pinned
+     *
+     * @param pageFile Page file written by convert()
+     * @param budgetBytes Memory kept for unpinned resident pages (at least one page is kept)
+     * @return true if the file is a valid page file
+     */
+    bool open(const std::string& pageFile, uint64_t budgetBytes);
+
+    /**
+     * Get texture width
+     *
+     * @return Width in texels
+     */
+    int getWidth() const;
+
+    /**
+     * Get texture height
+     *
+     * @return Height in texels
+     */
+    int getHeight() const;
+
+    /**
+     * Get the number of mip levels
+     *
+     * @return Level count, down to 1x1
+     */
+    int getLevelCount() const;
+
+    /**
+     * Get the geometry of a mip level
+     *
+     * @param level Level index (0 is the full-resolution texture)
+     * @return Level geometry
+     */
+    const Level& getLevel(int level) const;
+
+    /**
+     * Id of the page holding a texel
+     *
+     * Texels one past the right or bottom edge belong to the last page, whose
+     * extra column and row replicate the edge.
+     *
+     * @param level Level index
+     * @param x X coordinate (0 to the level width)
+     * @param y Y coordinate (0 to the level height)
+     * @return Page id
+     */
+    uint32_t pageId(int level, int x, int y) const {
+        const Level& info = levels[level];
+        const int px = std::min(x >> PAGE_SHIFT, info.pagesX - 1);
+        const int py = std::min(y >> PAGE_SHIFT, info.pagesY - 1);
+        return info.firstPage + static_cast<uint32_t>(py * info.pagesX + px);
+    }
+
+    /**
+     * Address of a texel in its resident page
+     *
+     * @param level Level index
+     * @param x X coordinate (0 to the level width)
+     * @param y Y coordinate (0 to the level height)
+     * @return Pointer to the texel; (x + 1, y) and (x, y + 1) follow at +1 and +PAGE_STRIDE
+     *         when x and y lie inside the level. Only valid while the page is pinned.
+     */
+    const uint32_t* texelAddress(int level, int x, int y) const {
+        const Level& info = levels[level];
+        const int px = std::min(x >> PAGE_SHIFT, info.pagesX - 1);
+        const int py = std::min(y >> PAGE_SHIFT, info.pagesY - 1);
+        const uint32_t id = info.firstPage + static_cast<uint32_t>(py * info.pagesX + px);
+        return residentPages[id] + (y - (py << PAGE_SHIFT)) * PAGE_STRIDE + (x - (px << PAGE_SHIFT));
+    }
+
+    /**
+     * Make pages resident and keep them so until unpinned, reading missing pages
+     * from the page file and evicting the least recently used unpinned ones
+     *
+     * @param ids Page ids (without repeats)
+     * @param count Number of ids
+     */
+    void pin(const uint32_t* ids, int count);
+
+    /**
+     * Release pages pinned by pin()
+     *
+     * @param ids Page ids passed to pin()
+     * @param count Number of ids
+     */
+    void unpin(const uint32_t* ids, int count);
+
+    /**
+     * Read one texel, pinning its page for the duration
+     *
+     * @param level Level index
+     * @param x X coordinate inside the level
+     * @param y Y coordinate inside the level
+     * @return Packed texel
+     */
+    uint32_t texel(int level, int x, int y);
+
+    /**
+     * Get the page cache counters
+     *
+     * @return Counters so far
+     */
+    Stats getStats() const;
+
+private:
+    /**
+     * Memory holding one resident page
+     */
+    struct Slot {
+        std::unique_ptr<uint32_t[]> texels;
+        uint32_t page;     // Page held by the slot
+        int pins;          // Outstanding pin() calls; pinned slots are never reused
+        int older, newer;  // Neighbours in the list of unpinned slots, -1 at the ends
+    };
+
+    int width, height;
+    std::vector<Level> levels;
+    uint64_t dataOffset;                        // File offset of page 0
+    std::vector<const uint32_t*> residentPages; // Texels of each page, or null when not resident
+    std::vector<int> pageSlots;                 // Slot of each resident page, or -1
+    std::vector<Slot> slots;
+    std::vector<int> freeSlots;                 // Slots whose memory was released
+    size_t slotBudget;                          // Slots kept allocated when unpinned
+    size_t allocatedSlots;
+    int oldest, newest;                         // Ends of the list of unpinned slots
+    std::ifstream file;
+    mutable std::mutex mutex;
+    Stats stats;
+
+    /**
+     * Find memory for a page about to be read: a released slot, a new slot within
+     * the budget, the least recently used unpinned slot, or a new slot over the
+     * budget when every slot is pinned. Called with the mutex held.
+     *
+     * @return Slot index
+     */
+    int takeSlot();
+
+    /**
+     * Remove a slot from the list of unpinned slots. Called with the mutex held.
+     *
+     * @param slot Slot index
+     */
+    void unlinkSlot(int slot);
+
+    /**
+     * Release a slot's memory, dropping its page. Called with the mutex held.
+     *
+     * @param slot Slot index
+     */
+    void releaseSlot(int slot);
+};
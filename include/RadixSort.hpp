@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Key that orders doubles as unsigned integers, rounded to single precision
+ *
+ * @param value Finite value
+ * @return Key with key(a) < key(b) whenever float(a) < float(b)
+ */
+uint32_t orderedFloatKey(double value);
+
+/**
+ * Stable LSD radix sort of (key, value) pairs by ascending key
+ *
+ * Four 8-bit passes, skipping any pass whose digit is the same for every key.
+ * Every vector keeps its own storage, so once they have grown to the largest
+ * input, sorts do not allocate.
+ *
+ * @param keys Keys to sort (sorted on return)
+ * @param values Payload moved along with each key
+ * @param scratchKeys Scratch storage, resized as needed
+ * @param scratchValues Scratch storage, resized as needed
+ */
+void radixSortPairs(std::vector<uint32_t>& keys, std::vector<uint32_t>& values,
+    std::vector<uint32_t>& scratchKeys, std::vector<uint32_t>& scratchValues);
@@ -0,0 +1,477 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <type_traits>
+#include "Math.hpp"
+#include "Image.hpp"
+
+/**
+ * Inclusive integer pixel rectangle
+ */
+class RasterRect {
+public:
+    int minX, minY, maxX, maxY;
+
+    /**
+     * Constructor for creating a rectangle (defaults to an empty rectangle)
+     *
+     * @param minX Leftmost column
+     * @param minY Topmost row
+     * @param maxX Rightmost column (inclusive)
+     * @param maxY Bottom row (inclusive)
+     */
+    RasterRect(int minX = 0, int minY = 0, int maxX = -1, int maxY = -1);
+
+    /**
+     * Check if the rectangle covers no pixels
+     *
+     * @return True if the rectangle is empty
+     */
+    bool isEmpty() const;
+
+    /**
+     * Intersect with another rectangle
+     *
+     * @param other Rectangle to intersect with
+     * @return The overlapping rectangle (possibly empty)
+     */
+    RasterRect intersect(const RasterRect& other) const;
+};
+
+/**
+ * Half-space rasterizer for convex polygons
+ *
+ * Vertices are snapped to fixed point with SUBPIXEL_BITS of subpixel precision and
+ * pixels are sampled at integer coordinates. Each edge becomes an integer edge
+ * function that is stepped incrementally; ties on an edge are resolved with the
+ * top-left rule, so polygons sharing an edge never overlap or leave cracks.
+ *
+ * The bounding box is walked in BLOCK_SIZE x BLOCK_SIZE blocks. Blocks entirely
+ * outside one edge are skipped, blocks entirely inside every edge are emitted
+ * without any per-pixel test, and only blocks straddling an edge test pixels.
+ * Covered pixels are handed to a shader as horizontal spans: any type with
+ * a method void span(int y, int x0, int x1) (x1 inclusive).
+ *
+ * For multisampling, rasterizeCoverage tests COVERAGE_SAMPLES points of every
+ * pixel of the blocks straddling an edge instead of its center, in the rotated
+ * grid of SAMPLE_X and SAMPLE_Y. The offsets are whole subpixels, so each edge
+ * function moves by an exact integer to a sample and polygons sharing an edge
+ * still split every sample between them.
+ */
+class Rasterizer {
+public:
+    static const int SUBPIXEL_BITS = 4;
+    static const int BLOCK_SIZE = 8;
+    static const int MAX_VERTICES = 12;
+    static const int COVERAGE_SAMPLES = 4;
+    static const unsigned FULL_COVERAGE = (1u << COVERAGE_SAMPLES) - 1;
+
+    // Coverage sample positions relative to the pixel center, in subpixels;
+    // sample k is bit k of a coverage mask
+    static const int SAMPLE_X[COVERAGE_SAMPLES];
+    static const int SAMPLE_Y[COVERAGE_SAMPLES];
+
+    /**
+     * Set up edge functions for a convex polygon (either winding)
+     *
+     * @param vertices Polygon vertices in screen space
+     * @param count Number of vertices (3 to MAX_VERTICES)
+     */
+    Rasterizer(const Vec2* vertices, int count);
+
+    /**
+     * Check if the polygon covers no area
+     *
+     * @return True if nothing would be rasterized
+     */
+    bool isEmpty() const;
+
+    /**
+     * Get the pixel bounding box of the polygon
+     *
+     * @return Bounding box (unclipped)
+     */
+    const RasterRect& getBounds() const;
+
+    /**
+     * Rasterize the polygon inside a clip rectangle
+     *
+     * @param clip Pixels outside this rectangle are never emitted
+     * @param shader Receives the covered spans row by row
+     */
+    template<typename Shader>
+    void rasterize(const RasterRect& clip, Shader& shader) const;
+
+    /**
+     * Rasterize the polygon, skipping the blocks a test reports as hidden
+     *
+     * Each block the polygon touches is offered to blockVisible(x0, y0, x1, y1)
+     * with its clipped pixel rectangle before any of its edges are stepped; blocks
+     * for which it returns false emit nothing.
+     *
+     * @param clip Pixels outside this rectangle are never emitted
+     * @param shader Receives the covered spans row by row
+     * @param blockVisible Returns false for blocks that need not be drawn
+     */
+    template<typename Shader, typename BlockTest>
+    void rasterize(const RasterRect& clip, Shader& shader, BlockTest& blockVisible) const;
+
+    /**
+     * Get the bounding box of the pixels with at least one coverage sample inside
+     *
+     * @return Bounding box (unclipped), at least as large as getBounds()
+     */
+    const RasterRect& getCoverageBounds() const;
+
+    /**
+     * Rasterize the polygon's coverage samples, skipping the blocks a test reports as hidden
+     *
+     * Runs of pixels with every sample covered go to shader.span(y, x0, x1) as in
+     * rasterize; each pixel with only some samples covered goes on its own to
+     * shader.partial(y, x, mask), mask holding a bit per covered sample.
+     *
+     * @param clip Pixels outside this rectangle are never emitted
+     * @param shader Receives the fully covered spans and the partially covered pixels
+     * @param blockVisible Returns false for blocks that need not be drawn
+     */
+    template<typename Shader, typename BlockTest>
+    void rasterizeCoverage(const RasterRect& clip, Shader& shader, BlockTest& blockVisible) const;
+
+private:
+    /**
+     * Edge function E(x, y) = a * x + b * y + c; a pixel is inside when E >= 0
+     */
+    struct Edge {
+        int64_t a, b, c;
+    };
+
+    Edge edges[MAX_VERTICES];
+    int edgeCount;
+    RasterRect bounds;
+    RasterRect coverageBounds;
+
+    /**
+     * Block walk shared by rasterize and rasterizeCoverage
+     *
+     * @tparam Samples 1 to test pixel centers, COVERAGE_SAMPLES to test coverage samples
+     * @param area Clipped pixels to walk
+     * @param shader Receives the covered spans (and partial pixels when multisampling)
+     * @param blockVisible Returns false for blocks that need not be drawn
+     */
+    template<int Samples, typename Shader, typename BlockTest>
+    void walkBlocks(const RasterRect& area, Shader& shader, BlockTest& blockVisible) const;
+};
+
+/**
+ * Span shader that fills covered pixels with a solid color
+ */
+class SolidFill {
+public:
+    /**
+     * Constructor
+     *
+     * @param target Image to fill
+     * @param color Fill color
+     */
+    SolidFill(Image& target, const Color& color) : target(target), color(color) {}
+
+    void span(int y, int x0, int x1) {
+        fillPixels(target.rowData(y) + x0, static_cast<size_t>(x1 - x0 + 1), color);
+    }
+
+private:
+    Image& target;
+    Color color;
+};
+
+/**
+ * Draw a Bresenham line, writing only the pixels inside a clip rectangle
+ *
+ * The same pixels are produced whatever the clip rectangle, so a line drawn
+ * piecewise into adjacent clip rectangles matches the unclipped line. Lines
+ * missing the rectangle are rejected from their bounding box, and the rest are
+ * clipped parametrically (Liang-Barsky) before the walk starts mid-line, so the
+ * cost follows the visible length rather than the full length.
+ *
+ * @param target Image to draw into
+ * @param x0 Start X coordinate
+ * @param y0 Start Y coordinate
+ * @param x1 End X coordinate
+ * @param y1 End Y coordinate
+ * @param color Line color
+ * @param clip Pixels outside this rectangle are left untouched (must lie inside the image)
+ */
+void drawClippedLine(Image& target, int x0, int y0, int x1, int y1, const Color& color, const RasterRect& clip);
+
+/**
+ * Walk the pixels drawClippedLine would draw, handing each to a callback
+ *
+ * @param x0 Start X coordinate
+ * @param y0 Start Y coordinate
+ * @param x1 End X coordinate
+ * @param y1 End Y coordinate
+ * @param clip Only pixels inside this rectangle are visited
+ * @param plot Called as plot(x, y) for every visited pixel
+ */
+template<typename Plot>
+void walkClippedLine(int x0, int y0, int x1, int y1, const RasterRect& clip, Plot& plot);
+
+// Minor-axis steps a Bresenham walk has taken after `step` major-axis steps:
+// max(0, ceil((2 * step * minor - major) / (2 * major)))
+inline int64_t bresenhamMinorSteps(int64_t step, int64_t major, int64_t minor) {
+    int64_t numerator = 2 * step * minor - major;
+    if (numerator <= 0) {
+        return 0;
+    }
+    return (numerator + 2 * major - 1) / (2 * major);
+}
+
+// One Liang-Barsky boundary test, p * t <= q, narrowing [t0, t1]
+inline bool clipLineParameter(double p, double q, double& t0, double& t1) {
+    if (p == 0.0) {
+        return q >= 0.0;
+    }
+    double r = q / p;
+    if (p < 0.0) {
+        if (r > t1) return false;
+        t0 = std::max(t0, r);
+    }
+    else {
+        if (r < t0) return false;
+        t1 = std::min(t1, r);
+    }
+    return true;
+}
+
+template<typename Plot>
+void walkClippedLine(int x0, int y0, int x1, int y1, const RasterRect& clip, Plot& plot) {
+    // Skip lines whose bounding box misses the clip rectangle
+    if (std::max(x0, x1) < clip.minX || std::min(x0, x1) > clip.maxX ||
+        std::max(y0, y1) < clip.minY || std::min(y0, y1) > clip.maxY) {
+        return;
+    }
+
+    const int64_t dx = std::abs(static_cast<int64_t>(x1) - x0);
+    const int64_t dy = std::abs(static_cast<int64_t>(y1) - y0);
+    const int sx = (x0 < x1) ? 1 : -1;
+    const int sy = (y0 < y1) ? 1 : -1;
+    const int64_t major = std::max(dx, dy);
+    const int64_t minor = std::min(dx, dy);
+
+    // Parameter range of the ideal segment inside the clip rectangle widened by a
+    // pixel, which covers the half-pixel the walk may stray from the ideal line
+    double t0 = 0.0, t1 = 1.0;
+    const double ex = static_cast<double>(x1) - x0;
+    const double ey = static_cast<double>(y1) - y0;
+    if (!clipLineParameter(-ex, x0 - (clip.minX - 1.0), t0, t1) ||
+        !clipLineParameter(ex, (clip.maxX + 1.0) - x0, t0, t1) ||
+        !clipLineParameter(-ey, y0 - (clip.minY - 1.0), t0, t1) ||
+        !clipLineParameter(ey, (clip.maxY + 1.0) - y0, t0, t1)) {
+        return;
+    }
+    const int64_t first = std::max<int64_t>(0, static_cast<int64_t>(std::floor(t0 * major)) - 1);
+    const int64_t last = std::min<int64_t>(major, static_cast<int64_t>(std::ceil(t1 * major)) + 1);
+
+    // Bresenham's line algorithm, entered at the first step that can be visible
+    // with the state it would have reached walking from (x0, y0)
+    const int64_t minorSteps = bresenhamMinorSteps(first, major, minor);
+    const int64_t stepsX = (dx >= dy) ? first : minorSteps;
+    const int64_t stepsY = (dx >= dy) ? minorSteps : first;
+    int64_t x = x0 + sx * stepsX;
+    int64_t y = y0 + sy * stepsY;
+    int64_t err = dx - dy - stepsX * dy + stepsY * dx;
+
+    for (int64_t step = first; ; step++) {
+        if (x >= clip.minX && x <= clip.maxX && y >= clip.minY && y <= clip.maxY) {
+            plot(static_cast<int>(x), static_cast<int>(y));
+        }
+
+        if (step >= last) break;
+
+        int64_t e2 = 2 * err;
+        if (e2 > -dy) {
+            err -= dy;
+            x += sx;
+        }
+        if (e2 < dx) {
+            err += dx;
+            y += sy;
+        }
+    }
+}
+
+template<typename Shader>
+void Rasterizer::rasterize(const RasterRect& clip, Shader& shader) const {
+    auto everyBlock = [](int, int, int, int) { return true; };
+    rasterize(clip, shader, everyBlock);
+}
+
+// Hands a partially covered pixel to a coverage shader; center sampling never has one
+template<typename Shader>
+inline void emitPartialPixel(Shader& shader, int y, int x, unsigned mask, std::true_type) {
+    shader.partial(y, x, mask);
+}
+
+template<typename Shader>
+inline void emitPartialPixel(Shader&, int, int, unsigned, std::false_type) {
+}
+
+template<typename Shader, typename BlockTest>
+void Rasterizer::rasterize(const RasterRect& clip, Shader& shader, BlockTest& blockVisible) const {
+    walkBlocks<1>(bounds.intersect(clip), shader, blockVisible);
+}
+
+template<typename Shader, typename BlockTest>
+void Rasterizer::rasterizeCoverage(const RasterRect& clip, Shader& shader, BlockTest& blockVisible) const {
+    walkBlocks<COVERAGE_SAMPLES>(coverageBounds.intersect(clip), shader, blockVisible);
+}
+
+template<int Samples, typename Shader, typename BlockTest>
+void Rasterizer::walkBlocks(const RasterRect& area, Shader& shader, BlockTest& blockVisible) const {
+    if (edgeCount == 0 || area.isEmpty()) {
+        return;
+    }
+    const unsigned fullMask = (1u << Samples) - 1;
+
+    // Each edge function's step from a pixel center to its samples, and the
+    // extremes of those steps for the block tests
+    int64_t sampleStep[MAX_VERTICES][Samples];
+    int64_t lowStep[MAX_VERTICES];
+    int64_t highStep[MAX_VERTICES];
+    for (int i = 0; i < edgeCount; i++) {
+        lowStep[i] = 0;
+        highStep[i] = 0;
+        for (int k = 0; k < Samples && Samples > 1; k++) {
+            sampleStep[i][k] = (edges[i].a * SAMPLE_X[k] + edges[i].b * SAMPLE_Y[k]) >> SUBPIXEL_BITS;
+            lowStep[i] = std::min(lowStep[i], sampleStep[i][k]);
+            highStep[i] = std::max(highStep[i], sampleStep[i][k]);
+        }
+    }
+
+    // Blocks are aligned to the pixel grid so neighbouring clip rectangles share them
+    const int mask = ~(BLOCK_SIZE - 1);
+    const int firstBlockX = area.minX & mask;
+    const int firstBlockY = area.minY & mask;
+
+    // Open span per row of the current block row, merged across adjacent blocks
+    int spanStart[BLOCK_SIZE];
+    int spanEnd[BLOCK_SIZE];
+
+    for (int by = firstBlockY; by <= area.maxY; by += BLOCK_SIZE) {
+        const int y0 = std::max(by, area.minY);
+        const int y1 = std::min(by + BLOCK_SIZE - 1, area.maxY);
+        for (int r = 0; r < BLOCK_SIZE; r++) {
+            spanStart[r] = -1;
+        }
+
+        auto emit = [&](int y, int x0, int x1) {
+            int r = y - by;
+            if (spanStart[r] >= 0 && spanEnd[r] + 1 == x0) {
+                spanEnd[r] = x1;
+                return;
+            }
+            if (spanStart[r] >= 0) {
+                shader.span(y, spanStart[r], spanEnd[r]);
+            }
+            spanStart[r] = x0;
+            spanEnd[r] = x1;
+        };
+
+        for (int bx = firstBlockX; bx <= area.maxX; bx += BLOCK_SIZE) {
+            const int x0 = std::max(bx, area.minX);
+            const int x1 = std::min(bx + BLOCK_SIZE - 1, area.maxX);
+
+            // Trivial reject/accept from the extreme corners of the block for each edge
+            bool rejected = false;
+            bool fullyInside = true;
+            int64_t rowStart[MAX_VERTICES];
+            for (int i = 0; i < edgeCount; i++) {
+                const Edge& e = edges[i];
+                int64_t corner = e.a * x0 + e.b * y0 + e.c;
+                int64_t dx = e.a * (x1 - x0);
+                int64_t dy = e.b * (y1 - y0);
+                int64_t lowest = corner + std::min<int64_t>(dx, 0) + std::min<int64_t>(dy, 0) + lowStep[i];
+                int64_t highest = corner + std::max<int64_t>(dx, 0) + std::max<int64_t>(dy, 0) + highStep[i];
+                if (highest < 0) {
+                    rejected = true;
+                    break;
+                }
+                if (lowest < 0) {
+                    fullyInside = false;
+                }
+                rowStart[i] = corner;
+            }
+
+            if (rejected || !blockVisible(x0, y0, x1, y1)) {
+                continue;
+            }
+
+            if (fullyInside) {
+                for (int y = y0; y <= y1; y++) {
+                    emit(y, x0, x1);
+                }
+                continue;
+            }
+
+            // Partial block: step the edge functions pixel by pixel
+            for (int y = y0; y <= y1; y++) {
+                int64_t value[MAX_VERTICES];
+                for (int i = 0; i < edgeCount; i++) {
+                    value[i] = rowStart[i];
+                    rowStart[i] += edges[i].b;
+                }
+
+                int runStart = -1;
+                for (int x = x0; x <= x1; x++) {
+                    unsigned mask = fullMask;
+                    if (Samples == 1) {
+                        int64_t outside = 0;
+                        for (int i = 0; i < edgeCount; i++) {
+                            outside |= value[i];
+                            value[i] += edges[i].a;
+                        }
+                        mask = outside >= 0 ? fullMask : 0;
+                    }
+                    else {
+                        for (int i = 0; i < edgeCount; i++) {
+                            for (int k = 0; k < Samples; k++) {
+                                if (value[i] + sampleStep[i][k] < 0) {
+                                    mask &= ~(1u << k);
+                                }
+                            }
+                            value[i] += edges[i].a;
+                        }
+                    }
+
+                    if (mask == fullMask) {
+                        if (runStart < 0) {
+                            runStart = x;
+                        }
+                        continue;
+                    }
+                    if (runStart >= 0) {
+                        emit(y, runStart, x - 1);
+                        runStart = -1;
+                    }
+                    if (mask != 0) {
+                        emitPartialPixel(shader, y, x, mask, std::integral_constant<bool, (Samples > 1)>());
+                    }
+                }
+                if (runStart >= 0) {
+                    emit(y, runStart, x1);
+                }
+            }
+        }
+
+        // Flush the spans still open at the end of the block row
+        for (int y = y0; y <= y1; y++) {
+            int r = y - by;
+            if (spanStart[r] >= 0) {
+                shader.span(y, spanStart[r], spanEnd[r]);
+            }
+        }
+    }
+}
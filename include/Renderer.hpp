@@ -1,12 +1,49 @@
 #pragma once
 #include "Cube.hpp"
+#include "DepthBuffer.hpp"
+#include "Antialiasing.hpp"
 #include "Image.hpp"
 #include "Math.hpp"
+#include "Mesh.hpp"
+#include "Rasterizer.hpp"
+#include "Scene.hpp"
+#include "Texture.hpp"
+#include "TextureSampler.hpp"
+#include "ThreadPool.hpp"
 #include <vector>
 #include <array>
+#include <memory>
+#include <cstdint>
 
-// Forward declaration for ConfigManager
+// Forward declarations
 class ConfigManager;
+class ClipVolume;
+
+/**
+ * Strategy used to visit the pixels covered by a textured quad
+ */
+enum class TextureWalk {
+    Reference,  // Inside test and full homography multiply for every bounding box pixel
+    Scanline    // Rasterizer spans with incremental homography stepping
+};
+
+/**
+ * Counters accumulated by the renderer across frames
+ */
+struct RenderStats {
+    long long frames = 0;            // Frames rendered
+    long long texturedPixels = 0;    // Pixels written by the texture walk
+    long long clippedFaces = 0;      // Faces cut by the near plane or the guard band
+    long long culledFaces = 0;       // Faces entirely outside one clip plane
+    long long drawnInstances = 0;    // Cube instances inside the view frustum
+    long long culledInstances = 0;   // Cube instances whose bounding sphere is outside it
+    long long shadedPixels = 0;      // Face pixels filled or textured (overdraw included)
+    long long depthRejectedPixels = 0;  // Face pixels failing their own depth compare
+    long long blockRejectedPixels = 0;  // Face pixels rejected by a depth block's range, never compared
+    long long occludedBlocks = 0;       // Face blocks skipped whole, before rasterizing, as hidden
+    long long visibilityPixels = 0;     // Face pixels written to the visibility buffer (overdraw included)
+    double textureMs = 0.0;          // Time spent mapping textures onto faces
+};
 
 /**
  * Camera class for 3D to 2D projection
@@ -28,6 +65,12 @@ public:
      */
     Vec2 projectPoint(const Vec3& point) const;
 
+    /**
+     * Projects a point already clipped against the near plane, without the
+     * behind-the-camera guard
+     */
+    Vec2 projectClipped(const Vec3& point) const;
+
     // Getters/setters
     double getScale() const;
     void setScale(double s);
@@ -49,24 +92,344 @@ private:
     Color backgroundColor;
     ViewCamera camera;
     int decalFaceIndex;  // Which face gets the texture (0-5)
+    TextureWalk textureWalk;
+    TextureFilter textureFilter;  // Filter used by the scanline walk
+    TexturePrecision texturePrecision;  // Coordinate math of bilinear filtering
+    RenderStats stats;
 
     // Face colors (configurable)
     std::array<Color, 6> faceColors;
 
+    // Depth buffering (0 = faces drawn back to front without a depth buffer)
+    int depthBits;
+    DepthBuffer<uint16_t> depth16;
+    DepthBuffer<uint32_t> depth32;
+
+    // Visibility buffer mode: faces write their ids first, then each pixel is shaded once.
+    // Entries are 0 for the background or faceDraws index + 1, with VISIBILITY_OUTLINE
+    // set where the face's outline won. Under MSAA, pixels split between entries
+    // hold VISIBILITY_EDGE and the index of their CoverageSamples in the drawing
+    // worker's coverageSamples list.
+    static const uint32_t VISIBILITY_OUTLINE = 0x80000000u;
+    static const uint32_t VISIBILITY_EDGE = 0x40000000u;
+    bool visibilityBuffer;
+    std::vector<uint32_t> visibility;
+    std::vector<std::vector<CoverageSamples>> coverageSamples;  // Edge pixels of the tile each worker is drawing
+
+    // Antialiasing: faces are prepared, rasterized and depth-tested on a grid of
+    // samples (the pixels under MSAA), set up by beginFrame from the output size
+    // and the camera
+    Antialiasing antialiasing;
+    ViewCamera sampleCamera;   // Camera projecting onto the sample grid
+    int sampleWidth;           // Sample grid width (width times the samples per pixel along X)
+    int sampleHeight;          // Sample grid height
+    Image sampleImage;         // Shaded samples when supersampling
+
+    // Tiled rendering (tileSize 0 renders the whole frame in one pass)
+    int tileSize;
+    int tileThreads;
+    std::shared_ptr<ThreadPool> tilePool;
+
+    /**
+     * A visible face prepared for drawing: rasterizer setup plus fill or texture mapping
+     */
+    struct FaceDraw {
+        Vec2 vertices[Rasterizer::MAX_VERTICES];  // Screen-space polygon
+        int vertexCount;
+        unsigned outlineMask;        // Bit i set when edge i -> i+1 is drawn as outline
+        Rasterizer rasterizer;       // Edge setup for the polygon
+        Color color;                 // Fill color, or fallback color for textured faces
+        const Texture* texture;      // Texture to map, or null for a solid fill
+        Mat3x3 Hinv;                 // Inverse homography from screen to texture space
+        DepthPlane depthPlane;       // Closeness of the face over the screen, for depth testing
+
+        FaceDraw(const Vec2* vertices, int count, unsigned outlineMask, const Color& color);
+    };
+
+    /**
+     * Planar texture mapping in camera space: the point origin + s * edgeS + t * edgeT
+     * has texture coordinates uvOrigin + s * uvEdgeS + t * uvEdgeT
+     */
+    struct TexturePlane {
+        Vec3 origin, edgeS, edgeT;
+        Vec2 uvOrigin, uvEdgeS, uvEdgeT;
+    };
+
+    // Per-frame scratch, kept across frames so steady-state rendering does not allocate
+    std::vector<Vec3> transformedVertices;   // Current instance, camera space
+    std::vector<Vec2> projectedVertices;     // Current instance, screen space
+    std::vector<int> vertexOutcodes;         // Current instance, clip volume outcodes
+    std::vector<float> screenX;              // Current mesh, screen X of each vertex
+    std::vector<float> screenY;              // Current mesh, screen Y of each vertex
+    std::vector<float> screenDepth;          // Current mesh, camera-space depth of each vertex
+    std::vector<FaceDraw> faceDraws;         // Every visible face of the frame
+    std::vector<uint32_t> faceKeys;          // Back-to-front depth key of each entry of faceDraws
+    std::vector<uint32_t> drawOrder;         // faceDraws indices in drawing order
+    std::vector<uint32_t> sortScratchKeys;
+    std::vector<uint32_t> sortScratchOrder;
+    std::vector<std::vector<int>> tileBins;
+    std::vector<RenderStats> tileStats;
+
+    /**
+     * Prepares a face for drawing, computing the texture homography if needed
+     *
+     * Unclipped textured quads take the mapping from their four projected corners.
+     * Clipped faces no longer have those corners on screen, and triangles carry
+     * their own texture coordinates, so their mapping is built from a camera-space
+     * texture plane instead. Either way the screen to texture mapping is projective,
+     * so texture coordinates are interpolated perspective-correctly.
+     *
+     * @param vertices The projected vertices of the face
+     * @param depths Camera-space depth of each vertex
+     * @param count Number of vertices (textured faces without a plane need exactly 4)
+     * @param outlineMask Bit i set when edge i -> i+1 is part of the face outline
+     * @param color Face color (fallback color for textured faces)
+     * @param texture Texture to map onto the face, or null for a solid fill
+     * @param plane Camera-space texture plane of the face, or null to map the unit square onto its corners
+     * @return The prepared face (solid if the homography is invalid)
+     */
+    FaceDraw setupFace(const Vec2* vertices, const double* depths, int count, unsigned outlineMask,
+        const Color& color, const Texture* texture, const TexturePlane* plane) const;
+
+    /**
+     * Pixels a prepared face's fill, coverage samples or outline may touch
+     *
+     * @param face The prepared face
+     * @return Bounding rectangle (unclipped)
+     */
+    static RasterRect faceArea(const FaceDraw& face);
+
+    /**
+     * Draws a prepared face and its outline inside a clip rectangle
+     *
+     * @param targetImage The image to draw into
+     * @param face The prepared face
+     * @param clip Only pixels inside this rectangle are touched
+     * @param frameStats Counters to update
+     */
+    void drawFace(Image& targetImage, const FaceDraw& face, const RasterRect& clip, RenderStats& frameStats);
+
+    /**
+     * Draws a prepared face and its outline through a depth buffer
+     *
+     * Spans are depth-tested before they reach the fill or the texture sampler,
+     * so occluded pixels never fetch texels; textured faces always take the
+     * scanline walk. Outlines are tested with a one-pixel slope bias so they
+     * survive on the face they belong to.
+     *
+     * @param targetImage The image to draw into
+     * @param face The prepared face
+     * @param clip Only pixels inside this rectangle are touched
+     * @param depth Depth buffer of the frame
+     * @param frameStats Counters to update
+     */
+    template<typename T>
+    void drawFaceDepthTested(Image& targetImage, const FaceDraw& face, const RasterRect& clip,
+        DepthBuffer<T>& depth, RenderStats& frameStats);
+
+    /**
+     * Writes a prepared face's id and outline into the visibility buffer through a depth buffer
+     *
+     * The same pixels win as in drawFaceDepthTested, but nothing is shaded yet.
+     *
+     * Under MSAA the face's coverage samples are rasterized: pixels it covers
+     * only in part, or that already show other entries in some samples, take
+     * their entries sample by sample into edgePixels.
+     *
+     * @param faceIndex Index of the face in faceDraws
+     * @param clip Only pixels inside this rectangle are touched
+     * @param depth Depth buffer of the frame
+     * @param edgePixels Coverage samples of the clip rectangle's edge pixels
+     * @param frameStats Counters to update
+     */
+    template<typename T>
+    void drawFaceVisibility(uint32_t faceIndex, const RasterRect& clip, DepthBuffer<T>& depth,
+        std::vector<CoverageSamples>& edgePixels, RenderStats& frameStats);
+
+    /**
+     * Draws the faces of a frame or tile: straight into the target, or into the
+     * visibility buffer followed by a resolve of the clip rectangle. Supersampled
+     * frames are drawn into the sample image and box-filtered into the target.
+     *
+     * @param targetImage The image to draw into
+     * @param faces faceDraws indices in drawing order
+     * @param clip Samples to draw (pixels unless supersampling), aligned to the sample grid
+     * @param edgePixels Scratch list for the coverage samples of MSAA edge pixels
+     * @param frameStats Counters to update
+     */
+    template<typename Index>
+    void drawFaces(Image& targetImage, const std::vector<Index>& faces, const RasterRect& clip,
+        std::vector<CoverageSamples>& edgePixels, RenderStats& frameStats);
+
+    /**
+     * Writes the ids of faces into the visibility buffer, then resolves them into pixels
+     *
+     * @param samples The image of the sample grid (the output image unless supersampling)
+     * @param faces faceDraws indices in drawing order
+     * @param clip Samples to draw
+     * @param depth Depth buffer of the frame, which clears the visibility buffer with its blocks
+     * @param edgePixels Scratch list for the coverage samples of MSAA edge pixels
+     * @param frameStats Counters to update
+     */
+    template<typename Index, typename T>
+    void drawDeferred(Image& samples, const std::vector<Index>& faces, const RasterRect& clip,
+        DepthBuffer<T>& depth, std::vector<CoverageSamples>& edgePixels, RenderStats& frameStats);
+
+    /**
+     * Shades every pixel of a rectangle once from the visibility buffer
+     *
+     * Runs of pixels showing the same face are filled or handed to the texture
+     * sampler as one span; outline pixels are drawn white. MSAA edge pixels shade
+     * each entry their samples show once, at the pixel center, and weight it by
+     * its samples. Depth blocks nothing was drawn into are skipped.
+     *
+     * @param targetImage The image to draw into
+     * @param clip Pixels to resolve
+     * @param depth Depth buffer of the frame
+     * @param edgePixels Coverage samples the clip rectangle's edge pixels refer to
+     * @param frameStats Counters to update
+     */
+    template<typename T>
+    void resolveVisibility(Image& targetImage, const RasterRect& clip, const DepthBuffer<T>& depth,
+        const std::vector<CoverageSamples>& edgePixels, RenderStats& frameStats) const;
+
     /**
-     * Maps a texture onto a quadrilateral in the target image
+     * Colors of a run of pixels showing one visibility buffer entry
+     *
+     * @param out Receives x1 - x0 + 1 colors
+     * @param id Visibility buffer entry
+     * @param y Row
+     * @param x0 First pixel
+     * @param x1 Last pixel
+     * @param frameStats Counters to update
+     */
+    void shadeVisible(Color* out, uint32_t id, int y, int x0, int x1, RenderStats& frameStats) const;
+
+    /**
+     * Whether faces are drawn into the visibility buffer first (visibility buffer or MSAA)
+     */
+    bool deferredShading() const;
+
+    /**
+     * Whether every sample is shaded and box-filtered down (SSAA)
+     */
+    bool supersampled() const;
+
+    /**
+     * Sets up the sample grid and its camera for the next frame
+     */
+    void beginFrame();
+
+    /**
+     * Precision of the depth test in use: the configured depth buffer, or 32 bits
+     * when only the visibility buffer asks for depth testing
+     *
+     * @return 0 (faces sorted back to front), 16 or 32
+     */
+    int depthTestBits() const;
+
+    /**
+     * Sort key of a face: back to front without a depth buffer, front to back with one
+     *
+     * @param depth Camera-space depth of the face
+     * @return Key for sortFaces
+     */
+    uint32_t faceSortKey(double depth) const;
+
+    /**
+     * Draws prepared faces tile by tile, rasterizing tiles in parallel
+     *
+     * Faces are binned into tileSize x tileSize screen tiles; each tile draws its
+     * faces in order and writes only its own pixels, so the result matches drawing
+     * the faces over the whole frame.
+     *
+     * @param targetImage The image to draw into
+     */
+    void drawTiled(Image& targetImage);
+
+    /**
+     * Transforms, culls and clips one cube instance and appends its visible faces
+     * to faceDraws, with their depth keys
+     *
+     * Faces crossing the near plane or reaching beyond the guard band are clipped
+     * in camera space before projection, and faces entirely outside one of those
+     * planes are dropped, so no face costs more than one covering the screen.
+     *
+     * @param cube The cube geometry
+     * @param modelView Object to camera space transform
+     * @param decalFace Face that gets the decal texture, or -1
+     * @param colors Face colors
+     * @param decalTexture Optional texture for the decal face
+     * @param clipVolume Near plane and guard band
+     */
+    void prepareInstance(const Cube& cube, const Mat4x4& modelView, int decalFace,
+        const std::array<Color, 6>& colors, const Texture* decalTexture, const ClipVolume& clipVolume);
+
+    /**
+     * Projects, culls and clips the triangles of a mesh and appends the visible ones
+     * to faceDraws, with their depth keys
+     *
+     * Vertices are projected in one batch by the SoA vertex kernel and classified
+     * against the clip volume from their screen positions. Only triangles that
+     * need clipping or texturing transform their corners again in camera space.
+     * Solid triangles are flat shaded by the angle to the eye; triangles of the
+     * decal material are texture-mapped through their vertices' texture coordinates.
+     *
+     * @param mesh The mesh
+     * @param modelView Object to camera space transform
+     * @param decalMaterial Material id of the decal triangles, or -1
+     * @param decalTexture Optional texture for the decal triangles
+     * @param clipVolume Near plane and guard band
+     */
+    void prepareMesh(const Mesh& mesh, const Mat4x4& modelView, int decalMaterial, const Texture* decalTexture,
+        const ClipVolume& clipVolume);
+
+    /**
+     * Orders faceDraws into drawOrder with a radix sort on their depth keys
+     * Faces at the same depth keep the order they were prepared in.
+     */
+    void sortFaces();
+
+    /**
+     * Clears the target and draws the sorted faces over the whole frame or tile by tile
+     *
+     * @param target Image to render into (resized to the renderer's size if needed)
+     */
+    void drawFrame(Image& target);
+
+    /**
+     * Maps a face's texture onto its quadrilateral in the target image
      *
      * @param targetImage The image to draw the texture onto
-     * @param textureImage The texture image to map
-     * @param quadVertices The four vertices of the target quadrilateral
-     * @param fallbackColor Color to use if mapping fails
-     */
-    void mapTextureToQuad(
-        Image& targetImage,
-        const Image& textureImage,
-        const std::vector<Vec2>& quadVertices,
-        const Color& fallbackColor
-    );
+     * @param face The prepared textured face
+     * @param clip Only pixels inside this rectangle are touched
+     * @param frameStats Counters to update
+     */
+    void mapTextureToQuad(Image& targetImage, const FaceDraw& face, const RasterRect& clip, RenderStats& frameStats) const;
+
+    /**
+     * Reference texture walk: tests every pixel of the bounding box against the quad
+     * and applies the full inverse homography to each covered pixel
+     *
+     * @param targetImage The image to draw the texture onto
+     * @param face The prepared textured face
+     * @param clip Only pixels inside this rectangle are touched
+     * @return Number of pixels written
+     */
+    long long walkQuadReference(Image& targetImage, const FaceDraw& face, const RasterRect& clip) const;
+
+    /**
+     * Scanline texture walk: rasterizes the quad with the shared edge-function
+     * rasterizer and hands each span to the vectorized bilinear sampler, which
+     * evaluates (u*w, v*w, w) from per-span terms and the constant x-derivative
+     * of the inverse homography
+     *
+     * @param targetImage The image to draw the texture onto
+     * @param face The prepared textured face
+     * @param clip Only pixels inside this rectangle are touched
+     * @return Number of pixels written
+     */
+    long long walkQuadScanline(Image& targetImage, const FaceDraw& face, const RasterRect& clip) const;
 
 public:
     /**
@@ -92,18 +455,70 @@ public:
     void configure(const ConfigManager& config);
 
     /**
-     * Renders a single frame of the cube
+     * Renders a single frame of the cube into a caller-owned image
+     * Only touches this renderer's own state, so distinct Renderer instances may
+     * render concurrently from different threads. Scratch buffers and the target
+     * are reused, so once they have grown to the scene no heap allocation is made.
      *
+     * @param target Image to render into (resized to the renderer's size if needed)
      * @param cube The cube to render
      * @param angle Rotation angle (used for legacy compatibility)
-     * @param decalImage Optional texture for the specified face
+     * @param decalTexture Optional texture for the specified face
+     * @param rotationMatrix Optional custom rotation matrix (if null, uses angle)
+     */
+    void renderFrame(
+        Image& target,
+        const Cube& cube,
+        double angle,
+        const Texture* decalTexture = nullptr,
+        const Mat4x4* rotationMatrix = nullptr
+    );
+
+    /**
+     * Renders every instance of a scene into a caller-owned image
+     *
+     * Instances whose bounding sphere lies outside the view frustum are skipped
+     * before any of their vertices are transformed, so the cost of a frame follows
+     * the number of visible instances rather than the size of the scene. The
+     * visible faces of all instances are drawn back to front in one radix-sorted order.
+     *
+     * @param target Image to render into (resized to the renderer's size if needed)
+     * @param scene Instances to render
+     * @param view World to camera transform (rigid: rotation and translation only)
+     * @param decalTexture Optional texture for each instance's decal face
+     */
+    void renderFrame(Image& target, const Scene& scene, const Mat4x4& view, const Texture* decalTexture = nullptr);
+
+    /**
+     * Renders a triangle mesh into a caller-owned image
+     *
+     * The mesh is placed like the cube, 10 units in front of the camera. Material
+     * ids pick the face colors (modulo their count); the triangles of the decal
+     * material get the decal texture when the mesh has texture coordinates.
+     * Triangles are drawn back to front by their average depth.
+     *
+     * @param target Image to render into (resized to the renderer's size if needed)
+     * @param mesh The mesh to render
+     * @param rotation Object rotation
+     * @param decalMaterial Material id of the decal triangles, or -1 for none
+     * @param decalTexture Optional texture for the decal triangles
+     */
+    void renderFrame(Image& target, const Mesh& mesh, const Mat4x4& rotation, int decalMaterial,
+        const Texture* decalTexture = nullptr);
+
+    /**
+     * Renders a single frame of the cube into a new image
+     *
+     * @param cube The cube to render
+     * @param angle Rotation angle (used for legacy compatibility)
+     * @param decalTexture Optional texture for the specified face
      * @param rotationMatrix Optional custom rotation matrix (if null, uses angle)
      * @return The rendered image
      */
     Image renderFrame(
         const Cube& cube,
         double angle,
-        const Image* decalImage = nullptr,
+        const Texture* decalTexture = nullptr,
         const Mat4x4* rotationMatrix = nullptr
     );
 
@@ -116,6 +531,73 @@ public:
     void setDecalFaceIndex(int index);
     int getDecalFaceIndex() const;
 
+    void setTextureWalk(TextureWalk walk);
+    TextureWalk getTextureWalk() const;
+
+    void setTextureFilter(TextureFilter filter);
+    TextureFilter getTextureFilter() const;
+
+    void setTexturePrecision(TexturePrecision precision);
+    TexturePrecision getTexturePrecision() const;
+
+    const RenderStats& getStats() const;
+    void resetStats();
+
+    /**
+     * Configure depth buffering
+     *
+     * Without a depth buffer faces are drawn back to front, which is exact for one
+     * convex object only. With one, faces are drawn front to back and every pixel
+     * is depth-tested, with whole spans rejected early against per-block depth ranges.
+     *
+     * @param bits Depth precision: 0 (no depth buffer), 16 or 32
+     */
+    void setDepthBuffer(int bits);
+    int getDepthBits() const;
+
+    /**
+     * Configure visibility buffer (deferred) shading
+     *
+     * Faces are first rasterized, depth-tested, into a buffer of 32-bit face ids;
+     * a second pass then shades each pixel exactly once, so texture fetches follow
+     * the resolution rather than the depth complexity of the scene. Uses the
+     * configured depth buffer, or a 32-bit one when none is configured.
+     *
+     * @param enabled true for two-pass shading, false to shade faces as they are drawn
+     */
+    void setVisibilityBuffer(bool enabled);
+    bool getVisibilityBuffer() const;
+
+    /**
+     * Configure antialiasing
+     *
+     * SSAA renders every sample and box-filters them into the output. MSAA goes
+     * through the visibility buffer at the output resolution: the rasterizer
+     * tests four coverage samples only in blocks straddling a face edge, each
+     * pixel is depth-tested once, at its center, and each face is shaded once
+     * per pixel it shows in. Only edge pixels keep per-sample entries. Faces
+     * crossing each other inside a pixel are therefore not antialiased along the
+     * crossing. Outlines stay one sample wide (one pixel under MSAA). MSAA uses
+     * the configured depth buffer, or a 32-bit one when none is configured.
+     *
+     * @param mode Antialiasing mode
+     */
+    void setAntialiasing(Antialiasing mode);
+    Antialiasing getAntialiasing() const;
+
+    /**
+     * Configure tiled rendering
+     * Tiles are measured in samples of the antialiasing grid. Tile sizes are rounded
+     * up to a multiple of the depth buffer block size, so tiles rasterized in
+     * parallel never share a depth block, and each tile covers whole pixels.
+     *
+     * @param tileSize Tile edge length in pixels (0 disables tiling)
+     * @param threads Threads rasterizing tiles in parallel (0 = all hardware threads)
+     */
+    void setTiling(int tileSize, int threads);
+    int getTileSize() const;
+    int getTileThreads() const;
+
     ViewCamera& getCamera();
 
     int getWidth() const;
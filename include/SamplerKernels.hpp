@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstdint>
+
+class PagedTexture;
+
+// Plain data interface to the ISA-specific sampling kernels. The kernel sources are
+// compiled with per-file instruction set flags, so this header must stay free of
+// inline functions and standard library templates.
+
+// Tiled levels store 4x4 blocks of texels, one 64-byte cache line per block
+const int TEXTURE_TILE_SHIFT = 2;
+const int TEXTURE_TILE_SIZE = 1 << TEXTURE_TILE_SHIFT;
+
+// Largest half-size of an area filter box: 4097 x 4097 texels of 8-bit
+// channels still sum to less than 2^32
+const double MAX_AREA_EXTENT = 2048.0;
+
+// Mip chains of textures the vector kernels accept (under 32768 texels per side)
+const int MAX_VECTOR_LEVELS = 16;
+
+/**
+ * One level of an edge-padded mip chain
+ *
+ * Linear levels keep texel (x, y) at texels[y * stride + x]. Tiled levels keep
+ * it at texels[(y >> 2) * stride + ((y & 3) << 2) + ((x >> 2) << 4) + (x & 3)]
+ * (arithmetic shifts), so a bilinear footprint touches at most four cache lines
+ * whatever the direction of the walk.
+ */
+struct MipLevel {
+    const uint32_t* texels;     // Texel (0, 0) of the level
+    int stride;                 // Texels per padded row (linear) or per row of blocks (tiled)
+    int width, height;          // Level size in texels
+    bool tiled;                 // Block-tiled layout
+};
+
+/**
+ * One horizontal span of perspective-mapped bilinear texture samples
+ *
+ * Pixel x of the span samples the texture at (uw / w, vw / w) where
+ * uw = dUW * x + rowUW (likewise for v and w). Every kernel evaluates these terms
+ * per pixel and blends in the same 16.16 fixed point, so all kernels produce
+ * identical bytes and a pixel's value does not depend on where its span starts.
+ */
+struct TextureSpan {
+    const uint32_t* texels;     // Texel (0, 0) of an edge-padded 0xAABBGGRR texture
+    int stride;                 // Texels per padded row, or per row of blocks when tiled
+    int width, height;          // Texture size in texels
+    bool tiled;                 // Block-tiled layout (see MipLevel)
+    double rowUW, rowVW, rowW;  // Projective texture coordinates at x = 0 on this row
+    double dUW, dVW, dW;        // Their change per pixel along x
+    double dUWdy, dVWdy, dWdy;  // Their change per pixel along y (level selection)
+    const MipLevel* levels;     // Mip chain; levels[0] is the texture above
+    int levelCount;             // Number of mip levels
+    PagedTexture* pages;        // Paged texture to read instead of texels, or null (portable kernels only)
+    const uint32_t* summedArea; // Summed-area table of the base level (see sampleSpanArea), or null
+    int x0;                     // First pixel of the span
+    int count;                  // Number of pixels
+    uint32_t fallback;          // Packed color for samples outside the texture
+    unsigned char* out;         // Destination RGB bytes (3 per pixel)
+};
+
+/**
+ * Portable kernel, also used for the tail of every vector kernel
+ *
+ * @param span Span to sample
+ * @param first Index of the first pixel of the span to process
+ */
+void sampleSpanScalar(const TextureSpan& span, int first);
+
+/**
+ * Portable nearest-texel kernel on the base level
+ *
+ * @param span Span to sample
+ */
+void sampleSpanNearest(const TextureSpan& span);
+
+/**
+ * Portable trilinear kernel: picks a fractional mip level per pixel from the
+ * screen-space derivatives of the texture coordinates and blends bilinear
+ * samples of the two nearest levels. Also used for the tail of the vector
+ * trilinear kernels.
+ *
+ * @param span Span to sample
+ * @param first Index of the first pixel of the span to process
+ */
+void sampleSpanTrilinear(const TextureSpan& span, int first);
+
+/**
+ * Portable fixed-point bilinear kernel
+ *
+ * Only the fixed-point benchmark selects it: the segment walk is scalar, so while
+ * it beats the portable double kernel it is slower than the AVX2 and AVX-512
+ * ones, which divide 8 or 16 pixels at a time.
+ *
+ * Texture coordinates are exact (one double divide) at the start, middle and end
+ * of every 8 screen columns, counted from x = 0 so pixels do not depend on where
+ * their span starts. In between they follow the quadratic through those three
+ * points, stepped in 16.16 fixed point. Segments where that can be off by more
+ * than 2^-12 texel, judged from the span's w gradient, divide at every pixel, as
+ * do stepped pixels within 2^-11 texel of the texture's edge, so exactly the same
+ * pixels get the fallback color as in the double kernels. Blends use 8-bit
+ * weights and round their result to nearest. Every per-pixel operation is
+ * integer, so output does not change with the compiler or with -ffast-math;
+ * those can only move an exact coordinate by one 1/65536 step, or switch a
+ * segment or pixel between stepping and dividing, when a double lies within
+ * rounding of a threshold.
+ *
+ * Error bounds, per channel:
+ * - Coordinates: under 2^-12 texel of stepping error and 2^-15 of quantization.
+ * - Weights: rounding them to 1/256 adds at most 2^-9 texel, so each weight is
+ *   within 0.00223 of the exact one. A bilinear surface of 8-bit texels changes
+ *   by at most 255 per texel along either axis, so each axis moves a blend by
+ *   under 0.569.
+ * - Rounding adds at most 1/2, so a channel lies within 1.64 of the exact
+ *   bilinear value. The double kernels truncate, staying less than 1.01 below
+ *   it, so the two differ by at most 2.
+ * The axis term is reached next to a texel whose two neighbours differ from it
+ * by 255, as in a black and white checkerboard.
+ *
+ * @param span Span to sample
+ */
+void sampleSpanFixed(const TextureSpan& span);
+
+/**
+ * Portable area kernel: averages the base-level texels under the box that
+ * bounds each pixel's projected footprint, in constant time per pixel from a
+ * summed-area table. summedArea holds (width + 1) x (height + 1) entries of
+ * three 32-bit R, G, B sums; entry (x, y) sums the texels left of x and above y.
+ * Sums wrap modulo 2^32, which box differences undo as long as a box holds at
+ * most 2^32 / 255 texels. Magnified pixels are sampled bilinearly, and spans
+ * without a table fall back to trilinear filtering. Also used for the tail of
+ * the vector area kernels.
+ *
+ * @param span Span to sample
+ * @param first Index of the first pixel of the span to process
+ */
+void sampleSpanArea(const TextureSpan& span, int first);
+
+/**
+ * SSE4.1 kernel, 4 pixels per iteration
+ *
+ * @param span Span to sample (texture smaller than 32768 texels per side)
+ */
+void sampleSpanSSE41(const TextureSpan& span);
+
+/**
+ * AVX2 kernel, 8 pixels per iteration with hardware gathers
+ *
+ * @param span Span to sample (texture smaller than 32768 texels per side)
+ */
+void sampleSpanAVX2(const TextureSpan& span);
+
+/**
+ * AVX-512 kernel, 16 pixels per iteration with hardware gathers
+ *
+ * @param span Span to sample (texture smaller than 32768 texels per side)
+ */
+void sampleSpanAVX512(const TextureSpan& span);
+
+/**
+ * AVX2 trilinear kernel, 8 pixels per iteration with one masked gather per mip
+ * level present among them; bit-identical to sampleSpanTrilinear
+ *
+ * @param span Span to sample (texture smaller than 32768 texels per side)
+ */
+void sampleSpanTrilinearAVX2(const TextureSpan& span);
+
+/**
+ * AVX2 area kernel, 8 pixels per iteration gathering the box corners from the
+ * summed-area table; bit-identical to sampleSpanArea
+ *
+ * @param span Span to sample (texture smaller than 32768 texels per side)
+ */
+void sampleSpanAreaAVX2(const TextureSpan& span);
+
+/**
+ * AVX-512 trilinear kernel, 16 pixels per iteration (see sampleSpanTrilinearAVX2)
+ *
+ * @param span Span to sample (texture smaller than 32768 texels per side)
+ */
+void sampleSpanTrilinearAVX512(const TextureSpan& span);
+
+/**
+ * AVX-512 area kernel, 16 pixels per iteration (see sampleSpanAreaAVX2)
+ *
+ * @param span Span to sample (texture smaller than 32768 texels per side)
+ */
+void sampleSpanAreaAVX512(const TextureSpan& span);
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "Cube.hpp"
+#include "Image.hpp"
+#include "Math.hpp"
+
+/**
+ * Many instances of one cube, each with its own transform, decal face and colors
+ *
+ * Per-instance data lives in parallel contiguous arrays indexed by instance, so
+ * the renderer's culling pass walks transforms and bounding radii without
+ * touching colors or the mesh.
+ */
+class Scene {
+public:
+    Cube mesh;                                   // Geometry shared by every instance
+    std::vector<Mat4x4> transforms;              // Object to world transform of each instance
+    std::vector<double> boundingRadii;           // World-space bounding sphere radius around each instance's origin
+    std::vector<int> decalFaces;                 // Face showing the decal texture, or -1 for none
+    std::vector<std::array<Color, 6>> faceColors;  // Colors of each instance's faces
+
+    /**
+     * Constructor
+     *
+     * @param mesh Cube geometry drawn for every instance
+     */
+    Scene(const Cube& mesh = Cube());
+
+    /**
+     * Reserve room for a number of instances
+     *
+     * @param count Expected number of instances
+     */
+    void reserve(size_t count);
+
+    /**
+     * Add an instance
+     *
+     * @param transform Object to world transform (rotation, uniform or non-uniform scale, translation)
+     * @param decalFace Face showing the decal texture, or -1 for none
+     * @param colors Face colors
+     * @return Index of the new instance
+     */
+    size_t addInstance(const Mat4x4& transform, int decalFace, const std::array<Color, 6>& colors);
+
+    /**
+     * Replace the transform of an instance, updating its bounding sphere
+     *
+     * @param index Instance index
+     * @param transform New object to world transform
+     */
+    void setTransform(size_t index, const Mat4x4& transform);
+
+    /**
+     * Number of instances
+     *
+     * @return Instance count
+     */
+    size_t size() const;
+
+private:
+    /**
+     * World-space bounding radius of the mesh under a transform
+     *
+     * @param transform Object to world transform
+     * @return Radius scaled by the transform's largest axis scale
+     */
+    double boundingRadius(const Mat4x4& transform) const;
+};
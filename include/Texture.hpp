@@ -0,0 +1,337 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Image.hpp"
+#include "SamplerKernels.hpp"
+
+class MappedFile;
+class PagedTexture;
+
+/**
+ * Memory order of texels
+ */
+enum class TextureLayout {
+    Linear,  // Row-major padded rows
+    Tiled    // 4x4 blocks, one cache line each, so fetches cost the same in every direction
+};
+
+/**
+ * Texture stored as packed 32-bit texels with replicated edges
+ *
+ * Each texel is 0xAABBGGRR (R in the lowest byte). The image is surrounded by
+ * PADDING texels copied from the nearest edge, so bilinear footprints that hang
+ * over the last row or column can be fetched without clamping. Padded rows (and
+ * tiled blocks) start on 64-byte cache line boundaries.
+ *
+ * A box-filtered mip chain is built once on construction, down to 1x1. Every
+ * level is padded the same way and uses the same layout. Level views point into the texture's own
+ * storage, or into a mapped raw file (see writeRaw()), so a texture can be moved but not copied.
+ */
+class Texture {
+public:
+    static const int PADDING = 1;
+
+    /**
+     * Default constructor creates a 1x1 black texture
+     */
+    Texture();
+
+    /**
+     * Build a padded texture from an image
+     *
+     * @param image Source image
+     * @param layout Memory order of the texels
+     */
+    explicit Texture(const Image& image, TextureLayout layout = TextureLayout::Linear);
+
+    /**
+     * Build a padded texture from tightly packed RGBA32 rows
+     *
+     * Rows are copied into the padded storage whole rather than texel by texel,
+     * and alpha is kept.
+     *
+     * @param rgba Row-major 0xAABBGGRR texels, width per row
+     * @param width Width in texels
+     * @param height Height in texels
+     * @param layout Memory order of the texels
+     */
+    Texture(const uint32_t* rgba, int width, int height, TextureLayout layout = TextureLayout::Linear);
+
+    /**
+     * Build a texture from tightly packed RGBA32 rows, taking ownership of them
+     *
+     * A linear texture is laid out inside the buffer itself: it is grown to the
+     * padded size with realloc and the rows are moved apart in place, so the
+     * texels are never copied into a second allocation. Tiled textures copy and
+     * free the buffer.
+     *
+     * @param rgba Row-major 0xAABBGGRR texels allocated with malloc (as stbi_load returns them)
+     * @param width Width in texels
+     * @param height Height in texels
+     * @param layout Memory order of the texels
+     * @return The texture
+     */
+    static Texture adopt(uint32_t* rgba, int width, int height, TextureLayout layout = TextureLayout::Linear);
+
+    /**
+     * Sample a paged texture: level views carry sizes only (no texels), and
+     * samplers read through the texture's pages instead
+     *
+     * @param pages Opened paged texture, shared with the returned texture
+     * @return The texture
+     */
+    static Texture paged(const std::shared_ptr<PagedTexture>& pages);
+
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+    Texture(Texture&&) = default;
+    Texture& operator=(Texture&&) = default;
+
+    /**
+     * Get texture width
+     *
+     * @return Width in texels
+     */
+    int getWidth() const;
+
+    /**
+     * Get texture height
+     *
+     * @return Height in texels
+     */
+    int getHeight() const;
+
+    /**
+     * Get the distance between rows
+     *
+     * @return Texels per padded row, or per row of blocks for a tiled layout
+     */
+    int getStride() const;
+
+    /**
+     * Get the memory order of the texels
+     *
+     * @return Texture layout
+     */
+    TextureLayout getLayout() const;
+
+    /**
+     * Direct access to the texels
+     *
+     * @return Pointer to texel (0, 0); padding lies at negative offsets and past the edges
+     */
+    const uint32_t* texelData() const;
+
+    /**
+     * Get the number of mip levels
+     *
+     * @return Level count (1 for a 1x1 texture)
+     */
+    int getLevelCount() const;
+
+    /**
+     * Get the paged texture behind this texture, if any
+     *
+     * @return Paged texture, or null when the texels are in memory
+     */
+    PagedTexture* getPages() const;
+
+    /**
+     * Build the summed-area table of the base level used by the area filter
+     * (see sampleSpanArea). It takes 12 bytes per texel, so it is only built on
+     * request. Paged textures have no table and are filtered trilinearly instead.
+     */
+    void buildSummedAreaTable();
+
+    /**
+     * Get the summed-area table of the base level
+     *
+     * @return (width + 1) x (height + 1) RGB sums, or null if not built
+     */
+    const uint32_t* summedAreaData() const;
+
+    /**
+     * Get a mip level
+     *
+     * @param level Level index (0 is the full-resolution texture)
+     * @return View of the level's texels
+     */
+    const MipLevel& getLevel(int level) const;
+
+    /**
+     * Get all mip levels
+     *
+     * @return Pointer to getLevelCount() level views
+     */
+    const MipLevel* levelData() const;
+
+    /**
+     * Offset of a texel from texel (0, 0) of a level
+     *
+     * @param level Level view
+     * @param x X coordinate (may lie in the padding)
+     * @param y Y coordinate (may lie in the padding)
+     * @return Offset in texels
+     */
+    static ptrdiff_t texelOffset(const MipLevel& level, int x, int y) {
+        if (!level.tiled) {
+            return static_cast<ptrdiff_t>(y) * level.stride + x;
+        }
+        return static_cast<ptrdiff_t>(y >> TEXTURE_TILE_SHIFT) * level.stride +
+            ((y & (TEXTURE_TILE_SIZE - 1)) << TEXTURE_TILE_SHIFT) +
+            ((x >> TEXTURE_TILE_SHIFT) << (2 * TEXTURE_TILE_SHIFT)) + (x & (TEXTURE_TILE_SIZE - 1));
+    }
+
+    /**
+     * Get color of a specific texel
+     *
+     * @param x X coordinate
+     * @param y Y coordinate
+     * @return Color of the texel (black outside the texture)
+     */
+    Color getPixel(int x, int y) const;
+
+    /**
+     * Pack a color into a texel (opaque alpha)
+     *
+     * @param color Color to pack
+     * @return Packed texel
+     */
+    static uint32_t pack(const Color& color);
+
+    /**
+     * Unpack the RGB channels of a texel
+     *
+     * @param texel Packed texel
+     * @return Color of the texel
+     */
+    static Color unpack(uint32_t texel);
+
+    /**
+     * Rounded mean of four texels, channel by channel, as the mip chain is built
+     *
+     * @param t00 Top-left texel
+     * @param t10 Top-right texel
+     * @param t01 Bottom-left texel
+     * @param t11 Bottom-right texel
+     * @return Averaged texel
+     */
+    static uint32_t average4(uint32_t t00, uint32_t t10, uint32_t t01, uint32_t t11);
+
+    /**
+     * Size of the raw form of the texture
+     *
+     * @return Bytes writeRaw() writes
+     */
+    size_t rawSize() const;
+
+    /**
+     * Write the raw form of the texture: a header, then every level's padded
+     * texels exactly as they lie in memory, each level on a 64-byte boundary
+     *
+     * @param out Destination of rawSize() bytes, 64-byte aligned
+     */
+    void writeRaw(char* out) const;
+
+    /**
+     * Use the raw form of a texture in place, without copying its texels
+     *
+     * @param file Read-only mapping of a file written by writeRaw(), kept open by the texture
+     * @param texture Receives the texture
+     * @return false if the file is not a complete raw texture
+     */
+    static bool fromRaw(const std::shared_ptr<MappedFile>& file, Texture& texture);
+
+private:
+    int width, height;
+    int stride;
+    TextureLayout layout;
+    struct FreeDeleter {
+        void operator()(uint32_t* block) const { std::free(block); }
+    };
+
+    std::vector<std::unique_ptr<uint32_t, FreeDeleter>> storage;  // malloc'd padded texels of each level
+    std::vector<MipLevel> levels;
+    std::shared_ptr<MappedFile> mapping;  // Raw file the levels point into, if any
+    std::shared_ptr<PagedTexture> pages;  // Pages read instead of the levels' texels, if any
+    std::vector<uint32_t> summedArea;     // Summed-area table of the base level, if built
+
+    /**
+     * Empty texture of the given size, filled in by adopt(), fromRaw() or paged()
+     *
+     * @param width Width in texels
+     * @param height Height in texels
+     * @param layout Memory order of the texels
+     */
+    Texture(int width, int height, TextureLayout layout);
+
+    /**
+     * Allocate the padded, cache-line aligned storage of a level, uninitialized
+     *
+     * @param level Level with its size set; receives its layout, stride and texel pointer
+     * @param lead Receives the number of allocated texels before texel 0 on each axis
+     * @param allocWidth Receives the allocated texels per row, padding included
+     * @param allocHeight Receives the allocated rows, padding included
+     * @return Pointer to texel (0, 0)
+     */
+    uint32_t* allocateLevel(MipLevel& level, int& lead, int& allocWidth, int& allocHeight);
+
+    /**
+     * Allocate a padded level and fill it, edges included, from packed rows
+     *
+     * @param rgba Row-major texels, levelWidth per row
+     * @param levelWidth Level width in texels
+     * @param levelHeight Level height in texels
+     */
+    void addLevel(const uint32_t* rgba, int levelWidth, int levelHeight);
+
+    /**
+     * Turn a malloc'd buffer of packed rows into the padded linear base level
+     *
+     * @param rgba Row-major texels, width per row; owned by the texture afterwards
+     */
+    void adoptLevel(uint32_t* rgba);
+
+    /**
+     * Add the box-filtered mip chain below the base level, down to 1x1
+     *
+     * @param rows Base level texels, row by row
+     * @param rowStride Texels between the starts of consecutive rows
+     */
+    void buildMipChain(const uint32_t* rows, int rowStride);
+};
+
+
+/**
+ * Parse a texture layout name ("linear" or "tiled")
+ *
+ * @param name Layout name
+ * @param layout Receives the layout if the name is valid
+ * @return True if the name was recognized
+ */
+bool parseTextureLayout(const std::string& name, TextureLayout& layout);
+
+/**
+ * Name of a texture layout as used in the configuration
+ *
+ * @param layout Texture layout
+ * @return Name such as "tiled"
+ */
+const char* textureLayoutName(TextureLayout layout);
+
+/**
+ * Load a texture straight from an image file (PNG, JPG, etc.)
+ *
+ * stb_image decodes to four channels, which are exactly the packed texels, so
+ * the decoded rows go into the padded texture without an intermediate Image.
+ *
+ * @param filename Input image filename
+ * @param layout Memory order of the texels
+ * @return Loaded texture, or a 1x1 black texture if the file cannot be decoded
+ */
+Texture loadTexture(const std::string& filename, TextureLayout layout = TextureLayout::Linear);
\ No newline at end of file
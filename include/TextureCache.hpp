@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Texture.hpp"
+
+/**
+ * On-disk cache of decoded textures
+ *
+ * Each entry is a texture's padded mip chain in the raw form Texture::writeRaw()
+ * produces. It is named after the source file's content hash, size and
+ * modification time and the texel layout, so editing or replacing the source
+ * simply misses. A hit maps the entry and samples it in place: no decode and no
+ * copy. The least recently used entries are deleted to keep the directory under
+ * its size limit.
+ *
+ * Textures too large to keep in memory are cached as page files instead (see
+ * PagedTexture), converted on the first load and sampled a page at a time.
+ */
+class TextureCache {
+public:
+    /**
+     * Constructor
+     *
+     * @param directory Directory holding the entries, created when first written
+     * @param limitBytes Upper bound on the total size of the entries
+     */
+    TextureCache(const std::string& directory, uint64_t limitBytes);
+
+    /**
+     * Load a texture through the cache
+     *
+     * A miss decodes the file with loadTexture() and stores the result for the
+     * next run; any cache failure falls back to the decoded texture.
+     *
+     * @param filename Image file (PNG, JPG, etc.)
+     * @param layout Memory order of the texels
+     * @return Loaded texture, or a 1x1 black texture if the file cannot be read
+     */
+    Texture load(const std::string& filename, TextureLayout layout);
+
+    /**
+     * Load a texture as pages read on demand, through the cache
+     *
+     * A miss converts the file into a page file entry first. Failures fall back
+     * to loading the texture whole.
+     *
+     * @param filename Image file (PPM, PNG, JPG, etc.)
+     * @param budgetBytes Memory kept for resident pages
+     * @return Paged texture, or a resident one if paging is not possible
+     */
+    Texture loadPaged(const std::string& filename, uint64_t budgetBytes);
+
+    /**
+     * Path of a named entry, creating the cache directory if needed
+     *
+     * Names ending in ".tex" or ".pages" are evicted and cleared like any other entry.
+     *
+     * @param name File name inside the cache directory
+     * @return Entry path, or an empty string if the directory cannot be created
+     */
+    std::string entryPath(const std::string& name) const;
+
+    /**
+     * Delete every entry in the cache directory
+     */
+    void clear() const;
+
+private:
+    std::string directory;
+    uint64_t limitBytes;
+
+    /**
+     * Write a texture as a new entry, evicting old entries to make room
+     *
+     * @param path Entry path
+     * @param texture Texture to store
+     * @return true if the entry was written
+     */
+    bool store(const std::string& path, const Texture& texture) const;
+
+    /**
+     * Delete least recently used entries until the cache has room
+     *
+     * @param incoming Size of the entry about to be written
+     */
+    void evict(uint64_t incoming) const;
+};
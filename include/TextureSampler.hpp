@@ -0,0 +1,127 @@
+#pragma once
+
+#include "CpuFeatures.hpp"
+#include "Image.hpp"
+#include "Math.hpp"
+#include "Texture.hpp"
+#include "SamplerKernels.hpp"
+#include <string>
+
+/**
+ * Filter used to sample the decal texture
+ */
+enum class TextureFilter {
+    Nearest,    // Closest base-level texel
+    Bilinear,   // 2x2 base-level texels
+    Trilinear,  // Bilinear on the two mip levels nearest the pixel's footprint
+    Area        // Box average over the pixel's footprint from a summed-area table
+};
+
+/**
+ * Arithmetic of the bilinear per-pixel pipeline. Fixed is not configurable: it is
+ * scalar and slower than the vector double kernels, so only the fixed-point
+ * benchmark selects it (through Renderer::setTexturePrecision).
+ */
+enum class TexturePrecision {
+    Double,  // Perspective divide per pixel in double, 16-bit blend weights
+    Fixed    // 16.16 coordinates stepped in integers between divides every 8 pixels, 8-bit weights
+};
+
+/**
+ * Describe one row span of a face mapped through an inverse homography
+ *
+ * @param texture Texture to sample
+ * @param Hinv Inverse homography from screen to texture space
+ * @param y Row of the span
+ * @param x0 First pixel of the span
+ * @param x1 Last pixel of the span (inclusive)
+ * @param fallbackColor Color for samples outside the texture
+ * @param out Destination pixel for x0
+ * @return Span description for the sampling kernels
+ */
+TextureSpan makeTextureSpan(const Texture& texture, const Mat3x3& Hinv, int y, int x0, int x1,
+    const Color& fallbackColor, Color* out);
+
+/**
+ * Sample a span with the bilinear kernel for the active kernel level (see KernelIsa)
+ *
+ * @param span Span to sample
+ */
+void sampleTextureSpan(const TextureSpan& span);
+
+/**
+ * Sample a span with the bilinear kernel for a specific kernel level
+ *
+ * @param span Span to sample
+ * @param isa Kernel level (must be supported)
+ */
+void sampleTextureSpan(const TextureSpan& span, KernelIsa isa);
+
+/**
+ * Sample a span with a texture filter for the active kernel level (see KernelIsa)
+ * Bilinear spans use the fixed-point kernel when asked for. Trilinear and area
+ * spans have AVX2 and AVX-512 kernels, and SSE4.1 runs them portably since it
+ * has no gathers; nearest spans are always portable.
+ *
+ * @param span Span to sample
+ * @param filter Texture filter
+ * @param precision Arithmetic of bilinear spans (paged textures always use Double)
+ */
+void sampleFilteredSpan(const TextureSpan& span, TextureFilter filter,
+    TexturePrecision precision = TexturePrecision::Double);
+
+/**
+ * Sample a span with a texture filter for a specific kernel level
+ *
+ * @param span Span to sample
+ * @param filter Texture filter
+ * @param precision Arithmetic of bilinear spans (paged textures always use Double)
+ * @param isa Kernel level (must be supported)
+ */
+void sampleFilteredSpan(const TextureSpan& span, TextureFilter filter, TexturePrecision precision, KernelIsa isa);
+
+/**
+ * Sample a span of a paged texture with the portable kernels
+ * Pixels are taken in runs: the pages a run reads are pinned, the run is
+ * sampled from them, and they are unpinned, so output matches the resident kernels
+ *
+ * @param span Span to sample (pages set)
+ * @param filter Texture filter
+ */
+void samplePagedSpan(const TextureSpan& span, TextureFilter filter);
+
+/**
+ * Parse a texture filter name ("nearest", "bilinear", "trilinear" or "area")
+ *
+ * @param name Filter name
+ * @param filter Receives the filter if the name is valid
+ * @return True if the name was recognized
+ */
+bool parseTextureFilter(const std::string& name, TextureFilter& filter);
+
+/**
+ * Name of a texture filter as used in the configuration
+ *
+ * @param filter Texture filter
+ * @return Name such as "trilinear"
+ */
+const char* textureFilterName(TextureFilter filter);
+
+/**
+ * Name of a texture precision as logged by the benchmarks
+ *
+ * @param precision Texture precision
+ * @return Name such as "fixed"
+ */
+const char* texturePrecisionName(TexturePrecision precision);
+
+/**
+ * Reference bilinear sample in double precision
+ *
+ * @param texture Texture to sample
+ * @param u Horizontal texel coordinate
+ * @param v Vertical texel coordinate
+ * @param fallbackColor Color returned outside the texture
+ * @return Interpolated color, truncated to 8 bits per channel
+ */
+Color sampleBilinearReference(const Texture& texture, double u, double v, const Color& fallbackColor);
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed-size pool of worker threads for data-parallel loops
+ *
+ * The calling thread takes part in every loop as worker 0, so a pool of one
+ * thread spawns nothing and runs loops serially on the caller.
+ */
+class ThreadPool {
+public:
+    /**
+     * Constructor
+     *
+     * @param threadCount Total number of threads including the caller (0 = hardware threads)
+     */
+    explicit ThreadPool(int threadCount);
+
+    /**
+     * Destructor - stops and joins the worker threads
+     */
+    ~ThreadPool();
+
+    // Prevent copying
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Run fn(index, worker) for every index in [0, count) and wait for completion
+     *
+     * Indices are handed out in increasing order. The worker argument is in
+     * [0, getThreadCount()) and identifies the thread, so callers can keep
+     * per-thread state without locking. The first exception thrown by fn is
+     * rethrown on the calling thread.
+     *
+     * @param count Number of iterations
+     * @param fn Loop body
+     */
+    void parallelFor(int count, const std::function<void(int index, int worker)>& fn);
+
+    /**
+     * Get the number of threads taking part in loops (including the caller)
+     *
+     * @return Thread count
+     */
+    int getThreadCount() const;
+
+    /**
+     * Number of hardware threads available on this machine
+     *
+     * @return Hardware thread count (at least 1)
+     */
+    static int hardwareThreads();
+
+private:
+    /**
+     * Main loop of a spawned worker thread
+     *
+     * @param worker Worker index
+     */
+    void workerLoop(int worker);
+
+    /**
+     * Claim and run iterations of the current loop until none are left
+     *
+     * @param worker Worker index
+     */
+    void runIterations(int worker);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+
+    const std::function<void(int, int)>* job;
+    int jobCount;
+    std::atomic<int> nextIndex;
+    int busyWorkers;
+    unsigned generation;
+    bool stopping;
+    std::exception_ptr error;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+
+// Plain data interface to the ISA-specific vertex kernels. The kernel sources are
+// compiled with per-file instruction set flags, so this header must stay free of
+// inline functions and standard library templates.
+
+/**
+ * Points stored as one array per coordinate, double precision
+ */
+struct PointsSoA {
+    const double* x;
+    const double* y;
+    const double* z;
+};
+
+/**
+ * Output of transformAndProject, double precision
+ */
+struct ScreenPointsSoA {
+    double* x;          // Screen X after the perspective divide
+    double* y;          // Screen Y after the perspective divide
+    double* depth;      // Divisor w, the camera-space depth for perspectiveProjection()
+};
+
+/**
+ * Points stored as one array per coordinate, single precision
+ */
+struct PointsSoAf {
+    const float* x;
+    const float* y;
+    const float* z;
+};
+
+/**
+ * Output of transformAndProject, single precision
+ */
+struct ScreenPointsSoAf {
+    float* x;
+    float* y;
+    float* depth;
+};
+
+/**
+ * Portable kernel, also used for the tail of every vector kernel
+ *
+ * Point i becomes (X / W, Y / W) with depth W, where (X, Y, Z, W) = m * (x, y, z, 1).
+ * Every kernel uses the same operations in the same order (one divide for 1 / W,
+ * then two multiplies, no fused multiply-add), so all of them produce identical results.
+ *
+ * @param m Row-major 4x4 matrix
+ * @param in Input points
+ * @param out Output points
+ * @param first Index of the first point to process
+ * @param count Total number of points
+ */
+void transformAndProjectScalar(const double m[4][4], const PointsSoA& in, const ScreenPointsSoA& out,
+    size_t first, size_t count);
+
+/**
+ * Portable single-precision kernel (the matrix is rounded to float)
+ *
+ * @param m Row-major 4x4 matrix
+ * @param in Input points
+ * @param out Output points
+ * @param first Index of the first point to process
+ * @param count Total number of points
+ */
+void transformAndProjectScalar(const double m[4][4], const PointsSoAf& in, const ScreenPointsSoAf& out,
+    size_t first, size_t count);
+
+/**
+ * AVX2 kernel, 4 doubles per iteration
+ *
+ * @param m Row-major 4x4 matrix
+ * @param in Input points
+ * @param out Output points
+ * @param count Number of points
+ */
+void transformAndProjectAVX2(const double m[4][4], const PointsSoA& in, const ScreenPointsSoA& out, size_t count);
+
+/**
+ * AVX2 kernel, 8 floats per iteration
+ *
+ * @param m Row-major 4x4 matrix
+ * @param in Input points
+ * @param out Output points
+ * @param count Number of points
+ */
+void transformAndProjectAVX2(const double m[4][4], const PointsSoAf& in, const ScreenPointsSoAf& out, size_t count);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include "Image.hpp"
+
+/**
+ * Pipe to an external video encoder that reads raw RGB24 frames on stdin
+ *
+ * The encoder is started once with popen; every frame's pixel buffer is written
+ * to its stdin as is, so nothing touches the disk between render and encode.
+ */
+class VideoPipe {
+public:
+    /**
+     * Default constructor - no encoder running
+     */
+    VideoPipe();
+
+    /**
+     * Destructor - closes the pipe and waits for the encoder if still open
+     */
+    ~VideoPipe();
+
+    // The pipe owns a process handle
+    VideoPipe(const VideoPipe&) = delete;
+    VideoPipe& operator=(const VideoPipe&) = delete;
+
+    /**
+     * Start the encoder
+     *
+     * @param command Shell command reading rgb24 frames from stdin
+     * @return true if the encoder was started
+     */
+    bool open(const std::string& command);
+
+    /**
+     * Write one frame to the encoder
+     *
+     * @param frame Frame to write (every frame must have the same size)
+     * @return true if the whole frame was written
+     */
+    bool writeFrame(const Image& frame);
+
+    /**
+     * Close the encoder's stdin and wait for it to exit
+     *
+     * @return true if the encoder exited successfully
+     */
+    bool close();
+
+    /**
+     * Check if an encoder is running
+     *
+     * @return true between a successful open() and close()
+     */
+    bool isOpen() const;
+
+private:
+    FILE* pipe;
+};
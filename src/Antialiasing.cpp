@@ -0,0 +1,93 @@
+#include "Antialiasing.hpp"
+#include "AntialiasingKernels.hpp"
+#include "CpuFeatures.hpp"
+
+// Samples and pixels are box-filtered as packed RGB bytes
+static_assert(sizeof(Color) == 3, "Color must be three packed bytes");
+
+int antialiasingSampleScale(Antialiasing mode) {
+    switch (mode) {
+    case Antialiasing::SSAA2x2: return 2;
+    case Antialiasing::SSAA4x4: return 4;
+    default:                    return 1;
+    }
+}
+
+bool parseAntialiasing(const std::string& name, Antialiasing& mode) {
+    if (name == "none") {
+        mode = Antialiasing::None;
+    }
+    else if (name == "ssaa2x2" || name == "ssaa2x") {
+        mode = Antialiasing::SSAA2x2;
+    }
+    else if (name == "ssaa4x4" || name == "ssaa4x") {
+        mode = Antialiasing::SSAA4x4;
+    }
+    else if (name == "msaa4x") {
+        mode = Antialiasing::MSAA4x;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+const char* antialiasingName(Antialiasing mode) {
+    switch (mode) {
+    case Antialiasing::None:    return "none";
+    case Antialiasing::SSAA2x2: return "ssaa2x2";
+    case Antialiasing::SSAA4x4: return "ssaa4x4";
+    case Antialiasing::MSAA4x:  return "msaa4x";
+    default:                    return "unknown";
+    }
+}
+
+void downsampleBoxScalar(const DownsampleRect& rect, int firstColumn) {
+    const int factor = rect.factor;
+    const int count = factor * factor;
+    for (int y = 0; y < rect.height; y++) {
+        const unsigned char* sampleRow = rect.samples + static_cast<size_t>(y) * factor * rect.sampleStride;
+        unsigned char* out = rect.pixels + static_cast<size_t>(y) * rect.pixelStride;
+        for (int x = firstColumn; x < rect.width; x++) {
+            for (int c = 0; c < 3; c++) {
+                int sum = 0;
+                for (int i = 0; i < factor; i++) {
+                    const unsigned char* in = sampleRow + i * rect.sampleStride + 3 * factor * x + c;
+                    for (int k = 0; k < factor; k++) {
+                        sum += in[3 * k];
+                    }
+                }
+                out[3 * x + c] = static_cast<unsigned char>((sum + count / 2) / count);
+            }
+        }
+    }
+}
+
+void downsampleBox(const Image& samples, Image& target, int factor, const RasterRect& pixels) {
+    if (pixels.isEmpty()) {
+        return;
+    }
+
+    DownsampleRect rect;
+    rect.samples = reinterpret_cast<const unsigned char*>(
+        samples.rowData(pixels.minY * factor) + pixels.minX * factor);
+    rect.sampleStride = static_cast<size_t>(samples.getWidth()) * sizeof(Color);
+    rect.pixels = reinterpret_cast<unsigned char*>(target.rowData(pixels.minY) + pixels.minX);
+    rect.pixelStride = static_cast<size_t>(target.getWidth()) * sizeof(Color);
+    rect.width = pixels.maxX - pixels.minX + 1;
+    rect.height = pixels.maxY - pixels.minY + 1;
+    rect.factor = factor;
+
+#ifdef CUBE_X86_KERNELS
+    const KernelIsa isa = getKernelIsa();
+    if (isa >= KernelIsa::AVX2) {
+        downsampleBoxAVX2(rect);
+        return;
+    }
+    if (isa >= KernelIsa::SSE41) {
+        downsampleBoxSSE41(rect);
+        return;
+    }
+#endif
+    downsampleBoxScalar(rect, 0);
+}
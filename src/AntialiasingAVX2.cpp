@@ -0,0 +1,101 @@
+// Compiled with AVX2 code generation; only called after a CPU check
+#include "AntialiasingKernels.hpp"
+#include <immintrin.h>
+#include <cstring>
+
+// The SSE4.1 kernel's shuffle controls (see AntialiasingSSE41.cpp) in both
+// 128-bit lanes, which filter two 48-byte groups of samples side by side
+struct GatherMasks {
+    __m256i control[4][2][3];
+};
+
+static void buildGatherMasks(int factor, int outputBytes, GatherMasks& masks) {
+    for (int k = 0; k < factor; k++) {
+        for (int r = 0; r < 2; r++) {
+            for (int s = 0; s < 3; s++) {
+                alignas(16) unsigned char control[16];
+                for (int j = 0; j < 16; j++) {
+                    const int q = 16 * r + j;
+                    const int b = 3 * (factor * (q / 3) + k) + q % 3;
+                    control[j] = (q < outputBytes && b / 16 == s) ? static_cast<unsigned char>(b % 16) : 0x80;
+                }
+                masks.control[k][r][s] = _mm256_broadcastsi128_si256(
+                    _mm_load_si128(reinterpret_cast<const __m128i*>(control)));
+            }
+        }
+    }
+}
+
+// Group g in the low lane and group g + 1 in the high lane
+static inline __m256i loadGroups(const unsigned char* group) {
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(group + 48)), 1);
+}
+
+// Write one group's output pixels from a 128-bit lane
+static inline void storeGroup(unsigned char* dst, __m128i packedLo, __m128i packedHi, int outputBytes) {
+    if (outputBytes == 24) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), packedLo);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 16), packedHi);
+    }
+    else {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), packedLo);
+        const int tail = _mm_extract_epi32(packedLo, 2);
+        std::memcpy(dst + 8, &tail, 4);
+    }
+}
+
+void downsampleBoxAVX2(const DownsampleRect& rect) {
+    const int factor = rect.factor;
+    const int pixelsPerGroup = 16 / factor;
+    const int outputBytes = 3 * pixelsPerGroup;
+    const int shift = factor == 2 ? 2 : 4;
+    const __m256i round = _mm256_set1_epi16(static_cast<short>(1 << (shift - 1)));
+    const __m256i zero = _mm256_setzero_si256();
+
+    GatherMasks masks;
+    buildGatherMasks(factor, outputBytes, masks);
+
+    const int pairs = rect.width / pixelsPerGroup / 2;
+    for (int y = 0; y < rect.height; y++) {
+        const unsigned char* sampleRow = rect.samples + static_cast<size_t>(y) * factor * rect.sampleStride;
+        unsigned char* out = rect.pixels + static_cast<size_t>(y) * rect.pixelStride;
+
+        for (int g = 0; g < 2 * pairs; g += 2) {
+            __m256i sum0 = zero;
+            __m256i sum1 = zero;
+            __m256i sum2 = zero;
+            for (int i = 0; i < factor; i++) {
+                const unsigned char* in = sampleRow + i * rect.sampleStride + 48 * g;
+                const __m256i in0 = loadGroups(in);
+                const __m256i in1 = loadGroups(in + 16);
+                const __m256i in2 = loadGroups(in + 32);
+                for (int k = 0; k < factor; k++) {
+                    const __m256i lo = _mm256_or_si256(_mm256_or_si256(
+                        _mm256_shuffle_epi8(in0, masks.control[k][0][0]),
+                        _mm256_shuffle_epi8(in1, masks.control[k][0][1])),
+                        _mm256_shuffle_epi8(in2, masks.control[k][0][2]));
+                    const __m256i hi = _mm256_or_si256(_mm256_or_si256(
+                        _mm256_shuffle_epi8(in0, masks.control[k][1][0]),
+                        _mm256_shuffle_epi8(in1, masks.control[k][1][1])),
+                        _mm256_shuffle_epi8(in2, masks.control[k][1][2]));
+                    sum0 = _mm256_add_epi16(sum0, _mm256_unpacklo_epi8(lo, zero));
+                    sum1 = _mm256_add_epi16(sum1, _mm256_unpackhi_epi8(lo, zero));
+                    sum2 = _mm256_add_epi16(sum2, _mm256_unpacklo_epi8(hi, zero));
+                }
+            }
+
+            sum0 = _mm256_srli_epi16(_mm256_add_epi16(sum0, round), shift);
+            sum1 = _mm256_srli_epi16(_mm256_add_epi16(sum1, round), shift);
+            sum2 = _mm256_srli_epi16(_mm256_add_epi16(sum2, round), shift);
+            const __m256i packedLo = _mm256_packus_epi16(sum0, sum1);
+            const __m256i packedHi = _mm256_packus_epi16(sum2, zero);
+            unsigned char* dst = out + outputBytes * g;
+            storeGroup(dst, _mm256_castsi256_si128(packedLo), _mm256_castsi256_si128(packedHi), outputBytes);
+            storeGroup(dst + outputBytes, _mm256_extracti128_si256(packedLo, 1), _mm256_extracti128_si256(packedHi, 1),
+                outputBytes);
+        }
+    }
+
+    downsampleBoxScalar(rect, 2 * pairs * pixelsPerGroup);
+}
@@ -0,0 +1,88 @@
+// Compiled with SSE4.1 code generation; only called after a CPU check
+#include "AntialiasingKernels.hpp"
+#include <smmintrin.h>
+#include <cstring>
+
+// Output bytes [16 * r, 16 * r + 16) gathered from the three 16-byte loads of a
+// 48-byte group of samples: shuffle control per phase, output register and load
+struct GatherMasks {
+    __m128i control[4][2][3];
+};
+
+// Phase k picks sample k of every factor-sample run, so summing the phases of
+// all rows gives each output channel its whole block
+static void buildGatherMasks(int factor, int outputBytes, GatherMasks& masks) {
+    for (int k = 0; k < factor; k++) {
+        for (int r = 0; r < 2; r++) {
+            for (int s = 0; s < 3; s++) {
+                alignas(16) unsigned char control[16];
+                for (int j = 0; j < 16; j++) {
+                    const int q = 16 * r + j;
+                    const int b = 3 * (factor * (q / 3) + k) + q % 3;
+                    control[j] = (q < outputBytes && b / 16 == s) ? static_cast<unsigned char>(b % 16) : 0x80;
+                }
+                masks.control[k][r][s] = _mm_load_si128(reinterpret_cast<const __m128i*>(control));
+            }
+        }
+    }
+}
+
+void downsampleBoxSSE41(const DownsampleRect& rect) {
+    const int factor = rect.factor;
+    const int pixelsPerGroup = 16 / factor;
+    const int outputBytes = 3 * pixelsPerGroup;
+    const int shift = factor == 2 ? 2 : 4;
+    const __m128i round = _mm_set1_epi16(static_cast<short>(1 << (shift - 1)));
+    const __m128i zero = _mm_setzero_si128();
+
+    GatherMasks masks;
+    buildGatherMasks(factor, outputBytes, masks);
+
+    const int groups = rect.width / pixelsPerGroup;
+    for (int y = 0; y < rect.height; y++) {
+        const unsigned char* sampleRow = rect.samples + static_cast<size_t>(y) * factor * rect.sampleStride;
+        unsigned char* out = rect.pixels + static_cast<size_t>(y) * rect.pixelStride;
+
+        for (int g = 0; g < groups; g++) {
+            __m128i sum0 = zero;
+            __m128i sum1 = zero;
+            __m128i sum2 = zero;
+            for (int i = 0; i < factor; i++) {
+                const __m128i* in = reinterpret_cast<const __m128i*>(sampleRow + i * rect.sampleStride + 48 * g);
+                const __m128i in0 = _mm_loadu_si128(in);
+                const __m128i in1 = _mm_loadu_si128(in + 1);
+                const __m128i in2 = _mm_loadu_si128(in + 2);
+                for (int k = 0; k < factor; k++) {
+                    const __m128i lo = _mm_or_si128(_mm_or_si128(
+                        _mm_shuffle_epi8(in0, masks.control[k][0][0]),
+                        _mm_shuffle_epi8(in1, masks.control[k][0][1])),
+                        _mm_shuffle_epi8(in2, masks.control[k][0][2]));
+                    const __m128i hi = _mm_or_si128(_mm_or_si128(
+                        _mm_shuffle_epi8(in0, masks.control[k][1][0]),
+                        _mm_shuffle_epi8(in1, masks.control[k][1][1])),
+                        _mm_shuffle_epi8(in2, masks.control[k][1][2]));
+                    sum0 = _mm_add_epi16(sum0, _mm_unpacklo_epi8(lo, zero));
+                    sum1 = _mm_add_epi16(sum1, _mm_unpackhi_epi8(lo, zero));
+                    sum2 = _mm_add_epi16(sum2, _mm_unpacklo_epi8(hi, zero));
+                }
+            }
+
+            sum0 = _mm_srli_epi16(_mm_add_epi16(sum0, round), shift);
+            sum1 = _mm_srli_epi16(_mm_add_epi16(sum1, round), shift);
+            sum2 = _mm_srli_epi16(_mm_add_epi16(sum2, round), shift);
+            const __m128i packedLo = _mm_packus_epi16(sum0, sum1);
+            unsigned char* dst = out + outputBytes * g;
+            if (outputBytes == 24) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), packedLo);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 16), _mm_packus_epi16(sum2, zero));
+            }
+            else {
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), packedLo);
+                const int tail = _mm_extract_epi32(packedLo, 2);
+                std::memcpy(dst + 8, &tail, 4);
+            }
+        }
+    }
+
+    downsampleBoxScalar(rect, groups * pixelsPerGroup);
+}
@@ -0,0 +1,1816 @@
+#include "Benchmark.hpp"
+#include "AllocationCounter.hpp"
+#include "Logger.hpp"
+#include "Rasterizer.hpp"
+#include "Renderer.hpp"
+#include "TextureSampler.hpp"
+#include "CpuFeatures.hpp"
+#include "RadixSort.hpp"
+#include "Scene.hpp"
+#include "Mesh.hpp"
+#include "ObjLoader.hpp"
+#include "Antialiasing.hpp"
+#include "AntialiasingKernels.hpp"
+#include "TextureCache.hpp"
+#include "PagedTexture.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <sstream>
+
+// Upper bound on frames rendered per measurement
+static const int MAX_SAMPLED_FRAMES = 48;
+
+// Texture color the texture walk scenario uses to see which pixels each walk covers;
+// nothing else in the scene is drawn in it
+static const Color COVERAGE_MARKER(255, 0, 255);
+
+// Outline color of the renderer; outlines are drawn over the edges of the faces
+static const Color OUTLINE_COLOR(255, 255, 255);
+
+// Frames per measurement in the high-resolution scenarios
+static const int TILE_SAMPLED_FRAMES = 4;
+
+// Texture and target size of the rotation sweep
+static const int SWEEP_TEXTURE_SIZE = 2048;
+static const int SWEEP_TARGET_SIZE = 1024;
+
+// Frames per measurement of the mesh scenario
+static const int MESH_SAMPLED_FRAMES = 8;
+
+// Size of the decoded texture ingested by the load scenario
+static const int LOAD_TEXTURE_SIZE = 8192;
+
+// Texture size, view size, view count and page budget of the paging scenario
+static const int PAGING_TEXTURE_SIZE = 8192;
+static const int PAGING_TARGET_SIZE = 1024;
+static const int PAGING_VIEWS = 9;
+static const int PAGING_BUDGET_MB = 16;
+
+// Documented bounds of the fixed-point kernel: per channel against the exact
+// bilinear value, and against the double kernels (see sampleSpanFixed)
+static const double FIXED_MAX_ERROR = 1.64;
+static const int FIXED_MAX_DIFFERENCE = 2;
+
+// Frame size and repeats of the frame clears timed by the kernel level scenario
+static const int CLEAR_WIDTH = 3840;
+static const int CLEAR_HEIGHT = 2160;
+static const int CLEAR_REPEATS = 20;
+
+// Rows of that frame filled with short runs, as rasterized spans are, the longest
+// run, and the repeats
+static const int SPAN_FILL_ROWS = 16;
+static const int SPAN_FILL_LONGEST = 64;
+static const int SPAN_FILL_REPEATS = 200;
+
+Benchmark::Benchmark(const ConfigManager& config, const Texture& decalTexture)
+    : config(config), decalTexture(decalTexture) {
+}
+
+std::vector<std::string> Benchmark::scenarioNames() {
+    return { "texture", "tiles", "sampler", "rotation", "homography", "clipping", "vertices", "scene", "mesh", "depth", "antialiasing", "load", "paging", "fixed", "isa" };
+}
+
+bool Benchmark::run(const std::string& name) {
+    const std::vector<std::string> names = scenarioNames();
+    if (std::find(names.begin(), names.end(), name) != names.end()) {
+        LOG_INFO << "Benchmark kernels: " << kernelIsaName(getKernelIsa()) << " (detected "
+            << kernelIsaName(detectKernelIsa()) << ")";
+    }
+
+    if (name == "texture") {
+        return runTextureWalk();
+    }
+    if (name == "tiles") {
+        return runTileScaling();
+    }
+    if (name == "sampler") {
+        return runSamplerKernels();
+    }
+    if (name == "rotation") {
+        runRotationSweep();
+        return true;
+    }
+    if (name == "homography") {
+        runHomographySetup();
+        return true;
+    }
+    if (name == "clipping") {
+        runClipping();
+        return true;
+    }
+    if (name == "vertices") {
+        runVertexTransform();
+        return true;
+    }
+    if (name == "scene") {
+        runSceneScaling();
+        return true;
+    }
+    if (name == "mesh") {
+        runMeshPath();
+        return true;
+    }
+    if (name == "depth") {
+        runDepthTest();
+        return true;
+    }
+    if (name == "antialiasing") {
+        runAntialiasing();
+        return true;
+    }
+    if (name == "load") {
+        runTextureLoad();
+        return true;
+    }
+    if (name == "paging") {
+        runPaging();
+        return true;
+    }
+    if (name == "fixed") {
+        return runFixedPoint();
+    }
+    if (name == "isa") {
+        runKernelIsa();
+        return true;
+    }
+
+    LOG_ERROR << "Unknown benchmark: " << name;
+    return false;
+}
+
+std::vector<int> Benchmark::sampleFrames(int maxFrames) const {
+    std::vector<int> frames;
+    int count = std::min(config.numFrames, maxFrames);
+    for (int i = 0; i < count; i++) {
+        frames.push_back(static_cast<int>(static_cast<long long>(i) * config.numFrames / count));
+    }
+    return frames;
+}
+
+double Benchmark::timeFrames(const ConfigManager& scene, Renderer& renderer, int maxFrames, const FrameVisitor& visit,
+    long long* steadyAllocations) const {
+    Cube cube(scene.cubeSize);
+    if (steadyAllocations) {
+        *steadyAllocations = 0;
+    }
+    std::vector<int> frameNumbers = sampleFrames(maxFrames);
+    if (frameNumbers.empty()) {
+        return 0.0;
+    }
+
+    // One framebuffer reused for every frame, as in the animation loop
+    Image image;
+    double totalMs = 0.0;
+    for (size_t i = 0; i < frameNumbers.size(); i++) {
+        int frame = frameNumbers[i];
+        Mat4x4 rotation = scene.calculateRotation(frame);
+        double angle = 2.0 * M_PI * frame / scene.numFrames;
+
+        const long long allocationsBefore = threadAllocationCount();
+        auto start = std::chrono::steady_clock::now();
+        renderer.renderFrame(image, cube, angle, &decalTexture, &rotation);
+        auto end = std::chrono::steady_clock::now();
+        totalMs += std::chrono::duration<double, std::milli>(end - start).count();
+        if (steadyAllocations && i > 0) {
+            *steadyAllocations += threadAllocationCount() - allocationsBefore;
+        }
+
+        if (visit) {
+            visit(i, image);
+        }
+    }
+
+    return totalMs / frameNumbers.size();
+}
+
+int Benchmark::compareFrames(const std::vector<Image>& a, const std::vector<Image>& b, long long& differingPixels) {
+    int maxDiff = 0;
+    differingPixels = 0;
+    for (size_t i = 0; i < std::min(a.size(), b.size()); i++) {
+        for (int y = 0; y < a[i].getHeight(); y++) {
+            for (int x = 0; x < a[i].getWidth(); x++) {
+                Color ca = a[i].getPixel(x, y);
+                Color cb = b[i].getPixel(x, y);
+                int diff = std::max({ std::abs(ca.r - cb.r), std::abs(ca.g - cb.g), std::abs(ca.b - cb.b) });
+                if (diff > 0) {
+                    differingPixels++;
+                    maxDiff = std::max(maxDiff, diff);
+                }
+            }
+        }
+    }
+    return maxDiff;
+}
+
+uint64_t Benchmark::checksum(const Image& image) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (int y = 0; y < image.getHeight(); y++) {
+        const Color* row = image.rowData(y);
+        for (int x = 0; x < image.getWidth(); x++) {
+            hash = (hash ^ row[x].r) * 1099511628211ULL;
+            hash = (hash ^ row[x].g) * 1099511628211ULL;
+            hash = (hash ^ row[x].b) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+/**
+ * Whether a pixel shows the coverage marker, give or take the one unit the
+ * reference sampler loses by truncating
+ */
+static inline bool showsMarker(const Image& image, int x, int y) {
+    const Color c = image.getPixel(x, y);
+    return std::abs(c.r - COVERAGE_MARKER.r) <= 1 && std::abs(c.g - COVERAGE_MARKER.g) <= 1 &&
+        std::abs(c.b - COVERAGE_MARKER.b) <= 1;
+}
+
+/**
+ * Whether a pixel lies on the edge of the marker coverage: one of its eight
+ * neighbours is covered differently, or is an outline hiding the edge
+ */
+static bool onCoverageEdge(const Image& image, int x, int y) {
+    const bool covered = showsMarker(image, x, y);
+    for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, image.getHeight() - 1); ny++) {
+        for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, image.getWidth() - 1); nx++) {
+            const Color c = image.getPixel(nx, ny);
+            const bool outline = c.r == OUTLINE_COLOR.r && c.g == OUTLINE_COLOR.g && c.b == OUTLINE_COLOR.b;
+            if (outline || showsMarker(image, nx, ny) != covered) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool Benchmark::runTextureWalk() {
+    LOG_INFO << "Benchmark 'texture': " << config.width << "x" << config.height
+        << ", " << sampleFrames(MAX_SAMPLED_FRAMES).size() << " frames";
+
+    // The reference walk samples bilinearly in double precision
+    Renderer renderer(config);
+    renderer.setTiling(0, 1);
+    renderer.setTextureFilter(TextureFilter::Bilinear);
+    renderer.setTexturePrecision(TexturePrecision::Double);
+    std::vector<Image> referenceFrames;
+    std::vector<Image> scanlineFrames;
+
+    renderer.setTextureWalk(TextureWalk::Reference);
+    double referenceFrameMs = timeFrames(config, renderer, MAX_SAMPLED_FRAMES,
+        [&](size_t, const Image& image) { referenceFrames.push_back(image); });
+    RenderStats referenceStats = renderer.getStats();
+
+    renderer.resetStats();
+    renderer.setTextureWalk(TextureWalk::Scanline);
+    double scanlineFrameMs = timeFrames(config, renderer, MAX_SAMPLED_FRAMES,
+        [&](size_t, const Image& image) { scanlineFrames.push_back(image); });
+    RenderStats scanlineStats = renderer.getStats();
+
+    // Coverage on its own: both walks draw a texture of the marker color alone, so a
+    // pixel shows the marker exactly where a walk covered it
+    const Texture marker(Image(2, 2, COVERAGE_MARKER));
+    std::vector<Image> referenceCoverage;
+    std::vector<Image> scanlineCoverage;
+    Cube cube(config.cubeSize);
+    for (int frame : sampleFrames(MAX_SAMPLED_FRAMES)) {
+        Mat4x4 rotation = config.calculateRotation(frame);
+        double angle = 2.0 * M_PI * frame / config.numFrames;
+        referenceCoverage.emplace_back();
+        renderer.setTextureWalk(TextureWalk::Reference);
+        renderer.renderFrame(referenceCoverage.back(), cube, angle, &marker, &rotation);
+        scanlineCoverage.emplace_back();
+        renderer.setTextureWalk(TextureWalk::Scanline);
+        renderer.renderFrame(scanlineCoverage.back(), cube, angle, &marker, &rotation);
+    }
+
+    // Pixels covered by one walk only must lie on the edge of the reference
+    // coverage; colors are compared where both walks covered the pixel
+    long long coveredPixels = 0;
+    long long coverageDiffers = 0;
+    long long coverageOffEdge = 0;
+    long long differingPixels = 0;
+    int maxDiff = 0;
+    for (size_t i = 0; i < referenceFrames.size(); i++) {
+        for (int y = 0; y < referenceFrames[i].getHeight(); y++) {
+            for (int x = 0; x < referenceFrames[i].getWidth(); x++) {
+                const bool inReference = showsMarker(referenceCoverage[i], x, y);
+                if (inReference != showsMarker(scanlineCoverage[i], x, y)) {
+                    coverageDiffers++;
+                    if (!onCoverageEdge(referenceCoverage[i], x, y)) {
+                        coverageOffEdge++;
+                    }
+                    continue;
+                }
+                if (!inReference) {
+                    continue;
+                }
+                coveredPixels++;
+                Color ca = referenceFrames[i].getPixel(x, y);
+                Color cb = scanlineFrames[i].getPixel(x, y);
+                int diff = std::max({ std::abs(ca.r - cb.r), std::abs(ca.g - cb.g), std::abs(ca.b - cb.b) });
+                if (diff > 0) {
+                    differingPixels++;
+                    maxDiff = std::max(maxDiff, diff);
+                }
+            }
+        }
+    }
+
+    double referenceMs = referenceStats.textureMs / referenceStats.frames;
+    double scanlineMs = scanlineStats.textureMs / scanlineStats.frames;
+
+    LOG_INFO << "  textured pixels/frame: " << scanlineStats.texturedPixels / scanlineStats.frames;
+    LOG_INFO << "  reference walk: " << referenceMs << " ms/frame texturing, " << referenceFrameMs << " ms/frame total";
+    LOG_INFO << "  scanline walk:  " << scanlineMs << " ms/frame texturing, " << scanlineFrameMs << " ms/frame total";
+    LOG_INFO << "  texturing speedup: " << (scanlineMs > 0 ? referenceMs / scanlineMs : 0.0) << "x";
+    LOG_INFO << "  coverage: " << coveredPixels << " pixels covered by both walks, " << coverageDiffers
+        << " by one only (" << coverageOffEdge << " off the edge)";
+    LOG_INFO << "  differing pixels: " << differingPixels << ", max channel difference: " << maxDiff;
+    bool passed = true;
+    if (coverageOffEdge > 0) {
+        LOG_ERROR << "Scanline walk coverage differs from the reference walk away from the quad edges at "
+            << coverageOffEdge << " pixels";
+        passed = false;
+    }
+    if (maxDiff > 1) {
+        LOG_ERROR << "Scanline walk differs from the reference walk by " << maxDiff;
+        passed = false;
+    }
+    return passed;
+}
+
+bool Benchmark::runTileScaling() {
+    const int resolutions[][2] = { { 1920, 1080 }, { 3840, 2160 }, { 7680, 4320 } };
+    const int threadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+    const int tileSize = config.tileSize > 0 ? config.tileSize : 64;
+
+    LOG_INFO << "Benchmark 'tiles': " << tileSize << "x" << tileSize << " tiles, "
+        << sampleFrames(TILE_SAMPLED_FRAMES).size() << " frames per run, "
+        << ThreadPool::hardwareThreads() << " hardware threads";
+
+    bool passed = true;
+    for (const auto& resolution : resolutions) {
+        // Scale the camera with the height so the cube covers the same share of the frame
+        ConfigManager scene = config;
+        scene.width = resolution[0];
+        scene.height = resolution[1];
+        scene.cameraScale = config.cameraScale * resolution[1] / config.height;
+
+        Renderer untiled(scene);
+        untiled.setTiling(0, 1);
+        std::vector<uint64_t> expected;
+        double untiledMs = timeFrames(scene, untiled, TILE_SAMPLED_FRAMES,
+            [&](size_t, const Image& image) { expected.push_back(checksum(image)); });
+
+        LOG_INFO << "  " << scene.width << "x" << scene.height << " untiled: " << untiledMs << " ms/frame";
+
+        for (int threads : threadCounts) {
+            Renderer tiled(scene);
+            tiled.setTiling(tileSize, threads);
+            bool identical = true;
+            long long allocations = 0;
+            double tiledMs = timeFrames(scene, tiled, TILE_SAMPLED_FRAMES,
+                [&](size_t i, const Image& image) { identical = identical && checksum(image) == expected[i]; },
+                &allocations);
+
+            LOG_INFO << "    " << threads << " thread(s): " << tiledMs << " ms/frame, speedup "
+                << (tiledMs > 0 ? untiledMs / tiledMs : 0.0) << "x, "
+                << (identical ? "identical" : "MISMATCH") << ", " << allocations << " steady-state allocations";
+            if (!identical) {
+                LOG_ERROR << "Tiled frames at " << scene.width << "x" << scene.height << " with " << threads
+                    << " thread(s) differ from untiled ones";
+                passed = false;
+            }
+            if (allocations > 0) {
+                LOG_ERROR << "Tiled rendering at " << scene.width << "x" << scene.height << " with " << threads
+                    << " thread(s) made " << allocations << " heap allocations after its first frame";
+                passed = false;
+            }
+        }
+    }
+    return passed;
+}
+
+bool Benchmark::runSamplerKernels() {
+    // A tilted, perspective-distorted quad over a 640x560 target
+    const int targetWidth = 640;
+    const int targetHeight = 560;
+    const int repeats = 20;
+    std::vector<Vec2> textureCorners = {
+        Vec2(0, 0), Vec2(decalTexture.getWidth() - 1, 0),
+        Vec2(decalTexture.getWidth() - 1, decalTexture.getHeight() - 1), Vec2(0, decalTexture.getHeight() - 1)
+    };
+    std::vector<Vec2> quad = { Vec2(100, 80), Vec2(600, 40), Vec2(560, 520), Vec2(60, 470) };
+    Mat3x3 Hinv = computeHomography(textureCorners, quad).inverse();
+    const Color fallback(255, 0, 255);
+
+    LOG_INFO << "Benchmark 'sampler': " << targetWidth << "x" << targetHeight << " samples x " << repeats
+        << ", texture " << decalTexture.getWidth() << "x" << decalTexture.getHeight();
+
+    // Today's per-pixel loop: full homography, divide and double-precision blend
+    Image reference(targetWidth, targetHeight);
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        for (int y = 0; y < targetHeight; y++) {
+            Color* row = reference.rowData(y);
+            for (int x = 0; x < targetWidth; x++) {
+                Vec3 p = Hinv * Vec3(x, y, 1.0);
+                if (std::abs(p.z) > 1e-8) {
+                    p.x /= p.z;
+                    p.y /= p.z;
+                }
+                row[x] = sampleBilinearReference(decalTexture, p.x, p.y, fallback);
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double referenceMs = std::chrono::duration<double, std::milli>(end - start).count() / repeats;
+    double pixels = static_cast<double>(targetWidth) * targetHeight;
+    LOG_INFO << "  reference: " << referenceMs << " ms, " << pixels / referenceMs / 1000.0 << " Mpix/s";
+
+    const KernelIsa kernels[] = { KernelIsa::SSE2, KernelIsa::SSE41, KernelIsa::AVX2, KernelIsa::AVX512 };
+    for (KernelIsa isa : kernels) {
+        if (!isKernelIsaSupported(isa)) {
+            LOG_INFO << "  " << kernelIsaName(isa) << ": not supported on this CPU";
+            continue;
+        }
+
+        Image result(targetWidth, targetHeight);
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r++) {
+            for (int y = 0; y < targetHeight; y++) {
+                sampleTextureSpan(makeTextureSpan(decalTexture, Hinv, y, 0, targetWidth - 1, fallback, result.rowData(y)), isa);
+            }
+        }
+        end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count() / repeats;
+
+        long long differingPixels = 0;
+        int maxDiff = compareFrames({ reference }, { result }, differingPixels);
+        LOG_INFO << "  " << kernelIsaName(isa) << ": " << ms << " ms, " << pixels / ms / 1000.0 << " Mpix/s, speedup "
+            << referenceMs / ms << "x, max channel difference " << maxDiff
+            << " (" << differingPixels << " pixels differ)";
+    }
+
+    // The area filter needs a summed-area table, which the decal only has when
+    // it is the configured filter
+    Texture areaTexture;
+    const Texture* areaSource = &decalTexture;
+    if (!decalTexture.summedAreaData()) {
+        areaTexture = loadTexture(config.decalImagePath);
+        areaTexture.buildSummedAreaTable();
+        areaSource = &areaTexture;
+    }
+
+    // Filters on a heavily minified quad, where trilinear reads the small mip levels
+    const int smallSize = 48;
+    std::vector<Vec2> smallQuad = { Vec2(4, 6), Vec2(44, 2), Vec2(40, 44), Vec2(2, 40) };
+    Mat3x3 smallHinv = computeHomography(textureCorners, smallQuad).inverse();
+    const int smallRepeats = repeats * 100;
+    const TextureFilter filters[] = {
+        TextureFilter::Nearest, TextureFilter::Bilinear, TextureFilter::Trilinear, TextureFilter::Area
+    };
+    for (TextureFilter filter : filters) {
+        const Texture& texture = filter == TextureFilter::Area ? *areaSource : decalTexture;
+        Image result(smallSize, smallSize);
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < smallRepeats; r++) {
+            for (int y = 0; y < smallSize; y++) {
+                sampleFilteredSpan(makeTextureSpan(texture, smallHinv, y, 0, smallSize - 1, fallback, result.rowData(y)), filter);
+            }
+        }
+        end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count() / smallRepeats;
+        LOG_INFO << "  " << textureFilterName(filter) << " (" << smallSize << "x" << smallSize << " minified): "
+            << ms * 1000.0 << " us, " << smallSize * smallSize / ms / 1000.0 << " Mpix/s";
+    }
+
+    // A large texture minified onto a small perspective quad, so the pixels of one
+    // vector span several mip levels: the vector trilinear and area kernels against
+    // the portable ones, which must give identical bytes in either texel layout
+    const int largeSize = 2048;
+    std::vector<uint32_t> pattern(static_cast<size_t>(largeSize) * largeSize);
+    for (int y = 0; y < largeSize; y++) {
+        for (int x = 0; x < largeSize; x++) {
+            const uint32_t noise = (static_cast<uint32_t>(x) * 0x9E3779B1u) ^ (static_cast<uint32_t>(y) * 0x85EBCA77u);
+            pattern[static_cast<size_t>(y) * largeSize + x] = 0xFF000000u | ((x ^ y) & 0xFF) |
+                (((x >> 3) + (y >> 3)) & 0xFF) << 8 | (noise >> 24) << 16;
+        }
+    }
+    const TextureLayout layouts[] = { TextureLayout::Linear, TextureLayout::Tiled };
+    std::vector<Texture> largeTextures;
+    for (TextureLayout layout : layouts) {
+        largeTextures.emplace_back(pattern.data(), largeSize, largeSize, layout);
+        largeTextures.back().buildSummedAreaTable();
+    }
+    const int minifiedSize = 160;
+    std::vector<Vec2> largeCorners = {
+        Vec2(0, 0), Vec2(largeSize - 1, 0), Vec2(largeSize - 1, largeSize - 1), Vec2(0, largeSize - 1)
+    };
+    std::vector<Vec2> minifiedQuad = { Vec2(12, 30), Vec2(150, 4), Vec2(156, 152), Vec2(2, 118) };
+    Mat3x3 minifiedHinv = computeHomography(largeCorners, minifiedQuad).inverse();
+    const int minifiedRepeats = repeats * 10;
+    const TextureFilter minifiedFilters[] = { TextureFilter::Bilinear, TextureFilter::Trilinear, TextureFilter::Area };
+    bool identical = true;
+    for (TextureFilter filter : minifiedFilters) {
+        Image portable(minifiedSize, minifiedSize);
+        Image portableTiled(minifiedSize, minifiedSize);
+        double portableMs = 0;
+        for (KernelIsa isa : kernels) {
+            if (!isKernelIsaSupported(isa)) {
+                continue;
+            }
+            Image result(minifiedSize, minifiedSize);
+            start = std::chrono::steady_clock::now();
+            for (int r = 0; r < minifiedRepeats; r++) {
+                for (int y = 0; y < minifiedSize; y++) {
+                    sampleFilteredSpan(makeTextureSpan(largeTextures[0], minifiedHinv, y, 0, minifiedSize - 1, fallback,
+                        result.rowData(y)), filter, TexturePrecision::Double, isa);
+                }
+            }
+            end = std::chrono::steady_clock::now();
+            double ms = std::chrono::duration<double, std::milli>(end - start).count() / minifiedRepeats;
+
+            Image tiled(minifiedSize, minifiedSize);
+            for (int y = 0; y < minifiedSize; y++) {
+                sampleFilteredSpan(makeTextureSpan(largeTextures[1], minifiedHinv, y, 0, minifiedSize - 1, fallback,
+                    tiled.rowData(y)), filter, TexturePrecision::Double, isa);
+            }
+
+            // SSE2 runs the portable kernels, which the others must match
+            if (isa == KernelIsa::SSE2) {
+                portable = result;
+                portableTiled = tiled;
+                portableMs = ms;
+            }
+            long long differingPixels = 0;
+            long long differingTiled = 0;
+            int maxDiff = compareFrames({ portable }, { result }, differingPixels);
+            int maxDiffTiled = compareFrames({ portableTiled }, { tiled }, differingTiled);
+            LOG_INFO << "  " << textureFilterName(filter) << " (" << largeSize << "x" << largeSize << " on "
+                << minifiedSize << "x" << minifiedSize << ") " << kernelIsaName(isa) << ": " << ms * 1000.0 << " us, "
+                << minifiedSize * minifiedSize / ms / 1000.0 << " Mpix/s, speedup " << portableMs / ms << "x";
+            if (maxDiff != 0 || maxDiffTiled != 0) {
+                LOG_ERROR << "  " << textureFilterName(filter) << " " << kernelIsaName(isa) << " differs from SSE2 in "
+                    << differingPixels << " linear and " << differingTiled << " tiled pixels (max channel difference "
+                    << std::max(maxDiff, maxDiffTiled) << ")";
+                identical = false;
+            }
+        }
+    }
+
+    // An oblique strip: the texture stretched along x and squeezed 8x along y, as a
+    // face seen at a grazing angle. Each filter is compared with the mean of 16x16
+    // bilinear samples per pixel.
+    const int stripWidth = 640;
+    const int stripHeight = 24;
+    const int subsamples = 16;
+    std::vector<Vec2> strip = { Vec2(0, 2), Vec2(stripWidth - 1, 0), Vec2(stripWidth - 1, stripHeight - 1),
+        Vec2(0, stripHeight - 3) };
+    Mat3x3 stripHinv = computeHomography(textureCorners, strip).inverse();
+    std::vector<double> truth(static_cast<size_t>(stripWidth) * stripHeight * 3);
+    for (int y = 0; y < stripHeight; y++) {
+        for (int x = 0; x < stripWidth; x++) {
+            double sum[3] = { 0, 0, 0 };
+            for (int sy = 0; sy < subsamples; sy++) {
+                for (int sx = 0; sx < subsamples; sx++) {
+                    Vec3 p = stripHinv * Vec3(x - 0.5 + (sx + 0.5) / subsamples, y - 0.5 + (sy + 0.5) / subsamples, 1.0);
+                    Color c = sampleBilinearReference(decalTexture, p.x / p.z, p.y / p.z, fallback);
+                    sum[0] += c.r;
+                    sum[1] += c.g;
+                    sum[2] += c.b;
+                }
+            }
+            for (int c = 0; c < 3; c++) {
+                truth[(static_cast<size_t>(y) * stripWidth + x) * 3 + c] = sum[c] / (subsamples * subsamples);
+            }
+        }
+    }
+    const int stripRepeats = repeats * 10;
+    for (TextureFilter filter : filters) {
+        const Texture& texture = filter == TextureFilter::Area ? *areaSource : decalTexture;
+        Image result(stripWidth, stripHeight);
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < stripRepeats; r++) {
+            for (int y = 0; y < stripHeight; y++) {
+                sampleFilteredSpan(makeTextureSpan(texture, stripHinv, y, 0, stripWidth - 1, fallback, result.rowData(y)), filter);
+            }
+        }
+        end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count() / stripRepeats;
+
+        double error = 0;
+        for (int y = 0; y < stripHeight; y++) {
+            const unsigned char* row = reinterpret_cast<const unsigned char*>(result.rowData(y));
+            for (int i = 0; i < stripWidth * 3; i++) {
+                error += std::abs(row[i] - truth[static_cast<size_t>(y) * stripWidth * 3 + i]);
+            }
+        }
+        LOG_INFO << "  " << textureFilterName(filter) << " (" << stripWidth << "x" << stripHeight << " oblique): "
+            << ms * 1000.0 << " us, " << stripWidth * stripHeight / ms / 1000.0 << " Mpix/s, mean error "
+            << error / truth.size() << " against " << subsamples << "x" << subsamples << " supersampling";
+    }
+    return identical;
+}
+
+// Span shader sampling the covered pixels of a quad with the active kernel
+struct SweepShader {
+    Image& target;
+    const Texture& texture;
+    const Mat3x3& Hinv;
+    Color fallback;
+
+    void span(int y, int x0, int x1) {
+        sampleTextureSpan(makeTextureSpan(texture, Hinv, y, x0, x1, fallback, target.rowData(y) + x0));
+    }
+};
+
+void Benchmark::runRotationSweep() {
+    const int angleSteps = 12;
+    const int repeats = 3;
+
+    // A large synthetic texture so a quarter turn really strides across rows
+    Image pattern(SWEEP_TEXTURE_SIZE, SWEEP_TEXTURE_SIZE);
+    for (int y = 0; y < SWEEP_TEXTURE_SIZE; y++) {
+        Color* row = pattern.rowData(y);
+        for (int x = 0; x < SWEEP_TEXTURE_SIZE; x++) {
+            row[x] = Color(x & 0xFF, y & 0xFF, (x ^ y) & 0xFF);
+        }
+    }
+
+    double extent = SWEEP_TEXTURE_SIZE - 1;
+    std::vector<Vec2> textureCorners = { Vec2(0, 0), Vec2(extent, 0), Vec2(extent, extent), Vec2(0, extent) };
+    const double center = SWEEP_TARGET_SIZE / 2.0;
+    const double radius = SWEEP_TARGET_SIZE * 0.49;
+    RasterRect clip(0, 0, SWEEP_TARGET_SIZE - 1, SWEEP_TARGET_SIZE - 1);
+
+    LOG_INFO << "Benchmark 'rotation': " << SWEEP_TEXTURE_SIZE << "x" << SWEEP_TEXTURE_SIZE << " texture on a "
+        << SWEEP_TARGET_SIZE << "x" << SWEEP_TARGET_SIZE << " target, " << kernelIsaName(getKernelIsa()) << " bilinear";
+
+    const TextureLayout layouts[] = { TextureLayout::Linear, TextureLayout::Tiled };
+    for (TextureLayout layout : layouts) {
+        Texture texture(pattern, layout);
+        Image target(SWEEP_TARGET_SIZE, SWEEP_TARGET_SIZE);
+        double fastestMs = 0.0;
+        double slowestMs = 0.0;
+
+        for (int step = 0; step < angleSteps; step++) {
+            // Square inscribed in the target, rotated in the image plane
+            double angle = step * M_PI / angleSteps;
+            std::vector<Vec2> quad;
+            for (int corner = 0; corner < 4; corner++) {
+                double a = angle + (corner * 0.5 - 0.75) * M_PI;
+                quad.push_back(Vec2(center + radius * std::cos(a), center + radius * std::sin(a)));
+            }
+            Mat3x3 Hinv = computeHomography(textureCorners, quad).inverse();
+            Rasterizer rasterizer(quad.data(), 4);
+            SweepShader shader = { target, texture, Hinv, Color(255, 0, 255) };
+
+            auto start = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeats; r++) {
+                rasterizer.rasterize(clip, shader);
+            }
+            auto end = std::chrono::steady_clock::now();
+            double ms = std::chrono::duration<double, std::milli>(end - start).count() / repeats;
+
+            fastestMs = (step == 0) ? ms : std::min(fastestMs, ms);
+            slowestMs = std::max(slowestMs, ms);
+            LOG_INFO << "  " << textureLayoutName(layout) << " " << static_cast<int>(angle * 180.0 / M_PI + 0.5)
+                << " deg: " << ms << " ms";
+        }
+
+        LOG_INFO << "  " << textureLayoutName(layout) << ": " << fastestMs << "-" << slowestMs
+            << " ms, slowest/fastest " << slowestMs / fastestMs;
+    }
+}
+
+void Benchmark::runHomographySetup() {
+    const int quadCount = 64;
+    const int repeats = 2000;
+
+    // Perspective quads: a square tilted away from the viewer at varying angles
+    std::vector<std::vector<Vec2>> quads;
+    for (int i = 0; i < quadCount; i++) {
+        double angle = 0.1 + 1.3 * i / quadCount;
+        double spin = 2.0 * M_PI * i / quadCount;
+        std::vector<Vec2> quad;
+        for (int corner = 0; corner < 4; corner++) {
+            double a = spin + corner * 0.5 * M_PI;
+            double x = std::cos(a);
+            double y = std::sin(a) * std::cos(angle);
+            double z = 4.0 + std::sin(a) * std::sin(angle);
+            quad.push_back(Vec2(640.0 + 600.0 * x / z, 360.0 + 600.0 * y / z));
+        }
+        quads.push_back(quad);
+    }
+
+    double extent = decalTexture.getWidth() - 1;
+    double extentY = decalTexture.getHeight() - 1;
+    std::vector<Vec2> textureCorners = { Vec2(0, 0), Vec2(extent, 0), Vec2(extent, extentY), Vec2(0, extentY) };
+
+    // Sum of an entry of every mapping, so neither loop can be optimized away
+    double checksumSolve = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        for (const auto& quad : quads) {
+            Mat3x3 Hinv = computeHomography(textureCorners.data(), quad.data()).inverse();
+            checksumSolve += Hinv.m[0][0] / Hinv.m[2][2];
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double solveNs = std::chrono::duration<double, std::nano>(end - start).count() / (repeats * quadCount);
+
+    double checksumClosed = 0.0;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        for (const auto& quad : quads) {
+            Mat3x3 Hinv;
+            if (quadToSquare(quad.data(), Hinv)) {
+                checksumClosed += Hinv.m[0][0] * extent / Hinv.m[2][2];
+            }
+        }
+    }
+    end = std::chrono::steady_clock::now();
+    double closedNs = std::chrono::duration<double, std::nano>(end - start).count() / (repeats * quadCount);
+
+    LOG_INFO << "Benchmark 'homography': " << quadCount << " perspective quads x " << repeats;
+    LOG_INFO << "  8x8 solve + inverse: " << solveNs << " ns/face";
+    LOG_INFO << "  closed form:         " << closedNs << " ns/face";
+    LOG_INFO << "  speedup: " << solveNs / closedNs << "x, relative mapping difference "
+        << std::abs(checksumSolve - checksumClosed) / std::abs(checksumSolve);
+}
+
+void Benchmark::runClipping() {
+    struct ClipScene {
+        const char* name;
+        double cubeSize;
+        double cameraScale;
+    };
+    // The cube sits 10 units in front of the camera: a 14-unit cube sweeps its
+    // corners through the near plane, a 30-unit cube contains the camera
+    const ClipScene scenes[] = {
+        { "configured", config.cubeSize, config.cameraScale },
+        { "crossing near plane", 14.0, config.cameraScale },
+        { "camera inside cube", 30.0, config.cameraScale },
+        { "1000x camera scale", config.cubeSize, config.cameraScale * 1000.0 }
+    };
+    const int tileSize = config.tileSize > 0 ? config.tileSize : 64;
+
+    LOG_INFO << "Benchmark 'clipping': " << config.width << "x" << config.height
+        << ", " << sampleFrames(MAX_SAMPLED_FRAMES).size() << " frames per scene";
+
+    for (const auto& clipScene : scenes) {
+        ConfigManager scene = config;
+        scene.cubeSize = clipScene.cubeSize;
+        scene.cameraScale = clipScene.cameraScale;
+
+        Renderer untiled(scene);
+        untiled.setTiling(0, 1);
+        std::vector<uint64_t> expected;
+        double frameMs = timeFrames(scene, untiled, MAX_SAMPLED_FRAMES,
+            [&](size_t, const Image& image) { expected.push_back(checksum(image)); });
+        const RenderStats& stats = untiled.getStats();
+
+        Renderer tiled(scene);
+        tiled.setTiling(tileSize, 1);
+        bool identical = true;
+        timeFrames(scene, tiled, MAX_SAMPLED_FRAMES,
+            [&](size_t i, const Image& image) { identical = identical && checksum(image) == expected[i]; });
+
+        double frames = static_cast<double>(std::max<long long>(1, stats.frames));
+        LOG_INFO << "  " << clipScene.name << ": " << frameMs << " ms/frame, "
+            << stats.clippedFaces / frames << " clipped and " << stats.culledFaces / frames
+            << " culled faces/frame, tiled " << (identical ? "identical" : "MISMATCH");
+    }
+}
+
+void Benchmark::runVertexTransform() {
+    // A field of points 40 per side around the cube, as a mesh or cube field would have
+    const int side = 40;
+    const size_t count = static_cast<size_t>(side) * side * side;
+    const int repeats = 50;
+
+    std::vector<Vec3> points;
+    std::vector<double> xs, ys, zs;
+    std::vector<float> xf, yf, zf;
+    points.reserve(count);
+    for (int i = 0; i < side; i++) {
+        for (int j = 0; j < side; j++) {
+            for (int k = 0; k < side; k++) {
+                Vec3 p((i - side / 2) * 0.1, (j - side / 2) * 0.1, (k - side / 2) * 0.1);
+                points.push_back(p);
+                xs.push_back(p.x);
+                ys.push_back(p.y);
+                zs.push_back(p.z);
+                xf.push_back(static_cast<float>(p.x));
+                yf.push_back(static_cast<float>(p.y));
+                zf.push_back(static_cast<float>(p.z));
+            }
+        }
+    }
+
+    // Model transform of a mid-animation frame, as the renderer builds it
+    Mat4x4 model;
+    model.m[2][3] = 10.0;
+    model = model * config.calculateRotation(config.numFrames / 3);
+    const double cx = config.width / 2.0;
+    const double cy = config.height / 2.0;
+    const Mat4x4 transform = perspectiveProjection(config.cameraScale, cx, cy) * model;
+
+    LOG_INFO << "Benchmark 'vertices': " << count << " vertices x " << repeats;
+
+    // Current path: one Vec3 at a time through Mat4x4::transform and projectPoint
+    std::vector<Vec2> reference(count);
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        for (size_t i = 0; i < count; i++) {
+            reference[i] = projectPoint(model.transform(points[i]), config.cameraScale, cx, cy);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double perVertexSeconds = std::chrono::duration<double>(end - start).count();
+    LOG_INFO << "  per-vertex AoS: " << count * repeats / perVertexSeconds / 1e6 << " Mvertices/s";
+
+    std::vector<double> sx(count), sy(count), depth(count);
+    std::vector<float> sxf(count), syf(count), depthf(count);
+    const PointsSoA in = { xs.data(), ys.data(), zs.data() };
+    const ScreenPointsSoA out = { sx.data(), sy.data(), depth.data() };
+    const PointsSoAf inf = { xf.data(), yf.data(), zf.data() };
+    const ScreenPointsSoAf outf = { sxf.data(), syf.data(), depthf.data() };
+
+    // Largest distance in pixels from the per-vertex result
+    auto maxError = [&](const auto& x, const auto& y) {
+        double error = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            error = std::max(error, std::max(std::abs(x[i] - reference[i].x), std::abs(y[i] - reference[i].y)));
+        }
+        return error;
+    };
+
+    struct Kernel {
+        const char* name;
+        bool available;
+        std::function<void()> run;
+        bool single;
+    };
+    const Kernel kernels[] = {
+        { "SoA scalar double", true, [&]() { transformAndProjectScalar(transform.m, in, out, 0, count); }, false },
+#ifdef CUBE_X86_KERNELS
+        { "SoA AVX2 double  ", cpuHasAVX2(), [&]() { transformAndProjectAVX2(transform.m, in, out, count); }, false },
+#endif
+        { "SoA scalar float ", true, [&]() { transformAndProjectScalar(transform.m, inf, outf, 0, count); }, true },
+#ifdef CUBE_X86_KERNELS
+        { "SoA AVX2 float   ", cpuHasAVX2(), [&]() { transformAndProjectAVX2(transform.m, inf, outf, count); }, true },
+#endif
+    };
+
+    uint64_t scalarHash[2] = { 0, 0 };
+    for (const auto& kernel : kernels) {
+        if (!kernel.available) {
+            LOG_INFO << "  " << kernel.name << ": not supported on this CPU";
+            continue;
+        }
+
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r++) {
+            kernel.run();
+        }
+        end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+
+        // Bitwise fingerprint of the output, to check every ISA agrees
+        uint64_t hash = 14695981039346656037ULL;
+        auto mix = [&hash](const void* data, size_t bytes) {
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < bytes; i++) {
+                hash = (hash ^ p[i]) * 1099511628211ULL;
+            }
+        };
+        double error;
+        if (kernel.single) {
+            mix(sxf.data(), count * sizeof(float));
+            mix(syf.data(), count * sizeof(float));
+            error = maxError(sxf, syf);
+        }
+        else {
+            mix(sx.data(), count * sizeof(double));
+            mix(sy.data(), count * sizeof(double));
+            error = maxError(sx, sy);
+        }
+        uint64_t& expected = scalarHash[kernel.single ? 1 : 0];
+        if (expected == 0) {
+            expected = hash;
+        }
+
+        LOG_INFO << "  " << kernel.name << ": " << count * repeats / seconds / 1e6 << " Mvertices/s, speedup "
+            << perVertexSeconds / seconds << "x, max error " << error << " px, "
+            << (hash == expected ? "matches scalar" : "MISMATCH with scalar");
+    }
+}
+
+void Benchmark::runSceneScaling() {
+    const int frames = 4;
+    const size_t visibleCounts[] = { 2500, 5000, 10000 };
+    const size_t totalCounts[] = { 10000, 30000, 100000 };
+
+    std::array<Color, 6> colors;
+    for (size_t i = 0; i < colors.size(); i++) {
+        colors[i] = i < config.faceColors.size() ? config.faceColors[i] : Color(128, 128, 128);
+    }
+
+    // `visible` small cubes in a block in front of the camera, the rest behind it
+    auto buildScene = [&](size_t visible, size_t total) {
+        Scene scene(Cube(0.3));
+        scene.reserve(total);
+        for (size_t i = 0; i < total; i++) {
+            size_t slot = i < visible ? i : i - visible;
+            double x = static_cast<double>(slot % 20) * 0.5 - 4.75;
+            double y = static_cast<double>((slot / 20) % 20) * 0.5 - 4.75;
+            double z = static_cast<double>(slot / 400) * 0.5;
+            Mat4x4 transform = rotateY(0.37 * i) * rotateX(0.21 * i);
+            transform.m[0][3] = x;
+            transform.m[1][3] = y;
+            transform.m[2][3] = i < visible ? 10.0 + z : -10.0 - z;
+            scene.addInstance(transform, i % 7 == 0 ? config.decalFaceIndex : -1, colors);
+        }
+        return scene;
+    };
+
+    auto timeScene = [&](const Scene& scene, RenderStats& stats) {
+        Renderer renderer(config);
+        renderer.setTiling(0, 1);
+        Image image;
+        Mat4x4 view;
+        renderer.renderFrame(image, scene, view, &decalTexture);  // Grow the scratch buffers
+        renderer.resetStats();
+
+        auto start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++) {
+            renderer.renderFrame(image, scene, view, &decalTexture);
+        }
+        auto end = std::chrono::steady_clock::now();
+        stats = renderer.getStats();
+        return std::chrono::duration<double, std::milli>(end - start).count() / frames;
+    };
+
+    LOG_INFO << "Benchmark 'scene': " << config.width << "x" << config.height << ", " << frames << " frames per run";
+
+    for (size_t visible : visibleCounts) {
+        for (size_t total : totalCounts) {
+            if (total < visible) continue;
+            RenderStats stats;
+            double frameMs = timeScene(buildScene(visible, total), stats);
+            LOG_INFO << "  " << total << " instances, " << stats.drawnInstances / frames << " visible, "
+                << stats.culledInstances / frames << " culled: " << frameMs << " ms/frame, "
+                << 1000.0 * frameMs / std::max<size_t>(1, visible) << " us per visible instance";
+        }
+    }
+
+    // Depth sort of 30000 faces: radix on 32-bit keys against std::sort on doubles
+    const size_t faceCount = 30000;
+    const int repeats = 20;
+    std::vector<double> depths(faceCount);
+    uint64_t seed = 12345;
+    for (size_t i = 0; i < faceCount; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        depths[i] = 5.0 + static_cast<double>(seed >> 11) / 9007199254740992.0 * 50.0;
+    }
+
+    std::vector<uint32_t> keys, order, scratchKeys, scratchOrder;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        keys.resize(faceCount);
+        order.resize(faceCount);
+        for (size_t i = 0; i < faceCount; i++) {
+            keys[i] = ~orderedFloatKey(depths[i]);
+            order[i] = static_cast<uint32_t>(i);
+        }
+        radixSortPairs(keys, order, scratchKeys, scratchOrder);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double radixUs = std::chrono::duration<double, std::micro>(end - start).count() / repeats;
+
+    std::vector<uint32_t> comparisonOrder(faceCount);
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        for (size_t i = 0; i < faceCount; i++) {
+            comparisonOrder[i] = static_cast<uint32_t>(i);
+        }
+        std::stable_sort(comparisonOrder.begin(), comparisonOrder.end(),
+            [&](uint32_t a, uint32_t b) { return depths[a] > depths[b]; });
+    }
+    end = std::chrono::steady_clock::now();
+    double comparisonUs = std::chrono::duration<double, std::micro>(end - start).count() / repeats;
+
+    // Keys keep single precision, so only faces closer than that may swap places
+    bool backToFront = true;
+    for (size_t i = 0; i + 1 < faceCount; i++) {
+        backToFront = backToFront &&
+            static_cast<float>(depths[order[i]]) >= static_cast<float>(depths[order[i + 1]]);
+    }
+
+    LOG_INFO << "  depth sort of " << faceCount << " faces: radix " << radixUs << " us, comparison "
+        << comparisonUs << " us, speedup " << comparisonUs / radixUs << "x, "
+        << (backToFront ? "back to front" : "MISORDERED");
+}
+
+// Writes a UV sphere as OBJ text: quads between rings, the lower half in material "label"
+static bool writeSphereObj(const std::string& filename, int segments, int rings) {
+    FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        LOG_ERROR << "Could not create " << filename;
+        return false;
+    }
+
+    for (int j = 0; j <= rings; j++) {
+        double theta = M_PI * j / rings;
+        for (int i = 0; i <= segments; i++) {
+            double phi = 2.0 * M_PI * i / segments;
+            std::fprintf(file, "v %.6f %.6f %.6f\n", std::sin(theta) * std::cos(phi), std::cos(theta),
+                -std::sin(theta) * std::sin(phi));
+        }
+    }
+    for (int j = 0; j <= rings; j++) {
+        for (int i = 0; i <= segments; i++) {
+            std::fprintf(file, "vt %.6f %.6f\n", static_cast<double>(i) / segments, 1.0 - static_cast<double>(j) / rings);
+        }
+    }
+
+    std::fprintf(file, "usemtl body\n");
+    const int row = segments + 1;
+    for (int j = 0; j < rings; j++) {
+        if (j == rings / 2) {
+            std::fprintf(file, "usemtl label\n");
+        }
+        for (int i = 0; i < segments; i++) {
+            int a = j * row + i + 1;
+            int b = a + row;
+            std::fprintf(file, "f %d/%d %d/%d %d/%d %d/%d\n", a, a, b, b, b + 1, b + 1, a + 1, a + 1);
+        }
+    }
+
+    bool written = std::ferror(file) == 0;
+    written = std::fclose(file) == 0 && written;
+    return written;
+}
+
+void Benchmark::runMeshPath() {
+    // The configured mesh, or a generated sphere of 500k triangles
+    std::string path = config.meshPath;
+    std::string decalMaterialName = config.meshDecalMaterial;
+    bool generated = false;
+    if (path.empty()) {
+        const char* directory = std::getenv("TMPDIR");
+        path = std::string(directory ? directory : ".") + "/benchmark_sphere.obj";
+        decalMaterialName = "label";
+        if (!writeSphereObj(path, 500, 500)) {
+            return;
+        }
+        generated = true;
+    }
+
+    LOG_INFO << "Benchmark 'mesh': " << path << ", " << config.width << "x" << config.height;
+
+    // Best of three loads, so the page cache is warm
+    Mesh mesh;
+    double loadMs = 0.0;
+    for (int attempt = 0; attempt < 3; attempt++) {
+        auto start = std::chrono::steady_clock::now();
+        bool loaded = loadObjMesh(path, mesh);
+        auto end = std::chrono::steady_clock::now();
+        if (!loaded) {
+            return;
+        }
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        loadMs = attempt == 0 ? ms : std::min(loadMs, ms);
+    }
+    if (generated) {
+        std::remove(path.c_str());
+    }
+    LOG_INFO << "  load: " << mesh.triangleCount() << " triangles, " << mesh.vertexCount() << " vertices in "
+        << loadMs << " ms (" << mesh.triangleCount() / loadMs / 1000.0 << " Mtriangles/s)";
+
+    // Frame time of the triangle path
+    Cube cube(config.cubeSize);
+    mesh.fitToRadius(cube.boundingRadius);
+    int decalMaterial = decalMaterialName.empty() ? config.decalFaceIndex : mesh.findMaterial(decalMaterialName);
+    Renderer renderer(config);
+    renderer.setTiling(0, 1);
+    Image image;
+    std::vector<int> frames = sampleFrames(MESH_SAMPLED_FRAMES);
+    renderer.renderFrame(image, mesh, config.calculateRotation(0), decalMaterial, &decalTexture);
+    double totalMs = 0.0;
+    for (int frame : frames) {
+        Mat4x4 rotation = config.calculateRotation(frame);
+        auto start = std::chrono::steady_clock::now();
+        renderer.renderFrame(image, mesh, rotation, decalMaterial, &decalTexture);
+        auto end = std::chrono::steady_clock::now();
+        totalMs += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    double frameMs = totalMs / std::max<size_t>(1, frames.size());
+    LOG_INFO << "  render: " << frameMs << " ms/frame, " << mesh.triangleCount() / frameMs / 1000.0
+        << " Mtriangles/s";
+
+    // The cube as two textured triangles per face against the quad path. With black
+    // faces neither path shades anything, so apart from the quad path's white outlines
+    // only the texture mapping can differ.
+    ConfigManager black = config;
+    for (auto& color : black.faceColors) {
+        color = Color(0, 0, 0);
+    }
+    Renderer quads(black);
+    Renderer triangles(black);
+    quads.setTiling(0, 1);
+    triangles.setTiling(0, 1);
+    Mesh cubeMesh = cube.toMesh();
+    long long differingPixels = 0;
+    long long comparedPixels = 0;
+    int maxDiff = 0;
+    Image quadImage;
+    Image triangleImage;
+    for (int frame : sampleFrames(MAX_SAMPLED_FRAMES)) {
+        Mat4x4 rotation = config.calculateRotation(frame);
+        quads.renderFrame(quadImage, cube, 0.0, &decalTexture, &rotation);
+        triangles.renderFrame(triangleImage, cubeMesh, rotation, quads.getDecalFaceIndex(), &decalTexture);
+        for (int y = 0; y < quadImage.getHeight(); y++) {
+            const Color* a = quadImage.rowData(y);
+            const Color* b = triangleImage.rowData(y);
+            for (int x = 0; x < quadImage.getWidth(); x++) {
+                if (a[x].r == 255 && a[x].g == 255 && a[x].b == 255) {
+                    continue;
+                }
+                int diff = std::max({ std::abs(a[x].r - b[x].r), std::abs(a[x].g - b[x].g), std::abs(a[x].b - b[x].b) });
+                comparedPixels++;
+                if (diff > 0) {
+                    differingPixels++;
+                    maxDiff = std::max(maxDiff, diff);
+                }
+            }
+        }
+    }
+    LOG_INFO << "  cube as triangles vs quads: " << differingPixels << " of " << comparedPixels
+        << " pixels differ, max channel difference " << maxDiff;
+}
+
+void Benchmark::runDepthTest() {
+    const int frames = 4;
+    const size_t instanceCount = 600;
+
+    std::array<Color, 6> colors;
+    for (size_t i = 0; i < colors.size(); i++) {
+        colors[i] = i < config.faceColors.size() ? config.faceColors[i] : Color(128, 128, 128);
+    }
+
+    // Interpenetrating cubes stacked 10 deep in front of the camera, in scrambled depth order
+    Scene scene(Cube(1.5));
+    scene.reserve(instanceCount);
+    for (size_t i = 0; i < instanceCount; i++) {
+        const size_t slot = (i * 2654435761ULL) % instanceCount;
+        Mat4x4 transform = rotateY(0.37 * i) * rotateX(0.21 * i);
+        transform.m[0][3] = static_cast<double>(slot % 10) * 0.9 - 4.05;
+        transform.m[1][3] = static_cast<double>((slot / 10) % 6) * 0.9 - 2.25;
+        transform.m[2][3] = 8.0 + static_cast<double>(slot / 60) * 0.6;
+        scene.addInstance(transform, i % 5 == 0 ? config.decalFaceIndex : -1, colors);
+    }
+
+    auto timeDepth = [&](int bits, bool visibility, Image& image, RenderStats& stats) {
+        Renderer renderer(config);
+        renderer.setTiling(0, 1);
+        renderer.setDepthBuffer(bits);
+        renderer.setVisibilityBuffer(visibility);
+        Mat4x4 view;
+        renderer.renderFrame(image, scene, view, &decalTexture);  // Grow the scratch buffers
+        renderer.resetStats();
+
+        auto start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++) {
+            renderer.renderFrame(image, scene, view, &decalTexture);
+        }
+        auto end = std::chrono::steady_clock::now();
+        stats = renderer.getStats();
+        return std::chrono::duration<double, std::milli>(end - start).count() / frames;
+    };
+
+    LOG_INFO << "Benchmark 'depth': " << instanceCount << " overlapping cubes at " << config.width << "x"
+        << config.height << ", " << frames << " frames per run";
+
+    // Without a depth buffer every face pixel is shaded, which gives the depth complexity
+    const double screenPixels = static_cast<double>(config.width) * config.height * frames;
+    const int precisions[] = { 0, 16, 32 };
+    std::vector<Image> images(4);
+    for (int p = 0; p < 3; p++) {
+        RenderStats stats;
+        double frameMs = timeDepth(precisions[p], false, images[p], stats);
+        if (precisions[p] == 0) {
+            LOG_INFO << "  sorted, no depth buffer: " << frameMs << " ms/frame, depth complexity "
+                << stats.shadedPixels / screenPixels << ", textured pixels " << stats.texturedPixels / frames
+                << " per frame";
+            continue;
+        }
+        LOG_INFO << "  " << precisions[p] << "-bit depth buffer: " << frameMs << " ms/frame, overdraw "
+            << stats.shadedPixels / screenPixels << ", textured pixels " << stats.texturedPixels / frames
+            << " per frame; per frame " << stats.occludedBlocks / frames << " blocks skipped whole, "
+            << stats.blockRejectedPixels / frames << " pixels rejected by block range, "
+            << stats.depthRejectedPixels / frames << " by per-pixel compare";
+    }
+
+    // Visibility buffer: ids are depth-tested as above, then every covered pixel is shaded once
+    RenderStats visibilityStats;
+    double visibilityMs = timeDepth(32, true, images[3], visibilityStats);
+    LOG_INFO << "  visibility buffer, 32-bit depth: " << visibilityMs << " ms/frame, id overdraw "
+        << visibilityStats.visibilityPixels / screenPixels << ", shaded per screen pixel "
+        << visibilityStats.shadedPixels / screenPixels << ", textured pixels "
+        << visibilityStats.texturedPixels / frames << " per frame";
+
+    long long differingPixels = 0;
+    int maxDiff = compareFrames(std::vector<Image>(1, images[1]), std::vector<Image>(1, images[2]), differingPixels);
+    LOG_INFO << "  16-bit vs 32-bit depth: " << differingPixels << " pixels differ, max channel difference " << maxDiff;
+    maxDiff = compareFrames(std::vector<Image>(1, images[2]), std::vector<Image>(1, images[3]), differingPixels);
+    LOG_INFO << "  visibility buffer vs direct shading: " << differingPixels << " pixels differ, max channel difference "
+        << maxDiff;
+}
+
+void Benchmark::runAntialiasing() {
+    LOG_INFO << "Benchmark 'antialiasing': " << config.width << "x" << config.height << ", "
+        << sampleFrames(MAX_SAMPLED_FRAMES).size() << " frames per mode";
+
+    // Box filter kernels on noise, at the sample counts of each mode
+    const int repeats = 10;
+    const int factors[] = { 2, 4 };
+    for (int factor : factors) {
+        Image samples(config.width * factor, config.height * factor);
+        uint32_t seed = 2463534242u;
+        for (int y = 0; y < samples.getHeight(); y++) {
+            Color* row = samples.rowData(y);
+            for (int x = 0; x < samples.getWidth(); x++) {
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                row[x] = Color(seed & 0xFF, (seed >> 8) & 0xFF, (seed >> 16) & 0xFF);
+            }
+        }
+
+        Image scalarPixels(config.width, config.height);
+        Image vectorPixels(config.width, config.height);
+        DownsampleRect rect;
+        rect.samples = reinterpret_cast<const unsigned char*>(samples.rowData(0));
+        rect.sampleStride = static_cast<size_t>(samples.getWidth()) * sizeof(Color);
+        rect.pixelStride = static_cast<size_t>(config.width) * sizeof(Color);
+        rect.width = config.width;
+        rect.height = config.height;
+        rect.factor = factor;
+
+        rect.pixels = reinterpret_cast<unsigned char*>(scalarPixels.rowData(0));
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r++) {
+            downsampleBoxScalar(rect, 0);
+        }
+        auto end = std::chrono::steady_clock::now();
+        double scalarMs = std::chrono::duration<double, std::milli>(end - start).count() / repeats;
+
+        std::ostringstream report;
+        report << "scalar " << scalarMs << " ms";
+#ifdef CUBE_X86_KERNELS
+        struct BoxKernel {
+            KernelIsa isa;
+            void (*filter)(const DownsampleRect&);
+        };
+        const BoxKernel kernels[] = { { KernelIsa::SSE41, downsampleBoxSSE41 }, { KernelIsa::AVX2, downsampleBoxAVX2 } };
+        for (const BoxKernel& kernel : kernels) {
+            if (!isKernelIsaSupported(kernel.isa)) {
+                continue;
+            }
+            rect.pixels = reinterpret_cast<unsigned char*>(vectorPixels.rowData(0));
+            start = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeats; r++) {
+                kernel.filter(rect);
+            }
+            end = std::chrono::steady_clock::now();
+            double vectorMs = std::chrono::duration<double, std::milli>(end - start).count() / repeats;
+
+            long long differingPixels = 0;
+            compareFrames(std::vector<Image>(1, scalarPixels), std::vector<Image>(1, vectorPixels), differingPixels);
+            report << ", " << kernelIsaName(kernel.isa) << " " << vectorMs << " ms (" << scalarMs / vectorMs << "x, "
+                << (differingPixels == 0 ? "identical" : "MISMATCH") << ")";
+        }
+#endif
+        LOG_INFO << "  " << factor << "x" << factor << " box filter: " << report.str();
+    }
+
+    // Frame cost of each mode on the configured scene
+    const Antialiasing modes[] = { Antialiasing::None, Antialiasing::SSAA2x2, Antialiasing::SSAA4x4, Antialiasing::MSAA4x };
+    double baseMs = 0.0;
+    for (Antialiasing mode : modes) {
+        Renderer renderer(config);
+        renderer.setTiling(0, 1);
+        renderer.setAntialiasing(mode);
+        double frameMs = timeFrames(config, renderer, MAX_SAMPLED_FRAMES, FrameVisitor());
+        const RenderStats& stats = renderer.getStats();
+        if (mode == Antialiasing::None) {
+            baseMs = frameMs;
+        }
+        LOG_INFO << "  " << antialiasingName(mode) << ": " << frameMs << " ms/frame ("
+            << (baseMs > 0 ? frameMs / baseMs : 0.0) << "x), " << stats.shadedPixels / stats.frames
+            << " shaded and " << stats.texturedPixels / stats.frames << " textured pixels per frame";
+    }
+}
+
+void Benchmark::runTextureLoad() {
+    LOG_INFO << "Benchmark 'load': " << LOAD_TEXTURE_SIZE << "x" << LOAD_TEXTURE_SIZE
+        << " decoded texture, then " << config.decalImagePath;
+
+    // Opaque noise laid out as stbi_load returns it with four channels requested
+    std::vector<uint32_t> decoded(static_cast<size_t>(LOAD_TEXTURE_SIZE) * LOAD_TEXTURE_SIZE);
+    uint32_t seed = 2463534242u;
+    for (uint32_t& texel : decoded) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        texel = seed | 0xFF000000u;
+    }
+
+    // Ingest only: the Image round trip against copying the rows straight into the
+    // padded texture; both build the same mip chain afterwards
+    const TextureLayout layouts[] = { TextureLayout::Linear, TextureLayout::Tiled };
+    for (TextureLayout layout : layouts) {
+        auto start = std::chrono::steady_clock::now();
+        Image image(reinterpret_cast<unsigned char*>(decoded.data()), LOAD_TEXTURE_SIZE, LOAD_TEXTURE_SIZE, 4);
+        Texture viaImage(image, layout);
+        auto end = std::chrono::steady_clock::now();
+        double imageMs = std::chrono::duration<double, std::milli>(end - start).count();
+        image = Image();
+
+        start = std::chrono::steady_clock::now();
+        Texture direct(decoded.data(), LOAD_TEXTURE_SIZE, LOAD_TEXTURE_SIZE, layout);
+        end = std::chrono::steady_clock::now();
+        double directMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+        // A malloc'd copy stands in for the buffer stbi_load hands over
+        uint32_t* owned = static_cast<uint32_t*>(std::malloc(decoded.size() * sizeof(uint32_t)));
+        std::memcpy(owned, decoded.data(), decoded.size() * sizeof(uint32_t));
+        start = std::chrono::steady_clock::now();
+        Texture adopted = Texture::adopt(owned, LOAD_TEXTURE_SIZE, LOAD_TEXTURE_SIZE, layout);
+        end = std::chrono::steady_clock::now();
+        double adoptMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+        // Every base texel, padding included, must be the nearest decoded texel
+        const MipLevel& base = direct.getLevel(0);
+        bool identical = viaImage.getLevelCount() == direct.getLevelCount() &&
+            adopted.getLevelCount() == direct.getLevelCount();
+        for (int y = -Texture::PADDING; identical && y < LOAD_TEXTURE_SIZE + Texture::PADDING; y++) {
+            const uint32_t* row = decoded.data() +
+                static_cast<size_t>(std::min(std::max(y, 0), LOAD_TEXTURE_SIZE - 1)) * LOAD_TEXTURE_SIZE;
+            for (int x = -Texture::PADDING; x < LOAD_TEXTURE_SIZE + Texture::PADDING; x++) {
+                const uint32_t expected = row[std::min(std::max(x, 0), LOAD_TEXTURE_SIZE - 1)];
+                const ptrdiff_t offset = Texture::texelOffset(base, x, y);
+                if (base.texels[offset] != expected || viaImage.texelData()[offset] != expected ||
+                    adopted.texelData()[offset] != expected) {
+                    identical = false;
+                    break;
+                }
+            }
+        }
+        LOG_INFO << "  " << textureLayoutName(layout) << ": via Image " << imageMs << " ms, copied rows "
+            << directMs << " ms (" << imageMs / directMs << "x), adopted buffer " << adoptMs << " ms ("
+            << imageMs / adoptMs << "x), " << (identical ? "identical" : "MISMATCH");
+    }
+
+    // Whole load of the configured decal, decoding included
+    const int repeats = 10;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        Texture texture(loadImage(config.decalImagePath));
+    }
+    auto end = std::chrono::steady_clock::now();
+    double imageMs = std::chrono::duration<double, std::milli>(end - start).count() / repeats;
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        Texture texture = loadTexture(config.decalImagePath);
+    }
+    end = std::chrono::steady_clock::now();
+    double directMs = std::chrono::duration<double, std::milli>(end - start).count() / repeats;
+    LOG_INFO << "  decal file: loadImage + Texture " << imageMs << " ms, loadTexture " << directMs << " ms ("
+        << imageMs / directMs << "x)";
+
+    // The same load through a private texture cache: one miss that stores the entry, then hits
+    if (config.textureCacheDirectory.empty()) {
+        return;
+    }
+    TextureCache cache(config.textureCacheDirectory + "/benchmark",
+        static_cast<uint64_t>(std::max(config.textureCacheLimitMB, 0)) << 20);
+    cache.clear();
+    start = std::chrono::steady_clock::now();
+    Texture stored = cache.load(config.decalImagePath, TextureLayout::Linear);
+    end = std::chrono::steady_clock::now();
+    double missMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        Texture texture = cache.load(config.decalImagePath, TextureLayout::Linear);
+    }
+    end = std::chrono::steady_clock::now();
+    double hitMs = std::chrono::duration<double, std::milli>(end - start).count() / repeats;
+
+    Texture mapped = cache.load(config.decalImagePath, TextureLayout::Linear);
+    bool identical = mapped.getLevelCount() == stored.getLevelCount();
+    for (int l = 0; identical && l < mapped.getLevelCount(); l++) {
+        const MipLevel& a = stored.getLevel(l);
+        const MipLevel& b = mapped.getLevel(l);
+        for (int y = -Texture::PADDING; identical && y < a.height + Texture::PADDING; y++) {
+            identical = std::memcmp(a.texels + Texture::texelOffset(a, -Texture::PADDING, y),
+                b.texels + Texture::texelOffset(b, -Texture::PADDING, y),
+                (a.width + 2 * Texture::PADDING) * sizeof(uint32_t)) == 0;
+        }
+    }
+    cache.clear();
+    LOG_INFO << "  texture cache: miss and store " << missMs << " ms, mapped hit " << hitMs << " ms ("
+        << directMs / hitMs << "x faster than loadTexture), " << (identical ? "identical" : "MISMATCH");
+}
+
+void Benchmark::runPaging() {
+    if (config.textureCacheDirectory.empty()) {
+        LOG_WARNING << "Benchmark 'paging' writes its page file to the texture cache; set textureCache.directory to run it";
+        return;
+    }
+    LOG_INFO << "Benchmark 'paging': " << PAGING_TEXTURE_SIZE << "x" << PAGING_TEXTURE_SIZE << " texture, "
+        << PAGING_VIEWS << " views of " << PAGING_TARGET_SIZE << "x" << PAGING_TARGET_SIZE << ", "
+        << PAGING_BUDGET_MB << " MB page budget";
+
+    // Opaque noise, so any misplaced texel shows up in the comparison
+    std::vector<uint32_t> noise(static_cast<size_t>(PAGING_TEXTURE_SIZE) * PAGING_TEXTURE_SIZE);
+    uint32_t seed = 2463534242u;
+    for (uint32_t& texel : noise) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        texel = seed | 0xFF000000u;
+    }
+    Texture resident(noise.data(), PAGING_TEXTURE_SIZE, PAGING_TEXTURE_SIZE);
+
+    TextureCache cache(config.textureCacheDirectory + "/benchmark",
+        static_cast<uint64_t>(std::max(config.textureCacheLimitMB, 0)) << 20);
+    cache.clear();
+    const std::string pageFile = cache.entryPath("paging.pages");
+    auto start = std::chrono::steady_clock::now();
+    const bool converted = !pageFile.empty() &&
+        PagedTexture::convert(noise.data(), PAGING_TEXTURE_SIZE, PAGING_TEXTURE_SIZE, pageFile);
+    auto end = std::chrono::steady_clock::now();
+    std::vector<uint32_t>().swap(noise);
+    if (!converted) {
+        LOG_ERROR << "Could not write the page file";
+        return;
+    }
+    LOG_INFO << "  converted in " << std::chrono::duration<double, std::milli>(end - start).count() << " ms";
+
+    // Rotated square windows of 1024, 2048 and 4096 texels spread over the texture,
+    // from magnified to 4x minified
+    std::vector<Mat3x3> views;
+    const std::vector<Vec2> target = {
+        Vec2(0, 0), Vec2(PAGING_TARGET_SIZE - 1, 0),
+        Vec2(PAGING_TARGET_SIZE - 1, PAGING_TARGET_SIZE - 1), Vec2(0, PAGING_TARGET_SIZE - 1)
+    };
+    for (int v = 0; v < PAGING_VIEWS; v++) {
+        const double half = (PAGING_TEXTURE_SIZE / 16) << (v % 3);
+        const double angle = 0.35 * v;
+        const double centerX = PAGING_TEXTURE_SIZE * (0.25 + 0.5 * ((v * 5) % PAGING_VIEWS) / PAGING_VIEWS);
+        const double centerY = PAGING_TEXTURE_SIZE * (0.25 + 0.5 * ((v * 7) % PAGING_VIEWS) / PAGING_VIEWS);
+        std::vector<Vec2> window;
+        const double cornerX[] = { -1, 1, 1, -1 };
+        const double cornerY[] = { -1, -1, 1, 1 };
+        for (int c = 0; c < 4; c++) {
+            const double x = cornerX[c] * half;
+            const double y = cornerY[c] * half;
+            window.push_back(Vec2(centerX + x * std::cos(angle) - y * std::sin(angle),
+                centerY + x * std::sin(angle) + y * std::cos(angle)));
+        }
+        views.push_back(computeHomography(window, target).inverse());
+    }
+
+    const Color fallback(255, 0, 255);
+    const TextureFilter filters[] = { TextureFilter::Nearest, TextureFilter::Bilinear, TextureFilter::Trilinear };
+    for (TextureFilter filter : filters) {
+        // A fresh page cache per filter, so every filter starts cold
+        std::shared_ptr<PagedTexture> pages = std::make_shared<PagedTexture>();
+        if (!pages->open(pageFile, static_cast<uint64_t>(PAGING_BUDGET_MB) << 20)) {
+            break;
+        }
+        Texture paged = Texture::paged(pages);
+
+        double residentMs = 0, pagedMs = 0;
+        long long differingPixels = 0;
+        int maxDiff = 0;
+        Image a(PAGING_TARGET_SIZE, PAGING_TARGET_SIZE), b(PAGING_TARGET_SIZE, PAGING_TARGET_SIZE);
+        for (const Mat3x3& Hinv : views) {
+            start = std::chrono::steady_clock::now();
+            for (int y = 0; y < PAGING_TARGET_SIZE; y++) {
+                sampleFilteredSpan(makeTextureSpan(resident, Hinv, y, 0, PAGING_TARGET_SIZE - 1, fallback, a.rowData(y)), filter);
+            }
+            end = std::chrono::steady_clock::now();
+            residentMs += std::chrono::duration<double, std::milli>(end - start).count();
+
+            start = std::chrono::steady_clock::now();
+            for (int y = 0; y < PAGING_TARGET_SIZE; y++) {
+                sampleFilteredSpan(makeTextureSpan(paged, Hinv, y, 0, PAGING_TARGET_SIZE - 1, fallback, b.rowData(y)), filter);
+            }
+            end = std::chrono::steady_clock::now();
+            pagedMs += std::chrono::duration<double, std::milli>(end - start).count();
+
+            long long differing = 0;
+            maxDiff = std::max(maxDiff, compareFrames({ a }, { b }, differing));
+            differingPixels += differing;
+        }
+
+        PagedTexture::Stats stats = pages->getStats();
+        LOG_INFO << "  " << textureFilterName(filter) << ": resident " << residentMs / PAGING_VIEWS << " ms, paged "
+            << pagedMs / PAGING_VIEWS << " ms per view (" << pagedMs / residentMs << "x), " << stats.faults
+            << " pages read, " << stats.evictions << " evicted, peak " << stats.peakResidentBytes / 1024
+            << " KB resident, max channel difference " << maxDiff << " (" << differingPixels << " pixels differ)";
+    }
+    cache.clear();
+}
+
+bool Benchmark::runFixedPoint() {
+    // The perspective quad of the sampler scenario
+    const int targetWidth = 640;
+    const int targetHeight = 560;
+    const int repeats = 20;
+    std::vector<Vec2> textureCorners = {
+        Vec2(0, 0), Vec2(decalTexture.getWidth() - 1, 0),
+        Vec2(decalTexture.getWidth() - 1, decalTexture.getHeight() - 1), Vec2(0, decalTexture.getHeight() - 1)
+    };
+    std::vector<Vec2> quad = { Vec2(100, 80), Vec2(600, 40), Vec2(560, 520), Vec2(60, 470) };
+    Mat3x3 Hinv = computeHomography(textureCorners, quad).inverse();
+    const Color fallback(255, 0, 255);
+    const double pixels = static_cast<double>(targetWidth) * targetHeight;
+
+    LOG_INFO << "Benchmark 'fixed': " << targetWidth << "x" << targetHeight << " samples x " << repeats
+        << ", texture " << decalTexture.getWidth() << "x" << decalTexture.getHeight();
+
+    // Exact bilinear value at the exact coordinate of every pixel. Pixels whose
+    // coordinate lies within 1/256 texel of the texture's edge may land on either
+    // side of it in any finite precision and are left out of the error.
+    std::vector<char> nearEdge(static_cast<size_t>(targetWidth) * targetHeight);
+    const double margin = 1.0 / 256;
+    auto exactValues = [&](const Texture& texture) {
+        std::vector<double> truth(static_cast<size_t>(targetWidth) * targetHeight * 3);
+        for (int y = 0; y < targetHeight; y++) {
+            for (int x = 0; x < targetWidth; x++) {
+                Vec3 p = Hinv * Vec3(x, y, 1.0);
+                const double u = p.x / p.z;
+                const double v = p.y / p.z;
+                double* out = &truth[(static_cast<size_t>(y) * targetWidth + x) * 3];
+                nearEdge[static_cast<size_t>(y) * targetWidth + x] = std::abs(u) < margin || std::abs(v) < margin ||
+                    std::abs(u - texture.getWidth()) < margin || std::abs(v - texture.getHeight()) < margin;
+                if (u < 0 || v < 0 || u >= texture.getWidth() || v >= texture.getHeight()) {
+                    out[0] = fallback.r;
+                    out[1] = fallback.g;
+                    out[2] = fallback.b;
+                    continue;
+                }
+                // Texels past the last column and row repeat the edge, as the padding does
+                const int x0 = static_cast<int>(u);
+                const int y0 = static_cast<int>(v);
+                const int x1 = std::min(x0 + 1, texture.getWidth() - 1);
+                const int y1 = std::min(y0 + 1, texture.getHeight() - 1);
+                const double fx = u - x0;
+                const double fy = v - y0;
+                const Color c00 = texture.getPixel(x0, y0), c10 = texture.getPixel(x1, y0);
+                const Color c01 = texture.getPixel(x0, y1), c11 = texture.getPixel(x1, y1);
+                const int channels[4][3] = {
+                    { c00.r, c00.g, c00.b }, { c10.r, c10.g, c10.b }, { c01.r, c01.g, c01.b }, { c11.r, c11.g, c11.b }
+                };
+                for (int c = 0; c < 3; c++) {
+                    out[c] = (channels[0][c] * (1 - fx) + channels[1][c] * fx) * (1 - fy) +
+                        (channels[2][c] * (1 - fx) + channels[3][c] * fx) * fy;
+                }
+            }
+        }
+        return truth;
+    };
+    auto maxErrorOf = [&](const Image& result, const std::vector<double>& truth) {
+        double maxError = 0;
+        for (int y = 0; y < targetHeight; y++) {
+            const unsigned char* row = reinterpret_cast<const unsigned char*>(result.rowData(y));
+            for (int x = 0; x < targetWidth; x++) {
+                if (nearEdge[static_cast<size_t>(y) * targetWidth + x]) {
+                    continue;
+                }
+                for (int c = x * 3; c < x * 3 + 3; c++) {
+                    maxError = std::max(maxError, std::abs(row[c] - truth[static_cast<size_t>(y) * targetWidth * 3 + c]));
+                }
+            }
+        }
+        return maxError;
+    };
+    const std::vector<double> truth = exactValues(decalTexture);
+
+    // Portable double and the active kernel level against the fixed-point kernel
+    struct Variant {
+        const char* name;
+        std::function<void(const TextureSpan&)> sample;
+    };
+    std::vector<Variant> variants = {
+        { "double portable", [](const TextureSpan& span) { sampleTextureSpan(span, KernelIsa::SSE2); } },
+        { "fixed", [](const TextureSpan& span) { sampleSpanFixed(span); } }
+    };
+    if (getKernelIsa() != KernelIsa::SSE2) {
+        variants.insert(variants.begin() + 1, Variant{ kernelIsaName(getKernelIsa()),
+            [](const TextureSpan& span) { sampleTextureSpan(span, getKernelIsa()); } });
+    }
+
+    Image doubleResult, fixedResult;
+    double doubleMs = 0, fixedMaxError = 0;
+    for (const Variant& variant : variants) {
+        Image result(targetWidth, targetHeight);
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r++) {
+            for (int y = 0; y < targetHeight; y++) {
+                variant.sample(makeTextureSpan(decalTexture, Hinv, y, 0, targetWidth - 1, fallback, result.rowData(y)));
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count() / repeats;
+
+        if (&variant == &variants.front()) {
+            doubleResult = result;
+            doubleMs = ms;
+        }
+        double error = 0, maxError = 0;
+        int maxDiff = 0;
+        long long counted = 0, differingPixels = 0;
+        for (int y = 0; y < targetHeight; y++) {
+            const unsigned char* row = reinterpret_cast<const unsigned char*>(result.rowData(y));
+            const unsigned char* doubleRow = reinterpret_cast<const unsigned char*>(doubleResult.rowData(y));
+            for (int x = 0; x < targetWidth; x++) {
+                if (nearEdge[static_cast<size_t>(y) * targetWidth + x]) {
+                    continue;
+                }
+                int pixelDiff = 0;
+                for (int c = x * 3; c < x * 3 + 3; c++) {
+                    double e = std::abs(row[c] - truth[static_cast<size_t>(y) * targetWidth * 3 + c]);
+                    error += e;
+                    maxError = std::max(maxError, e);
+                    pixelDiff = std::max(pixelDiff, std::abs(row[c] - doubleRow[c]));
+                }
+                counted += 3;
+                differingPixels += pixelDiff > 0;
+                maxDiff = std::max(maxDiff, pixelDiff);
+            }
+        }
+        LOG_INFO << "  " << variant.name << ": " << ms << " ms, " << pixels / ms / 1000.0 << " Mpix/s ("
+            << doubleMs / ms << "x double portable), error against exact bilinear mean " << error / counted
+            << " max " << maxError << ", max channel difference from double " << maxDiff
+            << " (" << differingPixels << " pixels differ)";
+        fixedResult = result;
+        fixedMaxError = maxError;
+    }
+
+    // A black and white checkerboard of the decal's size puts 255 steps along
+    // both axes next to every texel, where the error bound is reached
+    Image board(decalTexture.getWidth(), decalTexture.getHeight());
+    for (int y = 0; y < board.getHeight(); y++) {
+        for (int x = 0; x < board.getWidth(); x++) {
+            board.setPixel(x, y, (x + y) % 2 ? Color(255, 255, 255) : Color(0, 0, 0));
+        }
+    }
+    Texture checkerboard(board);
+    const std::vector<double> boardTruth = exactValues(checkerboard);
+    for (const Variant& variant : variants) {
+        Image result(targetWidth, targetHeight);
+        for (int y = 0; y < targetHeight; y++) {
+            variant.sample(makeTextureSpan(checkerboard, Hinv, y, 0, targetWidth - 1, fallback, result.rowData(y)));
+        }
+        const double maxError = maxErrorOf(result, boardTruth);
+        LOG_INFO << "  " << variant.name << " on a checkerboard: max error against exact bilinear " << maxError;
+        if (&variant == &variants.back()) {
+            fixedMaxError = std::max(fixedMaxError, maxError);
+        }
+    }
+
+    // The same pixels whatever the span splits and texel layout
+    Texture tiled = loadTexture(config.decalImagePath, TextureLayout::Tiled);
+    Image split(targetWidth, targetHeight);
+    for (int y = 0; y < targetHeight; y++) {
+        for (int x0 = 0, width = 1 + y % 29; x0 < targetWidth; x0 += width) {
+            const int x1 = std::min(x0 + width, targetWidth) - 1;
+            sampleSpanFixed(makeTextureSpan(tiled, Hinv, y, x0, x1, fallback, split.rowData(y) + x0));
+        }
+    }
+    const bool identical = checksum(split) == checksum(fixedResult);
+    LOG_INFO << "  fixed with split spans over " << textureLayoutName(tiled.getLayout()) << " texels: "
+        << (identical ? "identical" : "MISMATCH");
+
+    // Whole frames of the configured scene
+    Renderer renderer(config);
+    renderer.setTiling(0, 1);
+    renderer.setTextureFilter(TextureFilter::Bilinear);
+    std::vector<Image> frames[2];
+    RenderStats stats[2];
+    double frameMs[2];
+    const TexturePrecision precisions[] = { TexturePrecision::Double, TexturePrecision::Fixed };
+    for (int p = 0; p < 2; p++) {
+        renderer.resetStats();
+        renderer.setTexturePrecision(precisions[p]);
+        frameMs[p] = timeFrames(config, renderer, MAX_SAMPLED_FRAMES,
+            [&](size_t, const Image& image) { frames[p].push_back(image); });
+        stats[p] = renderer.getStats();
+    }
+    for (int p = 0; p < 2; p++) {
+        LOG_INFO << "  " << texturePrecisionName(precisions[p]) << " frames: " << stats[p].textureMs / stats[p].frames
+            << " ms/frame texturing, " << frameMs[p] << " ms/frame total";
+    }
+    std::vector<int> frameNumbers = sampleFrames(MAX_SAMPLED_FRAMES);
+    std::ostringstream outside;
+    long long differingPixels = 0;
+    int maxDiff = 0;
+    for (size_t i = 0; i < frameNumbers.size(); i++) {
+        long long differing = 0;
+        const int diff = compareFrames({ frames[0][i] }, { frames[1][i] }, differing);
+        if (diff > FIXED_MAX_DIFFERENCE) {
+            outside << " " << frameNumbers[i] << " (" << diff << ")";
+        }
+        differingPixels += differing;
+        maxDiff = std::max(maxDiff, diff);
+    }
+    LOG_INFO << "  frames: max channel difference " << maxDiff << " (" << differingPixels << " of "
+        << stats[1].texturedPixels << " textured pixels differ)";
+
+    bool passed = identical;
+    if (fixedMaxError > FIXED_MAX_ERROR) {
+        LOG_ERROR << "Fixed-point error " << fixedMaxError << " exceeds its bound of " << FIXED_MAX_ERROR;
+        passed = false;
+    }
+    if (!outside.str().empty()) {
+        LOG_ERROR << "Fixed-point frames differ from double by more than " << FIXED_MAX_DIFFERENCE
+            << ", frame (max difference):" << outside.str();
+        passed = false;
+    }
+    return passed;
+}
+
+void Benchmark::runKernelIsa() {
+    const KernelIsa active = getKernelIsa();
+    LOG_INFO << "Benchmark 'isa': " << config.width << "x" << config.height << ", "
+        << sampleFrames(MAX_SAMPLED_FRAMES).size() << " frames, " << CLEAR_REPEATS << " "
+        << CLEAR_WIDTH << "x" << CLEAR_HEIGHT << " clears and " << SPAN_FILL_REPEATS << " fills of "
+        << SPAN_FILL_ROWS << " rows in runs of 1-" << SPAN_FILL_LONGEST << " pixels per level";
+
+    const KernelIsa levels[] = { KernelIsa::SSE2, KernelIsa::SSE41, KernelIsa::AVX2, KernelIsa::AVX512 };
+    std::vector<uint64_t> expected;
+    double baseClearMs = 0.0;
+    double baseSpanMs = 0.0;
+    double baseFrameMs = 0.0;
+    Image clearTarget(CLEAR_WIDTH, CLEAR_HEIGHT);
+    for (KernelIsa isa : levels) {
+        if (!isKernelIsaSupported(isa)) {
+            LOG_INFO << "  " << kernelIsaName(isa) << ": not supported on this CPU";
+            continue;
+        }
+        setKernelIsa(isa);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < CLEAR_REPEATS; r++) {
+            clearTarget.reset(CLEAR_WIDTH, CLEAR_HEIGHT, config.backgroundColor);
+        }
+        auto end = std::chrono::steady_clock::now();
+        double clearMs = std::chrono::duration<double, std::milli>(end - start).count() / CLEAR_REPEATS;
+
+        const Color spanColors[2] = { config.backgroundColor, Color(255, 255, 255) };
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < SPAN_FILL_REPEATS; r++) {
+            for (int y = 0, run = 0; y < SPAN_FILL_ROWS; y++) {
+                Color* row = clearTarget.rowData(y);
+                for (int x = 0; x < CLEAR_WIDTH; run++) {
+                    const int length = std::min(1 + run % SPAN_FILL_LONGEST, CLEAR_WIDTH - x);
+                    fillPixels(row + x, static_cast<size_t>(length), spanColors[run % 2]);
+                    x += length;
+                }
+            }
+        }
+        end = std::chrono::steady_clock::now();
+        double spanMs = std::chrono::duration<double, std::milli>(end - start).count() / SPAN_FILL_REPEATS;
+
+        Renderer renderer(config);
+        renderer.setTiling(0, 1);
+        std::vector<uint64_t> checksums;
+        double frameMs = timeFrames(config, renderer, MAX_SAMPLED_FRAMES,
+            [&](size_t, const Image& image) { checksums.push_back(checksum(image)); });
+        if (expected.empty()) {
+            expected = checksums;
+            baseClearMs = clearMs;
+            baseSpanMs = spanMs;
+            baseFrameMs = frameMs;
+        }
+
+        LOG_INFO << "  " << kernelIsaName(isa) << ": clear " << clearMs << " ms (" << baseClearMs / clearMs << "x), "
+            << "span fills " << spanMs << " ms (" << baseSpanMs / spanMs << "x), "
+            << frameMs << " ms/frame (" << baseFrameMs / frameMs << "x), "
+            << (checksums == expected ? "identical" : "MISMATCH");
+    }
+    setKernelIsa(active);
+}
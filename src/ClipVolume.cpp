@@ -0,0 +1,120 @@
+#include "ClipVolume.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Largest polygon the clipper handles: a convex polygon gains at most one vertex per plane
+static const int MAX_CLIP_VERTICES = 32;
+
+ClipVolume::ClipVolume(double scale, double centerX, double centerY, int width, int height, double nearZ, double margin)
+    : nearDepth(static_cast<float>(nearZ)),
+    left(static_cast<float>(-margin)),
+    right(static_cast<float>(width - 1 + margin)),
+    top(static_cast<float>(-margin)),
+    bottom(static_cast<float>(height - 1 + margin)) {
+
+    normals[0] = Vec3(0, 0, 1);
+    offsets[0] = -nearZ;
+    normals[1] = Vec3(scale, 0, centerX + margin);
+    normals[2] = Vec3(-scale, 0, width - 1 + margin - centerX);
+    normals[3] = Vec3(0, scale, centerY + margin);
+    normals[4] = Vec3(0, -scale, height - 1 + margin - centerY);
+    for (int i = 1; i < PLANE_COUNT; i++) {
+        offsets[i] = 0.0;
+    }
+
+    // Unit normals, so plane values are distances
+    for (int i = 0; i < PLANE_COUNT; i++) {
+        double length = std::sqrt(normals[i].dot(normals[i]));
+        normals[i] = normals[i] * (1.0 / length);
+        offsets[i] /= length;
+    }
+}
+
+int ClipVolume::outcode(const Vec3& p) const {
+    int code = 0;
+    for (int i = 0; i < PLANE_COUNT; i++) {
+        if (normals[i].dot(p) + offsets[i] < 0.0) {
+            code |= 1 << i;
+        }
+    }
+    return code;
+}
+
+int ClipVolume::outcodeProjected(float x, float y, float depth) const {
+    int code = depth < nearDepth ? NEAR_PLANE : 0;
+    if (depth == 0.0f) {
+        return code;
+    }
+
+    // Plane values are depth * (screen offset from the edge), so behind the eye the tests flip
+    if (depth * (x - left) < 0.0f) code |= LEFT_PLANE;
+    if (depth * (right - x) < 0.0f) code |= RIGHT_PLANE;
+    if (depth * (y - top) < 0.0f) code |= TOP_PLANE;
+    if (depth * (bottom - y) < 0.0f) code |= BOTTOM_PLANE;
+    return code;
+}
+
+bool ClipVolume::excludesSphere(const Vec3& center, double radius) const {
+    for (int i = 0; i < PLANE_COUNT; i++) {
+        if (normals[i].dot(center) + offsets[i] < -radius) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int ClipVolume::clipPolygon(const Vec3* input, int count, int planes, Vec3* output, unsigned& outlineMask) const {
+    Vec3 buffers[2][MAX_CLIP_VERTICES];
+    bool outlines[2][MAX_CLIP_VERTICES];
+
+    count = std::min(count, MAX_CLIP_VERTICES - PLANE_COUNT);
+    std::copy(input, input + count, buffers[0]);
+    std::fill(outlines[0], outlines[0] + count, true);
+
+    int current = 0;
+    for (int plane = 0; plane < PLANE_COUNT && count > 0; plane++) {
+        if (!(planes & (1 << plane))) {
+            continue;
+        }
+
+        const Vec3* src = buffers[current];
+        const bool* srcOutline = outlines[current];
+        Vec3* dst = buffers[1 - current];
+        bool* dstOutline = outlines[1 - current];
+        int written = 0;
+
+        for (int i = 0; i < count; i++) {
+            int j = (i + 1) % count;
+            double da = normals[plane].dot(src[i]) + offsets[plane];
+            double db = normals[plane].dot(src[j]) + offsets[plane];
+
+            if (da >= 0.0) {
+                // The edge leaving an inside vertex keeps its kind up to the crossing
+                dst[written] = src[i];
+                dstOutline[written++] = srcOutline[i];
+                if (db < 0.0) {
+                    // Leaving the volume: the next edge runs along the clip plane
+                    dst[written] = src[i] + (src[j] - src[i]) * (da / (da - db));
+                    dstOutline[written++] = false;
+                }
+            }
+            else if (db >= 0.0) {
+                // Entering the volume: the rest of this edge is part of the polygon
+                dst[written] = src[i] + (src[j] - src[i]) * (da / (da - db));
+                dstOutline[written++] = srcOutline[i];
+            }
+        }
+
+        count = written;
+        current = 1 - current;
+    }
+
+    outlineMask = 0;
+    for (int i = 0; i < count; i++) {
+        output[i] = buffers[current][i];
+        if (outlines[current][i]) {
+            outlineMask |= 1u << i;
+        }
+    }
+    return count;
+}
@@ -1,6 +1,10 @@
 ﻿#include "ConfigManager.hpp"
+#include "AllocationCounter.hpp"
 #include "Logger.hpp"
 #include "Renderer.hpp"
+#include "FrameWriter.hpp"
+#include "ThreadPool.hpp"
+#include "VideoPipe.hpp"
 #include <fstream>
 #include <iostream>
 #include <cmath>
@@ -25,11 +29,20 @@ void ConfigManager::setDefaults() {
     frameRate = 60;
     outputDirectory = "frames";
     outputFilename = "rotating_cube.mp4";
+    outputMode = "frames";
+    encoderCommand = "ffmpeg";
+    writerQueueDepth = 2;
 
     // Rendering settings
     width = 800;
     height = 600;
     backgroundColor = Color(10, 20, 30);
+    threads = 1;
+    tileSize = 0;
+    tileThreads = 0;
+    depthBits = 0;
+    visibilityBuffer = false;
+    antialiasing = "none";
 
     // Camera settings
     cameraScale = 500.0;
@@ -38,6 +51,17 @@ void ConfigManager::setDefaults() {
     cubeSize = 2.0;
     decalFaceIndex = 1;
     decalImagePath = "resources/textures/shrek.png";
+    decalSampler = "bilinear";
+    decalLayout = "linear";
+    decalPageBudgetMB = 0;
+
+    // Texture cache settings
+    textureCacheDirectory = "";
+    textureCacheLimitMB = 2048;
+
+    // Mesh settings
+    meshPath = "";
+    meshDecalMaterial = "";
 
     // Rotation settings
     rotationSpeedX = 0.5;
@@ -79,6 +103,9 @@ bool ConfigManager::loadFromFile(const std::string& filename) {
             frameRate = animation.value("frameRate", frameRate);
             outputDirectory = animation.value("outputDirectory", outputDirectory);
             outputFilename = animation.value("outputFilename", outputFilename);
+            outputMode = animation.value("outputMode", outputMode);
+            encoderCommand = animation.value("encoderCommand", encoderCommand);
+            writerQueueDepth = animation.value("writerQueueDepth", writerQueueDepth);
         }
 
         // Rendering settings
@@ -86,6 +113,12 @@ bool ConfigManager::loadFromFile(const std::string& filename) {
             auto& rendering = config["rendering"];
             width = rendering.value("width", width);
             height = rendering.value("height", height);
+            threads = rendering.value("threads", threads);
+            tileSize = rendering.value("tileSize", tileSize);
+            tileThreads = rendering.value("tileThreads", tileThreads);
+            depthBits = rendering.value("depthBuffer", depthBits);
+            visibilityBuffer = rendering.value("visibilityBuffer", visibilityBuffer);
+            antialiasing = rendering.value("antialiasing", antialiasing);
 
             if (rendering.contains("backgroundColor")) {
                 auto& bg = rendering["backgroundColor"];
@@ -107,6 +140,9 @@ bool ConfigManager::loadFromFile(const std::string& filename) {
             cubeSize = cube.value("size", cubeSize);
             decalFaceIndex = cube.value("decalFaceIndex", decalFaceIndex);
             decalImagePath = cube.value("decalImagePath", decalImagePath);
+            decalSampler = cube.value("decalSampler", decalSampler);
+            decalLayout = cube.value("decalLayout", decalLayout);
+            decalPageBudgetMB = cube.value("decalPageBudgetMB", decalPageBudgetMB);
 
             // Face colors
             if (cube.contains("faceColors")) {
@@ -121,6 +157,20 @@ bool ConfigManager::loadFromFile(const std::string& filename) {
             }
         }
 
+        // Texture cache settings
+        if (config.contains("textureCache")) {
+            auto& cache = config["textureCache"];
+            textureCacheDirectory = cache.value("directory", textureCacheDirectory);
+            textureCacheLimitMB = cache.value("limitMB", textureCacheLimitMB);
+        }
+
+        // Mesh settings
+        if (config.contains("mesh")) {
+            auto& mesh = config["mesh"];
+            meshPath = mesh.value("path", meshPath);
+            meshDecalMaterial = mesh.value("decalMaterial", meshDecalMaterial);
+        }
+
         // Rotation settings
         if (config.contains("rotation")) {
             auto& rotation = config["rotation"];
@@ -163,13 +213,22 @@ bool ConfigManager::saveToFile(const std::string& filename) const {
             {"numFrames", numFrames},
             {"frameRate", frameRate},
             {"outputDirectory", outputDirectory},
-            {"outputFilename", outputFilename}
+            {"outputFilename", outputFilename},
+            {"outputMode", outputMode},
+            {"encoderCommand", encoderCommand},
+            {"writerQueueDepth", writerQueueDepth}
         };
 
         // Rendering settings
         config["rendering"] = {
             {"width", width},
             {"height", height},
+            {"threads", threads},
+            {"tileSize", tileSize},
+            {"tileThreads", tileThreads},
+            {"depthBuffer", depthBits},
+            {"visibilityBuffer", visibilityBuffer},
+            {"antialiasing", antialiasing},
             {"backgroundColor", {
                 {"r", backgroundColor.r},
                 {"g", backgroundColor.g},
@@ -196,9 +255,24 @@ bool ConfigManager::saveToFile(const std::string& filename) const {
             {"size", cubeSize},
             {"decalFaceIndex", decalFaceIndex},
             {"decalImagePath", decalImagePath},
+            {"decalSampler", decalSampler},
+            {"decalLayout", decalLayout},
+            {"decalPageBudgetMB", decalPageBudgetMB},
             {"faceColors", faceColorsJson}
         };
 
+        // Texture cache settings
+        config["textureCache"] = {
+            {"directory", textureCacheDirectory},
+            {"limitMB", textureCacheLimitMB}
+        };
+
+        // Mesh settings
+        config["mesh"] = {
+            {"path", meshPath},
+            {"decalMaterial", meshDecalMaterial}
+        };
+
         // Rotation settings
         config["rotation"] = {
             {"speedX", rotationSpeedX},
@@ -265,29 +339,128 @@ double ConfigManager::parseRotation(const std::string& piString) {
 }
 
 // Animation methods (previously in AnimationManager)
-void ConfigManager::renderAnimation(Renderer& renderer, Cube& cube, const Image* decalImage) {
-    // Prepare output directory
-    prepareOutputDirectory();
+void ConfigManager::renderAnimation(Renderer& renderer, Cube& cube, const Texture* decalTexture,
+    const Mesh* mesh, int decalMaterial) {
+    bool pipeMode = (outputMode == "pipe");
+    if (!pipeMode && outputMode != "frames") {
+        LOG_WARNING << "Unknown output mode '" << outputMode << "', writing frame files";
+    }
 
-    // Render each frame
-    for (int frame = 0; frame < numFrames; frame++) {
+    // Stream frames to the encoder, or write them to the output directory
+    VideoPipe encoder;
+    if (pipeMode) {
+        if (!encoder.open(buildEncoderCommand())) {
+            return;
+        }
+    }
+    else {
+        prepareOutputDirectory();
+    }
+
+    ThreadPool pool(threads);
+    LOG_INFO << "Rendering frames on " << pool.getThreadCount() << " thread(s)";
+
+    // Each worker renders with its own copy of the renderer
+    std::vector<Renderer> renderers(pool.getThreadCount(), renderer);
+
+    // Frames already use every worker, so tiles are drawn on the frame's own thread
+    if (pool.getThreadCount() > 1 && renderer.getTileSize() > 0 && renderer.getTileThreads() != 1) {
+        LOG_INFO << "Rendering frames concurrently; tiles are drawn single-threaded";
+        for (auto& workerRenderer : renderers) {
+            workerRenderer.setTiling(renderer.getTileSize(), 1);
+        }
+    }
+
+    // Heap allocations made by renderFrame once a worker's scratch has grown
+    // (its first frame sizes it), counted per worker to avoid sharing a counter
+    std::vector<long long> steadyAllocations(pool.getThreadCount(), 0);
+    std::vector<int> steadyFrames(pool.getThreadCount(), 0);
+    std::vector<char> warmedUp(pool.getThreadCount(), 0);
+
+    // Every worker renders one frame while up to writerQueueDepth finished frames
+    // wait for the writer thread
+    FrameWriter writer(width, height, pool.getThreadCount() + std::max(writerQueueDepth, 1),
+        [&](const Image& frame, int frameNumber) {
+            if (pipeMode) {
+                return encoder.writeFrame(frame);
+            }
+            return saveFrame(frame, frameNumber);
+        });
+
+    pool.parallelFor(numFrames, [&](int frame, int worker) {
         // Calculate angle based on frame number and rotation settings
         Mat4x4 rotation = calculateRotation(frame);
 
         // Render the frame with the calculated rotation
         double angle = 2.0 * M_PI * frame / numFrames;
-        Image frameImage = renderer.renderFrame(cube, angle, decalImage, &rotation);
+        Image& frameImage = writer.acquire(frame);
+        long long allocationsBefore = threadAllocationCount();
+        if (mesh) {
+            renderers[worker].renderFrame(frameImage, *mesh, rotation, decalMaterial, decalTexture);
+        }
+        else {
+            renderers[worker].renderFrame(frameImage, cube, angle, decalTexture, &rotation);
+        }
+        if (warmedUp[worker]) {
+            steadyAllocations[worker] += threadAllocationCount() - allocationsBefore;
+            steadyFrames[worker]++;
+        }
+        warmedUp[worker] = 1;
 
-        // Save the frame
-        saveFrame(frameImage, frame);
+        // The writer saves the frame or hands it to the encoder in order
+        writer.submit(frame);
 
         LOG_INFO << "Frame " << frame + 1 << "/" << numFrames << " rendered";
+    });
+
+    FrameWriterStats writerStats = writer.finish();
+    LOG_INFO << "Frame writer: " << writerStats.framesWritten << " frames, " << writerStats.writeMs
+        << " ms writing, " << writerStats.writerIdleMs << " ms waiting for frames; renderers blocked "
+        << writerStats.rendererBlockedMs << " ms waiting for buffers";
+    bool writeFailed = writerStats.framesWritten < numFrames;
+
+    long long totalSteadyAllocations = 0;
+    int totalSteadyFrames = 0;
+    for (size_t i = 0; i < steadyAllocations.size(); i++) {
+        totalSteadyAllocations += steadyAllocations[i];
+        totalSteadyFrames += steadyFrames[i];
+    }
+    if (totalSteadyAllocations > 0) {
+        LOG_WARNING << "Rendering made " << totalSteadyAllocations << " heap allocations over "
+            << totalSteadyFrames << " steady-state frames";
+    }
+    else {
+        LOG_INFO << "Rendering made no heap allocations over " << totalSteadyFrames << " steady-state frames";
+    }
+
+    if (pipeMode) {
+        // Closing stdin lets the encoder finish the file
+        if (encoder.close() && !writeFailed) {
+            LOG_INFO << "Video created successfully: " << outputFilename;
+        }
+        else {
+            LOG_ERROR << "Failed to encode video through the pipe";
+        }
+        return;
+    }
+
+    if (writeFailed) {
+        LOG_ERROR << "Only " << writerStats.framesWritten << " of " << numFrames << " frames were saved";
     }
 
     // Create video from the frames
     createVideo();
 }
 
+std::string ConfigManager::buildEncoderCommand() const {
+    std::ostringstream command;
+    command << encoderCommand
+        << " -y -f rawvideo -pix_fmt rgb24 -s " << width << "x" << height
+        << " -framerate " << frameRate << " -i -"
+        << " -c:v libx264 -pix_fmt yuv420p \"" << outputFilename << "\"";
+    return command.str();
+}
+
 Mat4x4 ConfigManager::calculateRotation(int frame) const {
     // Base angle calculation - proportion of total rotation
     double baseAngle = totalRotation * frame / numFrames;
@@ -328,10 +501,10 @@ void ConfigManager::prepareOutputDirectory() const {
     }
 }
 
-void ConfigManager::saveFrame(const Image& frame, int frameNumber) const {
+bool ConfigManager::saveFrame(const Image& frame, int frameNumber) const {
     std::stringstream ss;
     ss << outputDirectory << "/frame_" << frameNumber << ".ppm";
-    frame.saveAsPPM(ss.str());
+    return frame.saveAsPPM(ss.str());
 }
 
 bool ConfigManager::createVideo() const {
@@ -0,0 +1,123 @@
+#include "CpuFeatures.hpp"
+#include "Logger.hpp"
+#include <atomic>
+
+#if defined(CUBE_X86_KERNELS) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+bool cpuHasSSE41() {
+#if !defined(CUBE_X86_KERNELS)
+    return false;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+#else
+    return __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+bool cpuHasAVX2() {
+#if !defined(CUBE_X86_KERNELS)
+    return false;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+bool cpuHasAVX512() {
+#if !defined(CUBE_X86_KERNELS)
+    return false;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    // The OS must save the opmask and both halves of the 32 zmm registers
+    if (!osxsave || (_xgetbv(0) & 0xE6) != 0xE6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 30)) != 0;
+#else
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+}
+
+bool isKernelIsaSupported(KernelIsa isa) {
+    switch (isa) {
+    case KernelIsa::SSE2:   return true;
+    case KernelIsa::SSE41:  return cpuHasSSE41();
+    case KernelIsa::AVX2:   return cpuHasAVX2();
+    case KernelIsa::AVX512: return cpuHasAVX512();
+    default:                return false;
+    }
+}
+
+KernelIsa detectKernelIsa() {
+    if (isKernelIsaSupported(KernelIsa::AVX512)) return KernelIsa::AVX512;
+    if (isKernelIsaSupported(KernelIsa::AVX2)) return KernelIsa::AVX2;
+    if (isKernelIsaSupported(KernelIsa::SSE41)) return KernelIsa::SSE41;
+    return KernelIsa::SSE2;
+}
+
+static std::atomic<KernelIsa>& activeIsa() {
+    static std::atomic<KernelIsa> isa(detectKernelIsa());
+    return isa;
+}
+
+KernelIsa getKernelIsa() {
+    return activeIsa().load(std::memory_order_relaxed);
+}
+
+bool setKernelIsa(KernelIsa isa) {
+    if (!isKernelIsaSupported(isa)) {
+        LOG_WARNING << "Kernel instruction set " << kernelIsaName(isa) << " is not supported here";
+        return false;
+    }
+    activeIsa() = isa;
+    return true;
+}
+
+bool parseKernelIsa(const std::string& name, KernelIsa& isa) {
+    if (name == "sse2") {
+        isa = KernelIsa::SSE2;
+    }
+    else if (name == "sse4.1") {
+        isa = KernelIsa::SSE41;
+    }
+    else if (name == "avx2") {
+        isa = KernelIsa::AVX2;
+    }
+    else if (name == "avx512") {
+        isa = KernelIsa::AVX512;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+const char* kernelIsaName(KernelIsa isa) {
+    switch (isa) {
+#ifdef CUBE_X86_KERNELS
+    case KernelIsa::SSE2:   return "SSE2";
+#else
+    case KernelIsa::SSE2:   return "portable";
+#endif
+    case KernelIsa::SSE41:  return "SSE4.1";
+    case KernelIsa::AVX2:   return "AVX2";
+    case KernelIsa::AVX512: return "AVX-512";
+    default:                return "unknown";
+    }
+}
@@ -1,4 +1,5 @@
 #include "Cube.hpp"
+#include <algorithm>
 
 Cube::Cube(double size) {
     // Define the 8 vertices of the cube
@@ -15,18 +16,71 @@ Cube::Cube(double size) {
     };
 
     // Define the 6 faces of the cube (each face is a list of vertex indices)
-    faces = {
-        {4, 5, 6, 7}, // back face
-        {0, 3, 2, 1}, // front face
-        {0, 1, 5, 4}, // bottom face
-        {2, 3, 7, 6}, // top face
-        {0, 4, 7, 3}, // left face
-        {1, 2, 6, 5}  // right face
-    };
+    faces = { {
+        {{4, 5, 6, 7}}, // back face
+        {{0, 3, 2, 1}}, // front face
+        {{0, 1, 5, 4}}, // bottom face
+        {{2, 3, 7, 6}}, // top face
+        {{0, 4, 7, 3}}, // left face
+        {{1, 2, 6, 5}}  // right face
+    } };
+
+    computeFaceGeometry();
 }
 
 void Cube::transform(const Mat4x4& matrix) {
     for (auto& vertex : vertices) {
         vertex = matrix.transform(vertex);
     }
-}
\ No newline at end of file
+    computeFaceGeometry();
+}
+
+Mesh Cube::toMesh() const {
+    static const char* const faceNames[] = { "back", "front", "bottom", "top", "left", "right" };
+    static const float cornerU[] = { 0.0f, 1.0f, 1.0f, 0.0f };
+    static const float cornerV[] = { 0.0f, 0.0f, 1.0f, 1.0f };
+
+    Mesh mesh;
+    for (size_t i = 0; i < faces.size(); i++) {
+        const uint32_t first = static_cast<uint32_t>(mesh.x.size());
+        for (int corner = 0; corner < 4; corner++) {
+            const Vec3& p = vertices[faces[i][corner]];
+            mesh.x.push_back(static_cast<float>(p.x));
+            mesh.y.push_back(static_cast<float>(p.y));
+            mesh.z.push_back(static_cast<float>(p.z));
+            mesh.u.push_back(cornerU[corner]);
+            mesh.v.push_back(cornerV[corner]);
+        }
+
+        const uint32_t triangles[] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+        mesh.indices.insert(mesh.indices.end(), triangles, triangles + 6);
+        mesh.materials.push_back(static_cast<uint16_t>(i));
+        mesh.materials.push_back(static_cast<uint16_t>(i));
+        mesh.materialNames.push_back(faceNames[i]);
+    }
+    mesh.computeGeometry();
+    return mesh;
+}
+
+void Cube::computeFaceGeometry() {
+    for (size_t i = 0; i < faces.size(); i++) {
+        const auto& face = faces[i];
+
+        // Faces wind so that this cross product points out of the cube
+        Vec3 v0 = vertices[face[0]];
+        Vec3 edge1 = vertices[face[1]] - v0;
+        Vec3 edge2 = vertices[face[2]] - v0;
+        normals[i] = edge1.cross(edge2).normalize();
+
+        Vec3 center(0, 0, 0);
+        for (int index : face) {
+            center = center + vertices[index];
+        }
+        centroids[i] = center * (1.0 / face.size());
+    }
+
+    boundingRadius = 0.0;
+    for (const auto& v : vertices) {
+        boundingRadius = std::max(boundingRadius, std::sqrt(v.dot(v)));
+    }
+}
@@ -0,0 +1,95 @@
+#include "FrameWriter.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <chrono>
+
+// Milliseconds elapsed since a time point
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+FrameWriter::FrameWriter(int width, int height, int bufferCount, Sink sink)
+    : buffers(std::max(bufferCount, 1), Image(width, height)),
+    ready(buffers.size(), 0),
+    sink(sink),
+    nextFrame(0),
+    stopping(false),
+    sinkFailed(false) {
+    writer = std::thread(&FrameWriter::writerLoop, this);
+}
+
+FrameWriter::~FrameWriter() {
+    finish();
+}
+
+Image& FrameWriter::acquire(int frameNumber) {
+    const int bufferCount = static_cast<int>(buffers.size());
+    std::unique_lock<std::mutex> lock(mutex);
+    if (frameNumber >= nextFrame + bufferCount) {
+        auto start = std::chrono::steady_clock::now();
+        bufferFree.wait(lock, [&] { return frameNumber < nextFrame + bufferCount; });
+        stats.rendererBlockedMs += elapsedMs(start);
+    }
+    return buffers[frameNumber % bufferCount];
+}
+
+void FrameWriter::submit(int frameNumber) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready[frameNumber % buffers.size()] = 1;
+    }
+    frameReady.notify_one();
+}
+
+FrameWriterStats FrameWriter::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    frameReady.notify_one();
+
+    if (writer.joinable()) {
+        writer.join();
+    }
+    return stats;
+}
+
+void FrameWriter::writerLoop() {
+    const size_t bufferCount = buffers.size();
+
+    while (true) {
+        size_t slot;
+        int frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto start = std::chrono::steady_clock::now();
+            frameReady.wait(lock, [&] { return stopping || ready[nextFrame % bufferCount]; });
+            stats.writerIdleMs += elapsedMs(start);
+
+            // Stop once the next frame in order will never arrive
+            slot = nextFrame % bufferCount;
+            if (!ready[slot]) {
+                return;
+            }
+            frame = nextFrame;
+        }
+
+        // The buffer belongs to the writer until nextFrame moves past it
+        auto start = std::chrono::steady_clock::now();
+        bool written = !sinkFailed && sink(buffers[slot], frame);
+        if (!written && !sinkFailed) {
+            LOG_ERROR << "Frame writer failed at frame " << frame << "; later frames are discarded";
+            sinkFailed = true;
+        }
+        double ms = elapsedMs(start);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stats.writeMs += ms;
+            stats.framesWritten += written ? 1 : 0;
+            ready[slot] = 0;
+            nextFrame++;
+        }
+        bufferFree.notify_all();
+    }
+}
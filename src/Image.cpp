@@ -1,8 +1,12 @@
 #include "Image.hpp"
 #include "Logger.hpp"
+#include "Rasterizer.hpp"
+#include "CpuFeatures.hpp"
+#include "FillKernels.hpp"
 #include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <cstring>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -19,6 +23,13 @@ Image::Image(int width, int height, const Color& background)
     : width(width), height(height), pixels(width* height, background) {
 }
 
+void Image::reset(int width, int height, const Color& background) {
+    this->width = width;
+    this->height = height;
+    pixels.resize(static_cast<size_t>(width) * height);
+    fillPixels(pixels.data(), pixels.size(), background);
+}
+
 void Image::setPixel(int x, int y, const Color& color) {
     if (x >= 0 && x < width && y >= 0 && y < height) {
         pixels[y * width + x] = color;
@@ -32,114 +43,101 @@ Color Image::getPixel(int x, int y) const {
     return Color(); // Default black
 }
 
+Color* Image::rowData(int y) {
+    return &pixels[y * width];
+}
+
+const Color* Image::rowData(int y) const {
+    return &pixels[y * width];
+}
+
 void Image::drawLine(int x0, int y0, int x1, int y1, const Color& color) {
-    // Bresenham's line algorithm
-    int dx = std::abs(x1 - x0);
-    int dy = std::abs(y1 - y0);
-    int sx = (x0 < x1) ? 1 : -1;
-    int sy = (y0 < y1) ? 1 : -1;
-    int err = dx - dy;
-
-    while (true) {
-        setPixel(x0, y0, color);
-
-        if (x0 == x1 && y0 == y1) break;
-
-        int e2 = 2 * err;
-        if (e2 > -dy) {
-            err -= dy;
-            x0 += sx;
-        }
-        if (e2 < dx) {
-            err += dx;
-            y0 += sy;
-        }
-    }
+    drawClippedLine(*this, x0, y0, x1, y1, color, RasterRect(0, 0, width - 1, height - 1));
 }
 
 void Image::fillTriangle(int x1, int y1, int x2, int y2, int x3, int y3, const Color& color) {
-    // Sort vertices by y-coordinate (y1 <= y2 <= y3)
-    if (y1 > y2) {
-        std::swap(x1, x2);
-        std::swap(y1, y2);
-    }
-    if (y1 > y3) {
-        std::swap(x1, x3);
-        std::swap(y1, y3);
-    }
-    if (y2 > y3) {
-        std::swap(x2, x3);
-        std::swap(y2, y3);
+    const Vec2 vertices[3] = { Vec2(x1, y1), Vec2(x2, y2), Vec2(x3, y3) };
+    Rasterizer rasterizer(vertices, 3);
+    SolidFill fill(*this, color);
+    rasterizer.rasterize(RasterRect(0, 0, width - 1, height - 1), fill);
+}
+
+// Runs shorter than this are filled pixel by pixel
+static const size_t FILL_PATTERN_PIXELS = 16;
+
+alignas(64) const unsigned char FILL_PHASE[192] = {
+    0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1,
+    2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0,
+    1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2,
+    0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1,
+    2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0,
+    1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2
+};
+
+void fillPixelsPortable(unsigned char* out, size_t count, const unsigned char* rgb) {
+    if (count < FILL_PATTERN_PIXELS) {
+        for (size_t i = 0; i < count; i++) {
+            out[3 * i] = rgb[0];
+            out[3 * i + 1] = rgb[1];
+            out[3 * i + 2] = rgb[2];
+        }
+        return;
     }
 
-    if (y2 == y3) {
-        // Flat bottom triangle
-        fillFlatBottomTriangle(x1, y1, x2, y2, x3, y3, color);
+    // 16 pixels are three 16-byte words, which the compiler stores whole; the
+    // pattern is built by doubling one pixel
+    unsigned char pattern[48];
+    std::memcpy(pattern, rgb, 3);
+    for (size_t n = 3; n < sizeof(pattern); n *= 2) {
+        std::memcpy(pattern + n, pattern, std::min(n, sizeof(pattern) - n));
     }
-    else if (y1 == y2) {
-        // Flat top triangle
-        fillFlatTopTriangle(x1, y1, x2, y2, x3, y3, color);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        std::memcpy(out + 3 * i, pattern, sizeof(pattern));
     }
-    else {
-        // General triangle - split into flat-bottom and flat-top
-        int x4 = x1 + ((y2 - y1) * (x3 - x1)) / (y3 - y1);
-        int y4 = y2;
-
-        fillFlatBottomTriangle(x1, y1, x2, y2, x4, y4, color);
-        fillFlatTopTriangle(x2, y2, x4, y4, x3, y3, color);
+    if (i < count) {
+        std::memcpy(out + 3 * i, pattern, 3 * (count - i));
     }
 }
 
-void Image::fillFlatBottomTriangle(int x1, int y1, int x2, int y2, int x3, int y3, const Color& color) {
-    if (y2 == y1) return; // Prevent division by zero
-
-    double slope1 = static_cast<double>(x2 - x1) / (y2 - y1);
-    double slope2 = static_cast<double>(x3 - x1) / (y3 - y1);
-
-    double x_start = x1;
-    double x_end = x1;
-
-    for (int y = y1; y <= y2; y++) {
-        drawLine((int)x_start, y, (int)x_end, y, color);
-        x_start += slope1;
-        x_end += slope2;
+void fillPixels(Color* out, size_t count, const Color& color) {
+    static_assert(sizeof(Color) == 3, "Color must be three packed bytes");
+    const unsigned char rgb[3] = { color.r, color.g, color.b };
+    unsigned char* bytes = reinterpret_cast<unsigned char*>(out);
+#ifdef CUBE_X86_KERNELS
+    const KernelIsa isa = getKernelIsa();
+    if (isa >= KernelIsa::AVX512) {
+        fillPixelsAVX512(bytes, count, rgb);
+        return;
     }
-}
-
-void Image::fillFlatTopTriangle(int x1, int y1, int x2, int y2, int x3, int y3, const Color& color) {
-    if (y3 == y1) return; // Prevent division by zero
-
-    double slope1 = static_cast<double>(x3 - x1) / (y3 - y1);
-    double slope2 = static_cast<double>(x3 - x2) / (y3 - y2);
-
-    double x_start = x3;
-    double x_end = x3;
-
-    for (int y = y3; y >= y1; y--) {
-        drawLine((int)x_start, y, (int)x_end, y, color);
-        x_start -= slope1;
-        x_end -= slope2;
+    if (isa >= KernelIsa::AVX2) {
+        fillPixelsAVX2(bytes, count, rgb);
+        return;
     }
+#endif
+    fillPixelsPortable(bytes, count, rgb);
 }
 
-void Image::saveAsPPM(const std::string& filename) const {
+bool Image::saveAsPPM(const std::string& filename) const {
     std::ofstream file(filename, std::ios::binary);
     if (!file) {
         LOG_ERROR << "Could not open file for writing: " << filename;
-        return;
+        return false;
     }
 
     // PPM header
     file << "P6\n" << width << " " << height << "\n255\n";
 
-    // Write pixel data
-    for (const auto& pixel : pixels) {
-        file.write(reinterpret_cast<const char*>(&pixel.r), 1);
-        file.write(reinterpret_cast<const char*>(&pixel.g), 1);
-        file.write(reinterpret_cast<const char*>(&pixel.b), 1);
-    }
+    // Pixels are stored as packed RGB bytes, exactly the P6 body
+    static_assert(sizeof(Color) == 3, "Color must be three packed bytes");
+    file.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size() * sizeof(Color)));
 
     file.close();
+    if (!file) {
+        LOG_ERROR << "Failed to write image: " << filename;
+        return false;
+    }
+    return true;
 }
 
 int Image::getWidth() const { return width; }
@@ -169,18 +167,21 @@ Image loadImage(const std::string& filename) {
 Image::Image(unsigned char* data, int width, int height, int channels)
     : width(width), height(height), pixels(width* height, Color(0, 0, 0)) {
 
-    // Process the raw pixel data based on the number of channels
+    // Process the raw pixel data based on the number of channels, a row at a time
+    const size_t rowBytes = static_cast<size_t>(width) * channels;
     for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int index = (y * width + x) * channels;
-
-            if (channels >= 3) {
-                // RGB or RGBA
-                setPixel(x, y, Color(data[index], data[index + 1], data[index + 2]));
+        const unsigned char* in = data + y * rowBytes;
+        Color* row = rowData(y);
+        if (channels >= 3) {
+            // RGB or RGBA
+            for (int x = 0; x < width; x++, in += channels) {
+                row[x] = Color(in[0], in[1], in[2]);
             }
-            else if (channels == 1) {
-                // Grayscale
-                setPixel(x, y, Color(data[index], data[index], data[index]));
+        }
+        else if (channels == 1) {
+            // Grayscale
+            for (int x = 0; x < width; x++) {
+                row[x] = Color(in[x], in[x], in[x]);
             }
         }
     }
@@ -0,0 +1,41 @@
+// Compiled with AVX2 code generation; only called after a CPU check
+#include "FillKernels.hpp"
+#include <immintrin.h>
+#include <cstring>
+
+void fillPixelsAVX2(unsigned char* out, size_t count, const unsigned char* rgb) {
+    // 32 pixels fill three registers exactly, so the pattern repeats every 96 bytes;
+    // each register picks its bytes from the color repeated in every dword
+    const __m256i color = _mm256_set1_epi32(rgb[0] | rgb[1] << 8 | rgb[2] << 16);
+    const __m256i p0 = _mm256_shuffle_epi8(color, _mm256_load_si256(reinterpret_cast<const __m256i*>(FILL_PHASE)));
+    const __m256i p1 = _mm256_shuffle_epi8(color, _mm256_load_si256(reinterpret_cast<const __m256i*>(FILL_PHASE + 32)));
+    const __m256i p2 = _mm256_shuffle_epi8(color, _mm256_load_si256(reinterpret_cast<const __m256i*>(FILL_PHASE + 64)));
+
+    size_t i = 0;
+    if (count >= FILL_STREAM_PIXELS) {
+        // Whole pixels up to a 32-byte boundary (3 * 11 = 1 mod 32), then aligned
+        // non-temporal stores, which start on a pixel so the pattern still lines up
+        const size_t head = (0 - reinterpret_cast<size_t>(out)) * 11 & 31;
+        fillPixelsAVX2(out, head, rgb);
+        for (i = head; i + 32 <= count; i += 32) {
+            __m256i* dst = reinterpret_cast<__m256i*>(out + 3 * i);
+            _mm256_stream_si256(dst, p0);
+            _mm256_stream_si256(dst + 1, p1);
+            _mm256_stream_si256(dst + 2, p2);
+        }
+        _mm_sfence();
+    }
+    for (; i + 32 <= count; i += 32) {
+        __m256i* dst = reinterpret_cast<__m256i*>(out + 3 * i);
+        _mm256_storeu_si256(dst, p0);
+        _mm256_storeu_si256(dst + 1, p1);
+        _mm256_storeu_si256(dst + 2, p2);
+    }
+
+    // The last 0-31 pixels from a copy of the pattern
+    alignas(32) unsigned char pattern[96];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(pattern), p0);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(pattern + 32), p1);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(pattern + 64), p2);
+    std::memcpy(out + 3 * i, pattern, 3 * (count - i));
+}
@@ -0,0 +1,58 @@
+// Compiled with AVX-512 code generation; only called after a CPU check
+#include "FillKernels.hpp"
+// GCC 12 flags the placeholder registers of its own AVX-512 intrinsics as uninitialized
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// Mask of the first n bytes of a 64-byte store (n clamped to 0..64)
+static inline __mmask64 leadingBytes(size_t n) {
+    return n >= 64 ? ~0ULL : (1ULL << n) - 1;
+}
+
+void fillPixelsAVX512(unsigned char* out, size_t count, const unsigned char* rgb) {
+    // 64 pixels fill three registers exactly, so the pattern repeats every 192 bytes;
+    // each register picks its bytes from the color repeated in every dword
+    const __m512i color = _mm512_set1_epi32(rgb[0] | rgb[1] << 8 | rgb[2] << 16);
+    const __m512i p0 = _mm512_shuffle_epi8(color, _mm512_load_si512(FILL_PHASE));
+    const __m512i p1 = _mm512_shuffle_epi8(color, _mm512_load_si512(FILL_PHASE + 64));
+    const __m512i p2 = _mm512_shuffle_epi8(color, _mm512_load_si512(FILL_PHASE + 128));
+
+    size_t i = 0;
+    if (count >= FILL_STREAM_PIXELS) {
+        // Whole pixels up to a 64-byte boundary (3 * 43 = 1 mod 64), then aligned
+        // non-temporal stores, which start on a pixel so the pattern still lines up
+        const size_t head = (0 - reinterpret_cast<size_t>(out)) * 43 & 63;
+        fillPixelsAVX512(out, head, rgb);
+        for (i = head; i + 64 <= count; i += 64) {
+            unsigned char* dst = out + 3 * i;
+            _mm512_stream_si512(reinterpret_cast<__m512i*>(dst), p0);
+            _mm512_stream_si512(reinterpret_cast<__m512i*>(dst + 64), p1);
+            _mm512_stream_si512(reinterpret_cast<__m512i*>(dst + 128), p2);
+        }
+        _mm_sfence();
+    }
+    for (; i + 64 <= count; i += 64) {
+        unsigned char* dst = out + 3 * i;
+        _mm512_storeu_si512(dst, p0);
+        _mm512_storeu_si512(dst + 64, p1);
+        _mm512_storeu_si512(dst + 128, p2);
+    }
+
+    // The last 0-63 pixels with byte-masked stores
+    const size_t rest = 3 * (count - i);
+    unsigned char* dst = out + 3 * i;
+    _mm512_mask_storeu_epi8(dst, leadingBytes(rest), p0);
+    if (rest > 64) {
+        _mm512_mask_storeu_epi8(dst + 64, leadingBytes(rest - 64), p1);
+    }
+    if (rest > 128) {
+        _mm512_mask_storeu_epi8(dst + 128, leadingBytes(rest - 128), p2);
+    }
+}
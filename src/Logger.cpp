@@ -60,6 +60,7 @@ void Logger::log(LogLevel level, const std::string& message) {
 
     // Choose appropriate stream based on level
     std::ostream& stream = (level >= LWARNING) ? std::cerr : std::cout;
+    std::lock_guard<std::mutex> lock(outputMutex);
     stream << formattedMessage << std::endl;
 }
 
@@ -0,0 +1,174 @@
+#include "MappedFile.hpp"
+#include "Logger.hpp"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+    : mapping(nullptr), length(0), opened(false), writable(false)
+#if defined(_WIN32)
+    , fileHandle(nullptr), mappingHandle(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& filename, Access access) {
+    close();
+
+#if defined(_WIN32)
+    const DWORD flags = FILE_ATTRIBUTE_NORMAL | (access == Access::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN : 0);
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR << "Could not open " << filename;
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        LOG_ERROR << "Could not get the size of " << filename;
+        CloseHandle(file);
+        return false;
+    }
+    length = static_cast<size_t>(fileSize.QuadPart);
+    fileHandle = file;
+    if (length > 0) {
+        mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* view = mappingHandle ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view) {
+            LOG_ERROR << "Could not map " << filename;
+            close();
+            return false;
+        }
+        mapping = static_cast<const char*>(view);
+    }
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR << "Could not open " << filename;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        LOG_ERROR << "Could not get the size of " << filename;
+        ::close(fd);
+        return false;
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (length > 0) {
+        void* view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED) {
+            LOG_ERROR << "Could not map " << filename;
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+        madvise(view, length, access == Access::Sequential ? MADV_SEQUENTIAL : MADV_WILLNEED);
+        mapping = static_cast<const char*>(view);
+    }
+    // The mapping keeps the file alive
+    ::close(fd);
+#endif
+
+    opened = true;
+    return true;
+}
+
+bool MappedFile::create(const std::string& filename, size_t size) {
+    close();
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR << "Could not create " << filename;
+        return false;
+    }
+    fileHandle = file;
+    length = size;
+    const unsigned long long fileSize = size;
+    mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+        static_cast<DWORD>(fileSize >> 32), static_cast<DWORD>(fileSize), nullptr);
+    void* view = mappingHandle ? MapViewOfFile(mappingHandle, FILE_MAP_WRITE, 0, 0, 0) : nullptr;
+    if (!view) {
+        LOG_ERROR << "Could not map " << filename << " for writing";
+        close();
+        return false;
+    }
+    mapping = static_cast<const char*>(view);
+#else
+    int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        LOG_ERROR << "Could not create " << filename;
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        LOG_ERROR << "Could not size " << filename << " to " << size << " bytes";
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        LOG_ERROR << "Could not map " << filename << " for writing";
+        return false;
+    }
+    mapping = static_cast<const char*>(view);
+    length = size;
+#endif
+
+    opened = true;
+    writable = true;
+    return true;
+}
+
+void MappedFile::close() {
+#if defined(_WIN32)
+    if (mapping) {
+        UnmapViewOfFile(mapping);
+    }
+    if (mappingHandle) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle) {
+        CloseHandle(fileHandle);
+    }
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    if (mapping) {
+        munmap(const_cast<char*>(mapping), length);
+    }
+#endif
+    mapping = nullptr;
+    length = 0;
+    opened = false;
+    writable = false;
+}
+
+bool MappedFile::isOpen() const {
+    return opened;
+}
+
+const char* MappedFile::data() const {
+    return mapping;
+}
+
+char* MappedFile::writableData() {
+    return writable ? const_cast<char*>(mapping) : nullptr;
+}
+
+size_t MappedFile::size() const {
+    return length;
+}
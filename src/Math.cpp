@@ -1,5 +1,6 @@
 #include "Math.hpp"
 #include "Logger.hpp"
+#include "CpuFeatures.hpp"
 #include <iostream>
 #include <cmath>
 #include <algorithm>
@@ -196,6 +197,36 @@ Mat4x4 rotateZ(double angle) {
     return rot;
 }
 
+Mat4x4 Mat4x4::inverseAffine() const {
+    // Inverse of the linear part through its adjugate
+    double c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    double c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    double c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    double det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+    Mat4x4 inv;
+    if (std::abs(det) < 1e-12) {
+        LOG_WARNING << "Affine matrix is not invertible";
+        return inv;
+    }
+    double invDet = 1.0 / det;
+
+    inv.m[0][0] = c00 * invDet;
+    inv.m[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * invDet;
+    inv.m[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * invDet;
+    inv.m[1][0] = c01 * invDet;
+    inv.m[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * invDet;
+    inv.m[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * invDet;
+    inv.m[2][0] = c02 * invDet;
+    inv.m[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * invDet;
+    inv.m[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * invDet;
+
+    // Translation: -A^-1 * t
+    for (int i = 0; i < 3; i++) {
+        inv.m[i][3] = -(inv.m[i][0] * m[0][3] + inv.m[i][1] * m[1][3] + inv.m[i][2] * m[2][3]);
+    }
+    return inv;
+}
+
 // Projection and Homography functions
 Vec2 projectPoint(const Vec3& p, double d, double cx, double cy) {
     if (p.z <= 0.1) {
@@ -207,12 +238,91 @@ Vec2 projectPoint(const Vec3& p, double d, double cx, double cy) {
     return Vec2(d * p.x / p.z + cx, d * p.y / p.z + cy);
 }
 
+Mat4x4 perspectiveProjection(double d, double cx, double cy) {
+    Mat4x4 projection;
+    projection.m[0][0] = d;
+    projection.m[0][2] = cx;
+    projection.m[1][1] = d;
+    projection.m[1][2] = cy;
+    projection.m[3][2] = 1.0;
+    projection.m[3][3] = 0.0;
+    return projection;
+}
+
+void transformAndProjectScalar(const double m[4][4], const PointsSoA& in, const ScreenPointsSoA& out,
+    size_t first, size_t count) {
+    for (size_t i = first; i < count; i++) {
+        double x = in.x[i];
+        double y = in.y[i];
+        double z = in.z[i];
+        double tx = m[0][0] * x + m[0][1] * y + m[0][2] * z + m[0][3];
+        double ty = m[1][0] * x + m[1][1] * y + m[1][2] * z + m[1][3];
+        double tw = m[3][0] * x + m[3][1] * y + m[3][2] * z + m[3][3];
+        double invW = 1.0 / tw;
+        out.x[i] = tx * invW;
+        out.y[i] = ty * invW;
+        out.depth[i] = tw;
+    }
+}
+
+void transformAndProjectScalar(const double m[4][4], const PointsSoAf& in, const ScreenPointsSoAf& out,
+    size_t first, size_t count) {
+    float r[4][4];
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            r[i][j] = static_cast<float>(m[i][j]);
+        }
+    }
+
+    for (size_t i = first; i < count; i++) {
+        float x = in.x[i];
+        float y = in.y[i];
+        float z = in.z[i];
+        float tx = r[0][0] * x + r[0][1] * y + r[0][2] * z + r[0][3];
+        float ty = r[1][0] * x + r[1][1] * y + r[1][2] * z + r[1][3];
+        float tw = r[3][0] * x + r[3][1] * y + r[3][2] * z + r[3][3];
+        float invW = 1.0f / tw;
+        out.x[i] = tx * invW;
+        out.y[i] = ty * invW;
+        out.depth[i] = tw;
+    }
+}
+
+// The AVX2 kernels also serve the AVX-512 level
+static bool useVertexAVX2() {
+    return getKernelIsa() >= KernelIsa::AVX2;
+}
+
+void transformAndProject(const Mat4x4& transform, const PointsSoA& in, const ScreenPointsSoA& out, size_t count) {
+#ifdef CUBE_X86_KERNELS
+    if (useVertexAVX2()) {
+        transformAndProjectAVX2(transform.m, in, out, count);
+        return;
+    }
+#endif
+    transformAndProjectScalar(transform.m, in, out, 0, count);
+}
+
+void transformAndProject(const Mat4x4& transform, const PointsSoAf& in, const ScreenPointsSoAf& out, size_t count) {
+#ifdef CUBE_X86_KERNELS
+    if (useVertexAVX2()) {
+        transformAndProjectAVX2(transform.m, in, out, count);
+        return;
+    }
+#endif
+    transformAndProjectScalar(transform.m, in, out, 0, count);
+}
+
 Mat3x3 computeHomography(const std::vector<Vec2>& src, const std::vector<Vec2>& dst) {
     if (src.size() != 4 || dst.size() != 4) {
         LOG_ERROR << "Need exactly 4 corresponding points!";
         return Mat3x3();
     }
 
+    return computeHomography(src.data(), dst.data());
+}
+
+Mat3x3 computeHomography(const Vec2* src, const Vec2* dst) {
     // Check if points make a proper quadrilateral
     bool tooSmall = false;
 
@@ -352,19 +462,109 @@ Mat3x3 computeHomography(const std::vector<Vec2>& src, const std::vector<Vec2>&
     return H;
 }
 
+// Inverse of a 3x3 matrix through its adjugate; fails if the result is not finite
+static bool invertThroughAdjugate(const Mat3x3& s, Mat3x3& mapping) {
+    double c00 = s.m[1][1] * s.m[2][2] - s.m[1][2] * s.m[2][1];
+    double c01 = s.m[1][2] * s.m[2][0] - s.m[1][0] * s.m[2][2];
+    double c02 = s.m[1][0] * s.m[2][1] - s.m[1][1] * s.m[2][0];
+    double det = s.m[0][0] * c00 + s.m[0][1] * c01 + s.m[0][2] * c02;
+    if (!std::isfinite(det) || det == 0.0) {
+        return false;
+    }
+    double invDet = 1.0 / det;
+
+    mapping.m[0][0] = c00 * invDet;
+    mapping.m[0][1] = (s.m[0][2] * s.m[2][1] - s.m[0][1] * s.m[2][2]) * invDet;
+    mapping.m[0][2] = (s.m[0][1] * s.m[1][2] - s.m[0][2] * s.m[1][1]) * invDet;
+    mapping.m[1][0] = c01 * invDet;
+    mapping.m[1][1] = (s.m[0][0] * s.m[2][2] - s.m[0][2] * s.m[2][0]) * invDet;
+    mapping.m[1][2] = (s.m[0][2] * s.m[1][0] - s.m[0][0] * s.m[1][2]) * invDet;
+    mapping.m[2][0] = c02 * invDet;
+    mapping.m[2][1] = (s.m[0][1] * s.m[2][0] - s.m[0][0] * s.m[2][1]) * invDet;
+    mapping.m[2][2] = (s.m[0][0] * s.m[1][1] - s.m[0][1] * s.m[1][0]) * invDet;
+
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            if (!std::isfinite(mapping.m[i][j])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool quadToSquare(const Vec2* quad, Mat3x3& mapping) {
+    // Square-to-quad: x = (a u + b v + c) / (g u + h v + 1), y = (d u + e v + f) / (g u + h v + 1)
+    double sx = quad[0].x - quad[1].x + quad[2].x - quad[3].x;
+    double sy = quad[0].y - quad[1].y + quad[2].y - quad[3].y;
+    double dx1 = quad[1].x - quad[2].x;
+    double dx2 = quad[3].x - quad[2].x;
+    double dy1 = quad[1].y - quad[2].y;
+    double dy2 = quad[3].y - quad[2].y;
+
+    // Degenerate when the edges at corner 2 are (nearly) parallel, relative to the quad's size
+    double den = dx1 * dy2 - dx2 * dy1;
+    double extent = std::max(std::max(std::abs(dx1), std::abs(dx2)), std::max(std::abs(dy1), std::abs(dy2)));
+    if (!(std::abs(den) > 1e-9 * extent * extent)) {
+        return false;
+    }
+
+    double g = (sx * dy2 - dx2 * sy) / den;
+    double h = (dx1 * sy - sx * dy1) / den;
+
+    // w is 1, 1 + g, 1 + g + h and 1 + h at the corners; a sign change means the
+    // quad is not convex and the mapping passes through infinity inside it
+    const double MIN_W = 1e-6;
+    if (!(1.0 + g > MIN_W && 1.0 + h > MIN_W && 1.0 + g + h > MIN_W)) {
+        return false;
+    }
+
+    Mat3x3 s;
+    s.m[0][0] = quad[1].x - quad[0].x + g * quad[1].x;
+    s.m[0][1] = quad[3].x - quad[0].x + h * quad[3].x;
+    s.m[0][2] = quad[0].x;
+    s.m[1][0] = quad[1].y - quad[0].y + g * quad[1].y;
+    s.m[1][1] = quad[3].y - quad[0].y + h * quad[3].y;
+    s.m[1][2] = quad[0].y;
+    s.m[2][0] = g;
+    s.m[2][1] = h;
+    s.m[2][2] = 1.0;
+
+    return invertThroughAdjugate(s, mapping);
+}
+
+bool parallelogramToSquare(const Vec3& origin, const Vec3& edgeU, const Vec3& edgeV,
+    double d, double cx, double cy, Mat3x3& mapping) {
+    // Square-to-screen: the camera-space point origin + u * edgeU + v * edgeV,
+    // projected with homogeneous coordinates (d x + cx z, d y + cy z, z)
+    const Vec3* columns[3] = { &edgeU, &edgeV, &origin };
+    Mat3x3 s;
+    for (int j = 0; j < 3; j++) {
+        s.m[0][j] = d * columns[j]->x + cx * columns[j]->z;
+        s.m[1][j] = d * columns[j]->y + cy * columns[j]->z;
+        s.m[2][j] = columns[j]->z;
+    }
+
+    return invertThroughAdjugate(s, mapping);
+}
+
 bool isInsideQuad(const Vec2& p, const std::vector<Vec2>& quad) {
     if (quad.size() != 4) return false;
 
+    return isInsideConvexPolygon(p, quad.data(), 4);
+}
+
+bool isInsideConvexPolygon(const Vec2& p, const Vec2* polygon, int count) {
     // Check if point is on the same side of all edges
     bool allPositive = true;
     bool allNegative = true;
 
-    for (int i = 0; i < 4; i++) {
-        int j = (i + 1) % 4;
-        double edge_x = quad[j].x - quad[i].x;
-        double edge_y = quad[j].y - quad[i].y;
-        double to_p_x = p.x - quad[i].x;
-        double to_p_y = p.y - quad[i].y;
+    for (int i = 0; i < count; i++) {
+        int j = (i + 1) % count;
+        double edge_x = polygon[j].x - polygon[i].x;
+        double edge_y = polygon[j].y - polygon[i].y;
+        double to_p_x = p.x - polygon[i].x;
+        double to_p_y = p.y - polygon[i].y;
 
         double cross = edge_x * to_p_y - edge_y * to_p_x;
 
@@ -378,4 +578,4 @@ bool isInsideQuad(const Vec2& p, const std::vector<Vec2>& quad) {
     }
 
     return allPositive || allNegative;
-}
\ No newline at end of file
+}
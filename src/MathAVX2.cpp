@@ -0,0 +1,65 @@
+// Compiled with AVX2 code generation; only called after a CPU check
+#include "VertexKernels.hpp"
+#include <immintrin.h>
+
+void transformAndProjectAVX2(const double m[4][4], const PointsSoA& in, const ScreenPointsSoA& out, size_t count) {
+    __m256d r[4][4];
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            r[i][j] = _mm256_set1_pd(m[i][j]);
+        }
+    }
+    const __m256d one = _mm256_set1_pd(1.0);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d x = _mm256_loadu_pd(in.x + i);
+        __m256d y = _mm256_loadu_pd(in.y + i);
+        __m256d z = _mm256_loadu_pd(in.z + i);
+
+        __m256d tx = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+            _mm256_mul_pd(r[0][0], x), _mm256_mul_pd(r[0][1], y)), _mm256_mul_pd(r[0][2], z)), r[0][3]);
+        __m256d ty = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+            _mm256_mul_pd(r[1][0], x), _mm256_mul_pd(r[1][1], y)), _mm256_mul_pd(r[1][2], z)), r[1][3]);
+        __m256d tw = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+            _mm256_mul_pd(r[3][0], x), _mm256_mul_pd(r[3][1], y)), _mm256_mul_pd(r[3][2], z)), r[3][3]);
+
+        __m256d invW = _mm256_div_pd(one, tw);
+        _mm256_storeu_pd(out.x + i, _mm256_mul_pd(tx, invW));
+        _mm256_storeu_pd(out.y + i, _mm256_mul_pd(ty, invW));
+        _mm256_storeu_pd(out.depth + i, tw);
+    }
+
+    transformAndProjectScalar(m, in, out, i, count);
+}
+
+void transformAndProjectAVX2(const double m[4][4], const PointsSoAf& in, const ScreenPointsSoAf& out, size_t count) {
+    __m256 r[4][4];
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            r[i][j] = _mm256_set1_ps(static_cast<float>(m[i][j]));
+        }
+    }
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(in.x + i);
+        __m256 y = _mm256_loadu_ps(in.y + i);
+        __m256 z = _mm256_loadu_ps(in.z + i);
+
+        __m256 tx = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+            _mm256_mul_ps(r[0][0], x), _mm256_mul_ps(r[0][1], y)), _mm256_mul_ps(r[0][2], z)), r[0][3]);
+        __m256 ty = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+            _mm256_mul_ps(r[1][0], x), _mm256_mul_ps(r[1][1], y)), _mm256_mul_ps(r[1][2], z)), r[1][3]);
+        __m256 tw = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+            _mm256_mul_ps(r[3][0], x), _mm256_mul_ps(r[3][1], y)), _mm256_mul_ps(r[3][2], z)), r[3][3]);
+
+        __m256 invW = _mm256_div_ps(one, tw);
+        _mm256_storeu_ps(out.x + i, _mm256_mul_ps(tx, invW));
+        _mm256_storeu_ps(out.y + i, _mm256_mul_ps(ty, invW));
+        _mm256_storeu_ps(out.depth + i, tw);
+    }
+
+    transformAndProjectScalar(m, in, out, i, count);
+}
@@ -0,0 +1,80 @@
+#include "Mesh.hpp"
+#include <algorithm>
+
+Mesh::Mesh() : boundingRadius(0.0) {
+}
+
+size_t Mesh::vertexCount() const {
+    return x.size();
+}
+
+size_t Mesh::triangleCount() const {
+    return indices.size() / 3;
+}
+
+bool Mesh::hasTexCoords() const {
+    return !x.empty() && u.size() == x.size() && v.size() == x.size();
+}
+
+PointsSoAf Mesh::positions() const {
+    return { x.data(), y.data(), z.data() };
+}
+
+Vec3 Mesh::position(uint32_t index) const {
+    return Vec3(x[index], y[index], z[index]);
+}
+
+int Mesh::findMaterial(const std::string& name) const {
+    for (size_t i = 0; i < materialNames.size(); i++) {
+        if (materialNames[i] == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void Mesh::computeGeometry() {
+    const size_t triangles = triangleCount();
+    normals.resize(triangles);
+    for (size_t t = 0; t < triangles; t++) {
+        Vec3 a = position(indices[3 * t]);
+        Vec3 edge1 = position(indices[3 * t + 1]) - a;
+        Vec3 edge2 = position(indices[3 * t + 2]) - a;
+        normals[t] = edge1.cross(edge2).normalize();
+    }
+
+    double radiusSquared = 0.0;
+    for (size_t i = 0; i < vertexCount(); i++) {
+        Vec3 p = position(static_cast<uint32_t>(i));
+        radiusSquared = std::max(radiusSquared, p.dot(p));
+    }
+    boundingRadius = std::sqrt(radiusSquared);
+}
+
+void Mesh::fitToRadius(double radius) {
+    if (x.empty()) {
+        return;
+    }
+
+    auto center = [](const std::vector<float>& values) {
+        auto range = std::minmax_element(values.begin(), values.end());
+        return 0.5 * (static_cast<double>(*range.first) + *range.second);
+    };
+    const double cx = center(x);
+    const double cy = center(y);
+    const double cz = center(z);
+
+    double radiusSquared = 0.0;
+    for (size_t i = 0; i < vertexCount(); i++) {
+        Vec3 p(x[i] - cx, y[i] - cy, z[i] - cz);
+        radiusSquared = std::max(radiusSquared, p.dot(p));
+    }
+    const double scale = radiusSquared > 0.0 ? radius / std::sqrt(radiusSquared) : 1.0;
+
+    for (size_t i = 0; i < vertexCount(); i++) {
+        x[i] = static_cast<float>((x[i] - cx) * scale);
+        y[i] = static_cast<float>((y[i] - cy) * scale);
+        z[i] = static_cast<float>((z[i] - cz) * scale);
+    }
+    computeGeometry();
+}
@@ -0,0 +1,313 @@
+#include "ObjLoader.hpp"
+#include "MappedFile.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// Marks a position that no mesh vertex uses yet, or a vertex without texture coordinates
+static const uint32_t NO_INDEX = std::numeric_limits<uint32_t>::max();
+
+// Cursor over one line of the mapped file
+class LineCursor {
+public:
+    LineCursor(const char* begin, const char* end) : p(begin), end(end) {
+    }
+
+    bool atEnd() const {
+        return p >= end;
+    }
+
+    void skipSpaces() {
+        while (p < end && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+    }
+
+    // Reads the next whitespace-separated word
+    std::string word() {
+        skipSpaces();
+        const char* start = p;
+        while (p < end && *p != ' ' && *p != '\t') {
+            p++;
+        }
+        return std::string(start, p);
+    }
+
+    // Reads a signed decimal number with optional fraction and exponent
+    bool number(double& value) {
+        skipSpaces();
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negative = (*p == '-');
+            p++;
+        }
+
+        uint64_t mantissa = 0;
+        int exponent = 0;
+        int digits = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+            if (mantissa < 100000000000000000ULL) {
+                mantissa = mantissa * 10 + (*p - '0');
+            }
+            else {
+                exponent++;
+            }
+        }
+        if (p < end && *p == '.') {
+            p++;
+            for (; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+                if (mantissa < 100000000000000000ULL) {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    exponent--;
+                }
+            }
+        }
+        if (digits == 0) {
+            return false;
+        }
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            p++;
+            int exponentSign = 1;
+            if (p < end && (*p == '-' || *p == '+')) {
+                exponentSign = (*p == '-') ? -1 : 1;
+                p++;
+            }
+            int written = 0;
+            for (; p < end && *p >= '0' && *p <= '9'; p++) {
+                written = std::min(written * 10 + (*p - '0'), 1000);
+            }
+            exponent += exponentSign * written;
+        }
+
+        value = static_cast<double>(mantissa) * powerOfTen(exponent);
+        if (negative) {
+            value = -value;
+        }
+        return true;
+    }
+
+    // Reads a signed integer
+    bool integer(long long& value) {
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negative = (*p == '-');
+            p++;
+        }
+        if (p >= end || *p < '0' || *p > '9') {
+            return false;
+        }
+        value = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; p++) {
+            value = std::min(value * 10 + (*p - '0'), 1LL << 40);
+        }
+        if (negative) {
+            value = -value;
+        }
+        return true;
+    }
+
+    // Consumes c if it is the next character
+    bool accept(char c) {
+        if (p < end && *p == c) {
+            p++;
+            return true;
+        }
+        return false;
+    }
+
+    // Checks for a character that ends the current token
+    bool atSeparator() const {
+        return p >= end || *p == ' ' || *p == '\t';
+    }
+
+private:
+    const char* p;
+    const char* end;
+
+    static double powerOfTen(int exponent) {
+        static const double table[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        if (exponent >= 0 && exponent <= 22) {
+            return table[exponent];
+        }
+        if (exponent < 0 && exponent >= -22) {
+            return 1.0 / table[-exponent];
+        }
+        return std::pow(10.0, exponent);
+    }
+};
+
+// Resolves a 1-based or negative (relative) OBJ index into a 0-based one
+static bool resolveIndex(long long index, size_t count, uint32_t& resolved) {
+    long long zeroBased = index > 0 ? index - 1 : static_cast<long long>(count) + index;
+    if (index == 0 || zeroBased < 0 || zeroBased >= static_cast<long long>(count)) {
+        return false;
+    }
+    resolved = static_cast<uint32_t>(zeroBased);
+    return true;
+}
+
+bool loadObjMesh(const std::string& filename, Mesh& mesh) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        return false;
+    }
+
+    mesh = Mesh();
+
+    // OBJ positions and texture coordinates as read; mesh vertices are made from pairs of them
+    std::vector<float> positions;
+    std::vector<float> texCoords;
+
+    // Mesh vertices made from each position, chained through nextVariant
+    std::vector<uint32_t> firstVariant;
+    std::vector<uint32_t> nextVariant;
+    std::vector<uint32_t> variantTexCoord;
+
+    bool anyTexCoords = false;
+    int currentMaterial = -1;
+    std::vector<uint32_t> polygon;
+
+    const char* p = file.data();
+    const char* end = p + file.size();
+    long long lineNumber = 0;
+    while (p < end) {
+        const char* lineEnd = p;
+        while (lineEnd < end && *lineEnd != '\n') {
+            lineEnd++;
+        }
+        const char* next = lineEnd < end ? lineEnd + 1 : end;
+        if (lineEnd > p && lineEnd[-1] == '\r') {
+            lineEnd--;
+        }
+        lineNumber++;
+
+        LineCursor line(p, lineEnd);
+        p = next;
+        line.skipSpaces();
+        if (line.atEnd()) {
+            continue;
+        }
+
+        std::string keyword = line.word();
+        if (keyword == "v") {
+            double px, py, pz;
+            if (!line.number(px) || !line.number(py) || !line.number(pz)) {
+                LOG_ERROR << filename << ":" << lineNumber << ": malformed vertex";
+                return false;
+            }
+            positions.push_back(static_cast<float>(px));
+            positions.push_back(static_cast<float>(-py));
+            positions.push_back(static_cast<float>(-pz));
+            firstVariant.push_back(NO_INDEX);
+        }
+        else if (keyword == "vt") {
+            double tu, tv = 0.0;
+            if (!line.number(tu)) {
+                LOG_ERROR << filename << ":" << lineNumber << ": malformed texture coordinate";
+                return false;
+            }
+            line.number(tv);
+            texCoords.push_back(static_cast<float>(tu));
+            texCoords.push_back(static_cast<float>(1.0 - tv));
+        }
+        else if (keyword == "usemtl") {
+            std::string name = line.word();
+            currentMaterial = mesh.findMaterial(name);
+            if (currentMaterial < 0) {
+                if (mesh.materialNames.size() > std::numeric_limits<uint16_t>::max()) {
+                    LOG_ERROR << filename << ":" << lineNumber << ": too many materials";
+                    return false;
+                }
+                currentMaterial = static_cast<int>(mesh.materialNames.size());
+                mesh.materialNames.push_back(name);
+            }
+        }
+        else if (keyword == "f") {
+            const size_t positionCount = positions.size() / 3;
+            const size_t texCoordCount = texCoords.size() / 2;
+            polygon.clear();
+            for (;;) {
+                line.skipSpaces();
+                if (line.atEnd()) {
+                    break;
+                }
+
+                // v, v/vt, v//vn or v/vt/vn
+                long long index;
+                uint32_t position;
+                uint32_t texCoord = NO_INDEX;
+                if (!line.integer(index) || !resolveIndex(index, positionCount, position)) {
+                    LOG_ERROR << filename << ":" << lineNumber << ": bad vertex index in face";
+                    return false;
+                }
+                if (line.accept('/')) {
+                    if (!line.accept('/')) {
+                        if (!line.integer(index) || !resolveIndex(index, texCoordCount, texCoord)) {
+                            LOG_ERROR << filename << ":" << lineNumber << ": bad texture coordinate index in face";
+                            return false;
+                        }
+                        line.accept('/');
+                    }
+                    long long normal;
+                    line.integer(normal);
+                }
+                if (!line.atSeparator()) {
+                    LOG_ERROR << filename << ":" << lineNumber << ": malformed face";
+                    return false;
+                }
+
+                // Reuse the mesh vertex made from the same pair, or make a new one
+                uint32_t vertex = firstVariant[position];
+                while (vertex != NO_INDEX && variantTexCoord[vertex] != texCoord) {
+                    vertex = nextVariant[vertex];
+                }
+                if (vertex == NO_INDEX) {
+                    vertex = static_cast<uint32_t>(mesh.x.size());
+                    mesh.x.push_back(positions[3 * position]);
+                    mesh.y.push_back(positions[3 * position + 1]);
+                    mesh.z.push_back(positions[3 * position + 2]);
+                    mesh.u.push_back(texCoord != NO_INDEX ? texCoords[2 * texCoord] : 0.0f);
+                    mesh.v.push_back(texCoord != NO_INDEX ? texCoords[2 * texCoord + 1] : 0.0f);
+                    anyTexCoords = anyTexCoords || texCoord != NO_INDEX;
+                    variantTexCoord.push_back(texCoord);
+                    nextVariant.push_back(firstVariant[position]);
+                    firstVariant[position] = vertex;
+                }
+                polygon.push_back(vertex);
+            }
+
+            if (polygon.size() < 3) {
+                LOG_ERROR << filename << ":" << lineNumber << ": face with fewer than 3 vertices";
+                return false;
+            }
+            if (currentMaterial < 0) {
+                currentMaterial = static_cast<int>(mesh.materialNames.size());
+                mesh.materialNames.push_back("default");
+            }
+
+            // Triangle fan around the first vertex
+            for (size_t i = 1; i + 1 < polygon.size(); i++) {
+                mesh.indices.push_back(polygon[0]);
+                mesh.indices.push_back(polygon[i]);
+                mesh.indices.push_back(polygon[i + 1]);
+                mesh.materials.push_back(static_cast<uint16_t>(currentMaterial));
+            }
+        }
+    }
+
+    if (!anyTexCoords) {
+        mesh.u.clear();
+        mesh.v.clear();
+    }
+    mesh.computeGeometry();
+
+    LOG_INFO << "Loaded " << filename << ": " << mesh.vertexCount() << " vertices, "
+        << mesh.triangleCount() << " triangles, " << mesh.materialNames.size() << " material(s)"
+        << (anyTexCoords ? ", textured" : "");
+    return true;
+}
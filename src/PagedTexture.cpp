@@ -0,0 +1,503 @@
+#include "PagedTexture.hpp"
+#include "Logger.hpp"
+#include "Texture.hpp"
+#include "stb_image.h"
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+
+// Page files start with this header, followed by one PageFileLevel per mip level
+static const char PAGE_MAGIC[8] = { 'C', 'U', 'B', 'E', 'P', 'A', 'G', 'E' };
+static const uint32_t PAGE_VERSION = 1;
+
+// Pages start on a file system block boundary, one read each
+static const uint64_t PAGE_DATA_ALIGNMENT = 4096;
+
+struct PageFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t width, height;
+    uint32_t levelCount;
+    uint32_t pageSize, pageRows, pageStride;  // Page geometry the file was written with
+    uint32_t reserved;
+};
+
+struct PageFileLevel {
+    uint32_t width, height;
+    uint32_t pagesX, pagesY;
+    uint32_t firstPage;
+    uint32_t reserved;
+};
+
+/**
+ * Geometry of every level of a texture, down to 1x1, with pages numbered level by level
+ *
+ * @param width Base width in texels
+ * @param height Base height in texels
+ * @return Level geometry
+ */
+static std::vector<PagedTexture::Level> pageLevels(int width, int height) {
+    std::vector<PagedTexture::Level> levels;
+    uint32_t pages = 0;
+    for (;;) {
+        PagedTexture::Level level;
+        level.width = width;
+        level.height = height;
+        level.pagesX = (width + PagedTexture::PAGE_SIZE - 1) >> PagedTexture::PAGE_SHIFT;
+        level.pagesY = (height + PagedTexture::PAGE_SIZE - 1) >> PagedTexture::PAGE_SHIFT;
+        level.firstPage = pages;
+        levels.push_back(level);
+        pages += static_cast<uint32_t>(level.pagesX * level.pagesY);
+        if (width == 1 && height == 1) {
+            return levels;
+        }
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+}
+
+// File offset of page 0
+static uint64_t pageDataOffset(size_t levelCount) {
+    const uint64_t tables = sizeof(PageFileHeader) + levelCount * sizeof(PageFileLevel);
+    return (tables + PAGE_DATA_ALIGNMENT - 1) & ~(PAGE_DATA_ALIGNMENT - 1);
+}
+
+/**
+ * Writes the pages of one level as its rows arrive top to bottom, and hands the
+ * 2x2 averages of each pair of rows to the writer of the next level
+ *
+ * Only the current band of PAGE_ROWS rows is held: row k * PAGE_SIZE is both the
+ * first row of band k and the extra bottom row of band k - 1, which is written
+ * out when it arrives.
+ */
+class LevelWriter {
+public:
+    LevelWriter(std::ofstream& out, uint64_t dataOffset, const PagedTexture::Level& level, LevelWriter* next)
+        : out(out), dataOffset(dataOffset), level(level), next(next),
+          band(static_cast<size_t>(PagedTexture::PAGE_ROWS) * level.width),
+          page(static_cast<size_t>(PagedTexture::PAGE_STRIDE) * PagedTexture::PAGE_ROWS, 0),
+          pending(next ? level.width : 0), reduced(next ? next->level.width : 0), rows(0) {
+    }
+
+    /**
+     * Add the next row of the level
+     *
+     * @param row level.width packed texels
+     */
+    void push(const uint32_t* row) {
+        const int local = rows & (PagedTexture::PAGE_SIZE - 1);
+        if (local == 0 && rows > 0) {
+            std::memcpy(bandRow(PagedTexture::PAGE_SIZE), row, level.width * sizeof(uint32_t));
+            writeBand((rows >> PagedTexture::PAGE_SHIFT) - 1, PagedTexture::PAGE_ROWS);
+        }
+        std::memcpy(bandRow(local), row, level.width * sizeof(uint32_t));
+
+        // Pairs of rows make one row of the next level; an odd last row is dropped
+        if (next && (rows & 1)) {
+            reduce(pending.data(), row);
+        }
+        else if (next) {
+            std::memcpy(pending.data(), row, level.width * sizeof(uint32_t));
+        }
+        rows++;
+    }
+
+    /**
+     * Write the last band once every row has been pushed, then finish the next level
+     */
+    void finish() {
+        writeBand((rows - 1) >> PagedTexture::PAGE_SHIFT, ((rows - 1) & (PagedTexture::PAGE_SIZE - 1)) + 1);
+        if (next) {
+            // A single row is averaged with itself, as the mip chain does
+            if (rows == 1) {
+                reduce(pending.data(), pending.data());
+            }
+            next->finish();
+        }
+    }
+
+private:
+    std::ofstream& out;
+    uint64_t dataOffset;
+    PagedTexture::Level level;
+    LevelWriter* next;
+    std::vector<uint32_t> band;     // Rows of the current band, width per row
+    std::vector<uint32_t> page;     // Page being assembled
+    std::vector<uint32_t> pending;  // Even row waiting for its pair
+    std::vector<uint32_t> reduced;  // Row of the next level
+    int rows;                       // Rows pushed so far
+
+    uint32_t* bandRow(int row) {
+        return band.data() + static_cast<size_t>(row) * level.width;
+    }
+
+    void reduce(const uint32_t* row0, const uint32_t* row1) {
+        const int sourceWidth = level.width;
+        for (int x = 0; x < next->level.width; x++) {
+            const int x0 = std::min(2 * x, sourceWidth - 1);
+            const int x1 = std::min(2 * x + 1, sourceWidth - 1);
+            reduced[x] = Texture::average4(row0[x0], row0[x1], row1[x0], row1[x1]);
+        }
+        next->push(reduced.data());
+    }
+
+    /**
+     * Cut a band into pages and write them; rows and columns past the edges repeat the last ones
+     *
+     * @param pageRow Page row of the band
+     * @param bandRows Rows of the band that were pushed
+     */
+    void writeBand(int pageRow, int bandRows) {
+        for (int px = 0; px < level.pagesX; px++) {
+            const int firstColumn = px << PagedTexture::PAGE_SHIFT;
+            for (int r = 0; r < PagedTexture::PAGE_ROWS; r++) {
+                const uint32_t* source = bandRow(std::min(r, bandRows - 1));
+                uint32_t* dest = page.data() + static_cast<size_t>(r) * PagedTexture::PAGE_STRIDE;
+                const int copied = std::min(PagedTexture::PAGE_SIZE + 1, level.width - firstColumn);
+                std::memcpy(dest, source + firstColumn, copied * sizeof(uint32_t));
+                std::fill(dest + copied, dest + PagedTexture::PAGE_SIZE + 1, source[level.width - 1]);
+            }
+            const uint64_t id = level.firstPage + static_cast<uint64_t>(pageRow) * level.pagesX + px;
+            out.seekp(static_cast<std::streamoff>(dataOffset + id * PagedTexture::PAGE_BYTES));
+            out.write(reinterpret_cast<const char*>(page.data()), PagedTexture::PAGE_BYTES);
+        }
+    }
+};
+
+/**
+ * Write a page file from rows produced one at a time
+ *
+ * @param pageFile Page file to write
+ * @param width Width in texels
+ * @param height Height in texels
+ * @param readRow Fills the next row (width packed texels); returns false on error
+ * @return true if the page file was written
+ */
+static bool writePageFile(const std::string& pageFile, int width, int height,
+    const std::function<bool(uint32_t*)>& readRow) {
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+    std::ofstream out(pageFile, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        LOG_ERROR << "Failed to create page file: " << pageFile;
+        return false;
+    }
+
+    const std::vector<PagedTexture::Level> levels = pageLevels(width, height);
+    PageFileHeader header = {};
+    std::memcpy(header.magic, PAGE_MAGIC, sizeof(header.magic));
+    header.version = PAGE_VERSION;
+    header.width = static_cast<uint32_t>(width);
+    header.height = static_cast<uint32_t>(height);
+    header.levelCount = static_cast<uint32_t>(levels.size());
+    header.pageSize = PagedTexture::PAGE_SIZE;
+    header.pageRows = PagedTexture::PAGE_ROWS;
+    header.pageStride = PagedTexture::PAGE_STRIDE;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const PagedTexture::Level& level : levels) {
+        PageFileLevel entry = {};
+        entry.width = static_cast<uint32_t>(level.width);
+        entry.height = static_cast<uint32_t>(level.height);
+        entry.pagesX = static_cast<uint32_t>(level.pagesX);
+        entry.pagesY = static_cast<uint32_t>(level.pagesY);
+        entry.firstPage = level.firstPage;
+        out.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    }
+
+    // One writer per level, each feeding the next
+    const uint64_t dataOffset = pageDataOffset(levels.size());
+    std::vector<std::unique_ptr<LevelWriter>> writers(levels.size());
+    for (size_t i = levels.size(); i-- > 0; ) {
+        writers[i].reset(new LevelWriter(out, dataOffset, levels[i], i + 1 < levels.size() ? writers[i + 1].get() : nullptr));
+    }
+    std::vector<uint32_t> row(width);
+    for (int y = 0; y < height; y++) {
+        if (!readRow(row.data())) {
+            LOG_ERROR << "Page file conversion stopped at row " << y;
+            out.close();
+            std::remove(pageFile.c_str());
+            return false;
+        }
+        writers[0]->push(row.data());
+    }
+    writers[0]->finish();
+
+    out.close();
+    if (!out) {
+        LOG_ERROR << "Failed to write page file: " << pageFile;
+        std::remove(pageFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Read one whitespace-separated number of a PPM header, skipping comments
+ *
+ * @param in PPM stream
+ * @param value Receives the number
+ * @return false if no number follows
+ */
+static bool readPpmNumber(std::istream& in, int& value) {
+    int c = in.get();
+    while (c == '#' || std::isspace(c)) {
+        if (c == '#') {
+            while (c != '\n' && c != EOF) {
+                c = in.get();
+            }
+        }
+        c = in.get();
+    }
+    if (!std::isdigit(c)) {
+        return false;
+    }
+    value = 0;
+    while (std::isdigit(c) && value < (1 << 24)) {
+        value = value * 10 + (c - '0');
+        c = in.get();
+    }
+    // Exactly one whitespace character ends the number
+    return std::isspace(c) != 0;
+}
+
+bool PagedTexture::convert(const std::string& source, const std::string& pageFile) {
+    std::ifstream in(source, std::ios::binary);
+    char magic[2] = {};
+    in.read(magic, sizeof(magic));
+    int width = 0, height = 0, maxValue = 0;
+    if (in && magic[0] == 'P' && magic[1] == '6' && readPpmNumber(in, width) && readPpmNumber(in, height) &&
+        readPpmNumber(in, maxValue) && maxValue == 255) {
+        // Binary PPM: RGB bytes row by row, streamed straight into the level writers
+        std::vector<unsigned char> rgb(static_cast<size_t>(width) * 3);
+        return writePageFile(pageFile, width, height, [&](uint32_t* row) {
+            if (!in.read(reinterpret_cast<char*>(rgb.data()), static_cast<std::streamsize>(rgb.size()))) {
+                return false;
+            }
+            for (int x = 0; x < width; x++) {
+                row[x] = static_cast<uint32_t>(rgb[3 * x]) | (static_cast<uint32_t>(rgb[3 * x + 1]) << 8) |
+                    (static_cast<uint32_t>(rgb[3 * x + 2]) << 16) | 0xFF000000u;
+            }
+            return true;
+        });
+    }
+    in.close();
+
+    int channels;
+    unsigned char* data = stbi_load(source.c_str(), &width, &height, &channels, 4);
+    if (!data) {
+        LOG_ERROR << "Failed to load image: " << source;
+        LOG_ERROR << "STB Error: " << stbi_failure_reason();
+        return false;
+    }
+    const bool written = convert(reinterpret_cast<const uint32_t*>(data), width, height, pageFile);
+    stbi_image_free(data);
+    return written;
+}
+
+bool PagedTexture::convert(const uint32_t* rgba, int width, int height, const std::string& pageFile) {
+    int y = 0;
+    return writePageFile(pageFile, width, height, [&](uint32_t* row) {
+        std::memcpy(row, rgba + static_cast<size_t>(y++) * width, width * sizeof(uint32_t));
+        return true;
+    });
+}
+
+PagedTexture::PagedTexture()
+    : width(0), height(0), dataOffset(0), slotBudget(1), allocatedSlots(0), oldest(-1), newest(-1) {
+}
+
+PagedTexture::~PagedTexture() {
+}
+
+bool PagedTexture::open(const std::string& pageFile, uint64_t budgetBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    file.open(pageFile, std::ios::binary);
+    if (!file) {
+        LOG_ERROR << "Failed to open page file: " << pageFile;
+        return false;
+    }
+
+    PageFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, PAGE_MAGIC, sizeof(header.magic)) != 0 || header.version != PAGE_VERSION ||
+        header.pageSize != PAGE_SIZE || header.pageRows != PAGE_ROWS || header.pageStride != PAGE_STRIDE ||
+        header.width == 0 || header.height == 0 || header.width > 0x7FFFFFFF || header.height > 0x7FFFFFFF) {
+        LOG_ERROR << "Not a page file: " << pageFile;
+        file.close();
+        return false;
+    }
+
+    // The level table must describe exactly the chain convert() writes
+    std::vector<Level> expected = pageLevels(static_cast<int>(header.width), static_cast<int>(header.height));
+    bool valid = header.levelCount == expected.size();
+    for (size_t i = 0; valid && i < expected.size(); i++) {
+        PageFileLevel entry;
+        valid = file.read(reinterpret_cast<char*>(&entry), sizeof(entry)) &&
+            entry.width == static_cast<uint32_t>(expected[i].width) &&
+            entry.height == static_cast<uint32_t>(expected[i].height) &&
+            entry.pagesX == static_cast<uint32_t>(expected[i].pagesX) &&
+            entry.pagesY == static_cast<uint32_t>(expected[i].pagesY) &&
+            entry.firstPage == expected[i].firstPage;
+    }
+    const Level& last = expected.back();
+    const uint64_t pageCount = last.firstPage + static_cast<uint64_t>(last.pagesX) * last.pagesY;
+    dataOffset = pageDataOffset(expected.size());
+    file.seekg(0, std::ios::end);
+    if (!valid || static_cast<uint64_t>(file.tellg()) < dataOffset + pageCount * PAGE_BYTES) {
+        LOG_ERROR << "Incomplete page file: " << pageFile;
+        file.close();
+        return false;
+    }
+
+    width = static_cast<int>(header.width);
+    height = static_cast<int>(header.height);
+    levels = expected;
+    residentPages.assign(static_cast<size_t>(pageCount), nullptr);
+    pageSlots.assign(static_cast<size_t>(pageCount), -1);
+    slots.clear();
+    freeSlots.clear();
+    slotBudget = std::max<uint64_t>(budgetBytes / PAGE_BYTES, 1);
+    allocatedSlots = 0;
+    oldest = newest = -1;
+    stats = Stats();
+    return true;
+}
+
+int PagedTexture::getWidth() const {
+    return width;
+}
+
+int PagedTexture::getHeight() const {
+    return height;
+}
+
+int PagedTexture::getLevelCount() const {
+    return static_cast<int>(levels.size());
+}
+
+const PagedTexture::Level& PagedTexture::getLevel(int level) const {
+    return levels[level];
+}
+
+void PagedTexture::pin(const uint32_t* ids, int count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int i = 0; i < count; i++) {
+        const uint32_t id = ids[i];
+        int slot = pageSlots[id];
+        if (slot >= 0) {
+            if (slots[slot].pins++ == 0) {
+                unlinkSlot(slot);
+            }
+            continue;
+        }
+
+        slot = takeSlot();
+        Slot& entry = slots[slot];
+        entry.page = id;
+        entry.pins = 1;
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(dataOffset + static_cast<uint64_t>(id) * PAGE_BYTES));
+        if (!file.read(reinterpret_cast<char*>(entry.texels.get()), PAGE_BYTES)) {
+            LOG_ERROR << "Failed to read texture page " << id;
+            std::memset(entry.texels.get(), 0, PAGE_BYTES);
+        }
+        residentPages[id] = entry.texels.get();
+        pageSlots[id] = slot;
+        stats.faults++;
+    }
+}
+
+void PagedTexture::unpin(const uint32_t* ids, int count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int i = 0; i < count; i++) {
+        const int slot = pageSlots[ids[i]];
+        if (--slots[slot].pins > 0) {
+            continue;
+        }
+        // Slots taken over the budget while everything was pinned are given back
+        if (allocatedSlots > slotBudget) {
+            releaseSlot(slot);
+            continue;
+        }
+        Slot& entry = slots[slot];
+        entry.older = newest;
+        entry.newer = -1;
+        if (newest >= 0) {
+            slots[newest].newer = slot;
+        }
+        else {
+            oldest = slot;
+        }
+        newest = slot;
+    }
+}
+
+uint32_t PagedTexture::texel(int level, int x, int y) {
+    const uint32_t id = pageId(level, x, y);
+    pin(&id, 1);
+    const uint32_t value = *texelAddress(level, x, y);
+    unpin(&id, 1);
+    return value;
+}
+
+PagedTexture::Stats PagedTexture::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+int PagedTexture::takeSlot() {
+    // Reuse the least recently used page once the budget is spent
+    if (allocatedSlots >= slotBudget && oldest >= 0) {
+        const int slot = oldest;
+        unlinkSlot(slot);
+        residentPages[slots[slot].page] = nullptr;
+        pageSlots[slots[slot].page] = -1;
+        stats.evictions++;
+        return slot;
+    }
+
+    int slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else {
+        slot = static_cast<int>(slots.size());
+        slots.emplace_back();
+    }
+    slots[slot].texels.reset(new uint32_t[PAGE_BYTES / sizeof(uint32_t)]);
+    slots[slot].older = slots[slot].newer = -1;
+    allocatedSlots++;
+    stats.residentBytes = allocatedSlots * PAGE_BYTES;
+    stats.peakResidentBytes = std::max(stats.peakResidentBytes, stats.residentBytes);
+    return slot;
+}
+
+void PagedTexture::unlinkSlot(int slot) {
+    Slot& entry = slots[slot];
+    if (entry.older >= 0) {
+        slots[entry.older].newer = entry.newer;
+    }
+    else {
+        oldest = entry.newer;
+    }
+    if (entry.newer >= 0) {
+        slots[entry.newer].older = entry.older;
+    }
+    else {
+        newest = entry.older;
+    }
+    entry.older = entry.newer = -1;
+}
+
+void PagedTexture::releaseSlot(int slot) {
+    Slot& entry = slots[slot];
+    residentPages[entry.page] = nullptr;
+    pageSlots[entry.page] = -1;
+    entry.texels.reset();
+    freeSlots.push_back(slot);
+    allocatedSlots--;
+    stats.residentBytes = allocatedSlots * PAGE_BYTES;
+}
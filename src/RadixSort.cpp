@@ -0,0 +1,63 @@
+#include "RadixSort.hpp"
+#include <cstring>
+#include <algorithm>
+#include <utility>
+
+uint32_t orderedFloatKey(double value) {
+    float f = static_cast<float>(value);
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+
+    // Negative floats order backwards: flip all bits; positive ones just move above them
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+void radixSortPairs(std::vector<uint32_t>& keys, std::vector<uint32_t>& values,
+    std::vector<uint32_t>& scratchKeys, std::vector<uint32_t>& scratchValues) {
+    const size_t count = keys.size();
+    scratchKeys.resize(count);
+    scratchValues.resize(count);
+
+    // Histograms of all four digits in one pass over the keys
+    uint32_t counts[4][256] = {};
+    for (size_t i = 0; i < count; i++) {
+        uint32_t key = keys[i];
+        counts[0][key & 0xFF]++;
+        counts[1][(key >> 8) & 0xFF]++;
+        counts[2][(key >> 16) & 0xFF]++;
+        counts[3][key >> 24]++;
+    }
+
+    uint32_t* srcKeys = keys.data();
+    uint32_t* srcValues = values.data();
+    uint32_t* dstKeys = scratchKeys.data();
+    uint32_t* dstValues = scratchValues.data();
+    for (int pass = 0; pass < 4; pass++) {
+        const int shift = pass * 8;
+        uint32_t* histogram = counts[pass];
+        if (count == 0 || histogram[(srcKeys[0] >> shift) & 0xFF] == count) {
+            continue;  // Every key has the same digit
+        }
+
+        uint32_t offset = 0;
+        for (int digit = 0; digit < 256; digit++) {
+            uint32_t n = histogram[digit];
+            histogram[digit] = offset;
+            offset += n;
+        }
+        for (size_t i = 0; i < count; i++) {
+            uint32_t slot = histogram[(srcKeys[i] >> shift) & 0xFF]++;
+            dstKeys[slot] = srcKeys[i];
+            dstValues[slot] = srcValues[i];
+        }
+        std::swap(srcKeys, dstKeys);
+        std::swap(srcValues, dstValues);
+    }
+
+    // An odd number of passes leaves the result in the scratch buffers. Copy it
+    // back rather than swapping, so each vector keeps its own capacity.
+    if (srcKeys != keys.data()) {
+        std::copy(srcKeys, srcKeys + count, keys.data());
+        std::copy(srcValues, srcValues + count, values.data());
+    }
+}
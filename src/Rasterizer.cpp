@@ -0,0 +1,129 @@
+#include "Rasterizer.hpp"
+#include "Logger.hpp"
+#include <cmath>
+
+// RasterRect implementation
+RasterRect::RasterRect(int minX, int minY, int maxX, int maxY)
+    : minX(minX), minY(minY), maxX(maxX), maxY(maxY) {
+}
+
+bool RasterRect::isEmpty() const {
+    return minX > maxX || minY > maxY;
+}
+
+RasterRect RasterRect::intersect(const RasterRect& other) const {
+    return RasterRect(
+        std::max(minX, other.minX), std::max(minY, other.minY),
+        std::min(maxX, other.maxX), std::min(maxY, other.maxY)
+    );
+}
+
+// Floor/ceil division by a power of two for fixed-point values of either sign
+static inline int64_t floorShift(int64_t value, int bits) {
+    return value >> bits;
+}
+
+static inline int64_t ceilShift(int64_t value, int bits) {
+    return -((-value) >> bits);
+}
+
+// Rasterizer implementation
+
+// The rotated 4x grid: no two samples share a row or column, so near-horizontal
+// and near-vertical edges get four coverage levels rather than two
+const int Rasterizer::SAMPLE_X[COVERAGE_SAMPLES] = { -2, 6, -6, 2 };
+const int Rasterizer::SAMPLE_Y[COVERAGE_SAMPLES] = { -6, -2, 2, 6 };
+
+Rasterizer::Rasterizer(const Vec2* vertices, int count)
+    : edgeCount(0) {
+    if (count < 3 || count > MAX_VERTICES) {
+        LOG_ERROR << "Rasterizer needs between 3 and " << static_cast<int>(MAX_VERTICES) << " vertices, got " << count;
+        return;
+    }
+
+    // Keep fixed-point products comfortably inside 64 bits
+    const double LIMIT = static_cast<double>(1 << 22);
+    const double scale = static_cast<double>(1 << SUBPIXEL_BITS);
+
+    int64_t px[MAX_VERTICES];
+    int64_t py[MAX_VERTICES];
+    for (int i = 0; i < count; i++) {
+        if (!std::isfinite(vertices[i].x) || !std::isfinite(vertices[i].y)) {
+            return;
+        }
+        px[i] = std::llround(std::max(-LIMIT, std::min(LIMIT, vertices[i].x)) * scale);
+        py[i] = std::llround(std::max(-LIMIT, std::min(LIMIT, vertices[i].y)) * scale);
+    }
+
+    // Twice the signed area; orient the polygon so the interior is on the positive side
+    int64_t area = 0;
+    for (int i = 0; i < count; i++) {
+        int j = (i + 1) % count;
+        area += px[i] * py[j] - px[j] * py[i];
+    }
+    if (area == 0) {
+        return;
+    }
+    if (area < 0) {
+        std::reverse(px, px + count);
+        std::reverse(py, py + count);
+    }
+
+    int64_t minPX = px[0], maxPX = px[0], minPY = py[0], maxPY = py[0];
+    for (int i = 1; i < count; i++) {
+        minPX = std::min(minPX, px[i]);
+        maxPX = std::max(maxPX, px[i]);
+        minPY = std::min(minPY, py[i]);
+        maxPY = std::max(maxPY, py[i]);
+    }
+    bounds = RasterRect(
+        static_cast<int>(ceilShift(minPX, SUBPIXEL_BITS)), static_cast<int>(ceilShift(minPY, SUBPIXEL_BITS)),
+        static_cast<int>(floorShift(maxPX, SUBPIXEL_BITS)), static_cast<int>(floorShift(maxPY, SUBPIXEL_BITS))
+    );
+    // Samples lie within reach subpixels of the center along either axis
+    const int reach = *std::max_element(SAMPLE_X, SAMPLE_X + COVERAGE_SAMPLES);
+    coverageBounds = RasterRect(
+        static_cast<int>(ceilShift(minPX - reach, SUBPIXEL_BITS)), static_cast<int>(ceilShift(minPY - reach, SUBPIXEL_BITS)),
+        static_cast<int>(floorShift(maxPX + reach, SUBPIXEL_BITS)), static_cast<int>(floorShift(maxPY + reach, SUBPIXEL_BITS))
+    );
+
+    for (int i = 0; i < count; i++) {
+        int j = (i + 1) % count;
+        int64_t ex = px[j] - px[i];
+        int64_t ey = py[j] - py[i];
+        if (ex == 0 && ey == 0) {
+            continue; // Repeated vertex
+        }
+
+        // E(x, y) = ex * (y * S - py) - ey * (x * S - px) with S the subpixel scale
+        Edge& edge = edges[edgeCount++];
+        edge.a = -ey * (int64_t(1) << SUBPIXEL_BITS);
+        edge.b = ex * (int64_t(1) << SUBPIXEL_BITS);
+        edge.c = ey * px[i] - ex * py[i];
+
+        // Top-left rule: pixels exactly on a right or bottom edge belong to the neighbour
+        bool topLeft = (ey < 0) || (ey == 0 && ex > 0);
+        if (!topLeft) {
+            edge.c -= 1;
+        }
+    }
+}
+
+bool Rasterizer::isEmpty() const {
+    return edgeCount == 0 || bounds.isEmpty();
+}
+
+const RasterRect& Rasterizer::getBounds() const {
+    return bounds;
+}
+
+const RasterRect& Rasterizer::getCoverageBounds() const {
+    return coverageBounds;
+}
+
+void drawClippedLine(Image& target, int x0, int y0, int x1, int y1, const Color& color, const RasterRect& clip) {
+    auto plot = [&target, &color](int x, int y) {
+        target.rowData(y)[x] = color;
+    };
+    walkClippedLine(x0, y0, x1, y1, clip, plot);
+}
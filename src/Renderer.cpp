@@ -2,7 +2,32 @@
 #include "Math.hpp"
 #include "Logger.hpp"
 #include "ConfigManager.hpp"
+#include "Rasterizer.hpp"
+#include "TextureSampler.hpp"
+#include "ClipVolume.hpp"
+#include "RadixSort.hpp"
+#include "Antialiasing.hpp"
+#include <cmath>
 #include <algorithm>
+#include <chrono>
+
+// Distance of the near plane; points closer than this are never projected
+static const double NEAR_PLANE = 0.1;
+
+// Guard band around the viewport, in multiples of the larger viewport dimension.
+// Faces reaching past it are clipped, which bounds projected coordinates and the
+// length of every outline walked by the line drawer.
+static const double GUARD_BAND = 1.0;
+
+// Faces each tile bin reserves room for before binning
+static const size_t MAX_RESERVED_BIN_FACES = 256;
+
+// MSAA edge pixels each worker's coverage sample list reserves room for
+static const size_t MAX_RESERVED_EDGE_PIXELS = 16384;
+
+// Triangles of a mesh reserved for up front, so small meshes never grow the face
+// buffers mid-animation; buffers for larger meshes grow with the visible count
+static const size_t MAX_RESERVED_MESH_FACES = 65536;
 
 // ViewCamera implementation
 ViewCamera::ViewCamera(double scale, double x, double y)
@@ -10,7 +35,7 @@ ViewCamera::ViewCamera(double scale, double x, double y)
 }
 
 Vec2 ViewCamera::projectPoint(const Vec3& point) const {
-    if (point.z <= 0.1) {
+    if (point.z <= NEAR_PLANE) {
         // Return a point far off-screen for points behind camera
         return Vec2(-10000, -10000);
     }
@@ -20,6 +45,11 @@ Vec2 ViewCamera::projectPoint(const Vec3& point) const {
         scale * point.y / point.z + centerY);
 }
 
+Vec2 ViewCamera::projectClipped(const Vec3& point) const {
+    return Vec2(scale * point.x / point.z + centerX,
+        scale * point.y / point.z + centerY);
+}
+
 double ViewCamera::getScale() const {
     return scale;
 }
@@ -46,7 +76,11 @@ void ViewCamera::setCenterY(double y) {
 
 // Renderer implementation
 Renderer::Renderer(int width, int height)
-    : width(width), height(height), backgroundColor(10, 20, 30), decalFaceIndex(1) {
+    : width(width), height(height), backgroundColor(10, 20, 30), decalFaceIndex(1),
+    textureWalk(TextureWalk::Scanline), textureFilter(TextureFilter::Bilinear),
+    texturePrecision(TexturePrecision::Double), depthBits(0),
+    visibilityBuffer(false), antialiasing(Antialiasing::None), sampleWidth(width), sampleHeight(height),
+    tileSize(0), tileThreads(1) {
 
     // Set up camera at the center with appropriate scale
     camera = ViewCamera(500, width / 2.0, height / 2.0);
@@ -62,7 +96,11 @@ Renderer::Renderer(int width, int height)
     };
 }
 
-Renderer::Renderer(const ConfigManager& config) {
+Renderer::Renderer(const ConfigManager& config)
+    : textureWalk(TextureWalk::Scanline), textureFilter(TextureFilter::Bilinear),
+    texturePrecision(TexturePrecision::Double), depthBits(0),
+    visibilityBuffer(false), antialiasing(Antialiasing::None), sampleWidth(0), sampleHeight(0),
+    tileSize(0), tileThreads(1) {
     configure(config);
 }
 
@@ -75,6 +113,11 @@ void Renderer::configure(const ConfigManager& config) {
     decalFaceIndex = (config.decalFaceIndex >= 0 && config.decalFaceIndex < 6) ?
         config.decalFaceIndex : 1;
 
+    if (!parseTextureFilter(config.decalSampler, textureFilter)) {
+        LOG_WARNING << "Unknown decal sampler '" << config.decalSampler << "', using bilinear";
+        textureFilter = TextureFilter::Bilinear;
+    }
+
     // Set up camera
     camera = ViewCamera(config.cameraScale, width / 2.0, height / 2.0);
 
@@ -82,267 +125,1142 @@ void Renderer::configure(const ConfigManager& config) {
     for (size_t i = 0; i < std::min(config.faceColors.size(), faceColors.size()); i++) {
         faceColors[i] = config.faceColors[i];
     }
+
+    setDepthBuffer(config.depthBits);
+    setVisibilityBuffer(config.visibilityBuffer);
+
+    Antialiasing mode;
+    if (!parseAntialiasing(config.antialiasing, mode)) {
+        LOG_WARNING << "Unknown antialiasing mode '" << config.antialiasing << "', using none";
+        mode = Antialiasing::None;
+    }
+    setAntialiasing(mode);
+    setTiling(config.tileSize, config.tileThreads);
 }
 
-void Renderer::mapTextureToQuad(
-    Image& targetImage,
-    const Image& textureImage,
-    const std::vector<Vec2>& quadVertices,
-    const Color& fallbackColor
-) {
-    if (quadVertices.size() != 4) {
-        LOG_ERROR << "Texture mapping requires exactly 4 vertices";
-        return;
+Renderer::FaceDraw::FaceDraw(const Vec2* vertices, int count, unsigned outlineMask, const Color& color)
+    : vertexCount(std::min(count, static_cast<int>(Rasterizer::MAX_VERTICES))),
+    outlineMask(outlineMask),
+    rasterizer(vertices, count),
+    color(color),
+    texture(nullptr) {
+    std::copy(vertices, vertices + vertexCount, this->vertices);
+}
+
+// Closeness near / z is affine over the screen for a planar face; fit it through
+// the first vertex and the pair of others spanning the largest triangle with it
+static DepthPlane fitDepthPlane(const Vec2* vertices, const double* depths, int count) {
+    DepthPlane plane;
+    double bestArea = 0.0;
+    int best = -1;
+    for (int i = 1; i + 1 < count; i++) {
+        double area = std::abs((vertices[i].x - vertices[0].x) * (vertices[i + 1].y - vertices[0].y) -
+            (vertices[i].y - vertices[0].y) * (vertices[i + 1].x - vertices[0].x));
+        if (area > bestArea) {
+            bestArea = area;
+            best = i;
+        }
     }
 
-    // Define the corners of the texture in texture space
-    std::vector<Vec2> textureCorners = {
-        Vec2(0, 0),                                                      // Top-left
-        Vec2(textureImage.getWidth() - 1, 0),                            // Top-right
-        Vec2(textureImage.getWidth() - 1, textureImage.getHeight() - 1), // Bottom-right
-        Vec2(0, textureImage.getHeight() - 1)                            // Bottom-left
-    };
+    const double q0 = NEAR_PLANE / depths[0];
+    plane.c = q0;
+    if (best < 0) {
+        return plane;
+    }
 
-    // Compute homography from texture to quad
-    Mat3x3 H = computeHomography(textureCorners, quadVertices);
-    Mat3x3 Hinv = H.inverse();
+    const double x1 = vertices[best].x - vertices[0].x;
+    const double y1 = vertices[best].y - vertices[0].y;
+    const double x2 = vertices[best + 1].x - vertices[0].x;
+    const double y2 = vertices[best + 1].y - vertices[0].y;
+    const double q1 = NEAR_PLANE / depths[best] - q0;
+    const double q2 = NEAR_PLANE / depths[best + 1] - q0;
+    const double det = x1 * y2 - y1 * x2;
+    plane.a = (q1 * y2 - q2 * y1) / det;
+    plane.b = (x1 * q2 - x2 * q1) / det;
+    plane.c = q0 - plane.a * vertices[0].x - plane.b * vertices[0].y;
+    return plane;
+}
+
+Renderer::FaceDraw Renderer::setupFace(
+    const Vec2* vertices,
+    const double* depths,
+    int count,
+    unsigned outlineMask,
+    const Color& color,
+    const Texture* texture,
+    const TexturePlane* plane
+) const {
+    FaceDraw face(vertices, count, outlineMask, color);
+    if (depthTestBits() > 0) {
+        face.depthPlane = fitDepthPlane(vertices, depths, face.vertexCount);
+    }
+    if (!texture) {
+        return face;
+    }
 
-    // Check if homography is valid
-    bool validHomography = true;
-    for (int i = 0; i < 3 && validHomography; i++) {
+    Mat3x3 Hinv;
+    if (plane) {
+        // Screen to plane coordinates (s, t), then affinely on to texture coordinates
+        Mat3x3 toPlane;
+        if (!parallelogramToSquare(plane->origin, plane->edgeS, plane->edgeT, sampleCamera.getScale(),
+            sampleCamera.getCenterX(), sampleCamera.getCenterY(), toPlane)) {
+            return face;
+        }
+        const double uvRows[2][3] = {
+            { plane->uvEdgeS.x, plane->uvEdgeT.x, plane->uvOrigin.x },
+            { plane->uvEdgeS.y, plane->uvEdgeT.y, plane->uvOrigin.y }
+        };
         for (int j = 0; j < 3; j++) {
-            if (std::isnan(Hinv.m[i][j]) || std::isinf(Hinv.m[i][j])) {
-                validHomography = false;
-                break;
+            for (int i = 0; i < 2; i++) {
+                Hinv.m[i][j] = uvRows[i][0] * toPlane.m[0][j] + uvRows[i][1] * toPlane.m[1][j] +
+                    uvRows[i][2] * toPlane.m[2][j];
             }
+            Hinv.m[2][j] = toPlane.m[2][j];
         }
     }
+    else {
+        if (count != 4) {
+            LOG_ERROR << "Texture mapping requires exactly 4 vertices";
+            return face;
+        }
 
-    if (!validHomography) {
-        LOG_WARNING << "Invalid homography for texture mapping, using fallback";
+        // Screen to unit square in closed form; degenerate or folded quads are filled
+        // with the fallback color
+        if (!quadToSquare(vertices, Hinv)) {
+            return face;
+        }
+    }
 
-        // Fill with solid color using triangulation
-        targetImage.fillTriangle(
-            static_cast<int>(quadVertices[0].x), static_cast<int>(quadVertices[0].y),
-            static_cast<int>(quadVertices[1].x), static_cast<int>(quadVertices[1].y),
-            static_cast<int>(quadVertices[2].x), static_cast<int>(quadVertices[2].y),
-            fallbackColor
-        );
+    // Unit square to texel coordinates: corners land on the first and last texels
+    const double texScaleX = texture->getWidth() - 1;
+    const double texScaleY = texture->getHeight() - 1;
+    for (int j = 0; j < 3; j++) {
+        Hinv.m[0][j] *= texScaleX;
+        Hinv.m[1][j] *= texScaleY;
+    }
+
+    face.texture = texture;
+    face.Hinv = Hinv;
+    return face;
+}
+
+RasterRect Renderer::faceArea(const FaceDraw& face) {
+    RasterRect area = face.rasterizer.getCoverageBounds();
+    for (int i = 0; i < face.vertexCount; i++) {
+        const Vec2& v = face.vertices[i];
+        area.minX = std::min(area.minX, static_cast<int>(v.x));
+        area.minY = std::min(area.minY, static_cast<int>(v.y));
+        area.maxX = std::max(area.maxX, static_cast<int>(v.x));
+        area.maxY = std::max(area.maxY, static_cast<int>(v.y));
+    }
+    return area;
+}
+
+// Span shader that hands each covered span to the texture sampler kernels
+class TextureSpanShader {
+public:
+    long long pixels;
+
+    TextureSpanShader(Image& target, const Texture& texture, const Mat3x3& Hinv, const Color& fallbackColor,
+        TextureFilter filter, TexturePrecision precision)
+        : pixels(0), target(target), texture(texture), Hinv(Hinv), fallbackColor(fallbackColor), filter(filter),
+        precision(precision) {
+    }
+
+    void span(int y, int x0, int x1) {
+        Color* row = target.rowData(y);
+        sampleFilteredSpan(makeTextureSpan(texture, Hinv, y, x0, x1, fallbackColor, row + x0), filter, precision);
+        pixels += x1 - x0 + 1;
+    }
+
+private:
+    Image& target;
+    const Texture& texture;
+    const Mat3x3& Hinv;
+    Color fallbackColor;
+    TextureFilter filter;
+    TexturePrecision precision;
+};
+
+// Span shader that counts the pixels it passes on
+template<typename Shader>
+class CountingSpans {
+public:
+    CountingSpans(Shader& shader, long long& pixels) : shader(shader), pixels(pixels) {
+    }
+
+    void span(int y, int x0, int x1) {
+        shader.span(y, x0, x1);
+        pixels += x1 - x0 + 1;
+    }
+
+private:
+    Shader& shader;
+    long long& pixels;
+};
+
+// Span shader that depth-tests each span and passes the surviving runs on
+template<typename T, typename Shader>
+class DepthTestedSpans {
+public:
+    DepthTestedSpans(DepthBuffer<T>& depth, const DepthPlane& plane, Shader& shader, RenderStats& stats,
+        long long& passedPixels)
+        : depth(depth), plane(plane), shader(shader), stats(stats), passedPixels(passedPixels) {
+    }
+
+    void span(int y, int x0, int x1) {
+        auto emit = [this, y](int a, int b) {
+            shader.span(y, a, b);
+            passedPixels += b - a + 1;
+        };
+        depth.testSpan(y, x0, x1, plane, stats.blockRejectedPixels, stats.depthRejectedPixels, emit);
+    }
+
+private:
+    DepthBuffer<T>& depth;
+    const DepthPlane& plane;
+    Shader& shader;
+    RenderStats& stats;
+    long long& passedPixels;
+};
+
+// Span shader that writes a face id into the visibility buffer
+class VisibilityFill {
+public:
+    VisibilityFill(uint32_t* buffer, int width, uint32_t id) : buffer(buffer), width(width), id(id) {
+    }
+
+    void span(int y, int x0, int x1) {
+        uint32_t* row = buffer + static_cast<size_t>(y) * width;
+        std::fill(row + x0, row + x1 + 1, id);
+    }
+
+private:
+    uint32_t* buffer;
+    int width;
+    uint32_t id;
+};
+
+// Coverage shader that depth-tests a face into the MSAA visibility buffer. Fully
+// covered runs of plain pixels take the per-pixel test; pixels covered in part,
+// and edge pixels, are tested sample by sample against the face's depth at the
+// pixel center.
+template<typename T>
+class CoverageSpans {
+public:
+    CoverageSpans(DepthTestedSpans<T, VisibilityFill>& plain, DepthBuffer<T>& depth, const DepthPlane& plane,
+        uint32_t* buffer, int width, uint32_t id, uint32_t edgeFlag, std::vector<CoverageSamples>& edgePixels,
+        RenderStats& stats)
+        : plain(plain), depth(depth), plane(plane), buffer(buffer), width(width), id(id), edgeFlag(edgeFlag),
+        edgePixels(edgePixels), stats(stats) {
+    }
+
+    void span(int y, int x0, int x1) {
+        const uint32_t* row = buffer + static_cast<size_t>(y) * width;
+        int runStart = x0;
+        for (int bx0 = x0; bx0 <= x1; ) {
+            const int bx1 = std::min(x1, bx0 | (DepthBuffer<T>::BLOCK_SIZE - 1));
+            // Stale blocks hold no edge pixels
+            if (depth.touched(bx0, y)) {
+                for (int x = bx0; x <= bx1; x++) {
+                    if (row[x] & edgeFlag) {
+                        if (runStart < x) {
+                            plain.span(y, runStart, x - 1);
+                        }
+                        partial(y, x, Rasterizer::FULL_COVERAGE);
+                        runStart = x + 1;
+                    }
+                }
+            }
+            bx0 = bx1 + 1;
+        }
+        if (runStart <= x1) {
+            plain.span(y, runStart, x1);
+        }
+    }
+
+    void partial(int y, int x, unsigned mask) {
+        cover(x, y, mask, id, DepthBuffer<T>::quantize(plane.a * x + (plane.b * y + plane.c)));
+    }
+
+    /**
+     * Depth-test some samples of a pixel
+     *
+     * @param x Pixel X
+     * @param y Pixel Y
+     * @param mask Samples to test
+     * @param sampleId Visibility entry the passing samples take
+     * @param value Depth value of the samples
+     */
+    void cover(int x, int y, unsigned mask, uint32_t sampleId, T value) {
+        depth.touch(x, y);
+        uint32_t& entry = buffer[static_cast<size_t>(y) * width + x];
+        const T current = depth.at(x, y);
+        if (!(entry & edgeFlag)) {
+            if (value <= current) {
+                stats.depthRejectedPixels++;
+                return;
+            }
+            if (mask == Rasterizer::FULL_COVERAGE) {
+                depth.testPixel(x, y, value);
+                entry = sampleId;
+                stats.visibilityPixels++;
+                return;
+            }
+            // The pixel splits, every sample starting out with the entry it showed
+            CoverageSamples split;
+            for (int k = 0; k < Rasterizer::COVERAGE_SAMPLES; k++) {
+                split.ids[k] = entry;
+                split.depths[k] = current;
+            }
+            entry = edgeFlag | static_cast<uint32_t>(edgePixels.size());
+            edgePixels.push_back(split);
+        }
+
+        CoverageSamples& samples = edgePixels[entry & ~edgeFlag];
+        bool passed = false;
+        for (int k = 0; k < Rasterizer::COVERAGE_SAMPLES; k++) {
+            if ((mask & (1u << k)) && value > samples.depths[k]) {
+                samples.ids[k] = sampleId;
+                samples.depths[k] = value;
+                passed = true;
+            }
+        }
+        if (!passed) {
+            stats.depthRejectedPixels++;
+            return;
+        }
+        stats.visibilityPixels++;
+
+        // The pixel holds its farthest sample, which keeps the block tests conservative
+        uint32_t farthest = samples.depths[0];
+        bool single = true;
+        for (int k = 1; k < Rasterizer::COVERAGE_SAMPLES; k++) {
+            farthest = std::min(farthest, samples.depths[k]);
+            single = single && samples.ids[k] == samples.ids[0];
+        }
+        if (farthest > current) {
+            depth.testPixel(x, y, static_cast<T>(farthest));
+        }
+        // A face covering every sample turns the pixel back into a plain one
+        if (single) {
+            entry = samples.ids[0];
+        }
+    }
+
+private:
+    DepthTestedSpans<T, VisibilityFill>& plain;
+    DepthBuffer<T>& depth;
+    const DepthPlane& plane;
+    uint32_t* buffer;
+    int width;
+    uint32_t id;
+    uint32_t edgeFlag;
+    std::vector<CoverageSamples>& edgePixels;
+    RenderStats& stats;
+};
+
+// Walks the outline edges of a polygon, skipping edges introduced by clipping
+template<typename Plot>
+static void walkOutline(const Vec2* vertices, int count, unsigned outlineMask, const RasterRect& clip, Plot& plot) {
+    for (int i = 0; i < count; i++) {
+        if (!(outlineMask & (1u << i))) {
+            continue;
+        }
+        int j = (i + 1) % count;
+        walkClippedLine(
+            static_cast<int>(vertices[i].x), static_cast<int>(vertices[i].y),
+            static_cast<int>(vertices[j].x), static_cast<int>(vertices[j].y),
+            clip, plot);
+    }
+}
+
+void Renderer::drawFace(Image& targetImage, const FaceDraw& face, const RasterRect& clip, RenderStats& frameStats) {
+    const int bits = depthTestBits();
+    if (bits == 16) {
+        drawFaceDepthTested(targetImage, face, clip, depth16, frameStats);
+        return;
+    }
+    if (bits == 32) {
+        drawFaceDepthTested(targetImage, face, clip, depth32, frameStats);
+        return;
+    }
+
+    if (face.texture) {
+        mapTextureToQuad(targetImage, face, clip, frameStats);
+    }
+    else {
+        SolidFill fill(targetImage, face.color);
+        CountingSpans<SolidFill> counted(fill, frameStats.shadedPixels);
+        face.rasterizer.rasterize(clip, counted);
+    }
 
-        targetImage.fillTriangle(
-            static_cast<int>(quadVertices[0].x), static_cast<int>(quadVertices[0].y),
-            static_cast<int>(quadVertices[2].x), static_cast<int>(quadVertices[2].y),
-            static_cast<int>(quadVertices[3].x), static_cast<int>(quadVertices[3].y),
-            fallbackColor
+    // Draw face outlines, skipping edges introduced by clipping
+    const Vec2* vertices = face.vertices;
+    for (int i = 0; i < face.vertexCount; i++) {
+        if (!(face.outlineMask & (1u << i))) {
+            continue;
+        }
+        int j = (i + 1) % face.vertexCount;
+        drawClippedLine(
+            targetImage,
+            static_cast<int>(vertices[i].x), static_cast<int>(vertices[i].y),
+            static_cast<int>(vertices[j].x), static_cast<int>(vertices[j].y),
+            Color(255, 255, 255), // White outlines
+            clip
         );
+    }
+}
+
+static_assert(Rasterizer::BLOCK_SIZE == DepthBuffer<uint32_t>::BLOCK_SIZE,
+    "rasterizer blocks must line up with depth buffer blocks");
+
+template<typename T>
+void Renderer::drawFaceDepthTested(Image& targetImage, const FaceDraw& face, const RasterRect& clip,
+    DepthBuffer<T>& depth, RenderStats& frameStats) {
+    // Blocks hidden behind everything already drawn there are never rasterized
+    auto blockVisible = [&](int x0, int y0, int x1, int y1) {
+        if (depth.occludes(x0, y0, x1, y1, face.depthPlane)) {
+            frameStats.occludedBlocks++;
+            return false;
+        }
+        return true;
+    };
+
+    if (face.texture) {
+        auto start = std::chrono::steady_clock::now();
+        TextureSpanShader shader(targetImage, *face.texture, face.Hinv, face.color, textureFilter, texturePrecision);
+        DepthTestedSpans<T, TextureSpanShader> tested(depth, face.depthPlane, shader, frameStats,
+            frameStats.shadedPixels);
+        face.rasterizer.rasterize(clip, tested, blockVisible);
+        auto end = std::chrono::steady_clock::now();
+        frameStats.texturedPixels += shader.pixels;
+        frameStats.textureMs += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    else {
+        SolidFill fill(targetImage, face.color);
+        DepthTestedSpans<T, SolidFill> tested(depth, face.depthPlane, fill, frameStats, frameStats.shadedPixels);
+        face.rasterizer.rasterize(clip, tested, blockVisible);
+    }
+
+    // Outline pixels sit up to a pixel off the face, so they get a pixel's worth of slope as bias
+    const DepthPlane& plane = face.depthPlane;
+    const double bias = std::abs(plane.a) + std::abs(plane.b);
+    const Color white(255, 255, 255);
+    auto plot = [&](int x, int y) {
+        if (depth.testPixel(x, y, DepthBuffer<T>::quantize(plane.at(x, y) + bias))) {
+            targetImage.rowData(y)[x] = white;
+        }
+    };
+    walkOutline(face.vertices, face.vertexCount, face.outlineMask, clip, plot);
+}
+
+template<typename T>
+void Renderer::drawFaceVisibility(uint32_t faceIndex, const RasterRect& clip, DepthBuffer<T>& depth,
+    std::vector<CoverageSamples>& edgePixels, RenderStats& frameStats) {
+    const FaceDraw& face = faceDraws[faceIndex];
+    auto blockVisible = [&](int x0, int y0, int x1, int y1) {
+        if (depth.occludes(x0, y0, x1, y1, face.depthPlane)) {
+            frameStats.occludedBlocks++;
+            return false;
+        }
+        return true;
+    };
+
+    VisibilityFill fill(visibility.data(), sampleWidth, faceIndex + 1);
+    DepthTestedSpans<T, VisibilityFill> tested(depth, face.depthPlane, fill, frameStats,
+        frameStats.visibilityPixels);
+    // Same outline bias as drawFaceDepthTested
+    const DepthPlane& plane = face.depthPlane;
+    const double bias = std::abs(plane.a) + std::abs(plane.b);
+    const uint32_t outlineId = (faceIndex + 1) | VISIBILITY_OUTLINE;
+
+    if (antialiasing == Antialiasing::MSAA4x) {
+        CoverageSpans<T> covered(tested, depth, plane, visibility.data(), sampleWidth, faceIndex + 1,
+            VISIBILITY_EDGE, edgePixels, frameStats);
+        face.rasterizer.rasterizeCoverage(clip, covered, blockVisible);
+
+        // Outlines are walked on a 2x2 grid per pixel, as wide as one sample; each
+        // point marks the coverage sample in its quadrant of the pixel, which
+        // Rasterizer::SAMPLE_X and SAMPLE_Y number row by row
+        Vec2 doubled[Rasterizer::MAX_VERTICES];
+        for (int i = 0; i < face.vertexCount; i++) {
+            doubled[i] = Vec2(2.0 * face.vertices[i].x + 0.5, 2.0 * face.vertices[i].y + 0.5);
+        }
+        const RasterRect sampleClip(2 * clip.minX, 2 * clip.minY, 2 * clip.maxX + 1, 2 * clip.maxY + 1);
+        auto plotSample = [&](int sx, int sy) {
+            const int x = sx >> 1;
+            const int y = sy >> 1;
+            covered.cover(x, y, 1u << ((sy & 1) * 2 + (sx & 1)), outlineId,
+                DepthBuffer<T>::quantize(plane.at(x, y) + bias));
+        };
+        walkOutline(doubled, face.vertexCount, face.outlineMask, sampleClip, plotSample);
+        return;
+    }
+
+    face.rasterizer.rasterize(clip, tested, blockVisible);
+    auto plot = [&](int x, int y) {
+        if (depth.testPixel(x, y, DepthBuffer<T>::quantize(plane.at(x, y) + bias))) {
+            visibility[static_cast<size_t>(y) * sampleWidth + x] = outlineId;
+        }
+    };
+    walkOutline(face.vertices, face.vertexCount, face.outlineMask, clip, plot);
+}
+
+template<typename Index>
+void Renderer::drawFaces(Image& targetImage, const std::vector<Index>& faces, const RasterRect& clip,
+    std::vector<CoverageSamples>& edgePixels, RenderStats& frameStats) {
+    // Supersampled faces are drawn into the sample image and filtered down afterwards
+    Image& samples = supersampled() ? sampleImage : targetImage;
+    const int scale = antialiasingSampleScale(antialiasing);
+    const RasterRect pixels(clip.minX / scale, clip.minY / scale,
+        (clip.maxX + 1) / scale - 1, (clip.maxY + 1) / scale - 1);
+
+    if (!deferredShading()) {
+        for (Index f : faces) {
+            drawFace(samples, faceDraws[f], clip, frameStats);
+        }
+    }
+    else if (depthTestBits() == 16) {
+        drawDeferred(samples, faces, clip, depth16, edgePixels, frameStats);
+    }
+    else {
+        drawDeferred(samples, faces, clip, depth32, edgePixels, frameStats);
+    }
+
+    if (supersampled()) {
+        downsampleBox(sampleImage, targetImage, scale, pixels);
+    }
+}
+
+template<typename Index, typename T>
+void Renderer::drawDeferred(Image& samples, const std::vector<Index>& faces, const RasterRect& clip,
+    DepthBuffer<T>& depth, std::vector<CoverageSamples>& edgePixels, RenderStats& frameStats) {
+    // Only the area the faces reach is resolved; the background is already in place elsewhere
+    edgePixels.clear();
+    RasterRect drawn;
+    for (Index f : faces) {
+        drawFaceVisibility(static_cast<uint32_t>(f), clip, depth, edgePixels, frameStats);
+        const RasterRect area = faceArea(faceDraws[f]);
+        drawn = drawn.isEmpty() ? area : RasterRect(std::min(drawn.minX, area.minX), std::min(drawn.minY, area.minY),
+            std::max(drawn.maxX, area.maxX), std::max(drawn.maxY, area.maxY));
+    }
+    if (!drawn.isEmpty()) {
+        resolveVisibility(samples, clip.intersect(drawn), depth, edgePixels, frameStats);
+    }
+}
 
+void Renderer::shadeVisible(Color* out, uint32_t id, int y, int x0, int x1, RenderStats& frameStats) const {
+    if (id == 0) {
+        fillPixels(out, static_cast<size_t>(x1 - x0 + 1), backgroundColor);
+        return;
+    }
+    if (id & VISIBILITY_OUTLINE) {
+        fillPixels(out, static_cast<size_t>(x1 - x0 + 1), Color(255, 255, 255));
         return;
     }
 
+    const FaceDraw& face = faceDraws[id - 1];
+    frameStats.shadedPixels += x1 - x0 + 1;
+    if (!face.texture) {
+        fillPixels(out, static_cast<size_t>(x1 - x0 + 1), face.color);
+        return;
+    }
+
+    sampleFilteredSpan(makeTextureSpan(*face.texture, face.Hinv, y, x0, x1, face.color, out), textureFilter,
+        texturePrecision);
+    frameStats.texturedPixels += x1 - x0 + 1;
+}
+
+// Last column of the run of touched depth blocks starting at x, or x - 1 if x's block is untouched
+template<typename T>
+static int touchedRunEnd(const DepthBuffer<T>& depth, int x, int y, int maxX) {
+    const int block = DepthBuffer<T>::BLOCK_SIZE;
+    int end = x - 1;
+    while (end < maxX && depth.touched(end + 1, y)) {
+        end = std::min(maxX, ((end + 1) | (block - 1)));
+    }
+    return end;
+}
+
+template<typename T>
+void Renderer::resolveVisibility(Image& targetImage, const RasterRect& clip, const DepthBuffer<T>& depth,
+    const std::vector<CoverageSamples>& edgePixels, RenderStats& frameStats) const {
+    for (int y = clip.minY; y <= clip.maxY; y++) {
+        const uint32_t* ids = &visibility[static_cast<size_t>(y) * sampleWidth];
+        Color* row = targetImage.rowData(y);
+        for (int x0 = clip.minX; x0 <= clip.maxX; ) {
+            // Nothing was drawn in untouched blocks, and the background is already in place
+            const int touchedEnd = touchedRunEnd(depth, x0, y, clip.maxX);
+            if (touchedEnd < x0) {
+                x0 = std::min(clip.maxX, x0 | (DepthBuffer<T>::BLOCK_SIZE - 1)) + 1;
+                continue;
+            }
+
+            while (x0 <= touchedEnd) {
+                const uint32_t id = ids[x0];
+                if (id & VISIBILITY_EDGE) {
+                    // Each entry the samples show is shaded once and weighted by its samples
+                    const CoverageSamples& samples = edgePixels[id & ~VISIBILITY_EDGE];
+                    const int count = Rasterizer::COVERAGE_SAMPLES;
+                    int sum[3] = { count / 2, count / 2, count / 2 };
+                    for (int k = 0; k < count; k++) {
+                        int weight = 0;
+                        bool seen = false;
+                        for (int j = 0; j < count; j++) {
+                            seen = seen || (j < k && samples.ids[j] == samples.ids[k]);
+                            weight += samples.ids[j] == samples.ids[k] ? 1 : 0;
+                        }
+                        if (seen) {
+                            continue;
+                        }
+                        Color color;
+                        shadeVisible(&color, samples.ids[k], y, x0, x0, frameStats);
+                        sum[0] += weight * color.r;
+                        sum[1] += weight * color.g;
+                        sum[2] += weight * color.b;
+                    }
+                    row[x0] = Color(static_cast<unsigned char>(sum[0] / count),
+                        static_cast<unsigned char>(sum[1] / count), static_cast<unsigned char>(sum[2] / count));
+                    x0++;
+                    continue;
+                }
+
+                int x1 = x0;
+                while (x1 < touchedEnd && ids[x1 + 1] == id) {
+                    x1++;
+                }
+                if (id != 0) {
+                    shadeVisible(row + x0, id, y, x0, x1, frameStats);
+                }
+                x0 = x1 + 1;
+            }
+        }
+    }
+}
+
+void Renderer::drawTiled(Image& targetImage) {
+    const int tilesX = (sampleWidth + tileSize - 1) / tileSize;
+    const int tilesY = (sampleHeight + tileSize - 1) / tileSize;
+    const RasterRect frameRect(0, 0, sampleWidth - 1, sampleHeight - 1);
+
+    // Bin faces into every tile their fill or outline may touch, keeping draw order.
+    // Bins keep their capacity from frame to frame.
+    if (tileBins.size() != static_cast<size_t>(tilesX * tilesY)) {
+        tileBins.assign(tilesX * tilesY, std::vector<int>());
+    }
+    // Room for as many faces as the face buffers hold, not just this frame's visible
+    // ones, so bins stop growing with them; bins of large scenes grow as needed
+    const size_t binReserve = std::min<size_t>(faceDraws.capacity(), MAX_RESERVED_BIN_FACES);
+    for (auto& bin : tileBins) {
+        bin.clear();
+        bin.reserve(binReserve);
+    }
+    for (uint32_t f : drawOrder) {
+        const FaceDraw& face = faceDraws[f];
+        const RasterRect area = faceArea(face).intersect(frameRect);
+        if (area.isEmpty()) {
+            continue;
+        }
+
+        for (int ty = area.minY / tileSize; ty <= area.maxY / tileSize; ty++) {
+            for (int tx = area.minX / tileSize; tx <= area.maxX / tileSize; tx++) {
+                tileBins[ty * tilesX + tx].push_back(static_cast<int>(f));
+            }
+        }
+    }
+
+    // Each worker keeps its own counters; they are merged once the frame is done
+    tileStats.assign(tilePool ? tilePool->getThreadCount() : 1, RenderStats());
+
+    // Everything the tile loop needs, so the closure captures two pointers and
+    // fits in std::function's inline storage
+    struct TileJob {
+        Image& target;
+        const std::vector<FaceDraw>& faces;
+        RasterRect frameRect;
+        int tilesX;
+    } job = { targetImage, faceDraws, frameRect, tilesX };
+
+    auto drawTile = [this, &job](int tile, int worker) {
+        int tx = tile % job.tilesX;
+        int ty = tile / job.tilesX;
+        RasterRect clip = RasterRect(
+            tx * tileSize, ty * tileSize,
+            tx * tileSize + tileSize - 1, ty * tileSize + tileSize - 1
+        ).intersect(job.frameRect);
+
+        drawFaces(job.target, tileBins[tile], clip, coverageSamples[worker], tileStats[worker]);
+    };
+
+    if (tilePool) {
+        tilePool->parallelFor(tilesX * tilesY, drawTile);
+    }
+    else {
+        for (int tile = 0; tile < tilesX * tilesY; tile++) {
+            drawTile(tile, 0);
+        }
+    }
+
+    for (const auto& ws : tileStats) {
+        stats.texturedPixels += ws.texturedPixels;
+        stats.textureMs += ws.textureMs;
+        stats.shadedPixels += ws.shadedPixels;
+        stats.depthRejectedPixels += ws.depthRejectedPixels;
+        stats.blockRejectedPixels += ws.blockRejectedPixels;
+        stats.occludedBlocks += ws.occludedBlocks;
+        stats.visibilityPixels += ws.visibilityPixels;
+    }
+}
+
+void Renderer::mapTextureToQuad(Image& targetImage, const FaceDraw& face, const RasterRect& clip, RenderStats& frameStats) const {
+    auto start = std::chrono::steady_clock::now();
+
+    long long pixels;
+    if (textureWalk == TextureWalk::Reference) {
+        pixels = walkQuadReference(targetImage, face, clip);
+    }
+    else {
+        pixels = walkQuadScanline(targetImage, face, clip);
+    }
+    frameStats.texturedPixels += pixels;
+    frameStats.shadedPixels += pixels;
+
+    auto end = std::chrono::steady_clock::now();
+    frameStats.textureMs += std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+long long Renderer::walkQuadReference(Image& targetImage, const FaceDraw& face, const RasterRect& clip) const {
+    const Texture& texture = *face.texture;
+    long long pixels = 0;
+
     // Find bounding box of the quad
     int minX = targetImage.getWidth(), minY = targetImage.getHeight();
     int maxX = 0, maxY = 0;
 
-    for (const auto& v : quadVertices) {
+    for (int i = 0; i < face.vertexCount; i++) {
+        const Vec2& v = face.vertices[i];
         minX = std::min(minX, static_cast<int>(v.x));
         minY = std::min(minY, static_cast<int>(v.y));
         maxX = std::max(maxX, static_cast<int>(v.x));
         maxY = std::max(maxY, static_cast<int>(v.y));
     }
 
-    // Clamp to image bounds
-    minX = std::max(0, minX);
-    minY = std::max(0, minY);
-    maxX = std::min(targetImage.getWidth() - 1, maxX);
-    maxY = std::min(targetImage.getHeight() - 1, maxY);
+    // Clamp to the clip rectangle
+    minX = std::max(clip.minX, minX);
+    minY = std::max(clip.minY, minY);
+    maxX = std::min(clip.maxX, maxX);
+    maxY = std::min(clip.maxY, maxY);
 
     // For each pixel in the bounding box
     for (int y = minY; y <= maxY; y++) {
         for (int x = minX; x <= maxX; x++) {
-            // Check if point is inside the quad
+            // Check if point is inside the quad (a larger polygon once clipped)
             Vec2 p(x, y);
-            if (isInsideQuad(p, quadVertices)) {
+            if (isInsideConvexPolygon(p, face.vertices, face.vertexCount)) {
                 // Apply inverse homography
-                Vec3 p_hom = Hinv * Vec3(p.x, p.y, 1.0);
+                Vec3 p_hom = face.Hinv * Vec3(p.x, p.y, 1.0);
                 if (std::abs(p_hom.z) > 1e-8) {
                     p_hom.x /= p_hom.z;
                     p_hom.y /= p_hom.z;
                 }
 
-                // Check if point is within texture bounds
-                if (p_hom.x >= 0 && p_hom.x < textureImage.getWidth() &&
-                    p_hom.y >= 0 && p_hom.y < textureImage.getHeight()) {
-                    // Bilinear interpolation
-                    int x0 = static_cast<int>(p_hom.x);
-                    int y0 = static_cast<int>(p_hom.y);
-                    int x1 = std::min(x0 + 1, textureImage.getWidth() - 1);
-                    int y1 = std::min(y0 + 1, textureImage.getHeight() - 1);
-
-                    double fx = p_hom.x - x0;
-                    double fy = p_hom.y - y0;
-
-                    Color c00 = textureImage.getPixel(x0, y0);
-                    Color c10 = textureImage.getPixel(x1, y0);
-                    Color c01 = textureImage.getPixel(x0, y1);
-                    Color c11 = textureImage.getPixel(x1, y1);
-
-                    unsigned char r = static_cast<unsigned char>(
-                        (1 - fx) * (1 - fy) * c00.r + fx * (1 - fy) * c10.r +
-                        (1 - fx) * fy * c01.r + fx * fy * c11.r);
-                    unsigned char g = static_cast<unsigned char>(
-                        (1 - fx) * (1 - fy) * c00.g + fx * (1 - fy) * c10.g +
-                        (1 - fx) * fy * c01.g + fx * fy * c11.g);
-                    unsigned char b = static_cast<unsigned char>(
-                        (1 - fx) * (1 - fy) * c00.b + fx * (1 - fy) * c10.b +
-                        (1 - fx) * fy * c01.b + fx * fy * c11.b);
-
-                    targetImage.setPixel(x, y, Color(r, g, b));
-                }
-                else {
-                    // Outside texture bounds, use fallback color
-                    targetImage.setPixel(x, y, fallbackColor);
-                }
+                targetImage.setPixel(x, y, sampleBilinearReference(texture, p_hom.x, p_hom.y, face.color));
+                pixels++;
             }
         }
     }
+
+    return pixels;
 }
 
-Image Renderer::renderFrame(
+long long Renderer::walkQuadScanline(Image& targetImage, const FaceDraw& face, const RasterRect& clip) const {
+    TextureSpanShader shader(targetImage, *face.texture, face.Hinv, face.color, textureFilter, texturePrecision);
+    face.rasterizer.rasterize(clip, shader);
+    return shader.pixels;
+}
+
+void Renderer::prepareInstance(
     const Cube& cube,
-    double angle,
-    const Image* decalImage,
-    const Mat4x4* rotationMatrix
+    const Mat4x4& modelView,
+    int decalFace,
+    const std::array<Color, 6>& colors,
+    const Texture* decalTexture,
+    const ClipVolume& clipVolume
 ) {
-    // Create a copy of the cube for transformation
-    Cube transformedCube = cube;
-
-    // Set up transformation matrices
-    Mat4x4 translateZ;
-    translateZ.m[2][3] = 10.0;
-
-    // Create rotation matrix based on the angle or use provided matrix
-    Mat4x4 rotation;
-    if (rotationMatrix) {
-        rotation = *rotationMatrix;
-    }
-    else {
-        rotation = rotateY(angle) * rotateX(angle * 0.5);
+    // Transform the cube vertices, classify them against the clip volume and project them to 2D
+    const size_t numVertices = cube.vertices.size();
+    transformedVertices.resize(numVertices);
+    projectedVertices.resize(numVertices);
+    vertexOutcodes.resize(numVertices);
+    for (size_t i = 0; i < numVertices; i++) {
+        transformedVertices[i] = modelView.transform(cube.vertices[i]);
+        projectedVertices[i] = sampleCamera.projectPoint(transformedVertices[i]);
+        vertexOutcodes[i] = clipVolume.outcode(transformedVertices[i]);
     }
 
-    // Apply transformations
-    transformedCube.transform(translateZ * rotation);
+    // The camera in object space: a face is visible when it lies on the outer side of its plane
+    const Vec3 cameraInObject = modelView.inverseAffine().transform(Vec3(0, 0, 0));
 
-    // Create frame with background color
-    Image frameImage(width, height, backgroundColor);
+    const size_t numFaces = cube.faces.size();
+    for (size_t idx = 0; idx < numFaces; idx++) {
+        const auto& face = cube.faces[idx];
+        if (!(cube.normals[idx].dot(cameraInObject - cube.centroids[idx]) > 0.0)) continue;
 
-    // Project the cube vertices to 2D
-    std::vector<Vec2> projectedVertices;
-    for (const auto& v : transformedCube.vertices) {
-        projectedVertices.push_back(camera.projectPoint(v));
-    }
+        // Apply decal texture to specified face if needed (with proper bounds checking)
+        const Texture* texture = (static_cast<int>(idx) == decalFace) ? decalTexture : nullptr;
+        const Color& color = colors[idx < colors.size() ? idx : 0];
+
+        // Trivially reject faces entirely outside one plane, trivially accept faces inside all of them
+        int outsideAny = 0;
+        int outsideAll = ~0;
+        for (int vertex : face) {
+            outsideAny |= vertexOutcodes[vertex];
+            outsideAll &= vertexOutcodes[vertex];
+        }
+        if (outsideAll != 0) {
+            stats.culledFaces++;
+            continue;
+        }
 
-    // Calculate face visibility
-    std::vector<bool> faceVisible(transformedCube.faces.size(), false);
+        // Center Z used for sorting
+        double depth = modelView.transform(cube.centroids[idx]).z;
+
+        Vec2 quadVertices[Rasterizer::MAX_VERTICES];
+        if (outsideAny == 0) {
+            // Project face vertices
+            int count = std::min(static_cast<int>(face.size()), static_cast<int>(Rasterizer::MAX_VERTICES));
+            double depths[Rasterizer::MAX_VERTICES];
+            for (int i = 0; i < count; i++) {
+                quadVertices[i] = projectedVertices[face[i]];
+                depths[i] = transformedVertices[face[i]].z;
+            }
 
-    // Calculate which faces are visible
-    for (size_t i = 0; i < transformedCube.faces.size(); i++) {
-        const auto& face = transformedCube.faces[i];
+            const unsigned allEdges = (1u << count) - 1;
+            faceDraws.push_back(setupFace(quadVertices, depths, count, allEdges, color, texture, nullptr));
+        }
+        else {
+            // Clip in camera space against the planes the face crosses, then project
+            Vec3 corners[Rasterizer::MAX_VERTICES];
+            Vec3 clipped[Rasterizer::MAX_VERTICES];
+            int cornerCount = std::min(static_cast<int>(face.size()),
+                static_cast<int>(Rasterizer::MAX_VERTICES) - ClipVolume::PLANE_COUNT);
+            for (int i = 0; i < cornerCount; i++) {
+                corners[i] = transformedVertices[face[i]];
+            }
 
-        // Get three vertices of the face to calculate normal
-        Vec3 v0 = transformedCube.vertices[face[0]];
-        Vec3 v1 = transformedCube.vertices[face[1]];
-        Vec3 v2 = transformedCube.vertices[face[2]];
+            unsigned outlineMask = 0;
+            int count = clipVolume.clipPolygon(corners, cornerCount, outsideAny, clipped, outlineMask);
+            if (count < 3) {
+                stats.culledFaces++;
+                continue;
+            }
+            double depths[Rasterizer::MAX_VERTICES];
+            for (int i = 0; i < count; i++) {
+                quadVertices[i] = sampleCamera.projectClipped(clipped[i]);
+                depths[i] = clipped[i].z;
+            }
 
-        // Calculate face normal using cross product
-        Vec3 edge1 = v1 - v0;
-        Vec3 edge2 = v2 - v0;
-        Vec3 normal = edge1.cross(edge2).normalize();
+            // Map the unit square through the plane of the original face
+            TexturePlane plane;
+            if (texture && cornerCount == 4) {
+                plane.origin = corners[0];
+                plane.edgeS = corners[1] - corners[0];
+                plane.edgeT = corners[3] - corners[0];
+                plane.uvOrigin = Vec2(0, 0);
+                plane.uvEdgeS = Vec2(1, 0);
+                plane.uvEdgeT = Vec2(0, 1);
+            }
 
-        // Face is visible if normal points towards camera (negative z)
-        double dotProduct = -normal.z;
+            stats.clippedFaces++;
+            faceDraws.push_back(setupFace(quadVertices, depths, count, outlineMask, color, texture,
+                (texture && cornerCount == 4) ? &plane : nullptr));
+        }
 
-        // Threshold for visibility
-        faceVisible[i] = (dotProduct > 0.001);
+        faceKeys.push_back(faceSortKey(depth));
     }
+}
 
-    // Check if decal face is visible (with proper bounds checking)
-    const size_t numFaces = transformedCube.faces.size();
-    const size_t safeDecalFaceIndex = static_cast<size_t>(decalFaceIndex);
-    bool decalFaceVisible = (safeDecalFaceIndex < numFaces &&
-        faceVisible[safeDecalFaceIndex] &&
-        decalImage != nullptr);
+// Flat shading with a light at the eye: a quarter ambient, the rest by the cosine of the view angle
+static inline Color shadeColor(const Color& color, double cosine) {
+    const double intensity = 0.25 + 0.75 * std::max(0.0, std::min(1.0, cosine));
+    return Color(
+        static_cast<unsigned char>(color.r * intensity + 0.5),
+        static_cast<unsigned char>(color.g * intensity + 0.5),
+        static_cast<unsigned char>(color.b * intensity + 0.5));
+}
 
-    // Sort faces by z-depth for correct rendering order (back-to-front)
-    std::vector<size_t> faceIndices(numFaces);
-    for (size_t i = 0; i < faceIndices.size(); i++) {
-        faceIndices[i] = i;
+void Renderer::prepareMesh(
+    const Mesh& mesh,
+    const Mat4x4& modelView,
+    int decalMaterial,
+    const Texture* decalTexture,
+    const ClipVolume& clipVolume
+) {
+    // Project every vertex in one batch, then classify it from its screen position
+    const size_t numVertices = mesh.vertexCount();
+    screenX.resize(numVertices);
+    screenY.resize(numVertices);
+    screenDepth.resize(numVertices);
+    vertexOutcodes.resize(numVertices);
+    const Mat4x4 projection = perspectiveProjection(sampleCamera.getScale(), sampleCamera.getCenterX(), sampleCamera.getCenterY());
+    const ScreenPointsSoAf screen = { screenX.data(), screenY.data(), screenDepth.data() };
+    transformAndProject(projection * modelView, mesh.positions(), screen, numVertices);
+    for (size_t i = 0; i < numVertices; i++) {
+        vertexOutcodes[i] = clipVolume.outcodeProjected(screenX[i], screenY[i], screenDepth[i]);
     }
 
-    std::sort(faceIndices.begin(), faceIndices.end(), [&](size_t a, size_t b) {
-        const auto& faceA = transformedCube.faces[a];
-        const auto& faceB = transformedCube.faces[b];
-
-        // Calculate center Z consistently
-        Vec3 centerA(0, 0, 0);
-        Vec3 centerB(0, 0, 0);
+    const Vec3 cameraInObject = modelView.inverseAffine().transform(Vec3(0, 0, 0));
+    const bool textured = decalTexture && mesh.hasTexCoords();
+    const int allPlanes = (1 << ClipVolume::PLANE_COUNT) - 1;
 
-        for (int idx : faceA) centerA = centerA + transformedCube.vertices[idx];
-        for (int idx : faceB) centerB = centerB + transformedCube.vertices[idx];
+    const size_t numTriangles = mesh.triangleCount();
+    for (size_t t = 0; t < numTriangles; t++) {
+        const uint32_t* corner = &mesh.indices[3 * t];
 
-        centerA = centerA * (1.0 / faceA.size());
-        centerB = centerB * (1.0 / faceB.size());
+        // Back-face test against the camera in object space
+        const Vec3 toCamera = cameraInObject - mesh.position(corner[0]);
+        const double facing = mesh.normals[t].dot(toCamera);
+        if (!(facing > 0.0)) continue;
 
-        const double EPSILON = 1e-10;
-        if (std::abs(centerA.z - centerB.z) < EPSILON)
-            return a < b;
-
-        return centerA.z > centerB.z; // Render back-to-front
-        });
-
-    // Draw each visible face
-    for (size_t idx : faceIndices) {
-        if (!faceVisible[idx]) continue;
+        int outsideAny = 0;
+        int outsideAll = ~0;
+        for (int k = 0; k < 3; k++) {
+            outsideAny |= vertexOutcodes[corner[k]];
+            outsideAll &= vertexOutcodes[corner[k]];
+        }
+        if (outsideAll != 0) {
+            stats.culledFaces++;
+            continue;
+        }
 
-        const auto& face = transformedCube.faces[idx];
+        const int material = mesh.materials[t];
+        const Texture* texture = (textured && material == decalMaterial) ? decalTexture : nullptr;
+        const Color color = shadeColor(faceColors[material % faceColors.size()], facing / toCamera.length());
 
-        // Project face vertices
-        std::vector<Vec2> quadVertices;
-        for (int vertIdx : face) {
-            quadVertices.push_back(projectedVertices[vertIdx]);
+        // Camera-space corners, only for triangles that clip or carry a texture
+        Vec3 corners[3];
+        TexturePlane plane;
+        if (texture || outsideAny != 0) {
+            for (int k = 0; k < 3; k++) {
+                corners[k] = modelView.transform(mesh.position(corner[k]));
+            }
+        }
+        if (texture) {
+            const Vec2 uv0(mesh.u[corner[0]], mesh.v[corner[0]]);
+            plane.origin = corners[0];
+            plane.edgeS = corners[1] - corners[0];
+            plane.edgeT = corners[2] - corners[0];
+            plane.uvOrigin = uv0;
+            plane.uvEdgeS = Vec2(mesh.u[corner[1]] - uv0.x, mesh.v[corner[1]] - uv0.y);
+            plane.uvEdgeT = Vec2(mesh.u[corner[2]] - uv0.x, mesh.v[corner[2]] - uv0.y);
         }
 
-        // Apply decal texture to specified face if needed (with proper bounds checking)
-        if (idx == safeDecalFaceIndex && decalFaceVisible) {
-            mapTextureToQuad(
-                frameImage,
-                *decalImage,
-                quadVertices,
-                faceColors[idx]
-            );
+        Vec2 polygon[Rasterizer::MAX_VERTICES];
+        double depths[Rasterizer::MAX_VERTICES];
+        int count = 3;
+        if (outsideAny == 0) {
+            for (int k = 0; k < 3; k++) {
+                polygon[k] = Vec2(screenX[corner[k]], screenY[corner[k]]);
+                depths[k] = screenDepth[corner[k]];
+            }
         }
         else {
-            // Fill with solid color using triangulation
-            for (size_t i = 0; i < face.size() - 2; i++) {
-                frameImage.fillTriangle(
-                    static_cast<int>(quadVertices[0].x), static_cast<int>(quadVertices[0].y),
-                    static_cast<int>(quadVertices[i + 1].x), static_cast<int>(quadVertices[i + 1].y),
-                    static_cast<int>(quadVertices[i + 2].x), static_cast<int>(quadVertices[i + 2].y),
-                    faceColors[idx]
-                );
+            // Screen positions behind the eye are unreliable, so a triangle crossing
+            // the near plane is clipped against every plane
+            const int planes = (outsideAny & ClipVolume::NEAR_PLANE) ? allPlanes : outsideAny;
+            Vec3 clipped[Rasterizer::MAX_VERTICES];
+            unsigned outlineMask = 0;
+            count = clipVolume.clipPolygon(corners, 3, planes, clipped, outlineMask);
+            if (count < 3) {
+                stats.culledFaces++;
+                continue;
             }
+            for (int k = 0; k < count; k++) {
+                polygon[k] = sampleCamera.projectClipped(clipped[k]);
+                depths[k] = clipped[k].z;
+            }
+            stats.clippedFaces++;
+        }
+
+        // Mesh triangles are drawn without outlines
+        faceDraws.push_back(setupFace(polygon, depths, count, 0, color, texture, texture ? &plane : nullptr));
+
+        const double depth = (static_cast<double>(screenDepth[corner[0]]) + screenDepth[corner[1]] +
+            screenDepth[corner[2]]) / 3.0;
+        faceKeys.push_back(faceSortKey(depth));
+    }
+}
+
+uint32_t Renderer::faceSortKey(double depth) const {
+    // Ascending keys: nearer faces first when depth testing, farther faces first otherwise
+    return depthTestBits() > 0 ? orderedFloatKey(depth) : ~orderedFloatKey(depth);
+}
+
+void Renderer::sortFaces() {
+    // Sized like faceDraws, so they stop growing when it does
+    drawOrder.reserve(faceDraws.capacity());
+    sortScratchKeys.reserve(faceDraws.capacity());
+    sortScratchOrder.reserve(faceDraws.capacity());
+
+    drawOrder.resize(faceDraws.size());
+    for (size_t i = 0; i < drawOrder.size(); i++) {
+        drawOrder[i] = static_cast<uint32_t>(i);
+    }
+    radixSortPairs(faceKeys, drawOrder, sortScratchKeys, sortScratchOrder);
+}
+
+void Renderer::drawFrame(Image& target) {
+    // Clear the frame to the background color and the depth buffer to infinitely far
+    target.reset(width, height, backgroundColor);
+    if (supersampled()) {
+        sampleImage.reset(sampleWidth, sampleHeight, backgroundColor);
+    }
+    // Visibility entries are cleared with their depth blocks, on first use
+    uint32_t* ids = nullptr;
+    if (deferredShading()) {
+        visibility.resize(static_cast<size_t>(sampleWidth) * sampleHeight);
+        ids = visibility.data();
+    }
+    if (depthTestBits() == 16) {
+        depth16.reset(sampleWidth, sampleHeight, ids);
+    }
+    else if (depthTestBits() == 32) {
+        depth32.reset(sampleWidth, sampleHeight, ids);
+    }
+
+    // One edge pixel list per worker; lists keep their capacity from frame to frame
+    const size_t workers = tilePool ? tilePool->getThreadCount() : 1;
+    if (coverageSamples.size() < workers) {
+        coverageSamples.resize(workers);
+    }
+    if (antialiasing == Antialiasing::MSAA4x) {
+        const size_t area = tileSize > 0 ? static_cast<size_t>(tileSize) * tileSize :
+            static_cast<size_t>(sampleWidth) * sampleHeight;
+        for (auto& list : coverageSamples) {
+            list.reserve(std::min(area, MAX_RESERVED_EDGE_PIXELS));
         }
+    }
+
+    // Draw the faces over the whole sample grid or tile by tile
+    if (tileSize > 0) {
+        drawTiled(target);
+    }
+    else {
+        drawFaces(target, drawOrder, RasterRect(0, 0, sampleWidth - 1, sampleHeight - 1), coverageSamples[0], stats);
+    }
+
+    stats.frames++;
+}
+
+void Renderer::renderFrame(
+    Image& target,
+    const Cube& cube,
+    double angle,
+    const Texture* decalTexture,
+    const Mat4x4* rotationMatrix
+) {
+    // Create rotation matrix based on the angle or use provided matrix
+    Mat4x4 rotation;
+    if (rotationMatrix) {
+        rotation = *rotationMatrix;
+    }
+    else {
+        rotation = rotateY(angle) * rotateX(angle * 0.5);
+    }
 
-        // Draw face outlines
-        for (size_t i = 0; i < quadVertices.size(); i++) {
-            size_t j = (i + 1) % quadVertices.size();
-            frameImage.drawLine(
-                static_cast<int>(quadVertices[i].x), static_cast<int>(quadVertices[i].y),
-                static_cast<int>(quadVertices[j].x), static_cast<int>(quadVertices[j].y),
-                Color(255, 255, 255) // White outlines
-            );
+    // Set up transformation matrices
+    Mat4x4 translateZ;
+    translateZ.m[2][3] = 10.0;
+    Mat4x4 modelView = translateZ * rotation;
+
+    beginFrame();
+    const ClipVolume clipVolume(sampleCamera.getScale(), sampleCamera.getCenterX(), sampleCamera.getCenterY(),
+        sampleWidth, sampleHeight, NEAR_PLANE, GUARD_BAND * std::max(sampleWidth, sampleHeight));
+    const ClipVolume frustum(sampleCamera.getScale(), sampleCamera.getCenterX(), sampleCamera.getCenterY(),
+        sampleWidth, sampleHeight, NEAR_PLANE, 0.0);
+
+    faceDraws.clear();
+    faceDraws.reserve(cube.faces.size());
+    faceKeys.clear();
+    faceKeys.reserve(cube.faces.size());
+    if (frustum.excludesSphere(modelView.transform(Vec3(0, 0, 0)), cube.boundingRadius)) {
+        stats.culledInstances++;
+    }
+    else {
+        stats.drawnInstances++;
+        int decalFace = (decalTexture && decalFaceIndex < static_cast<int>(cube.faces.size())) ? decalFaceIndex : -1;
+        prepareInstance(cube, modelView, decalFace, faceColors, decalTexture, clipVolume);
+    }
+
+    sortFaces();
+    drawFrame(target);
+}
+
+void Renderer::renderFrame(Image& target, const Scene& scene, const Mat4x4& view, const Texture* decalTexture) {
+    beginFrame();
+    const ClipVolume clipVolume(sampleCamera.getScale(), sampleCamera.getCenterX(), sampleCamera.getCenterY(),
+        sampleWidth, sampleHeight, NEAR_PLANE, GUARD_BAND * std::max(sampleWidth, sampleHeight));
+    const ClipVolume frustum(sampleCamera.getScale(), sampleCamera.getCenterX(), sampleCamera.getCenterY(),
+        sampleWidth, sampleHeight, NEAR_PLANE, 0.0);
+
+    faceDraws.clear();
+    faceKeys.clear();
+    const size_t instances = scene.size();
+    for (size_t i = 0; i < instances; i++) {
+        // Cull on the instance origin alone before building its model-view matrix
+        const Mat4x4& model = scene.transforms[i];
+        Vec3 origin(model.m[0][3], model.m[1][3], model.m[2][3]);
+        if (frustum.excludesSphere(view.transform(origin), scene.boundingRadii[i])) {
+            stats.culledInstances++;
+            continue;
         }
+
+        stats.drawnInstances++;
+        prepareInstance(scene.mesh, view * model, scene.decalFaces[i], scene.faceColors[i], decalTexture, clipVolume);
+    }
+
+    sortFaces();
+    drawFrame(target);
+}
+
+void Renderer::renderFrame(Image& target, const Mesh& mesh, const Mat4x4& rotation, int decalMaterial,
+    const Texture* decalTexture) {
+    Mat4x4 translateZ;
+    translateZ.m[2][3] = 10.0;
+    Mat4x4 modelView = translateZ * rotation;
+
+    beginFrame();
+    const ClipVolume clipVolume(sampleCamera.getScale(), sampleCamera.getCenterX(), sampleCamera.getCenterY(),
+        sampleWidth, sampleHeight, NEAR_PLANE, GUARD_BAND * std::max(sampleWidth, sampleHeight));
+    const ClipVolume frustum(sampleCamera.getScale(), sampleCamera.getCenterX(), sampleCamera.getCenterY(),
+        sampleWidth, sampleHeight, NEAR_PLANE, 0.0);
+
+    const size_t reserved = std::min(mesh.triangleCount(), MAX_RESERVED_MESH_FACES);
+    faceDraws.clear();
+    faceDraws.reserve(reserved);
+    faceKeys.clear();
+    faceKeys.reserve(reserved);
+    if (frustum.excludesSphere(modelView.transform(Vec3(0, 0, 0)), mesh.boundingRadius)) {
+        stats.culledInstances++;
+    }
+    else {
+        stats.drawnInstances++;
+        prepareMesh(mesh, modelView, decalMaterial, decalTexture, clipVolume);
     }
 
+    sortFaces();
+    drawFrame(target);
+}
+
+Image Renderer::renderFrame(
+    const Cube& cube,
+    double angle,
+    const Texture* decalTexture,
+    const Mat4x4* rotationMatrix
+) {
+    Image frameImage(width, height, backgroundColor);
+    renderFrame(frameImage, cube, angle, decalTexture, rotationMatrix);
     return frameImage;
 }
 
@@ -377,6 +1295,116 @@ int Renderer::getDecalFaceIndex() const {
     return decalFaceIndex;
 }
 
+void Renderer::setDepthBuffer(int bits) {
+    if (bits == 0 || bits == 16 || bits == 32) {
+        depthBits = bits;
+    }
+    else {
+        LOG_ERROR << "Unsupported depth buffer precision: " << bits << " bits";
+        depthBits = 0;
+    }
+}
+
+int Renderer::getDepthBits() const {
+    return depthBits;
+}
+
+void Renderer::setVisibilityBuffer(bool enabled) {
+    visibilityBuffer = enabled;
+}
+
+bool Renderer::getVisibilityBuffer() const {
+    return visibilityBuffer;
+}
+
+void Renderer::setAntialiasing(Antialiasing mode) {
+    antialiasing = mode;
+}
+
+Antialiasing Renderer::getAntialiasing() const {
+    return antialiasing;
+}
+
+int Renderer::depthTestBits() const {
+    if (depthBits == 0 && deferredShading()) {
+        return 32;
+    }
+    return depthBits;
+}
+
+bool Renderer::deferredShading() const {
+    return visibilityBuffer || antialiasing == Antialiasing::MSAA4x;
+}
+
+bool Renderer::supersampled() const {
+    return antialiasing == Antialiasing::SSAA2x2 || antialiasing == Antialiasing::SSAA4x4;
+}
+
+void Renderer::beginFrame() {
+    // Sample k of pixel p sits at p + (k - (scale - 1) / 2) / scale, so the samples
+    // of a pixel are centered on the point an unsampled frame would use
+    const int scale = antialiasingSampleScale(antialiasing);
+    const double offset = (scale - 1) / 2.0;
+    sampleWidth = width * scale;
+    sampleHeight = height * scale;
+    sampleCamera = ViewCamera(camera.getScale() * scale, camera.getCenterX() * scale + offset,
+        camera.getCenterY() * scale + offset);
+}
+
+void Renderer::setTiling(int size, int threads) {
+    const int block = DepthBuffer<uint32_t>::BLOCK_SIZE;
+    tileSize = (std::max(0, size) + block - 1) / block * block;
+    tileThreads = threads;
+
+    // A single tile thread draws tiles on the calling thread
+    if (tileSize > 0 && threads != 1) {
+        tilePool = std::make_shared<ThreadPool>(threads);
+    }
+    else {
+        tilePool.reset();
+    }
+}
+
+int Renderer::getTileSize() const {
+    return tileSize;
+}
+
+int Renderer::getTileThreads() const {
+    return tileThreads;
+}
+
+void Renderer::setTextureWalk(TextureWalk walk) {
+    textureWalk = walk;
+}
+
+TextureWalk Renderer::getTextureWalk() const {
+    return textureWalk;
+}
+
+void Renderer::setTextureFilter(TextureFilter filter) {
+    textureFilter = filter;
+}
+
+TextureFilter Renderer::getTextureFilter() const {
+    return textureFilter;
+}
+
+void Renderer::setTexturePrecision(TexturePrecision precision) {
+    texturePrecision = precision;
+}
+
+TexturePrecision Renderer::getTexturePrecision() const {
+    return texturePrecision;
+}
+
+const RenderStats& Renderer::getStats() const {
+    return stats;
+}
+
+void Renderer::resetStats() {
+    stats = RenderStats();
+}
+
 ViewCamera& Renderer::getCamera() {
     return camera;
 }
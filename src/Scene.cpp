@@ -0,0 +1,40 @@
+#include "Scene.hpp"
+#include <algorithm>
+
+Scene::Scene(const Cube& mesh)
+    : mesh(mesh) {
+}
+
+void Scene::reserve(size_t count) {
+    transforms.reserve(count);
+    boundingRadii.reserve(count);
+    decalFaces.reserve(count);
+    faceColors.reserve(count);
+}
+
+size_t Scene::addInstance(const Mat4x4& transform, int decalFace, const std::array<Color, 6>& colors) {
+    transforms.push_back(transform);
+    boundingRadii.push_back(boundingRadius(transform));
+    decalFaces.push_back(decalFace);
+    faceColors.push_back(colors);
+    return transforms.size() - 1;
+}
+
+void Scene::setTransform(size_t index, const Mat4x4& transform) {
+    transforms[index] = transform;
+    boundingRadii[index] = boundingRadius(transform);
+}
+
+size_t Scene::size() const {
+    return transforms.size();
+}
+
+double Scene::boundingRadius(const Mat4x4& transform) const {
+    // The longest transformed basis vector bounds how far any point can move from the origin
+    double maxScale = 0.0;
+    for (int j = 0; j < 3; j++) {
+        Vec3 axis(transform.m[0][j], transform.m[1][j], transform.m[2][j]);
+        maxScale = std::max(maxScale, std::sqrt(axis.dot(axis)));
+    }
+    return mesh.boundingRadius * maxScale;
+}
@@ -0,0 +1,506 @@
+#include "Texture.hpp"
+#include "Logger.hpp"
+#include "MappedFile.hpp"
+#include "PagedTexture.hpp"
+#include "stb_image.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// Padded rows are rounded up to a whole number of 64-byte cache lines
+static const int ROW_ALIGNMENT = 16;
+
+// Raw textures start with this header, followed by one RawLevel per mip level
+static const char RAW_MAGIC[8] = { 'C', 'U', 'B', 'E', 'T', 'E', 'X', '\0' };
+static const uint32_t RAW_VERSION = 1;
+
+struct RawHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t width, height;
+    uint32_t layout;
+    uint32_t levelCount;
+    uint32_t reserved;
+};
+
+// Position of a level's padded texels, from the start of the raw texture
+struct RawLevel {
+    uint64_t offset;
+    uint64_t size;
+};
+
+// Offsets of raw levels are rounded up to cache lines
+static const size_t RAW_ALIGNMENT = 64;
+
+/**
+ * Allocated extent of a padded level
+ *
+ * @param level Level with its size and layout set; receives its stride
+ * @param lead Receives the number of allocated texels before texel 0 on each axis
+ * @param allocWidth Receives the allocated texels per row, padding included
+ * @param allocHeight Receives the allocated rows, padding included
+ */
+static void levelExtent(MipLevel& level, int& lead, int& allocWidth, int& allocHeight) {
+    const int levelWidth = level.width;
+    const int levelHeight = level.height;
+    if (level.tiled) {
+        // One whole block of padding before the texture keeps block offsets non-negative
+        lead = TEXTURE_TILE_SIZE;
+        allocWidth = ((levelWidth + Texture::PADDING + TEXTURE_TILE_SIZE - 1) / TEXTURE_TILE_SIZE + 1) * TEXTURE_TILE_SIZE;
+        allocHeight = ((levelHeight + Texture::PADDING + TEXTURE_TILE_SIZE - 1) / TEXTURE_TILE_SIZE + 1) * TEXTURE_TILE_SIZE;
+        level.stride = allocWidth * TEXTURE_TILE_SIZE;
+    }
+    else {
+        lead = Texture::PADDING;
+        allocWidth = (levelWidth + 2 * Texture::PADDING + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+        allocHeight = levelHeight + 2 * Texture::PADDING;
+        level.stride = allocWidth;
+    }
+}
+
+// Bytes to allocate for a level, with room to start it on a cache line
+static size_t allocationSize(int allocWidth, int allocHeight) {
+    return (static_cast<size_t>(allocWidth) * allocHeight + ROW_ALIGNMENT - 1) * sizeof(uint32_t);
+}
+
+/**
+ * Place a level in its allocation, the first padded row on a cache line
+ *
+ * @param level Level with its extent set; receives its texel pointer
+ * @param lead Allocated texels before texel 0 on each axis
+ * @param block Allocation of allocationSize() bytes
+ * @return Pointer to texel (0, 0)
+ */
+static uint32_t* levelOrigin(MipLevel& level, int lead, uint32_t* block) {
+    const size_t misalignment = reinterpret_cast<uintptr_t>(block) / sizeof(uint32_t) % ROW_ALIGNMENT;
+    uint32_t* first = block + (ROW_ALIGNMENT - misalignment) % ROW_ALIGNMENT;
+    uint32_t* origin = first - Texture::texelOffset(level, -lead, -lead);
+    level.texels = origin;
+    return origin;
+}
+
+/**
+ * Replicate the edges of a filled linear level into its padding
+ *
+ * @param origin Texel (0, 0) of the level
+ * @param level Level view
+ * @param allocWidth Allocated texels per row, padding included
+ */
+static void padLinearLevel(uint32_t* origin, const MipLevel& level, int allocWidth) {
+    for (int y = 0; y < level.height; y++) {
+        uint32_t* row = origin + static_cast<ptrdiff_t>(y) * level.stride;
+        std::fill(row - Texture::PADDING, row, row[0]);
+        std::fill(row + level.width, row - Texture::PADDING + allocWidth, row[level.width - 1]);
+    }
+    for (int p = 1; p <= Texture::PADDING; p++) {
+        std::memcpy(origin - static_cast<ptrdiff_t>(p) * level.stride - Texture::PADDING, origin - Texture::PADDING,
+            static_cast<size_t>(allocWidth) * sizeof(uint32_t));
+        std::memcpy(origin + static_cast<ptrdiff_t>(level.height - 1 + p) * level.stride - Texture::PADDING,
+            origin + static_cast<ptrdiff_t>(level.height - 1) * level.stride - Texture::PADDING,
+            static_cast<size_t>(allocWidth) * sizeof(uint32_t));
+    }
+}
+
+Texture::Texture() : Texture(Image()) {
+}
+
+Texture::Texture(const Image& image, TextureLayout layout)
+    : width(image.getWidth()), height(image.getHeight()), layout(layout) {
+    std::vector<uint32_t> rgba(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; y++) {
+        const Color* row = image.rowData(y);
+        uint32_t* out = rgba.data() + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; x++) {
+            out[x] = pack(row[x]);
+        }
+    }
+    addLevel(rgba.data(), width, height);
+    buildMipChain(rgba.data(), width);
+}
+
+Texture::Texture(const uint32_t* rgba, int width, int height, TextureLayout layout)
+    : width(width), height(height), layout(layout) {
+    addLevel(rgba, width, height);
+    buildMipChain(rgba, width);
+}
+
+Texture::Texture(int width, int height, TextureLayout layout)
+    : width(width), height(height), stride(0), layout(layout) {
+}
+
+Texture Texture::paged(const std::shared_ptr<PagedTexture>& pages) {
+    Texture texture(pages->getWidth(), pages->getHeight(), TextureLayout::Linear);
+    for (int i = 0; i < pages->getLevelCount(); i++) {
+        MipLevel level;
+        level.texels = nullptr;
+        level.stride = 0;
+        level.width = pages->getLevel(i).width;
+        level.height = pages->getLevel(i).height;
+        level.tiled = false;
+        texture.levels.push_back(level);
+    }
+    texture.pages = pages;
+    return texture;
+}
+
+Texture Texture::adopt(uint32_t* rgba, int width, int height, TextureLayout layout) {
+    if (layout != TextureLayout::Linear) {
+        Texture texture(rgba, width, height, layout);
+        std::free(rgba);
+        return texture;
+    }
+
+    Texture texture(width, height, layout);
+    texture.adoptLevel(rgba);
+    texture.buildMipChain(texture.levels[0].texels, texture.levels[0].stride);
+    return texture;
+}
+
+void Texture::buildMipChain(const uint32_t* rows, int rowStride) {
+    stride = levels[0].stride;
+
+    // Each further level averages 2x2 blocks of the previous one; odd edges reuse
+    // their last row or column. Linear levels are reduced straight into their
+    // padded rows, tiled levels through packed rows.
+    const uint32_t* source = rows;
+    int sourceStride = rowStride;
+    int sourceWidth = width;
+    int sourceHeight = height;
+    std::vector<uint32_t> reduced[2];
+    for (int next = 0; sourceWidth > 1 || sourceHeight > 1; next ^= 1) {
+        MipLevel level;
+        level.width = std::max(sourceWidth / 2, 1);
+        level.height = std::max(sourceHeight / 2, 1);
+        int lead, allocWidth, allocHeight;
+        uint32_t* out;
+        int outStride;
+        if (layout == TextureLayout::Linear) {
+            out = allocateLevel(level, lead, allocWidth, allocHeight);
+            outStride = level.stride;
+        }
+        else {
+            reduced[next].resize(static_cast<size_t>(level.width) * level.height);
+            out = reduced[next].data();
+            outStride = level.width;
+        }
+
+        for (int y = 0; y < level.height; y++) {
+            const uint32_t* row0 = source + static_cast<ptrdiff_t>(std::min(2 * y, sourceHeight - 1)) * sourceStride;
+            const uint32_t* row1 = source + static_cast<ptrdiff_t>(std::min(2 * y + 1, sourceHeight - 1)) * sourceStride;
+            uint32_t* outRow = out + static_cast<ptrdiff_t>(y) * outStride;
+            for (int x = 0; x < level.width; x++) {
+                const int x0 = std::min(2 * x, sourceWidth - 1);
+                const int x1 = std::min(2 * x + 1, sourceWidth - 1);
+                outRow[x] = average4(row0[x0], row0[x1], row1[x0], row1[x1]);
+            }
+        }
+
+        if (layout == TextureLayout::Linear) {
+            padLinearLevel(out, level, allocWidth);
+            levels.push_back(level);
+        }
+        else {
+            addLevel(out, level.width, level.height);
+        }
+        source = out;
+        sourceStride = outStride;
+        sourceWidth = level.width;
+        sourceHeight = level.height;
+    }
+}
+
+uint32_t Texture::average4(uint32_t t00, uint32_t t10, uint32_t t01, uint32_t t11) {
+    // Rounded mean of each channel, two channels per 16-bit lane at a time
+    const uint32_t mask = 0x00FF00FFu;
+    const uint32_t even = (t00 & mask) + (t10 & mask) + (t01 & mask) + (t11 & mask) + 0x00020002u;
+    const uint32_t odd = ((t00 >> 8) & mask) + ((t10 >> 8) & mask) + ((t01 >> 8) & mask) + ((t11 >> 8) & mask) + 0x00020002u;
+    return ((even >> 2) & mask) | (((odd >> 2) & mask) << 8);
+}
+
+uint32_t* Texture::allocateLevel(MipLevel& level, int& lead, int& allocWidth, int& allocHeight) {
+    level.tiled = (layout == TextureLayout::Tiled);
+    levelExtent(level, lead, allocWidth, allocHeight);
+
+    // Over-allocate so the first padded row, and with it every row and block, starts
+    // on a cache line; the fill writes every texel, so nothing is zeroed first
+    uint32_t* block = static_cast<uint32_t*>(std::malloc(allocationSize(allocWidth, allocHeight)));
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    storage.emplace_back(block);
+    return levelOrigin(level, lead, block);
+}
+
+void Texture::adoptLevel(uint32_t* rgba) {
+    MipLevel level;
+    level.width = width;
+    level.height = height;
+    level.tiled = false;
+    int lead, allocWidth, allocHeight;
+    levelExtent(level, lead, allocWidth, allocHeight);
+
+    // Grow the decoded buffer to the padded size; large blocks are remapped rather than copied
+    uint32_t* block = static_cast<uint32_t*>(std::realloc(rgba, allocationSize(allocWidth, allocHeight)));
+    if (!block) {
+        std::free(rgba);
+        throw std::bad_alloc();
+    }
+    storage.emplace_back(block);
+    uint32_t* origin = levelOrigin(level, lead, block);
+
+    // Every padded row starts past the end of its packed row, so moving rows from
+    // the last one up never overwrites a row still to be moved
+    for (int y = height - 1; y >= 0; y--) {
+        std::memmove(origin + static_cast<ptrdiff_t>(y) * level.stride, block + static_cast<size_t>(y) * width,
+            static_cast<size_t>(width) * sizeof(uint32_t));
+    }
+    padLinearLevel(origin, level, allocWidth);
+    levels.push_back(level);
+}
+
+void Texture::addLevel(const uint32_t* rgba, int levelWidth, int levelHeight) {
+    MipLevel level;
+    level.width = levelWidth;
+    level.height = levelHeight;
+    int lead, allocWidth, allocHeight;
+    uint32_t* origin = allocateLevel(level, lead, allocWidth, allocHeight);
+
+    // Each padded row is the source row copied whole with its end texels repeated
+    // into the padding. Linear rows are assembled in place; tiled rows are
+    // assembled once and scattered a block row (TEXTURE_TILE_SIZE texels) at a time.
+    std::vector<uint32_t> scratch(level.tiled ? allocWidth : 0);
+    for (int y = -lead; y < allocHeight - lead; y++) {
+        const uint32_t* source = rgba + static_cast<size_t>(std::min(std::max(y, 0), levelHeight - 1)) * levelWidth;
+        uint32_t* row = level.tiled ? scratch.data() : origin + texelOffset(level, -lead, y);
+        std::fill(row, row + lead, source[0]);
+        std::memcpy(row + lead, source, static_cast<size_t>(levelWidth) * sizeof(uint32_t));
+        std::fill(row + lead + levelWidth, row + allocWidth, source[levelWidth - 1]);
+
+        if (level.tiled) {
+            for (int x = -lead; x < allocWidth - lead; x += TEXTURE_TILE_SIZE) {
+                std::memcpy(origin + texelOffset(level, x, y), row + lead + x, TEXTURE_TILE_SIZE * sizeof(uint32_t));
+            }
+        }
+    }
+
+    // Growing storage moves the level buffers without reallocating them, so views stay valid
+    levels.push_back(level);
+}
+
+int Texture::getWidth() const { return width; }
+int Texture::getHeight() const { return height; }
+int Texture::getStride() const { return stride; }
+TextureLayout Texture::getLayout() const { return layout; }
+
+const uint32_t* Texture::texelData() const {
+    return levels[0].texels;
+}
+
+PagedTexture* Texture::getPages() const {
+    return pages.get();
+}
+
+void Texture::buildSummedAreaTable() {
+    if (pages) {
+        return;
+    }
+
+    // Entry (x + 1, y + 1) adds the running sum of row y up to x to the entry above.
+    // Unsigned sums wrap; box differences of at most 2^32 / 255 texels are still exact.
+    const size_t stride = static_cast<size_t>(width) + 1;
+    summedArea.assign(3 * stride * (static_cast<size_t>(height) + 1), 0);
+    const MipLevel& base = levels[0];
+    for (int y = 0; y < height; y++) {
+        const uint32_t* above = summedArea.data() + 3 * (y * stride);
+        uint32_t* out = summedArea.data() + 3 * ((y + 1) * stride);
+        uint32_t row[3] = { 0, 0, 0 };
+        for (int x = 0; x < width; x++) {
+            const uint32_t texel = base.texels[texelOffset(base, x, y)];
+            for (int c = 0; c < 3; c++) {
+                row[c] += (texel >> (8 * c)) & 0xFF;
+                out[3 * (x + 1) + c] = above[3 * (x + 1) + c] + row[c];
+            }
+        }
+    }
+}
+
+const uint32_t* Texture::summedAreaData() const {
+    return summedArea.empty() ? nullptr : summedArea.data();
+}
+
+int Texture::getLevelCount() const {
+    return static_cast<int>(levels.size());
+}
+
+const MipLevel& Texture::getLevel(int level) const {
+    return levels[level];
+}
+
+const MipLevel* Texture::levelData() const {
+    return levels.data();
+}
+
+Color Texture::getPixel(int x, int y) const {
+    if (x >= 0 && x < width && y >= 0 && y < height) {
+        if (pages) {
+            return unpack(pages->texel(0, x, y));
+        }
+        return unpack(texelData()[texelOffset(levels[0], x, y)]);
+    }
+    return Color(); // Default black
+}
+
+uint32_t Texture::pack(const Color& color) {
+    return static_cast<uint32_t>(color.r) |
+        (static_cast<uint32_t>(color.g) << 8) |
+        (static_cast<uint32_t>(color.b) << 16) |
+        0xFF000000u;
+}
+
+Color Texture::unpack(uint32_t texel) {
+    return Color(texel & 0xFF, (texel >> 8) & 0xFF, (texel >> 16) & 0xFF);
+}
+
+/**
+ * Padded texels of a level as one contiguous block
+ *
+ * @param level Level with its size and layout set; receives its stride
+ * @param lead Receives the number of allocated texels before texel 0 on each axis
+ * @return Block size in bytes
+ */
+static size_t levelBlockSize(MipLevel& level, int& lead) {
+    int allocWidth, allocHeight;
+    levelExtent(level, lead, allocWidth, allocHeight);
+    return static_cast<size_t>(allocWidth) * allocHeight * sizeof(uint32_t);
+}
+
+// Bytes before the first raw level: the header and the level table
+static size_t rawLevelsOffset(size_t levelCount) {
+    const size_t tableEnd = sizeof(RawHeader) + levelCount * sizeof(RawLevel);
+    return (tableEnd + RAW_ALIGNMENT - 1) / RAW_ALIGNMENT * RAW_ALIGNMENT;
+}
+
+size_t Texture::rawSize() const {
+    size_t size = rawLevelsOffset(levels.size());
+    for (MipLevel level : levels) {
+        int lead;
+        size += levelBlockSize(level, lead);
+    }
+    return size;
+}
+
+void Texture::writeRaw(char* out) const {
+    RawHeader header;
+    std::memcpy(header.magic, RAW_MAGIC, sizeof(header.magic));
+    header.version = RAW_VERSION;
+    header.width = static_cast<uint32_t>(width);
+    header.height = static_cast<uint32_t>(height);
+    header.layout = static_cast<uint32_t>(layout);
+    header.levelCount = static_cast<uint32_t>(levels.size());
+    header.reserved = 0;
+    std::memcpy(out, &header, sizeof(header));
+
+    // Block sizes are whole cache lines, so every level stays aligned
+    size_t offset = rawLevelsOffset(levels.size());
+    for (size_t l = 0; l < levels.size(); l++) {
+        MipLevel level = levels[l];
+        int lead;
+        RawLevel entry;
+        entry.offset = offset;
+        entry.size = levelBlockSize(level, lead);
+        std::memcpy(out + sizeof(header) + l * sizeof(RawLevel), &entry, sizeof(entry));
+
+        const uint32_t* first = level.texels + texelOffset(level, -lead, -lead);
+        std::memcpy(out + offset, first, entry.size);
+        offset += entry.size;
+    }
+}
+
+bool Texture::fromRaw(const std::shared_ptr<MappedFile>& file, Texture& texture) {
+    const char* data = file->data();
+    const size_t length = file->size();
+    RawHeader header;
+    if (length < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, RAW_MAGIC, sizeof(header.magic)) != 0 || header.version != RAW_VERSION ||
+        header.width == 0 || header.height == 0 || header.width > 0x7FFFFFFF || header.height > 0x7FFFFFFF ||
+        header.layout > static_cast<uint32_t>(TextureLayout::Tiled) || header.levelCount > 64 ||
+        length < rawLevelsOffset(header.levelCount)) {
+        return false;
+    }
+
+    // Levels must form the full chain down to 1x1, each block where the table
+    // says and exactly as large as the layout makes it
+    Texture raw(static_cast<int>(header.width), static_cast<int>(header.height), static_cast<TextureLayout>(header.layout));
+    MipLevel level;
+    level.width = raw.width;
+    level.height = raw.height;
+    level.tiled = (raw.layout == TextureLayout::Tiled);
+    for (uint32_t l = 0; l < header.levelCount; l++) {
+        RawLevel entry;
+        std::memcpy(&entry, data + sizeof(header) + l * sizeof(RawLevel), sizeof(entry));
+        int lead;
+        if (entry.size != levelBlockSize(level, lead) || entry.offset % RAW_ALIGNMENT != 0 ||
+            entry.offset > length || entry.size > length - entry.offset) {
+            return false;
+        }
+        const uint32_t* first = reinterpret_cast<const uint32_t*>(data + entry.offset);
+        level.texels = first - texelOffset(level, -lead, -lead);
+        raw.levels.push_back(level);
+
+        const bool last = (level.width == 1 && level.height == 1);
+        if (last != (l + 1 == header.levelCount)) {
+            return false;
+        }
+        level.width = std::max(level.width / 2, 1);
+        level.height = std::max(level.height / 2, 1);
+    }
+    if (raw.levels.empty()) {
+        return false;
+    }
+
+    raw.stride = raw.levels[0].stride;
+    raw.mapping = file;
+    texture = std::move(raw);
+    return true;
+}
+
+bool parseTextureLayout(const std::string& name, TextureLayout& layout) {
+    if (name == "linear") {
+        layout = TextureLayout::Linear;
+    }
+    else if (name == "tiled") {
+        layout = TextureLayout::Tiled;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+const char* textureLayoutName(TextureLayout layout) {
+    switch (layout) {
+    case TextureLayout::Linear: return "linear";
+    case TextureLayout::Tiled:  return "tiled";
+    default:                    return "unknown";
+    }
+}
+
+Texture loadTexture(const std::string& filename, TextureLayout layout) {
+    // Four channels whatever the file holds: stb then writes R, G, B, A bytes,
+    // which on little-endian hosts are exactly the 0xAABBGGRR texels
+    int width, height, channels;
+    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &channels, 4);
+    if (!data) {
+        LOG_ERROR << "Failed to load image: " << filename;
+        LOG_ERROR << "STB Error: " << stbi_failure_reason();
+        return Texture(); // Return a 1x1 black texture
+    }
+
+    // stb allocates with malloc, so the texture can take the buffer over
+    return Texture::adopt(reinterpret_cast<uint32_t*>(data), width, height, layout);
+}
\ No newline at end of file
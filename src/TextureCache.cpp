@@ -0,0 +1,373 @@
+#include "TextureCache.hpp"
+#include "Logger.hpp"
+#include "MappedFile.hpp"
+#include "PagedTexture.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+// Entries end in one of these suffixes; nothing else in the directory is ever deleted
+static const char ENTRY_SUFFIX[] = ".tex";
+static const char PAGES_SUFFIX[] = ".pages";
+
+/**
+ * Size and modification time of a file
+ */
+struct FileInfo {
+    std::string name;
+    uint64_t size = 0;
+    int64_t modified = 0;  // Platform ticks, only compared with each other
+};
+
+/**
+ * Look up a file's size and modification time
+ *
+ * @param path File path
+ * @param info Receives the size and time
+ * @return false if the file does not exist
+ */
+static bool statFile(const std::string& path, FileInfo& info) {
+#if defined(_WIN32)
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data)) {
+        return false;
+    }
+    info.size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    info.modified = static_cast<int64_t>((static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) |
+        data.ftLastWriteTime.dwLowDateTime);
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    info.size = static_cast<uint64_t>(st.st_size);
+    info.modified = static_cast<int64_t>(st.st_mtime);
+#endif
+    return true;
+}
+
+/**
+ * Create a directory and any missing parents
+ *
+ * @param path Directory path
+ * @return true if the directory exists afterwards
+ */
+static bool makeDirectories(const std::string& path) {
+    for (size_t end = 0; end != std::string::npos; ) {
+        end = path.find_first_of("/\\", end + 1);
+        const std::string prefix = path.substr(0, end);
+#if defined(_WIN32)
+        CreateDirectoryA(prefix.c_str(), nullptr);
+#else
+        mkdir(prefix.c_str(), 0755);
+#endif
+    }
+#if defined(_WIN32)
+    DWORD attributes = GetFileAttributesA(path.c_str());
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+#endif
+}
+
+/**
+ * List the cache entries in a directory
+ *
+ * @param directory Directory to list
+ * @return Name, size and modification time of every entry
+ */
+static std::vector<FileInfo> listEntries(const std::string& directory) {
+    std::vector<FileInfo> entries;
+    std::vector<std::string> names;
+#if defined(_WIN32)
+    WIN32_FIND_DATAA found;
+    HANDLE search = FindFirstFileA((directory + "\\*").c_str(), &found);
+    if (search != INVALID_HANDLE_VALUE) {
+        do {
+            names.push_back(found.cFileName);
+        } while (FindNextFileA(search, &found));
+        FindClose(search);
+    }
+#else
+    if (DIR* dir = opendir(directory.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            names.push_back(entry->d_name);
+        }
+        closedir(dir);
+    }
+#endif
+
+    auto endsWith = [](const std::string& name, const char* suffix) {
+        const size_t length = std::strlen(suffix);
+        return name.size() > length && name.compare(name.size() - length, length, suffix) == 0;
+    };
+    for (const std::string& name : names) {
+        FileInfo info;
+        if ((endsWith(name, ENTRY_SUFFIX) || endsWith(name, PAGES_SUFFIX)) && statFile(directory + "/" + name, info)) {
+            info.name = name;
+            entries.push_back(info);
+        }
+    }
+    return entries;
+}
+
+/**
+ * Mark a file as just used by setting its modification time to now
+ *
+ * @param path File path
+ */
+static void touchFile(const std::string& path) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file != INVALID_HANDLE_VALUE) {
+        FILETIME now;
+        GetSystemTimeAsFileTime(&now);
+        SetFileTime(file, nullptr, nullptr, &now);
+        CloseHandle(file);
+    }
+#else
+    utimes(path.c_str(), nullptr);
+#endif
+}
+
+// Identifies this process in temporary file names
+static unsigned long processId() {
+#if defined(_WIN32)
+    return GetCurrentProcessId();
+#else
+    return static_cast<unsigned long>(getpid());
+#endif
+}
+
+static const uint64_t HASH_PRIME = 0x9E3779B97F4A7C15ULL;
+
+/**
+ * Add bytes to a 64-bit hash, a word at a time
+ *
+ * @param hash Hash so far
+ * @param data Bytes to hash; only the last call may pass a size that is not a multiple of 8
+ * @param size Number of bytes
+ * @return Updated hash
+ */
+static uint64_t hashBytes(uint64_t hash, const char* data, size_t size) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * HASH_PRIME;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * HASH_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * Name an entry after its source: content hash, size and modification time
+ *
+ * The file is read in chunks rather than mapped, so hashing a source far larger
+ * than memory does not make it resident.
+ *
+ * @param filename Source file
+ * @param suffix Appended to the name
+ * @param key Receives the entry name
+ * @return false if the source cannot be read
+ */
+static bool entryName(const std::string& filename, const std::string& suffix, std::string& key) {
+    FileInfo source;
+    std::ifstream in(filename, std::ios::binary);
+    if (!statFile(filename, source) || !in) {
+        return false;
+    }
+    uint64_t hash = source.size * HASH_PRIME;
+    std::vector<char> chunk(1 << 20);
+    while (in) {
+        in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        hash = hashBytes(hash, chunk.data(), static_cast<size_t>(in.gcount()));
+    }
+    char name[64];
+    std::snprintf(name, sizeof(name), "%016llx-%llx-%llx",
+        static_cast<unsigned long long>(hash ^ (hash >> 32)),
+        static_cast<unsigned long long>(source.size), static_cast<unsigned long long>(source.modified));
+    key = name + suffix;
+    return true;
+}
+
+TextureCache::TextureCache(const std::string& directory, uint64_t limitBytes)
+    : directory(directory), limitBytes(limitBytes) {
+}
+
+Texture TextureCache::load(const std::string& filename, TextureLayout layout) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::string key;
+    if (!entryName(filename, std::string("-") + textureLayoutName(layout) + ENTRY_SUFFIX, key)) {
+        return loadTexture(filename, layout);
+    }
+    const std::string path = directory + "/" + key;
+
+    std::shared_ptr<MappedFile> entry = std::make_shared<MappedFile>();
+    FileInfo cached;
+    if (statFile(path, cached)) {
+        Texture texture;
+        if (entry->open(path, MappedFile::Access::Resident) && Texture::fromRaw(entry, texture)) {
+            touchFile(path);
+            auto end = std::chrono::steady_clock::now();
+            LOG_INFO << "Texture cache hit: " << path << " mapped in "
+                << std::chrono::duration<double, std::milli>(end - start).count() << " ms";
+            return texture;
+        }
+        LOG_WARNING << "Discarding unreadable texture cache entry " << path;
+        entry->close();
+        std::remove(path.c_str());
+    }
+
+    Texture texture = loadTexture(filename, layout);
+    if (texture.getWidth() > 1 || texture.getHeight() > 1) {
+        store(path, texture);
+    }
+    return texture;
+}
+
+Texture TextureCache::loadPaged(const std::string& filename, uint64_t budgetBytes) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::string key;
+    if (!entryName(filename, PAGES_SUFFIX, key)) {
+        return loadTexture(filename);
+    }
+    const std::string path = directory + "/" + key;
+
+    std::shared_ptr<PagedTexture> pages = std::make_shared<PagedTexture>();
+    FileInfo cached;
+    if (statFile(path, cached)) {
+        if (pages->open(path, budgetBytes)) {
+            touchFile(path);
+            auto end = std::chrono::steady_clock::now();
+            LOG_INFO << "Texture cache hit: " << path << " opened in "
+                << std::chrono::duration<double, std::milli>(end - start).count() << " ms";
+            return Texture::paged(pages);
+        }
+        LOG_WARNING << "Discarding unreadable texture cache entry " << path;
+        std::remove(path.c_str());
+    }
+
+    if (!makeDirectories(directory)) {
+        LOG_WARNING << "Could not create texture cache directory " << directory << ", loading the texture whole";
+        return loadTexture(filename);
+    }
+    const std::string temporary = path + "." + std::to_string(processId()) + ".tmp";
+    if (!PagedTexture::convert(filename, temporary)) {
+        std::remove(temporary.c_str());
+        return loadTexture(filename);
+    }
+
+    // The page file is needed for sampling, so it is kept even when it alone exceeds the limit
+    FileInfo converted;
+    statFile(temporary, converted);
+    if (converted.size > limitBytes) {
+        LOG_WARNING << "Page file of " << converted.size / (1024 * 1024)
+            << " MB exceeds the texture cache limit and will be evicted by the next entry";
+    }
+    evict(converted.size);
+#if defined(_WIN32)
+    std::remove(path.c_str());
+#endif
+    if (std::rename(temporary.c_str(), path.c_str()) != 0 || !pages->open(path, budgetBytes)) {
+        LOG_WARNING << "Could not add texture cache entry " << path << ", loading the texture whole";
+        std::remove(temporary.c_str());
+        return loadTexture(filename);
+    }
+    auto end = std::chrono::steady_clock::now();
+    LOG_INFO << "Texture cache: converted " << filename << " to " << path << " (" << converted.size / 1024
+        << " KB) in " << std::chrono::duration<double, std::milli>(end - start).count() << " ms";
+    return Texture::paged(pages);
+}
+
+bool TextureCache::store(const std::string& path, const Texture& texture) const {
+    const uint64_t size = texture.rawSize();
+    if (size > limitBytes) {
+        LOG_WARNING << "Texture of " << size / (1024 * 1024) << " MB exceeds the texture cache limit, not cached";
+        return false;
+    }
+    if (!makeDirectories(directory)) {
+        LOG_WARNING << "Could not create texture cache directory " << directory;
+        return false;
+    }
+    evict(size);
+
+    // Written under a private name and renamed into place, so a concurrent run
+    // never maps a partial entry
+    const std::string temporary = path + "." + std::to_string(processId()) + ".tmp";
+    MappedFile file;
+    if (!file.create(temporary, static_cast<size_t>(size))) {
+        return false;
+    }
+    texture.writeRaw(file.writableData());
+    file.close();
+
+#if defined(_WIN32)
+    std::remove(path.c_str());
+#endif
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        LOG_WARNING << "Could not add texture cache entry " << path;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    LOG_INFO << "Texture cache: stored " << path << " (" << size / 1024 << " KB)";
+    return true;
+}
+
+std::string TextureCache::entryPath(const std::string& name) const {
+    if (!makeDirectories(directory)) {
+        LOG_WARNING << "Could not create texture cache directory " << directory;
+        return std::string();
+    }
+    return directory + "/" + name;
+}
+
+void TextureCache::clear() const {
+    for (const FileInfo& entry : listEntries(directory)) {
+        std::remove((directory + "/" + entry.name).c_str());
+    }
+}
+
+void TextureCache::evict(uint64_t incoming) const {
+    std::vector<FileInfo> entries = listEntries(directory);
+    uint64_t total = incoming;
+    for (const FileInfo& entry : entries) {
+        total += entry.size;
+    }
+
+    // Hits refresh an entry's modification time, so the oldest is least recently used
+    std::sort(entries.begin(), entries.end(), [](const FileInfo& a, const FileInfo& b) {
+        return a.modified < b.modified;
+    });
+    for (const FileInfo& entry : entries) {
+        if (total <= limitBytes) {
+            break;
+        }
+        if (std::remove((directory + "/" + entry.name).c_str()) == 0) {
+            LOG_INFO << "Texture cache: evicted " << entry.name;
+            total -= entry.size;
+        }
+    }
+}
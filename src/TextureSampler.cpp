@@ -0,0 +1,811 @@
+#include "TextureSampler.hpp"
+#include "PagedTexture.hpp"
+#include <cmath>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+// Destination pixels are written as packed RGB bytes
+static_assert(sizeof(Color) == 3, "Color must be three packed bytes");
+
+// Vector kernels use 32-bit 16.16 coordinates
+static const int MAX_VECTOR_TEXTURE_SIZE = 32767;
+
+// The fixed-point kernel divides exactly at the ends and middle of every 8
+// screen columns
+static const int FIXED_SEGMENT_SHIFT = 3;
+static const int FIXED_SEGMENT = 1 << FIXED_SEGMENT_SHIFT;
+
+// Largest coordinate error of stepping between those columns, in texels;
+// beyond it a segment divides at every pixel
+static const double FIXED_STEP_ERROR = 1.0 / 4096;
+
+// Stepped coordinates within this many 1/65536 texel steps of a texture edge are
+// recomputed exactly: over FIXED_STEP_ERROR plus the rounding of the exact ones
+static const int64_t FIXED_EDGE_MARGIN = 32;
+
+/**
+ * Blend of a 2x2 texel footprint in 16.16 fixed point
+ *
+ * @param t00 Top-left texel
+ * @param t10 Top-right texel
+ * @param t01 Bottom-left texel
+ * @param t11 Bottom-right texel
+ * @param fracX Horizontal weight of the right texels (0 to 65535)
+ * @param fracY Vertical weight of the bottom texels (0 to 65535)
+ * @return Packed color
+ */
+static inline uint32_t bilinearBlend(uint32_t t00, uint32_t t10, uint32_t t01, uint32_t t11,
+    uint32_t fracX, uint32_t fracY) {
+    // Blend each channel horizontally with 16-bit weights, keep 8 fractional
+    // bits, then blend vertically; every intermediate fits in 32 bits
+    uint32_t color = 0;
+    for (int shift = 0; shift < 24; shift += 8) {
+        uint32_t c00 = (t00 >> shift) & 0xFF;
+        uint32_t c10 = (t10 >> shift) & 0xFF;
+        uint32_t c01 = (t01 >> shift) & 0xFF;
+        uint32_t c11 = (t11 >> shift) & 0xFF;
+        uint32_t top = (c00 * (65536 - fracX) + c10 * fracX + 128) >> 8;
+        uint32_t bottom = (c01 * (65536 - fracX) + c11 * fracX + 128) >> 8;
+        uint32_t value = (top * (65536 - fracY) + bottom * fracY) >> 24;
+        color |= value << shift;
+    }
+    return color;
+}
+
+// The portable kernels are written once over a texel source: resident levels,
+// pinned pages of a paged texture, or a pass that only records which pages a
+// run of pixels will read.
+
+/**
+ * Texels of an edge-padded mip chain in memory
+ */
+struct ResidentTexels {
+    const MipLevel* levels;
+
+    void quad(int level, int x, int y, uint32_t& t00, uint32_t& t10, uint32_t& t01, uint32_t& t11) const {
+        const MipLevel& mip = levels[level];
+        if (mip.tiled) {
+            t00 = mip.texels[Texture::texelOffset(mip, x, y)];
+            t10 = mip.texels[Texture::texelOffset(mip, x + 1, y)];
+            t01 = mip.texels[Texture::texelOffset(mip, x, y + 1)];
+            t11 = mip.texels[Texture::texelOffset(mip, x + 1, y + 1)];
+        }
+        else {
+            const uint32_t* p = mip.texels + static_cast<ptrdiff_t>(y) * mip.stride + x;
+            t00 = p[0];
+            t10 = p[1];
+            t01 = p[mip.stride];
+            t11 = p[mip.stride + 1];
+        }
+    }
+
+    uint32_t texel(int level, int x, int y) const {
+        const MipLevel& mip = levels[level];
+        return mip.texels[Texture::texelOffset(mip, x, y)];
+    }
+};
+
+/**
+ * Texels of a paged texture whose pages are pinned
+ */
+struct PagedTexels {
+    const PagedTexture* pages;
+
+    void quad(int level, int x, int y, uint32_t& t00, uint32_t& t10, uint32_t& t01, uint32_t& t11) const {
+        // A footprint never straddles pages: each page repeats its neighbours' first row and column
+        const uint32_t* p = pages->texelAddress(level, x, y);
+        t00 = p[0];
+        t10 = p[1];
+        t01 = p[PagedTexture::PAGE_STRIDE];
+        t11 = p[PagedTexture::PAGE_STRIDE + 1];
+    }
+
+    uint32_t texel(int level, int x, int y) const {
+        return *pages->texelAddress(level, x, y);
+    }
+};
+
+/**
+ * Texels of a paged texture, each fetch pinning its page for the duration
+ *
+ * Slower than PagedTexels; used for pixels whose pages do not fit a PageCollector.
+ */
+struct PinningTexels {
+    PagedTexture* pages;
+
+    void quad(int level, int x, int y, uint32_t& t00, uint32_t& t10, uint32_t& t01, uint32_t& t11) const {
+        // A bilinear footprint lies inside one page
+        const uint32_t id = pages->pageId(level, x, y);
+        pages->pin(&id, 1);
+        const uint32_t* p = pages->texelAddress(level, x, y);
+        t00 = p[0];
+        t10 = p[1];
+        t01 = p[PagedTexture::PAGE_STRIDE];
+        t11 = p[PagedTexture::PAGE_STRIDE + 1];
+        pages->unpin(&id, 1);
+    }
+
+    uint32_t texel(int level, int x, int y) const {
+        return pages->texel(level, x, y);
+    }
+};
+
+/**
+ * Records the distinct pages that texel fetches would read, returning black
+ *
+ * Pages that do not fit are dropped and flagged in full.
+ */
+struct PageCollector {
+    static const int CAPACITY = 16;
+
+    const PagedTexture* pages;
+    uint32_t ids[CAPACITY];
+    int count;
+    bool full;
+
+    void add(uint32_t id) {
+        for (int i = 0; i < count; i++) {
+            if (ids[i] == id) {
+                return;
+            }
+        }
+        if (count == CAPACITY) {
+            full = true;
+            return;
+        }
+        ids[count++] = id;
+    }
+
+    void quad(int level, int x, int y, uint32_t& t00, uint32_t& t10, uint32_t& t01, uint32_t& t11) {
+        add(pages->pageId(level, x, y));
+        t00 = t10 = t01 = t11 = 0;
+    }
+
+    uint32_t texel(int level, int x, int y) {
+        add(pages->pageId(level, x, y));
+        return 0;
+    }
+};
+
+/**
+ * Bilinear sample of the 2x2 texels around (u, v) in 16.16 fixed point
+ *
+ * @param texels Texel source
+ * @param level Edge-padded level to sample
+ * @param u Horizontal texel coordinate (non-negative)
+ * @param v Vertical texel coordinate (non-negative)
+ * @return Packed color
+ */
+template <class Texels>
+static inline uint32_t bilinearTexel(Texels& texels, int level, double u, double v) {
+    // 16.16 fixed-point texel coordinates
+    int64_t ui = static_cast<int64_t>(u * 65536.0);
+    int64_t vi = static_cast<int64_t>(v * 65536.0);
+    uint32_t fracX = static_cast<uint32_t>(ui & 0xFFFF);
+    uint32_t fracY = static_cast<uint32_t>(vi & 0xFFFF);
+    int x = static_cast<int>(ui >> 16);
+    int y = static_cast<int>(vi >> 16);
+
+    uint32_t t00, t10, t01, t11;
+    texels.quad(level, x, y, t00, t10, t01, t11);
+    return bilinearBlend(t00, t10, t01, t11, fracX, fracY);
+}
+
+/**
+ * Texture coordinates of pixel i of a span
+ *
+ * @param span Span being sampled
+ * @param i Pixel index in the span
+ * @param u Receives the horizontal texel coordinate
+ * @param v Receives the vertical texel coordinate
+ * @return 1 / w, or 1 where w is too close to zero to divide by
+ */
+static inline double spanCoordinates(const TextureSpan& span, int i, double& u, double& v) {
+    double fx = static_cast<double>(span.x0 + i);
+    u = span.dUW * fx + span.rowUW;
+    v = span.dVW * fx + span.rowVW;
+    double w = span.dW * fx + span.rowW;
+    double invW = std::abs(w) > 1e-8 ? 1.0 / w : 1.0;
+    u *= invW;
+    v *= invW;
+    return invW;
+}
+
+template <class Texels>
+static inline uint32_t bilinearPixel(const TextureSpan& span, Texels& texels, int i) {
+    double u, v;
+    spanCoordinates(span, i, u, v);
+    if (u >= 0 && u < span.width && v >= 0 && v < span.height) {
+        return bilinearTexel(texels, 0, u, v);
+    }
+    return span.fallback;
+}
+
+template <class Texels>
+static inline uint32_t nearestPixel(const TextureSpan& span, Texels& texels, int i) {
+    double u, v;
+    spanCoordinates(span, i, u, v);
+    if (u >= 0 && u < span.width && v >= 0 && v < span.height) {
+        // Rounding up past the last texel lands on its replicated edge
+        return texels.texel(0, static_cast<int>(u + 0.5), static_cast<int>(v + 0.5));
+    }
+    return span.fallback;
+}
+
+template <class Texels>
+static inline uint32_t trilinearPixel(const TextureSpan& span, Texels& texels, int i) {
+    double u, v;
+    const double invW = spanCoordinates(span, i, u, v);
+    if (!(u >= 0 && u < span.width && v >= 0 && v < span.height)) {
+        return span.fallback;
+    }
+
+    // Derivatives of u = uw / w: du/dx = (duw/dx - u * dw/dx) / w, likewise for y.
+    // The level of detail is log2 of the longer screen-axis footprint in texels,
+    // i.e. half the log2 of its squared length.
+    double dudx = (span.dUW - u * span.dW) * invW;
+    double dvdx = (span.dVW - v * span.dW) * invW;
+    double dudy = (span.dUWdy - u * span.dWdy) * invW;
+    double dvdy = (span.dVWdy - v * span.dWdy) * invW;
+    double footprint = std::max(dudx * dudx + dvdx * dvdx, dudy * dudy + dvdy * dvdy);
+
+    // Magnified pixels stay bit-identical to the bilinear kernel
+    if (!(footprint > 1.0)) {
+        return bilinearTexel(texels, 0, u, v);
+    }
+
+    // log2 approximated from the exponent and a linear mantissa, as texture units do
+    uint64_t bits;
+    std::memcpy(&bits, &footprint, sizeof(bits));
+    int exponent = static_cast<int>((bits >> 52) & 0x7FF) - 1023;
+    double mantissa = static_cast<double>(bits & 0xFFFFFFFFFFFFFull) * (1.0 / 4503599627370496.0);
+    double lod = 0.5 * (exponent + mantissa);
+
+    const int lastLevel = span.levelCount - 1;
+    int level = std::min(static_cast<int>(lod), lastLevel);
+    uint32_t blend = level < lastLevel ? static_cast<uint32_t>((lod - level) * 256.0) : 0;
+
+    // Texel j of level L covers base texels [j * 2^L, (j + 1) * 2^L); clamping to
+    // the last texel centre matches the replicated edge
+    uint32_t samples[2];
+    double scale = 1.0 / static_cast<double>(1 << level);
+    for (int k = 0; k < (blend ? 2 : 1); k++, scale *= 0.5) {
+        const MipLevel& mip = span.levels[level + k];
+        double mu = std::min(std::max((u + 0.5) * scale - 0.5, 0.0), mip.width - 1.0);
+        double mv = std::min(std::max((v + 0.5) * scale - 0.5, 0.0), mip.height - 1.0);
+        samples[k] = bilinearTexel(texels, level + k, mu, mv);
+    }
+
+    uint32_t color = samples[0];
+    if (blend) {
+        color = 0;
+        for (int shift = 0; shift < 24; shift += 8) {
+            uint32_t fine = (samples[0] >> shift) & 0xFF;
+            uint32_t coarse = (samples[1] >> shift) & 0xFF;
+            color |= ((fine * (256 - blend) + coarse * blend + 128) >> 8) << shift;
+        }
+    }
+    return color;
+}
+
+template <class Texels>
+static inline uint32_t areaPixel(const TextureSpan& span, Texels& texels, int i) {
+    if (!span.summedArea) {
+        return trilinearPixel(span, texels, i);
+    }
+    double u, v;
+    const double invW = spanCoordinates(span, i, u, v);
+    if (!(u >= 0 && u < span.width && v >= 0 && v < span.height)) {
+        return span.fallback;
+    }
+
+    // Screen-space derivatives as in the trilinear kernel
+    double dudx = (span.dUW - u * span.dW) * invW;
+    double dvdx = (span.dVW - v * span.dW) * invW;
+    double dudy = (span.dUWdy - u * span.dWdy) * invW;
+    double dvdy = (span.dVWdy - v * span.dWdy) * invW;
+    double footprint = std::max(dudx * dudx + dvdx * dvdx, dudy * dudy + dvdy * dvdy);
+
+    // Magnified pixels stay bit-identical to the bilinear kernel
+    if (!(footprint > 1.0)) {
+        return bilinearTexel(texels, 0, u, v);
+    }
+
+    // Texels overlapping the bounding box of the projected pixel square; texel j
+    // spans [j - 0.5, j + 0.5) around its centre. Edges are rounded by truncation,
+    // which floors the lower ones once they are clamped to zero.
+    double extentU = std::min(0.5 * (std::abs(dudx) + std::abs(dudy)), MAX_AREA_EXTENT);
+    double extentV = std::min(0.5 * (std::abs(dvdx) + std::abs(dvdy)), MAX_AREA_EXTENT);
+    int x0 = std::min(static_cast<int>(std::max(u - extentU + 0.5, 0.0)), span.width - 1);
+    int y0 = std::min(static_cast<int>(std::max(v - extentV + 0.5, 0.0)), span.height - 1);
+    const double right = u + extentU - 0.5;
+    const double bottom = v + extentV - 0.5;
+    int x1 = static_cast<int>(right);
+    int y1 = static_cast<int>(bottom);
+    x1 = std::min(std::max(x1 + (x1 < right), x0), span.width - 1);
+    y1 = std::min(std::max(y1 + (y1 < bottom), y0), span.height - 1);
+
+    // Box sum from the four corners of the table; wrapped sums cancel
+    const size_t stride = static_cast<size_t>(span.width) + 1;
+    const uint32_t* topLeft = span.summedArea + 3 * (y0 * stride + x0);
+    const uint32_t* topRight = span.summedArea + 3 * (y0 * stride + x1 + 1);
+    const uint32_t* bottomLeft = span.summedArea + 3 * ((y1 + 1) * stride + x0);
+    const uint32_t* bottomRight = span.summedArea + 3 * ((y1 + 1) * stride + x1 + 1);
+    const double scale = 1.0 / (static_cast<double>(x1 - x0 + 1) * (y1 - y0 + 1));
+    uint32_t color = 0;
+    for (int c = 0; c < 3; c++) {
+        uint32_t sum = bottomRight[c] - topRight[c] - bottomLeft[c] + topLeft[c];
+        color |= static_cast<uint32_t>(sum * scale + 0.5) << (8 * c);
+    }
+    return color;
+}
+
+static inline void storeColor(const TextureSpan& span, int i, uint32_t color) {
+    unsigned char* out = span.out + 3 * i;
+    out[0] = static_cast<unsigned char>(color);
+    out[1] = static_cast<unsigned char>(color >> 8);
+    out[2] = static_cast<unsigned char>(color >> 16);
+}
+
+void sampleSpanScalar(const TextureSpan& span, int first) {
+    ResidentTexels texels = { span.levels };
+    for (int i = first; i < span.count; i++) {
+        storeColor(span, i, bilinearPixel(span, texels, i));
+    }
+}
+
+void sampleSpanNearest(const TextureSpan& span) {
+    ResidentTexels texels = { span.levels };
+    for (int i = 0; i < span.count; i++) {
+        storeColor(span, i, nearestPixel(span, texels, i));
+    }
+}
+
+void sampleSpanTrilinear(const TextureSpan& span, int first) {
+    ResidentTexels texels = { span.levels };
+    for (int i = first; i < span.count; i++) {
+        storeColor(span, i, trilinearPixel(span, texels, i));
+    }
+}
+
+/**
+ * Blend of a 2x2 texel footprint with 8-bit weights, rounded to nearest
+ *
+ * @param t00 Top-left texel
+ * @param t10 Top-right texel
+ * @param t01 Bottom-left texel
+ * @param t11 Bottom-right texel
+ * @param fracX Horizontal weight of the right texels (0 to 256)
+ * @param fracY Vertical weight of the bottom texels (0 to 256)
+ * @return Packed color
+ */
+static inline uint32_t bilinearBlend8(uint32_t t00, uint32_t t10, uint32_t t01, uint32_t t11,
+    uint32_t fracX, uint32_t fracY) {
+    // Rows are blended with red and blue 16 bits apart in one word, which holds
+    // their weighted sums exactly. Columns need 24 bits per channel, so red and
+    // blue move 32 bits apart in a 64-bit word for the second blend.
+    const uint32_t invX = 256 - fracX;
+    const uint32_t invY = 256 - fracY;
+    const uint32_t rbTop = (t00 & 0xFF00FF) * invX + (t10 & 0xFF00FF) * fracX;
+    const uint32_t rbBottom = (t01 & 0xFF00FF) * invX + (t11 & 0xFF00FF) * fracX;
+    const uint32_t gTop = ((t00 & 0xFF00) * invX + (t10 & 0xFF00) * fracX) >> 8;
+    const uint32_t gBottom = ((t01 & 0xFF00) * invX + (t11 & 0xFF00) * fracX) >> 8;
+    const uint64_t top = (rbTop & 0xFFFF) | (static_cast<uint64_t>(rbTop >> 16) << 32);
+    const uint64_t bottom = (rbBottom & 0xFFFF) | (static_cast<uint64_t>(rbBottom >> 16) << 32);
+    const uint64_t rb = top * invY + bottom * fracY + 0x0000800000008000ULL;
+    const uint32_t g = (gTop * invY + gBottom * fracY + 0x8000) >> 16;
+    return static_cast<uint32_t>((rb >> 16) & 0xFF) | (g << 8) | (static_cast<uint32_t>((rb >> 48) & 0xFF) << 16);
+}
+
+/**
+ * 16.16 fixed-point coordinate, rounded down
+ *
+ * @param value Texel coordinate, clamped far outside any texture
+ * @return Fixed-point coordinate
+ */
+static inline int64_t toFixed(double value) {
+    double scaled = std::min(std::max(value * 65536.0, -4.5e15), 4.5e15);
+    int64_t fixed = static_cast<int64_t>(scaled);
+    return fixed - (static_cast<double>(fixed) > scaled);
+}
+
+// Fixed-point coordinates at a segment boundary
+struct FixedEndpoint {
+    double w;
+    int64_t u, v;
+};
+
+static inline FixedEndpoint fixedEndpoint(const TextureSpan& span, int x) {
+    const double sx = static_cast<double>(x);
+    FixedEndpoint end;
+    end.w = span.dW * sx + span.rowW;
+    const double invW = std::abs(end.w) > 1e-8 ? 1.0 / end.w : 1.0;
+    end.u = toFixed((span.dUW * sx + span.rowUW) * invW);
+    end.v = toFixed((span.dVW * sx + span.rowVW) * invW);
+    return end;
+}
+
+// 2 s^2 for the half segment s, so a quadratic through a segment's fixed-point
+// endpoints and middle has integer values and differences at every column
+static const int FIXED_QUADRATIC_SHIFT = 2 * FIXED_SEGMENT_SHIFT - 1;
+
+// Scaled quadratic coordinate stepped by exact forward differences
+struct FixedQuadratic {
+    int64_t value, delta, delta2;
+
+    void step() {
+        value += delta;
+        delta += delta2;
+    }
+};
+
+/**
+ * Quadratic through the coordinates at a segment's start, middle and end
+ *
+ * @param c0 Coordinate at the start
+ * @param cm Coordinate at the middle
+ * @param c1 Coordinate at the end
+ * @param t Column within the segment to start at
+ * @return Value and differences at t, scaled by 2^FIXED_QUADRATIC_SHIFT
+ */
+static inline FixedQuadratic fixedQuadratic(int64_t c0, int64_t cm, int64_t c1, int64_t t) {
+    // 2 s^2 P(t) = 2 s^2 c0 + 2 s (cm - c0) t + (c1 - 2 cm + c0) t (t - s)
+    const int64_t half = FIXED_SEGMENT / 2;
+    const int64_t linear = 2 * half * (cm - c0);
+    const int64_t second = c1 - 2 * cm + c0;
+    FixedQuadratic q;
+    q.value = c0 * (int64_t(1) << FIXED_QUADRATIC_SHIFT) + linear * t + second * t * (t - half);
+    q.delta = linear + second * (2 * t + 1 - half);
+    q.delta2 = 2 * second;
+    return q;
+}
+
+/**
+ * 8-bit weight of the next texel for a 16.16 coordinate, rounded to nearest
+ *
+ * @param c Fixed-point coordinate
+ * @return Weight (0 to 256)
+ */
+static inline uint32_t fixedWeight(int64_t c) {
+    return (static_cast<uint32_t>(c & 0xFFFF) + 128) >> 8;
+}
+
+/**
+ * Fixed-point bilinear sampling of a span
+ *
+ * @tparam Tiled Whether the base level is stored in tiles
+ * @param span Span to sample
+ */
+template<bool Tiled>
+static void sampleFixed(const TextureSpan& span) {
+    const MipLevel& base = span.levels[0];
+    const int64_t widthFixed = static_cast<int64_t>(span.width) << 16;
+    const int64_t heightFixed = static_cast<int64_t>(span.height) << 16;
+    auto pixel = [&](int64_t u, int64_t v) -> uint32_t {
+        if (static_cast<uint64_t>(u) >= static_cast<uint64_t>(widthFixed) ||
+            static_cast<uint64_t>(v) >= static_cast<uint64_t>(heightFixed)) {
+            return span.fallback;
+        }
+        const int x = static_cast<int>(u >> 16);
+        const int y = static_cast<int>(v >> 16);
+        uint32_t t00, t10, t01, t11;
+        if (Tiled) {
+            t00 = base.texels[Texture::texelOffset(base, x, y)];
+            t10 = base.texels[Texture::texelOffset(base, x + 1, y)];
+            t01 = base.texels[Texture::texelOffset(base, x, y + 1)];
+            t11 = base.texels[Texture::texelOffset(base, x + 1, y + 1)];
+        }
+        else {
+            const uint32_t* p = base.texels + static_cast<ptrdiff_t>(y) * base.stride + x;
+            t00 = p[0];
+            t10 = p[1];
+            t01 = p[base.stride];
+            t11 = p[base.stride + 1];
+        }
+        return bilinearBlend8(t00, t10, t01, t11, fixedWeight(u), fixedWeight(v));
+    };
+    auto exactPixel = [&](int i) -> uint32_t {
+        double u, v;
+        spanCoordinates(span, i, u, v);
+        return pixel(toFixed(u), toFixed(v));
+    };
+    // Stepped coordinates this close to a texture edge may be on the wrong side of it
+    auto nearEdge = [](int64_t c, int64_t size) {
+        return static_cast<uint64_t>(c + FIXED_EDGE_MARGIN) < 2 * FIXED_EDGE_MARGIN ||
+            static_cast<uint64_t>(c - size + FIXED_EDGE_MARGIN) < 2 * FIXED_EDGE_MARGIN;
+    };
+
+    // u = uw / w has d3u/dx3 = 6 dW^2 K / w^4, with K = dUW rowW - dW rowUW
+    // constant along the span. A quadratic through a segment's start, middle
+    // and end is then off by at most 2 s^3 / (3 sqrt 3) * dW^2 K / min|w|^4
+    // texels, s being half the segment; this is that factor over FIXED_STEP_ERROR.
+    const double half = FIXED_SEGMENT / 2;
+    const double ku = std::abs(span.dUW * span.rowW - span.dW * span.rowUW);
+    const double kv = std::abs(span.dVW * span.rowW - span.dW * span.rowVW);
+    const double curvature = 2.0 * half * half * half / (3.0 * std::sqrt(3.0)) * span.dW * span.dW *
+        std::max(ku, kv) / FIXED_STEP_ERROR;
+
+    // Segments of screen columns [start, start + FIXED_SEGMENT), each sharing its
+    // end with the next one's start
+    int start = span.x0 & ~(FIXED_SEGMENT - 1);
+    FixedEndpoint a = fixedEndpoint(span, start);
+    for (int i = 0; i < span.count; start += FIXED_SEGMENT) {
+        const int end = std::min(span.count, start + FIXED_SEGMENT - span.x0);
+        const FixedEndpoint b = fixedEndpoint(span, start + FIXED_SEGMENT);
+
+        // Stepping also needs w away from zero at both ends, which keeps
+        // segments off the horizon
+        const double minW = std::min(std::abs(a.w), std::abs(b.w));
+        if (((a.w > 1e-8 && b.w > 1e-8) || (a.w < -1e-8 && b.w < -1e-8)) &&
+            curvature <= minW * minW * minW * minW) {
+            const FixedEndpoint m = fixedEndpoint(span, start + FIXED_SEGMENT / 2);
+            const int64_t t = span.x0 + i - start;
+            FixedQuadratic u = fixedQuadratic(a.u, m.u, b.u, t);
+            FixedQuadratic v = fixedQuadratic(a.v, m.v, b.v, t);
+            for (; i < end; i++) {
+                const int64_t su = u.value >> FIXED_QUADRATIC_SHIFT;
+                const int64_t sv = v.value >> FIXED_QUADRATIC_SHIFT;
+                storeColor(span, i, nearEdge(su, widthFixed) || nearEdge(sv, heightFixed) ?
+                    exactPixel(i) : pixel(su, sv));
+                u.step();
+                v.step();
+            }
+        }
+        else {
+            for (; i < end; i++) {
+                storeColor(span, i, exactPixel(i));
+            }
+        }
+        a = b;
+    }
+}
+
+void sampleSpanFixed(const TextureSpan& span) {
+    if (span.tiled) {
+        sampleFixed<true>(span);
+    }
+    else {
+        sampleFixed<false>(span);
+    }
+}
+
+void sampleSpanArea(const TextureSpan& span, int first) {
+    ResidentTexels texels = { span.levels };
+    for (int i = first; i < span.count; i++) {
+        storeColor(span, i, areaPixel(span, texels, i));
+    }
+}
+
+/**
+ * Sample one pixel through any texel source
+ */
+template <class Texels>
+static inline uint32_t filteredPixel(const TextureSpan& span, Texels& texels, int i, TextureFilter filter) {
+    switch (filter) {
+    case TextureFilter::Nearest:   return nearestPixel(span, texels, i);
+    case TextureFilter::Trilinear: return trilinearPixel(span, texels, i);
+    case TextureFilter::Area:      return areaPixel(span, texels, i);
+    default:                       return bilinearPixel(span, texels, i);
+    }
+}
+
+void samplePagedSpan(const TextureSpan& span, TextureFilter filter) {
+    PagedTexels texels = { span.pages };
+    PageCollector collector;
+    collector.pages = span.pages;
+
+    // Runs of pixels are sampled once their pages are pinned. A run ends before
+    // the first pixel whose pages no longer fit; that pixel starts the next run,
+    // or is sampled on its own when its pages would not fit an empty collector.
+    for (int first = 0; first < span.count; ) {
+        collector.count = 0;
+        int end = first;
+        while (end < span.count) {
+            const int before = collector.count;
+            collector.full = false;
+            filteredPixel(span, collector, end, filter);
+            if (collector.full) {
+                collector.count = before;
+                break;
+            }
+            end++;
+        }
+        if (end == first) {
+            PinningTexels pinning = { span.pages };
+            storeColor(span, first, filteredPixel(span, pinning, first, filter));
+            first++;
+            continue;
+        }
+        span.pages->pin(collector.ids, collector.count);
+        for (int i = first; i < end; i++) {
+            storeColor(span, i, filteredPixel(span, texels, i, filter));
+        }
+        span.pages->unpin(collector.ids, collector.count);
+        first = end;
+    }
+}
+
+TextureSpan makeTextureSpan(const Texture& texture, const Mat3x3& Hinv, int y, int x0, int x1,
+    const Color& fallbackColor, Color* out) {
+    TextureSpan span;
+    span.texels = texture.texelData();
+    span.stride = texture.getStride();
+    span.tiled = texture.getLayout() == TextureLayout::Tiled;
+    span.width = texture.getWidth();
+    span.height = texture.getHeight();
+    span.rowUW = Hinv.m[0][1] * y + Hinv.m[0][2];
+    span.rowVW = Hinv.m[1][1] * y + Hinv.m[1][2];
+    span.rowW = Hinv.m[2][1] * y + Hinv.m[2][2];
+    span.dUW = Hinv.m[0][0];
+    span.dVW = Hinv.m[1][0];
+    span.dW = Hinv.m[2][0];
+    span.dUWdy = Hinv.m[0][1];
+    span.dVWdy = Hinv.m[1][1];
+    span.dWdy = Hinv.m[2][1];
+    span.levels = texture.levelData();
+    span.levelCount = texture.getLevelCount();
+    span.pages = texture.getPages();
+    span.summedArea = texture.summedAreaData();
+    span.x0 = x0;
+    span.count = x1 - x0 + 1;
+    span.fallback = Texture::pack(fallbackColor);
+    span.out = reinterpret_cast<unsigned char*>(out);
+    return span;
+}
+
+void sampleTextureSpan(const TextureSpan& span) {
+    sampleTextureSpan(span, getKernelIsa());
+}
+
+void sampleTextureSpan(const TextureSpan& span, KernelIsa isa) {
+    if (span.pages) {
+        samplePagedSpan(span, TextureFilter::Bilinear);
+        return;
+    }
+    bool vectorSized = span.width <= MAX_VECTOR_TEXTURE_SIZE && span.height <= MAX_VECTOR_TEXTURE_SIZE;
+
+#ifdef CUBE_X86_KERNELS
+    if (vectorSized && isa == KernelIsa::AVX512) {
+        sampleSpanAVX512(span);
+        return;
+    }
+    if (vectorSized && isa == KernelIsa::AVX2) {
+        sampleSpanAVX2(span);
+        return;
+    }
+    if (vectorSized && isa == KernelIsa::SSE41) {
+        sampleSpanSSE41(span);
+        return;
+    }
+#else
+    (void)isa;
+    (void)vectorSized;
+#endif
+
+    sampleSpanScalar(span, 0);
+}
+
+void sampleFilteredSpan(const TextureSpan& span, TextureFilter filter, TexturePrecision precision) {
+    sampleFilteredSpan(span, filter, precision, getKernelIsa());
+}
+
+void sampleFilteredSpan(const TextureSpan& span, TextureFilter filter, TexturePrecision precision, KernelIsa isa) {
+    if (span.pages) {
+        samplePagedSpan(span, filter);
+        return;
+    }
+    if (filter == TextureFilter::Bilinear && precision == TexturePrecision::Fixed) {
+        sampleSpanFixed(span);
+        return;
+    }
+    bool vectorSized = span.width <= MAX_VECTOR_TEXTURE_SIZE && span.height <= MAX_VECTOR_TEXTURE_SIZE;
+
+    switch (filter) {
+    case TextureFilter::Nearest:
+        sampleSpanNearest(span);
+        break;
+    case TextureFilter::Trilinear:
+#ifdef CUBE_X86_KERNELS
+        if (vectorSized && isa == KernelIsa::AVX512) {
+            sampleSpanTrilinearAVX512(span);
+            break;
+        }
+        if (vectorSized && isa == KernelIsa::AVX2) {
+            sampleSpanTrilinearAVX2(span);
+            break;
+        }
+#endif
+        sampleSpanTrilinear(span, 0);
+        break;
+    case TextureFilter::Area:
+#ifdef CUBE_X86_KERNELS
+        if (vectorSized && isa == KernelIsa::AVX512) {
+            sampleSpanAreaAVX512(span);
+            break;
+        }
+        if (vectorSized && isa == KernelIsa::AVX2) {
+            sampleSpanAreaAVX2(span);
+            break;
+        }
+#endif
+        sampleSpanArea(span, 0);
+        break;
+    default:
+        sampleTextureSpan(span, isa);
+        break;
+    }
+#ifndef CUBE_X86_KERNELS
+    (void)vectorSized;
+#endif
+}
+
+bool parseTextureFilter(const std::string& name, TextureFilter& filter) {
+    if (name == "nearest") {
+        filter = TextureFilter::Nearest;
+    }
+    else if (name == "bilinear") {
+        filter = TextureFilter::Bilinear;
+    }
+    else if (name == "trilinear") {
+        filter = TextureFilter::Trilinear;
+    }
+    else if (name == "area") {
+        filter = TextureFilter::Area;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+const char* textureFilterName(TextureFilter filter) {
+    switch (filter) {
+    case TextureFilter::Nearest:   return "nearest";
+    case TextureFilter::Bilinear:  return "bilinear";
+    case TextureFilter::Trilinear: return "trilinear";
+    case TextureFilter::Area:      return "area";
+    default:                       return "unknown";
+    }
+}
+
+const char* texturePrecisionName(TexturePrecision precision) {
+    switch (precision) {
+    case TexturePrecision::Double: return "double";
+    case TexturePrecision::Fixed:  return "fixed";
+    default:                       return "unknown";
+    }
+}
+
+Color sampleBilinearReference(const Texture& texture, double u, double v, const Color& fallbackColor) {
+    // Check if point is within texture bounds
+    if (u < 0 || u >= texture.getWidth() || v < 0 || v >= texture.getHeight()) {
+        // Outside texture bounds, use fallback color
+        return fallbackColor;
+    }
+
+    int x0 = static_cast<int>(u);
+    int y0 = static_cast<int>(v);
+    int x1 = std::min(x0 + 1, texture.getWidth() - 1);
+    int y1 = std::min(y0 + 1, texture.getHeight() - 1);
+
+    double fx = u - x0;
+    double fy = v - y0;
+
+    Color c00 = texture.getPixel(x0, y0);
+    Color c10 = texture.getPixel(x1, y0);
+    Color c01 = texture.getPixel(x0, y1);
+    Color c11 = texture.getPixel(x1, y1);
+
+    unsigned char r = static_cast<unsigned char>(
+        (1 - fx) * (1 - fy) * c00.r + fx * (1 - fy) * c10.r +
+        (1 - fx) * fy * c01.r + fx * fy * c11.r);
+    unsigned char g = static_cast<unsigned char>(
+        (1 - fx) * (1 - fy) * c00.g + fx * (1 - fy) * c10.g +
+        (1 - fx) * fy * c01.g + fx * fy * c11.g);
+    unsigned char b = static_cast<unsigned char>(
+        (1 - fx) * (1 - fy) * c00.b + fx * (1 - fy) * c10.b +
+        (1 - fx) * fy * c01.b + fx * fy * c11.b);
+
+    return Color(r, g, b);
+}
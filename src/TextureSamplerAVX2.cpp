@@ -0,0 +1,462 @@
+// Compiled with AVX2 code generation; only called after a CPU check
+#include "SamplerKernels.hpp"
+// GCC 12 flags the placeholder registers of its own gather intrinsics as uninitialized
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// Narrow the all-ones/zero masks of two 4 x double vectors to 8 x 32-bit lanes
+static inline __m256i narrowMask(__m256d lo, __m256d hi) {
+    const __m256i evenLanes = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    __m256i l = _mm256_permutevar8x32_epi32(_mm256_castpd_si256(lo), evenLanes);
+    __m256i h = _mm256_permutevar8x32_epi32(_mm256_castpd_si256(hi), evenLanes);
+    return _mm256_permute2x128_si256(l, h, 0x20);
+}
+
+// Bilinear blend of one 8-bit channel in 16.16 fixed point (see sampleSpanScalar)
+static inline __m256i blendChannel(__m256i t00, __m256i t10, __m256i t01, __m256i t11, int shift,
+    __m256i fx, __m256i fxInv, __m256i fy, __m256i fyInv) {
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i half = _mm256_set1_epi32(128);
+    __m256i c00 = _mm256_and_si256(_mm256_srli_epi32(t00, shift), byteMask);
+    __m256i c10 = _mm256_and_si256(_mm256_srli_epi32(t10, shift), byteMask);
+    __m256i c01 = _mm256_and_si256(_mm256_srli_epi32(t01, shift), byteMask);
+    __m256i c11 = _mm256_and_si256(_mm256_srli_epi32(t11, shift), byteMask);
+
+    __m256i top = _mm256_add_epi32(_mm256_mullo_epi32(c00, fxInv), _mm256_mullo_epi32(c10, fx));
+    __m256i bottom = _mm256_add_epi32(_mm256_mullo_epi32(c01, fxInv), _mm256_mullo_epi32(c11, fx));
+    top = _mm256_srli_epi32(_mm256_add_epi32(top, half), 8);
+    bottom = _mm256_srli_epi32(_mm256_add_epi32(bottom, half), 8);
+
+    __m256i value = _mm256_add_epi32(_mm256_mullo_epi32(top, fyInv), _mm256_mullo_epi32(bottom, fy));
+    return _mm256_slli_epi32(_mm256_srli_epi32(value, 24), shift);
+}
+
+// Texture coordinates of 4 consecutive pixels, zeroed where the sample misses the texture,
+// and 1 / w (1 where w is too close to zero to divide by)
+static inline void texcoords(const TextureSpan& span, __m256d fx, __m256d& u, __m256d& v, __m256d& valid,
+    __m256d& invW) {
+    __m256d uw = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(span.dUW), fx), _mm256_set1_pd(span.rowUW));
+    __m256d vw = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(span.dVW), fx), _mm256_set1_pd(span.rowVW));
+    __m256d w = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(span.dW), fx), _mm256_set1_pd(span.rowW));
+
+    // Perspective divide unless w is (nearly) zero
+    __m256d absW = _mm256_andnot_pd(_mm256_set1_pd(-0.0), w);
+    __m256d divide = _mm256_cmp_pd(absW, _mm256_set1_pd(1e-8), _CMP_GT_OQ);
+    invW = _mm256_blendv_pd(_mm256_set1_pd(1.0), _mm256_div_pd(_mm256_set1_pd(1.0), w), divide);
+    u = _mm256_blendv_pd(uw, _mm256_mul_pd(uw, invW), divide);
+    v = _mm256_blendv_pd(vw, _mm256_mul_pd(vw, invW), divide);
+
+    const __m256d zero = _mm256_setzero_pd();
+    valid = _mm256_and_pd(
+        _mm256_and_pd(_mm256_cmp_pd(u, zero, _CMP_GE_OQ), _mm256_cmp_pd(u, _mm256_set1_pd(span.width), _CMP_LT_OQ)),
+        _mm256_and_pd(_mm256_cmp_pd(v, zero, _CMP_GE_OQ), _mm256_cmp_pd(v, _mm256_set1_pd(span.height), _CMP_LT_OQ)));
+    u = _mm256_and_pd(u, valid);
+    v = _mm256_and_pd(v, valid);
+}
+
+// Offsets of the four bilinear taps from texel (0, 0) in a level's layout
+static inline void tapOffsets(int levelStride, bool tiled, __m256i x, __m256i y,
+    __m256i& o00, __m256i& o10, __m256i& o01, __m256i& o11) {
+    const __m256i stride = _mm256_set1_epi32(levelStride);
+    const __m256i one = _mm256_set1_epi32(1);
+    if (!tiled) {
+        o00 = _mm256_add_epi32(_mm256_mullo_epi32(y, stride), x);
+        o10 = _mm256_add_epi32(o00, one);
+        o01 = _mm256_add_epi32(o00, stride);
+        o11 = _mm256_add_epi32(o01, one);
+        return;
+    }
+
+    const __m256i inTile = _mm256_set1_epi32(TEXTURE_TILE_SIZE - 1);
+    __m256i x1 = _mm256_add_epi32(x, one);
+    __m256i y1 = _mm256_add_epi32(y, one);
+    __m256i col0 = _mm256_add_epi32(
+        _mm256_slli_epi32(_mm256_srai_epi32(x, TEXTURE_TILE_SHIFT), 2 * TEXTURE_TILE_SHIFT), _mm256_and_si256(x, inTile));
+    __m256i col1 = _mm256_add_epi32(
+        _mm256_slli_epi32(_mm256_srai_epi32(x1, TEXTURE_TILE_SHIFT), 2 * TEXTURE_TILE_SHIFT), _mm256_and_si256(x1, inTile));
+    __m256i row0 = _mm256_add_epi32(
+        _mm256_mullo_epi32(_mm256_srai_epi32(y, TEXTURE_TILE_SHIFT), stride),
+        _mm256_slli_epi32(_mm256_and_si256(y, inTile), TEXTURE_TILE_SHIFT));
+    __m256i row1 = _mm256_add_epi32(
+        _mm256_mullo_epi32(_mm256_srai_epi32(y1, TEXTURE_TILE_SHIFT), stride),
+        _mm256_slli_epi32(_mm256_and_si256(y1, inTile), TEXTURE_TILE_SHIFT));
+    o00 = _mm256_add_epi32(row0, col0);
+    o10 = _mm256_add_epi32(row0, col1);
+    o01 = _mm256_add_epi32(row1, col0);
+    o11 = _mm256_add_epi32(row1, col1);
+}
+
+// Write 8 packed colors as RGB bytes from pixel i of the span
+static inline void storePixels(const TextureSpan& span, int i, __m256i color) {
+    alignas(32) uint32_t packed[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(packed), color);
+    unsigned char* out = span.out + 3 * i;
+    for (int k = 0; k < 8; k++) {
+        out[3 * k] = static_cast<unsigned char>(packed[k]);
+        out[3 * k + 1] = static_cast<unsigned char>(packed[k] >> 8);
+        out[3 * k + 2] = static_cast<unsigned char>(packed[k] >> 16);
+    }
+}
+
+void sampleSpanAVX2(const TextureSpan& span) {
+    const __m256d fixedScale = _mm256_set1_pd(65536.0);
+    const __m256i fracMask = _mm256_set1_epi32(0xFFFF);
+    const __m256i one = _mm256_set1_epi32(65536);
+    const __m256i fallback = _mm256_set1_epi32(static_cast<int>(span.fallback));
+    const int* texels = reinterpret_cast<const int*>(span.texels);
+
+    int i = 0;
+    for (; i + 8 <= span.count; i += 8) {
+        __m256d fxLo = _mm256_add_pd(_mm256_set1_pd(static_cast<double>(span.x0 + i)), _mm256_setr_pd(0, 1, 2, 3));
+        __m256d fxHi = _mm256_add_pd(fxLo, _mm256_set1_pd(4.0));
+
+        __m256d uLo, vLo, validLo, invWLo, uHi, vHi, validHi, invWHi;
+        texcoords(span, fxLo, uLo, vLo, validLo, invWLo);
+        texcoords(span, fxHi, uHi, vHi, validHi, invWHi);
+
+        // 16.16 fixed-point texel coordinates
+        __m256i u = _mm256_set_m128i(
+            _mm256_cvttpd_epi32(_mm256_mul_pd(uHi, fixedScale)), _mm256_cvttpd_epi32(_mm256_mul_pd(uLo, fixedScale)));
+        __m256i v = _mm256_set_m128i(
+            _mm256_cvttpd_epi32(_mm256_mul_pd(vHi, fixedScale)), _mm256_cvttpd_epi32(_mm256_mul_pd(vLo, fixedScale)));
+
+        __m256i fx = _mm256_and_si256(u, fracMask);
+        __m256i fy = _mm256_and_si256(v, fracMask);
+        __m256i fxInv = _mm256_sub_epi32(one, fx);
+        __m256i fyInv = _mm256_sub_epi32(one, fy);
+
+        __m256i o00, o10, o01, o11;
+        tapOffsets(span.stride, span.tiled, _mm256_srai_epi32(u, 16), _mm256_srai_epi32(v, 16), o00, o10, o01, o11);
+        __m256i t00 = _mm256_i32gather_epi32(texels, o00, 4);
+        __m256i t10 = _mm256_i32gather_epi32(texels, o10, 4);
+        __m256i t01 = _mm256_i32gather_epi32(texels, o01, 4);
+        __m256i t11 = _mm256_i32gather_epi32(texels, o11, 4);
+
+        __m256i color = _mm256_or_si256(
+            _mm256_or_si256(
+                blendChannel(t00, t10, t01, t11, 0, fx, fxInv, fy, fyInv),
+                blendChannel(t00, t10, t01, t11, 8, fx, fxInv, fy, fyInv)),
+            blendChannel(t00, t10, t01, t11, 16, fx, fxInv, fy, fyInv));
+        color = _mm256_blendv_epi8(fallback, color, narrowMask(validLo, validHi));
+        storePixels(span, i, color);
+    }
+
+    sampleSpanScalar(span, i);
+}
+
+// Texture coordinates and screen-space derivatives of 4 consecutive pixels, and
+// the squared length of their longer screen-axis footprint (see trilinearPixel)
+struct Footprint {
+    __m256d u, v, valid;
+    __m256d dudx, dvdx, dudy, dvdy;
+    __m256d squared;
+    __m256d minified;   // Lanes whose footprint is longer than one texel
+};
+
+static inline Footprint footprint(const TextureSpan& span, __m256d fx) {
+    Footprint f;
+    __m256d invW;
+    texcoords(span, fx, f.u, f.v, f.valid, invW);
+    const __m256d dW = _mm256_set1_pd(span.dW);
+    const __m256d dWdy = _mm256_set1_pd(span.dWdy);
+    f.dudx = _mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(span.dUW), _mm256_mul_pd(f.u, dW)), invW);
+    f.dvdx = _mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(span.dVW), _mm256_mul_pd(f.v, dW)), invW);
+    f.dudy = _mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(span.dUWdy), _mm256_mul_pd(f.u, dWdy)), invW);
+    f.dvdy = _mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(span.dVWdy), _mm256_mul_pd(f.v, dWdy)), invW);
+    __m256d alongX = _mm256_add_pd(_mm256_mul_pd(f.dudx, f.dudx), _mm256_mul_pd(f.dvdx, f.dvdx));
+    __m256d alongY = _mm256_add_pd(_mm256_mul_pd(f.dudy, f.dudy), _mm256_mul_pd(f.dvdy, f.dvdy));
+    // std::max keeps its first argument unless it is less than the second
+    f.squared = _mm256_blendv_pd(alongX, alongY, _mm256_cmp_pd(alongX, alongY, _CMP_LT_OQ));
+    f.minified = _mm256_cmp_pd(f.squared, _mm256_set1_pd(1.0), _CMP_GT_OQ);
+    return f;
+}
+
+// (c + 0.5) * scale - 0.5 clamped to [0, last], compared in the order of
+// std::max and std::min so that the portable kernel's results carry over
+static inline __m256d mipCoordinate(__m256d c, __m256d scale, __m256d last) {
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d zero = _mm256_setzero_pd();
+    __m256d m = _mm256_sub_pd(_mm256_mul_pd(_mm256_add_pd(c, half), scale), half);
+    m = _mm256_blendv_pd(m, zero, _mm256_cmp_pd(m, zero, _CMP_LT_OQ));
+    return _mm256_blendv_pd(m, last, _mm256_cmp_pd(last, m, _CMP_LT_OQ));
+}
+
+// Mip levels of 4 consecutive pixels: the finer level, the 8-bit weight of the
+// coarser one, and 16.16 coordinates on both. Magnified pixels sample the base
+// level at their own coordinates with zero weight.
+struct LevelSelection {
+    __m128i fine, coarse, weight;
+    __m128i fineU, fineV, coarseU, coarseV;
+};
+
+static inline LevelSelection selectLevels(const TextureSpan& span, const Footprint& f,
+    const double* lastU, const double* lastV) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d fixedScale = _mm256_set1_pd(65536.0);
+    const __m128i lastLevel = _mm_set1_epi32(span.levelCount - 1);
+
+    // log2 from the exponent and a linear mantissa; adding 2^52 to the exponent
+    // as an integer makes a double that is exactly 2^52 + exponent
+    const __m256d exponentBias = _mm256_set1_pd(4503599627370496.0);
+    __m256i bits = _mm256_castpd_si256(f.squared);
+    __m256i exponent = _mm256_sub_epi64(_mm256_srli_epi64(bits, 52), _mm256_set1_epi64x(1023));
+    __m256d exponentValue = _mm256_sub_pd(
+        _mm256_castsi256_pd(_mm256_add_epi64(exponent, _mm256_castpd_si256(exponentBias))), exponentBias);
+    __m256d mantissa = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(
+        _mm256_and_si256(bits, _mm256_set1_epi64x(0xFFFFFFFFFFFFFll)), _mm256_castpd_si256(one))), one);
+    __m256d lod = _mm256_and_pd(_mm256_mul_pd(_mm256_set1_pd(0.5), _mm256_add_pd(exponentValue, mantissa)), f.minified);
+
+    LevelSelection s;
+    s.fine = _mm_min_epi32(_mm256_cvttpd_epi32(lod), lastLevel);
+    s.coarse = _mm_min_epi32(_mm_add_epi32(s.fine, _mm_set1_epi32(1)), lastLevel);
+    __m256d fraction = _mm256_mul_pd(_mm256_sub_pd(lod, _mm256_cvtepi32_pd(s.fine)), _mm256_set1_pd(256.0));
+    s.weight = _mm_andnot_si128(_mm_cmpeq_epi32(s.fine, lastLevel), _mm256_cvttpd_epi32(fraction));
+
+    // 2^-level, built from its exponent
+    __m256d scale = _mm256_castsi256_pd(_mm256_slli_epi64(
+        _mm256_sub_epi64(_mm256_set1_epi64x(1023), _mm256_cvtepi32_epi64(s.fine)), 52));
+    __m256d fineU = mipCoordinate(f.u, scale, _mm256_i32gather_pd(lastU, s.fine, 8));
+    __m256d fineV = mipCoordinate(f.v, scale, _mm256_i32gather_pd(lastV, s.fine, 8));
+    scale = _mm256_mul_pd(scale, _mm256_set1_pd(0.5));
+    __m256d coarseU = mipCoordinate(f.u, scale, _mm256_i32gather_pd(lastU, s.coarse, 8));
+    __m256d coarseV = mipCoordinate(f.v, scale, _mm256_i32gather_pd(lastV, s.coarse, 8));
+    fineU = _mm256_blendv_pd(f.u, fineU, f.minified);
+    fineV = _mm256_blendv_pd(f.v, fineV, f.minified);
+
+    s.fineU = _mm256_cvttpd_epi32(_mm256_mul_pd(fineU, fixedScale));
+    s.fineV = _mm256_cvttpd_epi32(_mm256_mul_pd(fineV, fixedScale));
+    s.coarseU = _mm256_cvttpd_epi32(_mm256_mul_pd(coarseU, fixedScale));
+    s.coarseV = _mm256_cvttpd_epi32(_mm256_mul_pd(coarseV, fixedScale));
+    return s;
+}
+
+// Bilinear samples of 8 pixels at 16.16 coordinates, each on its own mip level:
+// one masked gather per distinct level
+static inline __m256i sampleLevels(const MipLevel* levels, __m256i level, __m256i u, __m256i v) {
+    const __m256i fracMask = _mm256_set1_epi32(0xFFFF);
+    const __m256i one = _mm256_set1_epi32(65536);
+    __m256i fx = _mm256_and_si256(u, fracMask);
+    __m256i fy = _mm256_and_si256(v, fracMask);
+    __m256i fxInv = _mm256_sub_epi32(one, fx);
+    __m256i fyInv = _mm256_sub_epi32(one, fy);
+    __m256i x = _mm256_srai_epi32(u, 16);
+    __m256i y = _mm256_srai_epi32(v, 16);
+
+    alignas(32) int lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), level);
+    __m256i t00 = _mm256_setzero_si256();
+    __m256i t10 = t00, t01 = t00, t11 = t00;
+    for (int pending = 0xFF; pending; ) {
+        int k = 0;
+        while (!(pending & (1 << k))) {
+            k++;
+        }
+        const MipLevel& mip = levels[lanes[k]];
+        __m256i onLevel = _mm256_cmpeq_epi32(level, _mm256_set1_epi32(lanes[k]));
+        __m256i o00, o10, o01, o11;
+        tapOffsets(mip.stride, mip.tiled, x, y, o00, o10, o01, o11);
+        const int* texels = reinterpret_cast<const int*>(mip.texels);
+        t00 = _mm256_mask_i32gather_epi32(t00, texels, o00, onLevel, 4);
+        t10 = _mm256_mask_i32gather_epi32(t10, texels, o10, onLevel, 4);
+        t01 = _mm256_mask_i32gather_epi32(t01, texels, o01, onLevel, 4);
+        t11 = _mm256_mask_i32gather_epi32(t11, texels, o11, onLevel, 4);
+        pending &= ~_mm256_movemask_ps(_mm256_castsi256_ps(onLevel));
+    }
+
+    return _mm256_or_si256(
+        _mm256_or_si256(
+            blendChannel(t00, t10, t01, t11, 0, fx, fxInv, fy, fyInv),
+            blendChannel(t00, t10, t01, t11, 8, fx, fxInv, fy, fyInv)),
+        blendChannel(t00, t10, t01, t11, 16, fx, fxInv, fy, fyInv));
+}
+
+// Per-channel blend of two packed colors by the 8-bit weight of the second
+static inline __m256i blendColors(__m256i fine, __m256i coarse, __m256i weight) {
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i half = _mm256_set1_epi32(128);
+    const __m256i inverse = _mm256_sub_epi32(_mm256_set1_epi32(256), weight);
+    __m256i color = _mm256_setzero_si256();
+    for (int shift = 0; shift < 24; shift += 8) {
+        __m256i f = _mm256_and_si256(_mm256_srli_epi32(fine, shift), byteMask);
+        __m256i c = _mm256_and_si256(_mm256_srli_epi32(coarse, shift), byteMask);
+        __m256i value = _mm256_add_epi32(_mm256_mullo_epi32(f, inverse), _mm256_mullo_epi32(c, weight));
+        color = _mm256_or_si256(color, _mm256_slli_epi32(_mm256_srli_epi32(_mm256_add_epi32(value, half), 8), shift));
+    }
+    return color;
+}
+
+// Base-level bilinear samples of 8 pixels at double texture coordinates
+static inline __m256i sampleBase(const TextureSpan& span, const Footprint& lo, const Footprint& hi) {
+    const __m256d fixedScale = _mm256_set1_pd(65536.0);
+    __m256i u = _mm256_set_m128i(
+        _mm256_cvttpd_epi32(_mm256_mul_pd(hi.u, fixedScale)), _mm256_cvttpd_epi32(_mm256_mul_pd(lo.u, fixedScale)));
+    __m256i v = _mm256_set_m128i(
+        _mm256_cvttpd_epi32(_mm256_mul_pd(hi.v, fixedScale)), _mm256_cvttpd_epi32(_mm256_mul_pd(lo.v, fixedScale)));
+    return sampleLevels(span.levels, _mm256_setzero_si256(), u, v);
+}
+
+void sampleSpanTrilinearAVX2(const TextureSpan& span) {
+    if (span.levelCount > MAX_VECTOR_LEVELS) {
+        sampleSpanTrilinear(span, 0);
+        return;
+    }
+
+    // Mip coordinates are clamped to the last texel centre of their level
+    double lastU[MAX_VECTOR_LEVELS];
+    double lastV[MAX_VECTOR_LEVELS];
+    for (int k = 0; k < span.levelCount; k++) {
+        lastU[k] = span.levels[k].width - 1.0;
+        lastV[k] = span.levels[k].height - 1.0;
+    }
+    const __m256i fallback = _mm256_set1_epi32(static_cast<int>(span.fallback));
+
+    int i = 0;
+    for (; i + 8 <= span.count; i += 8) {
+        __m256d fxLo = _mm256_add_pd(_mm256_set1_pd(static_cast<double>(span.x0 + i)), _mm256_setr_pd(0, 1, 2, 3));
+        __m256d fxHi = _mm256_add_pd(fxLo, _mm256_set1_pd(4.0));
+        Footprint lo = footprint(span, fxLo);
+        Footprint hi = footprint(span, fxHi);
+        LevelSelection levelsLo = selectLevels(span, lo, lastU, lastV);
+        LevelSelection levelsHi = selectLevels(span, hi, lastU, lastV);
+
+        __m256i color = sampleLevels(span.levels, _mm256_set_m128i(levelsHi.fine, levelsLo.fine),
+            _mm256_set_m128i(levelsHi.fineU, levelsLo.fineU), _mm256_set_m128i(levelsHi.fineV, levelsLo.fineV));
+        __m256i weight = _mm256_set_m128i(levelsHi.weight, levelsLo.weight);
+        if (!_mm256_testz_si256(weight, weight)) {
+            __m256i coarse = sampleLevels(span.levels, _mm256_set_m128i(levelsHi.coarse, levelsLo.coarse),
+                _mm256_set_m128i(levelsHi.coarseU, levelsLo.coarseU), _mm256_set_m128i(levelsHi.coarseV, levelsLo.coarseV));
+            color = blendColors(color, coarse, weight);
+        }
+        color = _mm256_blendv_epi8(fallback, color, narrowMask(lo.valid, hi.valid));
+        storePixels(span, i, color);
+    }
+
+    sampleSpanTrilinear(span, i);
+}
+
+// Summed-area box of 4 consecutive minified pixels (see areaPixel): the table
+// offsets of its corners and the reciprocal of its texel count. Lanes outside
+// the mask get the box of texel (0, 0).
+struct AreaBox {
+    __m128i topLeft, topRight, bottomLeft, bottomRight;
+    __m256d scale;
+};
+
+static inline AreaBox areaBox(const TextureSpan& span, const Footprint& f, __m256d inBox) {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d maxExtent = _mm256_set1_pd(MAX_AREA_EXTENT);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m128i lastX = _mm_set1_epi32(span.width - 1);
+    const __m128i lastY = _mm_set1_epi32(span.height - 1);
+
+    __m256d extentU = _mm256_mul_pd(half, _mm256_add_pd(_mm256_andnot_pd(sign, f.dudx), _mm256_andnot_pd(sign, f.dudy)));
+    __m256d extentV = _mm256_mul_pd(half, _mm256_add_pd(_mm256_andnot_pd(sign, f.dvdx), _mm256_andnot_pd(sign, f.dvdy)));
+    extentU = _mm256_blendv_pd(extentU, maxExtent, _mm256_cmp_pd(maxExtent, extentU, _CMP_LT_OQ));
+    extentV = _mm256_blendv_pd(extentV, maxExtent, _mm256_cmp_pd(maxExtent, extentV, _CMP_LT_OQ));
+
+    __m256d left = _mm256_add_pd(_mm256_sub_pd(f.u, extentU), half);
+    __m256d top = _mm256_add_pd(_mm256_sub_pd(f.v, extentV), half);
+    left = _mm256_and_pd(_mm256_blendv_pd(left, zero, _mm256_cmp_pd(left, zero, _CMP_LT_OQ)), inBox);
+    top = _mm256_and_pd(_mm256_blendv_pd(top, zero, _mm256_cmp_pd(top, zero, _CMP_LT_OQ)), inBox);
+    __m128i x0 = _mm_min_epi32(_mm256_cvttpd_epi32(left), lastX);
+    __m128i y0 = _mm_min_epi32(_mm256_cvttpd_epi32(top), lastY);
+
+    // Right and bottom edges round up unless they are whole
+    const __m256d right = _mm256_and_pd(_mm256_sub_pd(_mm256_add_pd(f.u, extentU), half), inBox);
+    const __m256d bottom = _mm256_and_pd(_mm256_sub_pd(_mm256_add_pd(f.v, extentV), half), inBox);
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256d x1 = _mm256_cvtepi32_pd(_mm256_cvttpd_epi32(right));
+    __m256d y1 = _mm256_cvtepi32_pd(_mm256_cvttpd_epi32(bottom));
+    x1 = _mm256_add_pd(x1, _mm256_and_pd(_mm256_cmp_pd(x1, right, _CMP_LT_OQ), one));
+    y1 = _mm256_add_pd(y1, _mm256_and_pd(_mm256_cmp_pd(y1, bottom, _CMP_LT_OQ), one));
+    __m128i x1i = _mm_min_epi32(_mm_max_epi32(_mm256_cvttpd_epi32(x1), x0), lastX);
+    __m128i y1i = _mm_min_epi32(_mm_max_epi32(_mm256_cvttpd_epi32(y1), y0), lastY);
+
+    AreaBox box;
+    const __m128i stride = _mm_set1_epi32(span.width + 1);
+    const __m128i three = _mm_set1_epi32(3);
+    const __m128i next = _mm_set1_epi32(1);
+    __m128i rowTop = _mm_mullo_epi32(y0, stride);
+    __m128i rowBottom = _mm_mullo_epi32(_mm_add_epi32(y1i, next), stride);
+    __m128i right1 = _mm_add_epi32(x1i, next);
+    box.topLeft = _mm_mullo_epi32(_mm_add_epi32(rowTop, x0), three);
+    box.topRight = _mm_mullo_epi32(_mm_add_epi32(rowTop, right1), three);
+    box.bottomLeft = _mm_mullo_epi32(_mm_add_epi32(rowBottom, x0), three);
+    box.bottomRight = _mm_mullo_epi32(_mm_add_epi32(rowBottom, right1), three);
+    __m256d columns = _mm256_cvtepi32_pd(_mm_sub_epi32(right1, x0));
+    __m256d rows = _mm256_cvtepi32_pd(_mm_sub_epi32(_mm_add_epi32(y1i, next), y0));
+    box.scale = _mm256_div_pd(one, _mm256_mul_pd(columns, rows));
+    return box;
+}
+
+// One channel of 4 box averages, rounded to nearest
+static inline __m128i boxAverage(__m128i sum, __m256d scale) {
+    // Sums are unsigned: flip the sign bit and add it back as 2^31
+    const __m256d signBit = _mm256_set1_pd(2147483648.0);
+    __m256d value = _mm256_add_pd(
+        _mm256_cvtepi32_pd(_mm_xor_si128(sum, _mm_set1_epi32(static_cast<int>(0x80000000u)))), signBit);
+    return _mm256_cvttpd_epi32(_mm256_add_pd(_mm256_mul_pd(value, scale), _mm256_set1_pd(0.5)));
+}
+
+void sampleSpanAreaAVX2(const TextureSpan& span) {
+    if (!span.summedArea) {
+        sampleSpanTrilinearAVX2(span);
+        return;
+    }
+    // Table offsets are gathered as 32-bit indices
+    if (3 * (static_cast<int64_t>(span.width) + 1) * (static_cast<int64_t>(span.height) + 1) > 0x7FFFFFFF) {
+        sampleSpanArea(span, 0);
+        return;
+    }
+    const int* table = reinterpret_cast<const int*>(span.summedArea);
+    const __m256i fallback = _mm256_set1_epi32(static_cast<int>(span.fallback));
+
+    int i = 0;
+    for (; i + 8 <= span.count; i += 8) {
+        __m256d fxLo = _mm256_add_pd(_mm256_set1_pd(static_cast<double>(span.x0 + i)), _mm256_setr_pd(0, 1, 2, 3));
+        __m256d fxHi = _mm256_add_pd(fxLo, _mm256_set1_pd(4.0));
+        Footprint lo = footprint(span, fxLo);
+        Footprint hi = footprint(span, fxHi);
+        __m256d inBoxLo = _mm256_and_pd(lo.minified, lo.valid);
+        __m256d inBoxHi = _mm256_and_pd(hi.minified, hi.valid);
+        __m256i inBox = narrowMask(inBoxLo, inBoxHi);
+
+        // Magnified pixels stay bit-identical to the bilinear kernel
+        __m256i color = _mm256_setzero_si256();
+        if (_mm256_movemask_ps(_mm256_castsi256_ps(inBox)) != 0xFF) {
+            color = sampleBase(span, lo, hi);
+        }
+        if (!_mm256_testz_si256(inBox, inBox)) {
+            AreaBox boxLo = areaBox(span, lo, inBoxLo);
+            AreaBox boxHi = areaBox(span, hi, inBoxHi);
+            __m256i topLeft = _mm256_set_m128i(boxHi.topLeft, boxLo.topLeft);
+            __m256i topRight = _mm256_set_m128i(boxHi.topRight, boxLo.topRight);
+            __m256i bottomLeft = _mm256_set_m128i(boxHi.bottomLeft, boxLo.bottomLeft);
+            __m256i bottomRight = _mm256_set_m128i(boxHi.bottomRight, boxLo.bottomRight);
+            __m256i area = _mm256_setzero_si256();
+            for (int c = 0; c < 3; c++) {
+                const int* channel = table + c;
+                __m256i sum = _mm256_add_epi32(
+                    _mm256_sub_epi32(_mm256_i32gather_epi32(channel, bottomRight, 4), _mm256_i32gather_epi32(channel, topRight, 4)),
+                    _mm256_sub_epi32(_mm256_i32gather_epi32(channel, topLeft, 4), _mm256_i32gather_epi32(channel, bottomLeft, 4)));
+                __m256i average = _mm256_set_m128i(
+                    boxAverage(_mm256_extracti128_si256(sum, 1), boxHi.scale),
+                    boxAverage(_mm256_castsi256_si128(sum), boxLo.scale));
+                area = _mm256_or_si256(area, _mm256_slli_epi32(average, 8 * c));
+            }
+            color = _mm256_blendv_epi8(color, area, inBox);
+        }
+        color = _mm256_blendv_epi8(fallback, color, narrowMask(lo.valid, hi.valid));
+        storePixels(span, i, color);
+    }
+
+    sampleSpanArea(span, i);
+}
@@ -0,0 +1,457 @@
+// Compiled with AVX-512 code generation; only called after a CPU check
+#include "SamplerKernels.hpp"
+// GCC 12 flags the placeholder registers of its own AVX-512 intrinsics as uninitialized
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// Bilinear blend of one 8-bit channel in 16.16 fixed point (see sampleSpanScalar)
+static inline __m512i blendChannel(__m512i t00, __m512i t10, __m512i t01, __m512i t11, int shift,
+    __m512i fx, __m512i fxInv, __m512i fy, __m512i fyInv) {
+    const __m512i byteMask = _mm512_set1_epi32(0xFF);
+    const __m512i half = _mm512_set1_epi32(128);
+    __m512i c00 = _mm512_and_si512(_mm512_srli_epi32(t00, shift), byteMask);
+    __m512i c10 = _mm512_and_si512(_mm512_srli_epi32(t10, shift), byteMask);
+    __m512i c01 = _mm512_and_si512(_mm512_srli_epi32(t01, shift), byteMask);
+    __m512i c11 = _mm512_and_si512(_mm512_srli_epi32(t11, shift), byteMask);
+
+    __m512i top = _mm512_add_epi32(_mm512_mullo_epi32(c00, fxInv), _mm512_mullo_epi32(c10, fx));
+    __m512i bottom = _mm512_add_epi32(_mm512_mullo_epi32(c01, fxInv), _mm512_mullo_epi32(c11, fx));
+    top = _mm512_srli_epi32(_mm512_add_epi32(top, half), 8);
+    bottom = _mm512_srli_epi32(_mm512_add_epi32(bottom, half), 8);
+
+    __m512i value = _mm512_add_epi32(_mm512_mullo_epi32(top, fyInv), _mm512_mullo_epi32(bottom, fy));
+    return _mm512_slli_epi32(_mm512_srli_epi32(value, 24), shift);
+}
+
+// Texture coordinates of 8 consecutive pixels, zeroed where the sample misses the texture,
+// and 1 / w (1 where w is too close to zero to divide by)
+static inline __mmask8 texcoords(const TextureSpan& span, __m512d fx, __m512d& u, __m512d& v, __m512d& invW) {
+    __m512d uw = _mm512_add_pd(_mm512_mul_pd(_mm512_set1_pd(span.dUW), fx), _mm512_set1_pd(span.rowUW));
+    __m512d vw = _mm512_add_pd(_mm512_mul_pd(_mm512_set1_pd(span.dVW), fx), _mm512_set1_pd(span.rowVW));
+    __m512d w = _mm512_add_pd(_mm512_mul_pd(_mm512_set1_pd(span.dW), fx), _mm512_set1_pd(span.rowW));
+
+    // Perspective divide unless w is (nearly) zero
+    __mmask8 divide = _mm512_cmp_pd_mask(_mm512_abs_pd(w), _mm512_set1_pd(1e-8), _CMP_GT_OQ);
+    invW = _mm512_mask_div_pd(_mm512_set1_pd(1.0), divide, _mm512_set1_pd(1.0), w);
+    u = _mm512_mask_mul_pd(uw, divide, uw, invW);
+    v = _mm512_mask_mul_pd(vw, divide, vw, invW);
+
+    const __m512d zero = _mm512_setzero_pd();
+    __mmask8 valid = _mm512_cmp_pd_mask(u, zero, _CMP_GE_OQ) &
+        _mm512_cmp_pd_mask(u, _mm512_set1_pd(span.width), _CMP_LT_OQ) &
+        _mm512_cmp_pd_mask(v, zero, _CMP_GE_OQ) &
+        _mm512_cmp_pd_mask(v, _mm512_set1_pd(span.height), _CMP_LT_OQ);
+    u = _mm512_maskz_mov_pd(valid, u);
+    v = _mm512_maskz_mov_pd(valid, v);
+    return valid;
+}
+
+// Offsets of the four bilinear taps from texel (0, 0) in a level's layout
+static inline void tapOffsets(int levelStride, bool tiled, __m512i x, __m512i y,
+    __m512i& o00, __m512i& o10, __m512i& o01, __m512i& o11) {
+    const __m512i stride = _mm512_set1_epi32(levelStride);
+    const __m512i one = _mm512_set1_epi32(1);
+    if (!tiled) {
+        o00 = _mm512_add_epi32(_mm512_mullo_epi32(y, stride), x);
+        o10 = _mm512_add_epi32(o00, one);
+        o01 = _mm512_add_epi32(o00, stride);
+        o11 = _mm512_add_epi32(o01, one);
+        return;
+    }
+
+    const __m512i inTile = _mm512_set1_epi32(TEXTURE_TILE_SIZE - 1);
+    __m512i x1 = _mm512_add_epi32(x, one);
+    __m512i y1 = _mm512_add_epi32(y, one);
+    __m512i col0 = _mm512_add_epi32(
+        _mm512_slli_epi32(_mm512_srai_epi32(x, TEXTURE_TILE_SHIFT), 2 * TEXTURE_TILE_SHIFT), _mm512_and_si512(x, inTile));
+    __m512i col1 = _mm512_add_epi32(
+        _mm512_slli_epi32(_mm512_srai_epi32(x1, TEXTURE_TILE_SHIFT), 2 * TEXTURE_TILE_SHIFT), _mm512_and_si512(x1, inTile));
+    __m512i row0 = _mm512_add_epi32(
+        _mm512_mullo_epi32(_mm512_srai_epi32(y, TEXTURE_TILE_SHIFT), stride),
+        _mm512_slli_epi32(_mm512_and_si512(y, inTile), TEXTURE_TILE_SHIFT));
+    __m512i row1 = _mm512_add_epi32(
+        _mm512_mullo_epi32(_mm512_srai_epi32(y1, TEXTURE_TILE_SHIFT), stride),
+        _mm512_slli_epi32(_mm512_and_si512(y1, inTile), TEXTURE_TILE_SHIFT));
+    o00 = _mm512_add_epi32(row0, col0);
+    o10 = _mm512_add_epi32(row0, col1);
+    o01 = _mm512_add_epi32(row1, col0);
+    o11 = _mm512_add_epi32(row1, col1);
+}
+
+// Write 16 packed colors as RGB bytes from pixel i of the span
+static inline void storePixels(const TextureSpan& span, int i, __m512i color) {
+    // Packing 16 texels into 48 RGB bytes: drop alpha within each 128-bit lane,
+    // then move the lanes' 12-byte runs together
+    const __m512i dropAlpha = _mm512_broadcast_i32x4(
+        _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1));
+    const __m512i joinLanes = _mm512_setr_epi32(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 0, 0, 0, 0);
+    __m512i rgb = _mm512_permutexvar_epi32(joinLanes, _mm512_shuffle_epi8(color, dropAlpha));
+    _mm512_mask_storeu_epi32(span.out + 3 * i, 0x0FFF, rgb);
+}
+
+// Join two 8-lane halves into 16 lanes
+static inline __m512i join(__m256i lo, __m256i hi) {
+    return _mm512_inserti64x4(_mm512_castsi256_si512(lo), hi, 1);
+}
+
+void sampleSpanAVX512(const TextureSpan& span) {
+    const __m512d fixedScale = _mm512_set1_pd(65536.0);
+    const __m512i fracMask = _mm512_set1_epi32(0xFFFF);
+    const __m512i one = _mm512_set1_epi32(65536);
+    const __m512i fallback = _mm512_set1_epi32(static_cast<int>(span.fallback));
+    const int* texels = reinterpret_cast<const int*>(span.texels);
+
+    int i = 0;
+    for (; i + 16 <= span.count; i += 16) {
+        __m512d fxLo = _mm512_add_pd(_mm512_set1_pd(static_cast<double>(span.x0 + i)),
+            _mm512_setr_pd(0, 1, 2, 3, 4, 5, 6, 7));
+        __m512d fxHi = _mm512_add_pd(fxLo, _mm512_set1_pd(8.0));
+
+        __m512d uLo, vLo, invWLo, uHi, vHi, invWHi;
+        __mmask8 validLo = texcoords(span, fxLo, uLo, vLo, invWLo);
+        __mmask8 validHi = texcoords(span, fxHi, uHi, vHi, invWHi);
+
+        // 16.16 fixed-point texel coordinates
+        __m512i u = join(_mm512_cvttpd_epi32(_mm512_mul_pd(uLo, fixedScale)), _mm512_cvttpd_epi32(_mm512_mul_pd(uHi, fixedScale)));
+        __m512i v = join(_mm512_cvttpd_epi32(_mm512_mul_pd(vLo, fixedScale)), _mm512_cvttpd_epi32(_mm512_mul_pd(vHi, fixedScale)));
+
+        __m512i fx = _mm512_and_si512(u, fracMask);
+        __m512i fy = _mm512_and_si512(v, fracMask);
+        __m512i fxInv = _mm512_sub_epi32(one, fx);
+        __m512i fyInv = _mm512_sub_epi32(one, fy);
+
+        __m512i o00, o10, o01, o11;
+        tapOffsets(span.stride, span.tiled, _mm512_srai_epi32(u, 16), _mm512_srai_epi32(v, 16), o00, o10, o01, o11);
+        __m512i t00 = _mm512_i32gather_epi32(o00, texels, 4);
+        __m512i t10 = _mm512_i32gather_epi32(o10, texels, 4);
+        __m512i t01 = _mm512_i32gather_epi32(o01, texels, 4);
+        __m512i t11 = _mm512_i32gather_epi32(o11, texels, 4);
+
+        __m512i color = _mm512_or_si512(
+            _mm512_or_si512(
+                blendChannel(t00, t10, t01, t11, 0, fx, fxInv, fy, fyInv),
+                blendChannel(t00, t10, t01, t11, 8, fx, fxInv, fy, fyInv)),
+            blendChannel(t00, t10, t01, t11, 16, fx, fxInv, fy, fyInv));
+        const __mmask16 valid = static_cast<__mmask16>(validLo | (static_cast<unsigned>(validHi) << 8));
+        color = _mm512_mask_blend_epi32(valid, fallback, color);
+        storePixels(span, i, color);
+    }
+
+    sampleSpanScalar(span, i);
+}
+
+// Texture coordinates and screen-space derivatives of 8 consecutive pixels, and
+// the squared length of their longer screen-axis footprint (see trilinearPixel)
+struct Footprint {
+    __m512d u, v;
+    __m512d dudx, dvdx, dudy, dvdy;
+    __m512d squared;
+    __mmask8 valid;
+    __mmask8 minified;  // Lanes whose footprint is longer than one texel
+};
+
+static inline Footprint footprint(const TextureSpan& span, __m512d fx) {
+    Footprint f;
+    __m512d invW;
+    f.valid = texcoords(span, fx, f.u, f.v, invW);
+    const __m512d dW = _mm512_set1_pd(span.dW);
+    const __m512d dWdy = _mm512_set1_pd(span.dWdy);
+    f.dudx = _mm512_mul_pd(_mm512_sub_pd(_mm512_set1_pd(span.dUW), _mm512_mul_pd(f.u, dW)), invW);
+    f.dvdx = _mm512_mul_pd(_mm512_sub_pd(_mm512_set1_pd(span.dVW), _mm512_mul_pd(f.v, dW)), invW);
+    f.dudy = _mm512_mul_pd(_mm512_sub_pd(_mm512_set1_pd(span.dUWdy), _mm512_mul_pd(f.u, dWdy)), invW);
+    f.dvdy = _mm512_mul_pd(_mm512_sub_pd(_mm512_set1_pd(span.dVWdy), _mm512_mul_pd(f.v, dWdy)), invW);
+    __m512d alongX = _mm512_add_pd(_mm512_mul_pd(f.dudx, f.dudx), _mm512_mul_pd(f.dvdx, f.dvdx));
+    __m512d alongY = _mm512_add_pd(_mm512_mul_pd(f.dudy, f.dudy), _mm512_mul_pd(f.dvdy, f.dvdy));
+    // std::max keeps its first argument unless it is less than the second
+    f.squared = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(alongX, alongY, _CMP_LT_OQ), alongX, alongY);
+    f.minified = _mm512_cmp_pd_mask(f.squared, _mm512_set1_pd(1.0), _CMP_GT_OQ);
+    return f;
+}
+
+// (c + 0.5) * scale - 0.5 clamped to [0, last], compared in the order of
+// std::max and std::min so that the portable kernel's results carry over
+static inline __m512d mipCoordinate(__m512d c, __m512d scale, __m512d last) {
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512d zero = _mm512_setzero_pd();
+    __m512d m = _mm512_sub_pd(_mm512_mul_pd(_mm512_add_pd(c, half), scale), half);
+    m = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(m, zero, _CMP_LT_OQ), m, zero);
+    return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(last, m, _CMP_LT_OQ), m, last);
+}
+
+// Mip levels of 8 consecutive pixels: the finer level, the 8-bit weight of the
+// coarser one, and 16.16 coordinates on both. Magnified pixels sample the base
+// level at their own coordinates with zero weight.
+struct LevelSelection {
+    __m256i fine, coarse, weight;
+    __m256i fineU, fineV, coarseU, coarseV;
+};
+
+static inline LevelSelection selectLevels(const TextureSpan& span, const Footprint& f,
+    const double* lastU, const double* lastV) {
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d fixedScale = _mm512_set1_pd(65536.0);
+    const __m256i lastLevel = _mm256_set1_epi32(span.levelCount - 1);
+
+    // log2 from the exponent and a linear mantissa; adding 2^52 to the exponent
+    // as an integer makes a double that is exactly 2^52 + exponent
+    const __m512d exponentBias = _mm512_set1_pd(4503599627370496.0);
+    __m512i bits = _mm512_castpd_si512(f.squared);
+    __m512i exponent = _mm512_sub_epi64(_mm512_srli_epi64(bits, 52), _mm512_set1_epi64(1023));
+    __m512d exponentValue = _mm512_sub_pd(
+        _mm512_castsi512_pd(_mm512_add_epi64(exponent, _mm512_castpd_si512(exponentBias))), exponentBias);
+    __m512d mantissa = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(
+        _mm512_and_si512(bits, _mm512_set1_epi64(0xFFFFFFFFFFFFFll)), _mm512_castpd_si512(one))), one);
+    __m512d lod = _mm512_maskz_mul_pd(f.minified, _mm512_set1_pd(0.5), _mm512_add_pd(exponentValue, mantissa));
+
+    LevelSelection s;
+    s.fine = _mm256_min_epi32(_mm512_cvttpd_epi32(lod), lastLevel);
+    s.coarse = _mm256_min_epi32(_mm256_add_epi32(s.fine, _mm256_set1_epi32(1)), lastLevel);
+    __m512d fraction = _mm512_mul_pd(_mm512_sub_pd(lod, _mm512_cvtepi32_pd(s.fine)), _mm512_set1_pd(256.0));
+    s.weight = _mm256_andnot_si256(_mm256_cmpeq_epi32(s.fine, lastLevel), _mm512_cvttpd_epi32(fraction));
+
+    // 2^-level, built from its exponent
+    __m512d scale = _mm512_castsi512_pd(_mm512_slli_epi64(
+        _mm512_sub_epi64(_mm512_set1_epi64(1023), _mm512_cvtepi32_epi64(s.fine)), 52));
+    __m512d fineU = mipCoordinate(f.u, scale, _mm512_i32gather_pd(s.fine, lastU, 8));
+    __m512d fineV = mipCoordinate(f.v, scale, _mm512_i32gather_pd(s.fine, lastV, 8));
+    scale = _mm512_mul_pd(scale, _mm512_set1_pd(0.5));
+    __m512d coarseU = mipCoordinate(f.u, scale, _mm512_i32gather_pd(s.coarse, lastU, 8));
+    __m512d coarseV = mipCoordinate(f.v, scale, _mm512_i32gather_pd(s.coarse, lastV, 8));
+    fineU = _mm512_mask_blend_pd(f.minified, f.u, fineU);
+    fineV = _mm512_mask_blend_pd(f.minified, f.v, fineV);
+
+    s.fineU = _mm512_cvttpd_epi32(_mm512_mul_pd(fineU, fixedScale));
+    s.fineV = _mm512_cvttpd_epi32(_mm512_mul_pd(fineV, fixedScale));
+    s.coarseU = _mm512_cvttpd_epi32(_mm512_mul_pd(coarseU, fixedScale));
+    s.coarseV = _mm512_cvttpd_epi32(_mm512_mul_pd(coarseV, fixedScale));
+    return s;
+}
+
+// Bilinear samples of 16 pixels at 16.16 coordinates, each on its own mip level:
+// one masked gather per distinct level
+static inline __m512i sampleLevels(const MipLevel* levels, __m512i level, __m512i u, __m512i v) {
+    const __m512i fracMask = _mm512_set1_epi32(0xFFFF);
+    const __m512i one = _mm512_set1_epi32(65536);
+    __m512i fx = _mm512_and_si512(u, fracMask);
+    __m512i fy = _mm512_and_si512(v, fracMask);
+    __m512i fxInv = _mm512_sub_epi32(one, fx);
+    __m512i fyInv = _mm512_sub_epi32(one, fy);
+    __m512i x = _mm512_srai_epi32(u, 16);
+    __m512i y = _mm512_srai_epi32(v, 16);
+
+    alignas(64) int lanes[16];
+    _mm512_store_si512(lanes, level);
+    __m512i t00 = _mm512_setzero_si512();
+    __m512i t10 = t00, t01 = t00, t11 = t00;
+    for (unsigned pending = 0xFFFF; pending; ) {
+        int k = 0;
+        while (!(pending & (1u << k))) {
+            k++;
+        }
+        const MipLevel& mip = levels[lanes[k]];
+        __mmask16 onLevel = _mm512_cmpeq_epi32_mask(level, _mm512_set1_epi32(lanes[k]));
+        __m512i o00, o10, o01, o11;
+        tapOffsets(mip.stride, mip.tiled, x, y, o00, o10, o01, o11);
+        const int* texels = reinterpret_cast<const int*>(mip.texels);
+        t00 = _mm512_mask_i32gather_epi32(t00, onLevel, o00, texels, 4);
+        t10 = _mm512_mask_i32gather_epi32(t10, onLevel, o10, texels, 4);
+        t01 = _mm512_mask_i32gather_epi32(t01, onLevel, o01, texels, 4);
+        t11 = _mm512_mask_i32gather_epi32(t11, onLevel, o11, texels, 4);
+        pending &= ~static_cast<unsigned>(onLevel);
+    }
+
+    return _mm512_or_si512(
+        _mm512_or_si512(
+            blendChannel(t00, t10, t01, t11, 0, fx, fxInv, fy, fyInv),
+            blendChannel(t00, t10, t01, t11, 8, fx, fxInv, fy, fyInv)),
+        blendChannel(t00, t10, t01, t11, 16, fx, fxInv, fy, fyInv));
+}
+
+// Per-channel blend of two packed colors by the 8-bit weight of the second
+static inline __m512i blendColors(__m512i fine, __m512i coarse, __m512i weight) {
+    const __m512i byteMask = _mm512_set1_epi32(0xFF);
+    const __m512i half = _mm512_set1_epi32(128);
+    const __m512i inverse = _mm512_sub_epi32(_mm512_set1_epi32(256), weight);
+    __m512i color = _mm512_setzero_si512();
+    for (int shift = 0; shift < 24; shift += 8) {
+        __m512i f = _mm512_and_si512(_mm512_srli_epi32(fine, shift), byteMask);
+        __m512i c = _mm512_and_si512(_mm512_srli_epi32(coarse, shift), byteMask);
+        __m512i value = _mm512_add_epi32(_mm512_mullo_epi32(f, inverse), _mm512_mullo_epi32(c, weight));
+        color = _mm512_or_si512(color, _mm512_slli_epi32(_mm512_srli_epi32(_mm512_add_epi32(value, half), 8), shift));
+    }
+    return color;
+}
+
+// Base-level bilinear samples of 16 pixels at double texture coordinates
+static inline __m512i sampleBase(const TextureSpan& span, const Footprint& lo, const Footprint& hi) {
+    const __m512d fixedScale = _mm512_set1_pd(65536.0);
+    __m512i u = join(_mm512_cvttpd_epi32(_mm512_mul_pd(lo.u, fixedScale)), _mm512_cvttpd_epi32(_mm512_mul_pd(hi.u, fixedScale)));
+    __m512i v = join(_mm512_cvttpd_epi32(_mm512_mul_pd(lo.v, fixedScale)), _mm512_cvttpd_epi32(_mm512_mul_pd(hi.v, fixedScale)));
+    return sampleLevels(span.levels, _mm512_setzero_si512(), u, v);
+}
+
+void sampleSpanTrilinearAVX512(const TextureSpan& span) {
+    if (span.levelCount > MAX_VECTOR_LEVELS) {
+        sampleSpanTrilinear(span, 0);
+        return;
+    }
+
+    // Mip coordinates are clamped to the last texel centre of their level
+    double lastU[MAX_VECTOR_LEVELS];
+    double lastV[MAX_VECTOR_LEVELS];
+    for (int k = 0; k < span.levelCount; k++) {
+        lastU[k] = span.levels[k].width - 1.0;
+        lastV[k] = span.levels[k].height - 1.0;
+    }
+    const __m512i fallback = _mm512_set1_epi32(static_cast<int>(span.fallback));
+
+    int i = 0;
+    for (; i + 16 <= span.count; i += 16) {
+        __m512d fxLo = _mm512_add_pd(_mm512_set1_pd(static_cast<double>(span.x0 + i)),
+            _mm512_setr_pd(0, 1, 2, 3, 4, 5, 6, 7));
+        __m512d fxHi = _mm512_add_pd(fxLo, _mm512_set1_pd(8.0));
+        Footprint lo = footprint(span, fxLo);
+        Footprint hi = footprint(span, fxHi);
+        LevelSelection levelsLo = selectLevels(span, lo, lastU, lastV);
+        LevelSelection levelsHi = selectLevels(span, hi, lastU, lastV);
+
+        __m512i color = sampleLevels(span.levels, join(levelsLo.fine, levelsHi.fine),
+            join(levelsLo.fineU, levelsHi.fineU), join(levelsLo.fineV, levelsHi.fineV));
+        __m512i weight = join(levelsLo.weight, levelsHi.weight);
+        if (_mm512_test_epi32_mask(weight, weight)) {
+            __m512i coarse = sampleLevels(span.levels, join(levelsLo.coarse, levelsHi.coarse),
+                join(levelsLo.coarseU, levelsHi.coarseU), join(levelsLo.coarseV, levelsHi.coarseV));
+            color = blendColors(color, coarse, weight);
+        }
+        const __mmask16 valid = static_cast<__mmask16>(lo.valid | (static_cast<unsigned>(hi.valid) << 8));
+        color = _mm512_mask_blend_epi32(valid, fallback, color);
+        storePixels(span, i, color);
+    }
+
+    sampleSpanTrilinear(span, i);
+}
+
+// Summed-area box of 8 consecutive minified pixels (see areaPixel): the table
+// offsets of its corners and the reciprocal of its texel count. Lanes outside
+// the mask get the box of texel (0, 0).
+struct AreaBox {
+    __m256i topLeft, topRight, bottomLeft, bottomRight;
+    __m512d scale;
+};
+
+static inline AreaBox areaBox(const TextureSpan& span, const Footprint& f, __mmask8 inBox) {
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512d maxExtent = _mm512_set1_pd(MAX_AREA_EXTENT);
+    const __m256i lastX = _mm256_set1_epi32(span.width - 1);
+    const __m256i lastY = _mm256_set1_epi32(span.height - 1);
+
+    __m512d extentU = _mm512_mul_pd(half, _mm512_add_pd(_mm512_abs_pd(f.dudx), _mm512_abs_pd(f.dudy)));
+    __m512d extentV = _mm512_mul_pd(half, _mm512_add_pd(_mm512_abs_pd(f.dvdx), _mm512_abs_pd(f.dvdy)));
+    extentU = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(maxExtent, extentU, _CMP_LT_OQ), extentU, maxExtent);
+    extentV = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(maxExtent, extentV, _CMP_LT_OQ), extentV, maxExtent);
+
+    __m512d left = _mm512_add_pd(_mm512_sub_pd(f.u, extentU), half);
+    __m512d top = _mm512_add_pd(_mm512_sub_pd(f.v, extentV), half);
+    left = _mm512_maskz_mov_pd(inBox, _mm512_mask_blend_pd(_mm512_cmp_pd_mask(left, zero, _CMP_LT_OQ), left, zero));
+    top = _mm512_maskz_mov_pd(inBox, _mm512_mask_blend_pd(_mm512_cmp_pd_mask(top, zero, _CMP_LT_OQ), top, zero));
+    __m256i x0 = _mm256_min_epi32(_mm512_cvttpd_epi32(left), lastX);
+    __m256i y0 = _mm256_min_epi32(_mm512_cvttpd_epi32(top), lastY);
+
+    // Right and bottom edges round up unless they are whole
+    const __m512d right = _mm512_maskz_mov_pd(inBox, _mm512_sub_pd(_mm512_add_pd(f.u, extentU), half));
+    const __m512d bottom = _mm512_maskz_mov_pd(inBox, _mm512_sub_pd(_mm512_add_pd(f.v, extentV), half));
+    const __m512d one = _mm512_set1_pd(1.0);
+    __m512d x1 = _mm512_cvtepi32_pd(_mm512_cvttpd_epi32(right));
+    __m512d y1 = _mm512_cvtepi32_pd(_mm512_cvttpd_epi32(bottom));
+    x1 = _mm512_mask_add_pd(x1, _mm512_cmp_pd_mask(x1, right, _CMP_LT_OQ), x1, one);
+    y1 = _mm512_mask_add_pd(y1, _mm512_cmp_pd_mask(y1, bottom, _CMP_LT_OQ), y1, one);
+    __m256i x1i = _mm256_min_epi32(_mm256_max_epi32(_mm512_cvttpd_epi32(x1), x0), lastX);
+    __m256i y1i = _mm256_min_epi32(_mm256_max_epi32(_mm512_cvttpd_epi32(y1), y0), lastY);
+
+    AreaBox box;
+    const __m256i stride = _mm256_set1_epi32(span.width + 1);
+    const __m256i three = _mm256_set1_epi32(3);
+    const __m256i next = _mm256_set1_epi32(1);
+    __m256i rowTop = _mm256_mullo_epi32(y0, stride);
+    __m256i rowBottom = _mm256_mullo_epi32(_mm256_add_epi32(y1i, next), stride);
+    __m256i right1 = _mm256_add_epi32(x1i, next);
+    box.topLeft = _mm256_mullo_epi32(_mm256_add_epi32(rowTop, x0), three);
+    box.topRight = _mm256_mullo_epi32(_mm256_add_epi32(rowTop, right1), three);
+    box.bottomLeft = _mm256_mullo_epi32(_mm256_add_epi32(rowBottom, x0), three);
+    box.bottomRight = _mm256_mullo_epi32(_mm256_add_epi32(rowBottom, right1), three);
+    __m512d columns = _mm512_cvtepi32_pd(_mm256_sub_epi32(right1, x0));
+    __m512d rows = _mm512_cvtepi32_pd(_mm256_sub_epi32(_mm256_add_epi32(y1i, next), y0));
+    box.scale = _mm512_div_pd(one, _mm512_mul_pd(columns, rows));
+    return box;
+}
+
+// One channel of 8 box averages, rounded to nearest
+static inline __m256i boxAverage(__m256i sum, __m512d scale) {
+    __m512d value = _mm512_cvtepu32_pd(sum);
+    return _mm512_cvttpd_epi32(_mm512_add_pd(_mm512_mul_pd(value, scale), _mm512_set1_pd(0.5)));
+}
+
+void sampleSpanAreaAVX512(const TextureSpan& span) {
+    if (!span.summedArea) {
+        sampleSpanTrilinearAVX512(span);
+        return;
+    }
+    // Table offsets are gathered as 32-bit indices
+    if (3 * (static_cast<int64_t>(span.width) + 1) * (static_cast<int64_t>(span.height) + 1) > 0x7FFFFFFF) {
+        sampleSpanArea(span, 0);
+        return;
+    }
+    const int* table = reinterpret_cast<const int*>(span.summedArea);
+    const __m512i fallback = _mm512_set1_epi32(static_cast<int>(span.fallback));
+
+    int i = 0;
+    for (; i + 16 <= span.count; i += 16) {
+        __m512d fxLo = _mm512_add_pd(_mm512_set1_pd(static_cast<double>(span.x0 + i)),
+            _mm512_setr_pd(0, 1, 2, 3, 4, 5, 6, 7));
+        __m512d fxHi = _mm512_add_pd(fxLo, _mm512_set1_pd(8.0));
+        Footprint lo = footprint(span, fxLo);
+        Footprint hi = footprint(span, fxHi);
+        const __mmask8 inBoxLo = lo.minified & lo.valid;
+        const __mmask8 inBoxHi = hi.minified & hi.valid;
+        const __mmask16 inBox = static_cast<__mmask16>(inBoxLo | (static_cast<unsigned>(inBoxHi) << 8));
+
+        // Magnified pixels stay bit-identical to the bilinear kernel
+        __m512i color = _mm512_setzero_si512();
+        if (inBox != 0xFFFF) {
+            color = sampleBase(span, lo, hi);
+        }
+        if (inBox) {
+            AreaBox boxLo = areaBox(span, lo, inBoxLo);
+            AreaBox boxHi = areaBox(span, hi, inBoxHi);
+            __m512i topLeft = join(boxLo.topLeft, boxHi.topLeft);
+            __m512i topRight = join(boxLo.topRight, boxHi.topRight);
+            __m512i bottomLeft = join(boxLo.bottomLeft, boxHi.bottomLeft);
+            __m512i bottomRight = join(boxLo.bottomRight, boxHi.bottomRight);
+            __m512i area = _mm512_setzero_si512();
+            for (int c = 0; c < 3; c++) {
+                const int* channel = table + c;
+                __m512i sum = _mm512_add_epi32(
+                    _mm512_sub_epi32(_mm512_i32gather_epi32(bottomRight, channel, 4), _mm512_i32gather_epi32(topRight, channel, 4)),
+                    _mm512_sub_epi32(_mm512_i32gather_epi32(topLeft, channel, 4), _mm512_i32gather_epi32(bottomLeft, channel, 4)));
+                __m512i average = join(
+                    boxAverage(_mm512_castsi512_si256(sum), boxLo.scale),
+                    boxAverage(_mm512_extracti64x4_epi64(sum, 1), boxHi.scale));
+                area = _mm512_or_si512(area, _mm512_slli_epi32(average, 8 * c));
+            }
+            color = _mm512_mask_blend_epi32(inBox, color, area);
+        }
+        const __mmask16 valid = static_cast<__mmask16>(lo.valid | (static_cast<unsigned>(hi.valid) << 8));
+        color = _mm512_mask_blend_epi32(valid, fallback, color);
+        storePixels(span, i, color);
+    }
+
+    sampleSpanArea(span, i);
+}
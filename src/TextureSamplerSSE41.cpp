@@ -0,0 +1,137 @@
+// Compiled with SSE4.1 code generation; only called after a CPU check
+#include "SamplerKernels.hpp"
+#include <smmintrin.h>
+
+// Bilinear blend of one 8-bit channel in 16.16 fixed point (see sampleSpanScalar)
+static inline __m128i blendChannel(__m128i t00, __m128i t10, __m128i t01, __m128i t11, int shift,
+    __m128i fx, __m128i fxInv, __m128i fy, __m128i fyInv) {
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    const __m128i half = _mm_set1_epi32(128);
+    __m128i c00 = _mm_and_si128(_mm_srli_epi32(t00, shift), byteMask);
+    __m128i c10 = _mm_and_si128(_mm_srli_epi32(t10, shift), byteMask);
+    __m128i c01 = _mm_and_si128(_mm_srli_epi32(t01, shift), byteMask);
+    __m128i c11 = _mm_and_si128(_mm_srli_epi32(t11, shift), byteMask);
+
+    __m128i top = _mm_add_epi32(_mm_mullo_epi32(c00, fxInv), _mm_mullo_epi32(c10, fx));
+    __m128i bottom = _mm_add_epi32(_mm_mullo_epi32(c01, fxInv), _mm_mullo_epi32(c11, fx));
+    top = _mm_srli_epi32(_mm_add_epi32(top, half), 8);
+    bottom = _mm_srli_epi32(_mm_add_epi32(bottom, half), 8);
+
+    __m128i value = _mm_add_epi32(_mm_mullo_epi32(top, fyInv), _mm_mullo_epi32(bottom, fy));
+    return _mm_slli_epi32(_mm_srli_epi32(value, 24), shift);
+}
+
+// Texture coordinates of 2 consecutive pixels, zeroed where the sample misses the texture
+static inline void texcoords(const TextureSpan& span, __m128d fx, __m128d& u, __m128d& v, __m128d& valid) {
+    __m128d uw = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(span.dUW), fx), _mm_set1_pd(span.rowUW));
+    __m128d vw = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(span.dVW), fx), _mm_set1_pd(span.rowVW));
+    __m128d w = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(span.dW), fx), _mm_set1_pd(span.rowW));
+
+    // Perspective divide unless w is (nearly) zero
+    __m128d absW = _mm_andnot_pd(_mm_set1_pd(-0.0), w);
+    __m128d divide = _mm_cmpgt_pd(absW, _mm_set1_pd(1e-8));
+    __m128d invW = _mm_div_pd(_mm_set1_pd(1.0), w);
+    u = _mm_blendv_pd(uw, _mm_mul_pd(uw, invW), divide);
+    v = _mm_blendv_pd(vw, _mm_mul_pd(vw, invW), divide);
+
+    const __m128d zero = _mm_setzero_pd();
+    valid = _mm_and_pd(
+        _mm_and_pd(_mm_cmpge_pd(u, zero), _mm_cmplt_pd(u, _mm_set1_pd(span.width))),
+        _mm_and_pd(_mm_cmpge_pd(v, zero), _mm_cmplt_pd(v, _mm_set1_pd(span.height))));
+    u = _mm_and_pd(u, valid);
+    v = _mm_and_pd(v, valid);
+}
+
+// Offsets of the four bilinear taps from texel (0, 0) in the span's layout
+static inline void tapOffsets(const TextureSpan& span, __m128i x, __m128i y,
+    __m128i& o00, __m128i& o10, __m128i& o01, __m128i& o11) {
+    const __m128i stride = _mm_set1_epi32(span.stride);
+    const __m128i one = _mm_set1_epi32(1);
+    if (!span.tiled) {
+        o00 = _mm_add_epi32(_mm_mullo_epi32(y, stride), x);
+        o10 = _mm_add_epi32(o00, one);
+        o01 = _mm_add_epi32(o00, stride);
+        o11 = _mm_add_epi32(o01, one);
+        return;
+    }
+
+    const __m128i inTile = _mm_set1_epi32(TEXTURE_TILE_SIZE - 1);
+    __m128i x1 = _mm_add_epi32(x, one);
+    __m128i y1 = _mm_add_epi32(y, one);
+    __m128i col0 = _mm_add_epi32(
+        _mm_slli_epi32(_mm_srai_epi32(x, TEXTURE_TILE_SHIFT), 2 * TEXTURE_TILE_SHIFT), _mm_and_si128(x, inTile));
+    __m128i col1 = _mm_add_epi32(
+        _mm_slli_epi32(_mm_srai_epi32(x1, TEXTURE_TILE_SHIFT), 2 * TEXTURE_TILE_SHIFT), _mm_and_si128(x1, inTile));
+    __m128i row0 = _mm_add_epi32(
+        _mm_mullo_epi32(_mm_srai_epi32(y, TEXTURE_TILE_SHIFT), stride),
+        _mm_slli_epi32(_mm_and_si128(y, inTile), TEXTURE_TILE_SHIFT));
+    __m128i row1 = _mm_add_epi32(
+        _mm_mullo_epi32(_mm_srai_epi32(y1, TEXTURE_TILE_SHIFT), stride),
+        _mm_slli_epi32(_mm_and_si128(y1, inTile), TEXTURE_TILE_SHIFT));
+    o00 = _mm_add_epi32(row0, col0);
+    o10 = _mm_add_epi32(row0, col1);
+    o01 = _mm_add_epi32(row1, col0);
+    o11 = _mm_add_epi32(row1, col1);
+}
+
+void sampleSpanSSE41(const TextureSpan& span) {
+    const __m128d fixedScale = _mm_set1_pd(65536.0);
+    const __m128i fracMask = _mm_set1_epi32(0xFFFF);
+    const __m128i one = _mm_set1_epi32(65536);
+    const __m128i fallback = _mm_set1_epi32(static_cast<int>(span.fallback));
+    const uint32_t* texels = span.texels;
+
+    int i = 0;
+    for (; i + 4 <= span.count; i += 4) {
+        __m128d fxLo = _mm_add_pd(_mm_set1_pd(static_cast<double>(span.x0 + i)), _mm_setr_pd(0, 1));
+        __m128d fxHi = _mm_add_pd(fxLo, _mm_set1_pd(2.0));
+
+        __m128d uLo, vLo, validLo, uHi, vHi, validHi;
+        texcoords(span, fxLo, uLo, vLo, validLo);
+        texcoords(span, fxHi, uHi, vHi, validHi);
+
+        // 16.16 fixed-point texel coordinates
+        __m128i u = _mm_unpacklo_epi64(
+            _mm_cvttpd_epi32(_mm_mul_pd(uLo, fixedScale)), _mm_cvttpd_epi32(_mm_mul_pd(uHi, fixedScale)));
+        __m128i v = _mm_unpacklo_epi64(
+            _mm_cvttpd_epi32(_mm_mul_pd(vLo, fixedScale)), _mm_cvttpd_epi32(_mm_mul_pd(vHi, fixedScale)));
+        __m128i valid = _mm_castps_si128(_mm_shuffle_ps(
+            _mm_castpd_ps(validLo), _mm_castpd_ps(validHi), _MM_SHUFFLE(2, 0, 2, 0)));
+
+        __m128i fx = _mm_and_si128(u, fracMask);
+        __m128i fy = _mm_and_si128(v, fracMask);
+        __m128i fxInv = _mm_sub_epi32(one, fx);
+        __m128i fyInv = _mm_sub_epi32(one, fy);
+
+        // No gather instruction: fetch the four footprints one pixel at a time
+        alignas(16) int offsets[4][4];
+        __m128i o00, o10, o01, o11;
+        tapOffsets(span, _mm_srai_epi32(u, 16), _mm_srai_epi32(v, 16), o00, o10, o01, o11);
+        _mm_store_si128(reinterpret_cast<__m128i*>(offsets[0]), o00);
+        _mm_store_si128(reinterpret_cast<__m128i*>(offsets[1]), o10);
+        _mm_store_si128(reinterpret_cast<__m128i*>(offsets[2]), o01);
+        _mm_store_si128(reinterpret_cast<__m128i*>(offsets[3]), o11);
+        __m128i t00 = _mm_setr_epi32(texels[offsets[0][0]], texels[offsets[0][1]], texels[offsets[0][2]], texels[offsets[0][3]]);
+        __m128i t10 = _mm_setr_epi32(texels[offsets[1][0]], texels[offsets[1][1]], texels[offsets[1][2]], texels[offsets[1][3]]);
+        __m128i t01 = _mm_setr_epi32(texels[offsets[2][0]], texels[offsets[2][1]], texels[offsets[2][2]], texels[offsets[2][3]]);
+        __m128i t11 = _mm_setr_epi32(texels[offsets[3][0]], texels[offsets[3][1]], texels[offsets[3][2]], texels[offsets[3][3]]);
+
+        __m128i color = _mm_or_si128(
+            _mm_or_si128(
+                blendChannel(t00, t10, t01, t11, 0, fx, fxInv, fy, fyInv),
+                blendChannel(t00, t10, t01, t11, 8, fx, fxInv, fy, fyInv)),
+            blendChannel(t00, t10, t01, t11, 16, fx, fxInv, fy, fyInv));
+        color = _mm_blendv_epi8(fallback, color, valid);
+
+        alignas(16) uint32_t packed[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(packed), color);
+        unsigned char* out = span.out + 3 * i;
+        for (int k = 0; k < 4; k++) {
+            out[3 * k] = static_cast<unsigned char>(packed[k]);
+            out[3 * k + 1] = static_cast<unsigned char>(packed[k] >> 8);
+            out[3 * k + 2] = static_cast<unsigned char>(packed[k] >> 16);
+        }
+    }
+
+    sampleSpanScalar(span, i);
+}
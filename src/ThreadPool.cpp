@@ -0,0 +1,113 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(int threadCount)
+    : job(nullptr), jobCount(0), nextIndex(0), busyWorkers(0), generation(0), stopping(false) {
+    if (threadCount <= 0) {
+        threadCount = hardwareThreads();
+    }
+
+    // The caller acts as worker 0
+    for (int i = 1; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+int ThreadPool::getThreadCount() const {
+    return static_cast<int>(workers.size()) + 1;
+}
+
+int ThreadPool::hardwareThreads() {
+    unsigned count = std::thread::hardware_concurrency();
+    return count > 0 ? static_cast<int>(count) : 1;
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int, int)>& fn) {
+    if (count <= 0) {
+        return;
+    }
+
+    if (workers.empty()) {
+        for (int i = 0; i < count; i++) {
+            fn(i, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+        jobCount = count;
+        nextIndex = 0;
+        busyWorkers = static_cast<int>(workers.size());
+        error = nullptr;
+        generation++;
+    }
+    wake.notify_all();
+
+    runIterations(0);
+
+    std::exception_ptr failure;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return busyWorkers == 0; });
+        job = nullptr;
+        failure = error;
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+void ThreadPool::workerLoop(int worker) {
+    unsigned seenGeneration = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+        }
+
+        runIterations(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busyWorkers == 0) {
+                finished.notify_one();
+            }
+        }
+    }
+}
+
+void ThreadPool::runIterations(int worker) {
+    int index;
+    while ((index = nextIndex.fetch_add(1)) < jobCount) {
+        try {
+            (*job)(index, worker);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            // Stop handing out further iterations
+            nextIndex = jobCount;
+        }
+    }
+}
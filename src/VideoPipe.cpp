@@ -0,0 +1,78 @@
+#include "VideoPipe.hpp"
+#include "Logger.hpp"
+
+#if !defined(_WIN32)
+#include <csignal>
+#include <sys/wait.h>
+#endif
+
+VideoPipe::VideoPipe() : pipe(nullptr) {
+}
+
+VideoPipe::~VideoPipe() {
+    if (pipe) {
+        close();
+    }
+}
+
+bool VideoPipe::open(const std::string& command) {
+    if (pipe) {
+        LOG_ERROR << "Encoder pipe is already open";
+        return false;
+    }
+
+    LOG_INFO << "Starting encoder: " << command;
+
+#if defined(_WIN32)
+    pipe = _popen(command.c_str(), "wb");
+#else
+    // An encoder that exits early must surface as a write error, not kill the process
+    std::signal(SIGPIPE, SIG_IGN);
+    pipe = popen(command.c_str(), "w");
+#endif
+
+    if (!pipe) {
+        LOG_ERROR << "Could not start encoder: " << command;
+        return false;
+    }
+    return true;
+}
+
+bool VideoPipe::writeFrame(const Image& frame) {
+    if (!pipe) {
+        return false;
+    }
+
+    // Rows are contiguous RGB bytes, so the whole frame goes out in one write
+    static_assert(sizeof(Color) == 3, "Color must be three packed bytes");
+    size_t bytes = static_cast<size_t>(frame.getWidth()) * frame.getHeight() * sizeof(Color);
+    return fwrite(frame.rowData(0), 1, bytes, pipe) == bytes;
+}
+
+bool VideoPipe::close() {
+    if (!pipe) {
+        return false;
+    }
+
+#if defined(_WIN32)
+    int status = _pclose(pipe);
+    pipe = nullptr;
+    bool success = (status == 0);
+#else
+    int status = pclose(pipe);
+    pipe = nullptr;
+    if (status != -1 && WIFEXITED(status)) {
+        status = WEXITSTATUS(status);
+    }
+    bool success = (status == 0);
+#endif
+
+    if (!success) {
+        LOG_ERROR << "Encoder exited with status " << status;
+    }
+    return success;
+}
+
+bool VideoPipe::isOpen() const {
+    return pipe != nullptr;
+}
@@ -1,10 +1,21 @@
 ﻿#include <iostream>
 #include <string>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
 #include "Cube.hpp"
 #include "Renderer.hpp"
 #include "Image.hpp"
 #include "Logger.hpp"
 #include "ConfigManager.hpp"
+#include "Benchmark.hpp"
+#include "PagedTexture.hpp"
+#include "Texture.hpp"
+#include "TextureCache.hpp"
+#include "TextureSampler.hpp"
+#include "CpuFeatures.hpp"
+#include "Mesh.hpp"
+#include "ObjLoader.hpp"
 
 // Function to print command-line usage
 void printUsage(const char* programName) {
@@ -12,11 +23,23 @@ void printUsage(const char* programName) {
     std::cout << "Options:" << std::endl;
     std::cout << "  -h, --help            Show this help message" << std::endl;
     std::cout << "  -c, --config FILE     Load configuration from FILE (default: config.json)" << std::endl;
+    std::cout << "  -t, --threads N       Render N frames concurrently (0 = all hardware threads)" << std::endl;
+    std::cout << "  -b, --benchmark NAME  Run benchmark NAME on the configured scene instead of rendering" << std::endl;
+    std::cout << "                        (available:";
+    for (const auto& name : Benchmark::scenarioNames()) {
+        std::cout << " " << name;
+    }
+    std::cout << ")" << std::endl;
+    std::cout << "  --kernel-isa LEVEL    Run the kernels built for LEVEL instead of the best the CPU supports" << std::endl;
+    std::cout << "                        (sse2, sse4.1, avx2 or avx512)" << std::endl;
 }
 
 int main(int argc, char* argv[]) {
     // Default configuration file
     std::string configFile = "../../../../config.json";
+    std::string benchmarkName;
+    std::string kernelIsaOverride;
+    int threads = -1;
 
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -34,6 +57,33 @@ int main(int argc, char* argv[]) {
                 return 1;
             }
         }
+        else if (arg == "-t" || arg == "--threads") {
+            if (i + 1 < argc) {
+                threads = std::atoi(argv[++i]);
+            }
+            else {
+                LOG_ERROR << "Missing argument for " << arg;
+                return 1;
+            }
+        }
+        else if (arg == "-b" || arg == "--benchmark") {
+            if (i + 1 < argc) {
+                benchmarkName = argv[++i];
+            }
+            else {
+                LOG_ERROR << "Missing argument for " << arg;
+                return 1;
+            }
+        }
+        else if (arg == "--kernel-isa") {
+            if (i + 1 < argc) {
+                kernelIsaOverride = argv[++i];
+            }
+            else {
+                LOG_ERROR << "Missing argument for " << arg;
+                return 1;
+            }
+        }
         else {
             LOG_WARNING << "Unknown argument: " << arg;
         }
@@ -46,29 +96,140 @@ int main(int argc, char* argv[]) {
         LOG_INFO << "Using default settings...";
     }
 
+    // Command line overrides
+    if (threads >= 0) {
+        config.threads = threads;
+    }
+
+    // Pick the kernel builds once, before anything renders
+    const KernelIsa detectedIsa = detectKernelIsa();
+    if (!kernelIsaOverride.empty()) {
+        KernelIsa isa;
+        if (!parseKernelIsa(kernelIsaOverride, isa)) {
+            LOG_ERROR << "Unknown kernel instruction set: " << kernelIsaOverride;
+            return 1;
+        }
+        if (!setKernelIsa(isa)) {
+            LOG_ERROR << "Kernel instruction set " << kernelIsaOverride << " is not supported by this CPU";
+            return 1;
+        }
+    }
+    if (getKernelIsa() == detectedIsa) {
+        LOG_INFO << "Kernel instruction set: " << kernelIsaName(getKernelIsa()) << " (detected)";
+    }
+    else {
+        LOG_INFO << "Kernel instruction set: " << kernelIsaName(getKernelIsa()) << " (forced; the CPU supports "
+            << kernelIsaName(detectedIsa) << ")";
+    }
+
     // Create a cube with configurable size
     Cube cube(config.cubeSize);
 
+    // Optionally load a mesh to render instead, scaled to the cube's bounding sphere
+    Mesh mesh;
+    int meshDecalMaterial = -1;
+    if (!config.meshPath.empty()) {
+        if (!loadObjMesh(config.meshPath, mesh)) {
+            LOG_FATAL << "Failed to load mesh: " << config.meshPath;
+            return 1;
+        }
+        mesh.fitToRadius(cube.boundingRadius);
+
+        if (config.meshDecalMaterial.empty()) {
+            meshDecalMaterial = config.decalFaceIndex;
+        }
+        else {
+            meshDecalMaterial = mesh.findMaterial(config.meshDecalMaterial);
+            if (meshDecalMaterial < 0) {
+                LOG_WARNING << "Mesh has no material '" << config.meshDecalMaterial << "', no decal is applied";
+            }
+        }
+        if (meshDecalMaterial >= 0 && !mesh.hasTexCoords()) {
+            LOG_WARNING << "Mesh has no texture coordinates, no decal is applied";
+        }
+    }
+
     // Initialize the renderer with configuration
     Renderer renderer(config);
 
-    // Load the texture from the configured path
-    Image decalImage = loadImage(config.decalImagePath);
+    // Load the decal straight into the padded texel layout used by the samplers and build the
+    // mip chain, or map both from the texture cache. With a page budget the decal is paged
+    // from the cache instead, for textures too large to hold in memory.
+    TextureLayout decalLayout = TextureLayout::Linear;
+    if (!parseTextureLayout(config.decalLayout, decalLayout)) {
+        LOG_WARNING << "Unknown decal layout '" << config.decalLayout << "', using linear";
+    }
+    auto loadStart = std::chrono::steady_clock::now();
+    Texture decalTexture;
+    if (config.textureCacheDirectory.empty()) {
+        if (config.decalPageBudgetMB > 0) {
+            LOG_WARNING << "Paged decals need the texture cache; loading the decal whole";
+        }
+        decalTexture = loadTexture(config.decalImagePath, decalLayout);
+    }
+    else {
+        TextureCache cache(config.textureCacheDirectory, static_cast<uint64_t>(std::max(config.textureCacheLimitMB, 0)) << 20);
+        if (config.decalPageBudgetMB > 0) {
+            decalTexture = cache.loadPaged(config.decalImagePath, static_cast<uint64_t>(config.decalPageBudgetMB) << 20);
+        }
+        else {
+            decalTexture = cache.load(config.decalImagePath, decalLayout);
+        }
+    }
+    auto loadEnd = std::chrono::steady_clock::now();
 
     // Check if the image loaded successfully
-    if (decalImage.getWidth() <= 1 || decalImage.getHeight() <= 1) {
+    if (decalTexture.getWidth() <= 1 || decalTexture.getHeight() <= 1) {
         LOG_FATAL << "Failed to load required texture: " << config.decalImagePath;
         return 1;
     }
 
-    LOG_INFO << "Successfully loaded image: " << config.decalImagePath;
+    LOG_INFO << "Successfully loaded image: " << config.decalImagePath << " ("
+        << decalTexture.getWidth() << "x" << decalTexture.getHeight() << " in "
+        << std::chrono::duration<double, std::milli>(loadEnd - loadStart).count() << " ms)";
+
+    // The area filter reads a summed-area table of the decal, built once here
+    if (renderer.getTextureFilter() == TextureFilter::Area && decalTexture.getPages()) {
+        LOG_WARNING << "Area filtering needs the whole decal in memory; the paged decal is filtered trilinearly";
+    }
+    else if (renderer.getTextureFilter() == TextureFilter::Area) {
+        auto tableStart = std::chrono::steady_clock::now();
+        decalTexture.buildSummedAreaTable();
+        auto tableEnd = std::chrono::steady_clock::now();
+        LOG_INFO << "Summed-area table: "
+            << 12.0 * (decalTexture.getWidth() + 1) * (decalTexture.getHeight() + 1) / (1024 * 1024) << " MB in "
+            << std::chrono::duration<double, std::milli>(tableEnd - tableStart).count() << " ms";
+    }
+
+    if (decalTexture.getPages()) {
+        LOG_INFO << "Texture sampler: scalar, " << textureFilterName(renderer.getTextureFilter()) << " filtering over "
+            << decalTexture.getLevelCount() << " paged mip levels (" << config.decalPageBudgetMB << " MB page budget)";
+    }
+    else {
+        LOG_INFO << "Texture sampler: " << kernelIsaName(getKernelIsa()) << ", "
+            << textureFilterName(renderer.getTextureFilter()) << " filtering over "
+            << decalTexture.getLevelCount() << " " << textureLayoutName(decalLayout) << " mip levels";
+    }
+
+    // Run a benchmark instead of the animation if requested
+    if (!benchmarkName.empty()) {
+        Benchmark benchmark(config, decalTexture);
+        return benchmark.run(benchmarkName) ? 0 : 1;
+    }
 
     // Render animation
     LOG_INFO << "Rendering animation with " << config.numFrames << " frames...";
     LOG_INFO << "This will create a " << (config.numFrames / static_cast<double>(config.frameRate))
         << " second video at " << config.frameRate << " fps.";
 
-    config.renderAnimation(renderer, cube, &decalImage);
+    config.renderAnimation(renderer, cube, &decalTexture, config.meshPath.empty() ? nullptr : &mesh,
+        meshDecalMaterial);
+
+    if (PagedTexture* pages = decalTexture.getPages()) {
+        PagedTexture::Stats stats = pages->getStats();
+        LOG_INFO << "Decal pages: " << stats.faults << " read, " << stats.evictions << " evicted, peak "
+            << stats.peakResidentBytes / 1024 << " KB resident";
+    }
 
     LOG_INFO << "Animation complete!";
     return 0;